@@ -19,7 +19,12 @@ BmpBrush::BmpBrush()
     m_Width = 0;
     m_Height = 0;
     m_BytesPerPixel = 0; /* 3:RGB, 4:RGBA */
+    m_Compression = NONE;
+    m_Size = 0;
+    m_NumLevels = 1;
     m_Pixels = nullptr;
+    m_Pitch = 0;
+    m_TopDown = false;
 }
 
 BmpBrush::~BmpBrush()
@@ -32,6 +37,16 @@ BmpBrush::~BmpBrush()
  * Pixels are raw const char* from file!
  */
 bool BmpBrush::Load( const char* filename ) throw(std::exception)
+{
+    if (!m_FileHandle.is_open() ) {
+        m_FileHandle.open( filename, std::ios_base::binary | std::ios_base::in );
+        ASSERT( m_FileHandle.is_open(), "File open error! Invalid file or file size! (%s)", filename );
+        return Load( filename, m_FileHandle.const_data(), m_FileHandle.size() );
+    }
+    return this->m_Pixels != nullptr;
+}
+
+bool BmpBrush::Load( const char* name, const char* data, std::size_t size, boost::shared_ptr<const void> source ) throw(std::exception)
 {
     // make sure compiler does not add padding
 #pragma pack( push, 2 )
@@ -58,31 +73,42 @@ bool BmpBrush::Load( const char* filename ) throw(std::exception)
     };
 #pragma pack( pop )
 
-    if (!m_FileHandle.is_open() ) {
-        this->m_Pixels = nullptr;
-        m_FileHandle.open( filename, std::ios_base::binary | std::ios_base::in );
-        if ( m_FileHandle.is_open() && m_FileHandle.size() >= sizeof(BmpHeader) ) {
-            const BmpHeader* bmp = (const BmpHeader*)m_FileHandle.const_data();
-            if ( bmp->magic == 0x4D42 ) // == (unsigned short)'MB'
+    this->m_Pixels = nullptr;
+    m_Source = source;
+    if ( data && size >= sizeof(BmpHeader) ) {
+        const BmpHeader* bmp = (const BmpHeader*)data;
+        if ( bmp->magic == 0x4D42 ) // == (unsigned short)'MB'
+        {
+            // negative height: rows top down
+            const bool topDown = int(bmp->height) < 0;
+            const unsigned int height = topDown ? 0u - bmp->height : bmp->height;
+            if ( bmp->bih_size >= 40 &&
+                 bmp->planes == 1 &&
+                 (bmp->bpp == 24 || bmp->bpp == 32) &&
+                 bmp->compression == 0 )
             {
+                // rows are padded to 4 bytes - the last one may not be
+                const std::size_t row   = std::size_t(bmp->width) * (bmp->bpp >> 3);
+                const std::size_t pitch = (row + 3) & ~std::size_t(3);
+                ASSERT( Brush::IsValid( bmp->width, height, bmp->data_offset, pitch * (height - 1) + row, size ),
+                        "Invalid or truncated BMP (%s)!", name );
+
                 this->m_Width  = bmp->width;
-                this->m_Height = bmp->height;
-                if ( bmp->planes == 1 &&
-                     (bmp->bpp == 24 || bmp->bpp == 32) &&
-                     bmp->compression == 0 )
-                {
-                    // we map our pixel straight into the mmaped file
-                    this->m_BytesPerPixel = (bmp->bpp >> 3);
-                    this->m_Pixels = ((const char*)bmp) + bmp->data_offset;
-                } else {
-                    ASSERT( 0, "Unsupported format. Cannot load BMP (%s)!", filename );
-                }
+                this->m_Height = height;
+                this->m_TopDown = topDown;
+                this->m_BytesPerPixel = (bmp->bpp >> 3);
+                this->m_Pitch = pitch;
+                this->m_Size  = pitch * (height - 1) + row;
+                // we map our pixel straight into the mmaped file
+                this->m_Pixels = ((const char*)bmp) + bmp->data_offset;
             } else {
-                ASSERT( 0, "File '%s' is not a BMP format!", filename );
+                ASSERT( 0, "Unsupported format. Cannot load BMP (%s)!", name );
             }
         } else {
-            ASSERT( 0, "File open error! Invalid file or file size! (%s)", filename );
+            ASSERT( 0, "File '%s' is not a BMP format!", name );
         }
+    } else {
+        ASSERT( 0, "File open error! Invalid file or file size! (%s)", name );
     }
     return this->m_Pixels != nullptr;
 }
@@ -12,6 +12,8 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <algorithm>
+
 namespace bfs  = boost::filesystem;
 
 /************************************************************************/
@@ -41,22 +43,6 @@ static const int _DXT5(MAKE_4LE32( 'D','X','T','5' ));
 static const int _ATI1(MAKE_4LE32( 'A','T','I','1' ));
 static const int _ATI2(MAKE_4LE32( 'A','T','I','2' ));
 
-struct Format
-{
-    int m_RShift;
-    int m_GShift;
-    int m_BShift;
-    int m_AShift;
-
-    unsigned int m_RMask;
-    unsigned int m_GMask;
-    unsigned int m_BMask;
-    unsigned int m_AMask;
-};
-
-#define MAKE_COLOR( d, r,g,b, fmt ) \
-d = ((r << fmt.m_RShift) | (g << fmt.m_GShift) | (b << fmt.m_BShift)) & ~fmt.m_AMask;
-
 #define DDSD_CAPS                  0x00000001
 #define DDSD_HEIGHT                0x00000002
 #define DDSD_WIDTH                 0x00000004
@@ -145,15 +131,6 @@ typedef boost::shared_ptr<DdsHeader> DdsHeaderPtr;
 
 #pragma pack( pop )
 
-static unsigned char MaskToColorShift(unsigned int mask)
-{
-    unsigned char i = 0;
-
-    if(!mask) return(0);
-    while(!((mask >> i) & 1)) ++i;
-    return(i);
-}
-
 class DdsLoader
 {
 #pragma pack( push, 2 )
@@ -337,12 +314,18 @@ DdsBrush::DdsBrush()
     m_Width = 0;
     m_Height = 0;
     m_BytesPerPixel = 0; /* 3:RGB, 4:RGBA */
+    m_Compression = NONE;
+    m_Size = 0;
+    m_NumLevels = 1;
     m_Pixels = nullptr;
+    m_Pitch = 0;
+    m_TopDown = false;
 }
 
 DdsBrush::~DdsBrush()
 {
-    if ( m_Pixels ) {
+    // compressed pixels point into the mapping
+    if ( m_Pixels && m_Compression == NONE ) {
         delete [] m_Pixels;
     }
 }
@@ -353,345 +336,155 @@ DdsBrush::~DdsBrush()
  */
 bool DdsBrush::Load( const char* filename ) throw(std::exception)
 {
-    bool result = false;
     if (!m_FileHandle.is_open() ) {
-        this->m_Pixels = nullptr;
         m_FileHandle.open( filename, std::ios_base::binary | std::ios_base::in );
-        if ( m_FileHandle.is_open() && m_FileHandle.size() >= sizeof(DdsHeader) ) {
-            DdsLoader ddsLoader( m_FileHandle.const_data() );
-            DdsHeader& hdr = ddsLoader.GetHeader();
-
-            // DXT1/3/5 has alpha channel
-            int bpp = 0;
+        ASSERT( m_FileHandle.is_open(), "File open error! Invalid file or file size! (%s)", filename );
+        return Load( filename, m_FileHandle.const_data(), m_FileHandle.size() );
+    }
+    return this->m_Pixels != nullptr;
+}
 
-            unsigned int width(hdr.m_Width);
-            unsigned int height(hdr.m_Height);
+bool DdsBrush::Load( const char* name, const char* data, std::size_t dataSize, boost::shared_ptr<const void> source ) throw(std::exception)
+{
+    bool result = false;
+    this->m_Pixels = nullptr;
+    m_Source = source;
+    if ( data && dataSize >= sizeof(DdsHeader) ) {
+        DdsLoader ddsLoader( data );
+        DdsHeader& hdr = ddsLoader.GetHeader();
+        // all sizes below follow from these - checked once, the decoders trust them
+        ASSERT( Brush::IsValid( hdr.m_Width, hdr.m_Height, sizeof(DdsHeader), 0, dataSize ), "Invalid DDS image size (%s)", name );
+
+        // DXT1/3/5 has alpha channel
+        int bpp = 0;
+
+        unsigned int width(hdr.m_Width);
+        unsigned int height(hdr.m_Height);
+
+        size_t size;
+        int compression = DDS_COMPRESS_NONE;
+        if ( hdr.m_PixelFormat.m_Flags & DDPF_FOURCC )
+        {
+            unsigned int w = (width  + 3) >> 2;
+            unsigned int h = (height + 3) >> 2;
 
-            size_t size;
-            int compression = DDS_COMPRESS_NONE;
-            if ( hdr.m_PixelFormat.m_Flags & DDPF_FOURCC )
+            switch (hdr.m_PixelFormat.m_FourCC.AsInt)
             {
-                unsigned int w = (width  + 3) >> 2;
-                unsigned int h = (height + 3) >> 2;
-
-                switch (hdr.m_PixelFormat.m_FourCC.AsInt)
-                {
-                case _DXT1: compression = DDS_COMPRESS_BC1; bpp = 4; break;
-                case _DXT3: compression = DDS_COMPRESS_BC2; bpp = 4; break;
-                case _DXT5: compression = DDS_COMPRESS_BC3; bpp = 4; break;
-                case _ATI1: compression = DDS_COMPRESS_BC4; bpp = 1; break;
-                case _ATI2: compression = DDS_COMPRESS_BC5; bpp = 3; break;
-                }
-
-                size = w * h;
-                if ( compression == DDS_COMPRESS_BC1 || compression == DDS_COMPRESS_BC4 ) {
-                    size *= 8;
-                } else {
-                    size *= 16;
-                }
-                if ( width  < 4 ) width  = 4;
-                if ( height < 4 ) height = 4;
+            case _DXT1: compression = DDS_COMPRESS_BC1; bpp = 4; break;
+            case _DXT3: compression = DDS_COMPRESS_BC2; bpp = 4; break;
+            case _DXT5: compression = DDS_COMPRESS_BC3; bpp = 4; break;
+            case _ATI1: compression = DDS_COMPRESS_BC4; bpp = 4; break;   // decoded to BGRA
+            case _ATI2: compression = DDS_COMPRESS_BC5; bpp = 4; break;
+            }
 
+            size = w * h;
+            if ( compression == DDS_COMPRESS_BC1 || compression == DDS_COMPRESS_BC4 ) {
+                size *= 8;
             } else {
-                // <1 on unsigned ???
-                if ( width  < 1 ) width  = 1;
-                if ( height < 1 ) height = 1;
-                size = hdr.m_BufferSize;
-
-                bpp = hdr.m_PixelFormat.m_BitsPerPixel >> 3;
+                size *= 16;
             }
 
-            // only care about 2 && 4 byte RGBA textures for now
-            ASSERT( ( bpp == 4 || bpp == 2), "Unsupported bit depth. Only 2 and 4 bytes per pixels are supporte" );
+        } else {
+            // <1 on unsigned ???
+            if ( width  < 1 ) width  = 1;
+            if ( height < 1 ) height = 1;
+            size = hdr.m_BufferSize;
+
+            bpp = hdr.m_PixelFormat.m_BitsPerPixel >> 3;
+        }
+
+        // only care about 2 && 4 byte RGBA textures for now
+        ASSERT( ( bpp == 4 || bpp == 2), "Unsupported bit depth. Only 2 and 4 bytes per pixels are supporte" );
 
 
-            // source DDS descriptor (pixel data are in DDS format)
-            // destination surface descriptor (decoded DDS) - we will keep that! This is our
-            // target surface used to blit later
+        // source DDS descriptor (pixel data are in DDS format)
+        // destination surface descriptor (decoded DDS) - we will keep that! This is our
+        // target surface used to blit later
 
-            // no cube map, no volume map
-            if( ( hdr.m_Caps.m_Caps2 & (DDSCAPS2_CUBEMAP|DDSCAPS2_VOLUME)) == 0 )
+        // no cube map, no volume map
+        if( ( hdr.m_Caps.m_Caps2 & (DDSCAPS2_CUBEMAP|DDSCAPS2_VOLUME)) == 0 )
+        {
+            // read flat data
+            if ( hdr.m_PixelFormat.m_Flags & DDPF_FOURCC )
             {
-                // read flat data
-                if ( hdr.m_PixelFormat.m_Flags & DDPF_FOURCC )
+                // compressed - the blocks stay in the mapping, Texture uploads them as they are
+                m_Width  = hdr.m_Width;
+                m_Height = hdr.m_Height;
+                m_BytesPerPixel = bpp; // decoded, must be 4!!
+                switch ( compression )
                 {
-                    // compressed
-                    const unsigned char* pix = ddsLoader.LoadPixels( size, 0 );
-                    if ( pix )
-                    {
-                        Format format =
-                        {
-                            0, 8, 16, 24,
-                            0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000
-//                            24, 16, 8, 0,   // shift
-//                            0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff // mask
-                        };
-                        m_Width  = width;
-                        m_Height = height;
-                        m_BytesPerPixel = bpp; // must be 4!!
-                        m_Pixels = new char[ m_Width * m_BytesPerPixel * m_Height ];
-                        switch ( compression )
-                        {
-                        case DDS_COMPRESS_BC1: // DXT1
-                            m_FormatString = "DXT1";
-                            {
-                                unsigned int amask = format.m_AMask;
-                                for ( unsigned int y = 0; y < height; y += 4 ) {
-                                    for ( unsigned int x = 0; x < width; x += 4 )
-                                    {
-                                        unsigned int *dest = (unsigned int*)((m_Pixels) + (y * width + x) * bpp);
-#pragma pack( push, 2 )
-                                        // only works in LE mode!
-                                        struct s_dxt1_pixel {
-                                            unsigned short c0;   // r5g6b5 color 0
-                                            unsigned short c1;   // r5g6b5 color 1
-                                            unsigned long  clut; // 4x4 2bit color lut
-                                        } *dxt1 = (s_dxt1_pixel*)pix;
-#pragma pack( pop )
-                                        unsigned long colorbits = dxt1->clut;
-                                        // color block
-                                        unsigned int c0 = (unsigned int)dxt1->c0; // R5G6B5
-                                        unsigned int c1 = (unsigned int)dxt1->c1; // R5G6B5
-                                        unsigned int color_table[4] = { amask, amask, amask, 0 };
-
-                                        // no point in calculating remaining pixels if colors are 0
-                                        if ( c0 > 0 || c1 > 0 )
-                                        {
-                                            // r5g6b5 -> r8g8b8
-                                            int r0 = (c0 & 0xF800) >> 11; r0 = (r0 << 3 | r0 >> 2 );
-                                            int g0 = (c0 & 0x07E0) >> 5;  g0 = (g0 << 2 | g0 >> 4);
-                                            int b0 = (c0 & 0x001F);       b0 = (b0 << 3 | b0 >> 2);
-
-                                            int r1 = (c1 & 0xF800) >> 11; r1 = (r1 << 3 | r1 >> 2 );
-                                            int g1 = (c1 & 0x07E0) >> 5;  g1 = (g1 << 2 | g1 >> 4);
-                                            int b1 = (c1 & 0x001F);       b1 = (b1 << 3 | b1 >> 2);
-
-                                            MAKE_COLOR( color_table[0], r0, g0, b0, format );
-                                            color_table[0] |= amask;
-                                            MAKE_COLOR( color_table[1], r1, g1, b1, format );
-                                            color_table[1] |= amask;
-
-                                            if ( c0 > c1 ) {
-                                                MAKE_COLOR( color_table[2], (2*r0+r1)/3, (2*g0+g1)/3, (2*b0+b1)/3, format );
-                                                MAKE_COLOR( color_table[3], (r0+2*r1)/3, (g0+2*g1)/3, (b0+2*b1)/3, format );
-                                                color_table[2] |= amask;
-                                                color_table[3] |= amask;
-                                            } else {
-                                                r0 = (r0 + r1 + 1) >> 1;
-                                                g0 = (g0 + g1 + 1) >> 1;
-                                                b0 = (b0 + b1 + 1) >> 1;
-                                                MAKE_COLOR( color_table[2], r0, g0, b0, format );
-                                                color_table[2] |= amask;
-                                                // color_table[3] = 0x00000000; - already set
-                                            }
-                                        }
-                                        for ( int j = 0; j < 4; j++ )
-                                        {
-                                            unsigned int *d = dest + j * width;
-                                            for ( int i = 0; i < 4; i++ )
-                                            {
-                                                unsigned int ci = (colorbits & 0x03); colorbits >>= 2;
-                                                *d++ = color_table[ ci ];
-                                            }
-                                        }
-                                        pix += 8; // advance 128 bits ( = 16 * 8 )
-                                    }
-                                }
-                            }
-                            result = true;
-                            break;
-                        case DDS_COMPRESS_BC2: // DXT3
-                            m_FormatString = "DXT3";
-                            {
-                                for ( unsigned int y = 0; y < height; y += 4 ) {
-                                    for ( unsigned int x = 0; x < width; x += 4 )
-                                    {
-                                        unsigned int *dest = (unsigned int*)((m_Pixels) + (y * width + x) * bpp);
-#pragma pack( push, 2 )
-                                        // only works in LE mode!
-                                        struct s_dxt3_pixel {
-                                            unsigned long long alpha; // 4x4 4 bit alpha channel;
-                                            unsigned short c0;   // r5g6b5 color 0
-                                            unsigned short c1;   // r5g6b5 color 1
-                                            unsigned long  clut; // 4x4 2bit color lut
-                                        } *dxt3 = (s_dxt3_pixel*)pix;
-#pragma pack( pop )
-                                        // mask out first to bytes (a0 & a1)
-                                        unsigned long long alphabits = dxt3->alpha;
-                                        unsigned long      colorbits = dxt3->clut;
-
-                                        // color block
-                                        unsigned int c0 = (unsigned int)dxt3->c0; // R5G6B5
-                                        unsigned int c1 = (unsigned int)dxt3->c1; // R5G6B5
-                                        unsigned int color_table[4] = { 0, 0, 0, 0 };
-                                        // no point in calculating remaining pixels if colors are 0
-                                        if ( c0 > 0 || c1 > 0 )
-                                        {
-                                            // r5g6b5 -> r8g8b8
-                                            int r0 = (c0 & 0xF800) >> 11; r0 = (r0 << 3 | r0 >> 2);
-                                            int g0 = (c0 & 0x07E0) >> 5;  g0 = (g0 << 2 | g0 >> 4);
-                                            int b0 = (c0 & 0x001F);       b0 = (b0 << 3 | b0 >> 2);
-
-                                            int r1 = (c1 & 0xF800) >> 11; r1 = (r1 << 3 | r1 >> 2);
-                                            int g1 = (c1 & 0x07E0) >> 5;  g1 = (g1 << 2 | g1 >> 4);
-                                            int b1 = (c1 & 0x001F);       b1 = (b1 << 3 | b1 >> 2);
-
-                                            MAKE_COLOR( color_table[0], r0, g0, b0, format );
-                                            MAKE_COLOR( color_table[1], r1, g1, b1, format );
-
-                                            MAKE_COLOR( color_table[2], (2*r0+r1)/3, (2*g0+g1)/3, (2*b0+b1)/3, format );
-                                            MAKE_COLOR( color_table[3], (r0+2*r1)/3, (g0+2*g1)/3, (b0+2*b1)/3, format );
-                                        }
-
-                                        for ( int j = 0; j < 4; j++ )
-                                        {
-                                            unsigned int *d = dest + j * width;
-                                            for ( int i = 0; i < 4; i++ )
-                                            {
-                                                unsigned int alpha( (alphabits & 0x0f) * 17 ); alphabits >>= 4;
-                                                unsigned int ci = colorbits & 0x03; colorbits >>= 2;
-                                                *d++ = color_table[ ci ] | alpha;
-                                            }
-                                        }
-                                        pix += 16; // advance 128 bits ( = 16 * 8 )
-                                    }
-                                }
-                            }
-                            result = true;
-                            break;
-                        case DDS_COMPRESS_BC3: // DXT5
-                            m_FormatString = "DXT5";
-                            {
-                                for ( unsigned int y = 0; y < height; y += 4 ) {
-                                    for ( unsigned int x = 0; x < width; x += 4 )
-                                    {
-                                        unsigned int *dest = (unsigned int*)((m_Pixels) + (y * width + x) * bpp);
-#pragma pack( push, 2 )
-                                        // only works in LE mode!
-                                        struct s_dxt5_pixel {
-                                            union {
-                                                struct {
-                                                    unsigned char a0; // first alpha byte
-                                                    unsigned char a1; // second alpha byte
-                                                } alpha;
-                                                unsigned long long alut; // 4x4 3 bit alpha lut (containing a0&a1!)
-                                            };
-                                            unsigned short c0;   // r5g6b5 color 0
-                                            unsigned short c1;   // r5g6b5 color 1
-                                            unsigned long  clut; // 4x4 2bit color lut
-                                        } *dxt5 = (s_dxt5_pixel*)pix;
-#pragma pack( pop )
-                                        unsigned int a0 = (unsigned int)dxt5->alpha.a0;
-                                        unsigned int a1 = (unsigned int)dxt5->alpha.a1;
-                                        // mask out first to bytes (a0 & a1)
-                                        unsigned long long alphabits = (dxt5->alut >> 16);
-                                        unsigned long      colorbits = dxt5->clut;
-
-                                        // color block
-                                        unsigned int c0 = (unsigned int)dxt5->c0; // R5G6B5
-                                        unsigned int c1 = (unsigned int)dxt5->c1; // R5G6B5
-
-                                        unsigned int color_table[4] = { 0, 0, 0, 0 };
-                                        // no point in calculating remaining pixels if colors are 0
-                                        if ( c0 > 0 || c1 > 0 )
-                                        {
-                                            // r5g6b5 -> r8g8b8
-                                            int r0 = (c0 & 0xF800) >> 11; r0 = (r0 << 3 | r0 >> 2);
-                                            int g0 = (c0 & 0x07E0) >> 5;  g0 = (g0 << 2 | g0 >> 4);
-                                            int b0 = (c0 & 0x001F);       b0 = (b0 << 3 | b0 >> 2);
-
-                                            int r1 = (c1 & 0xF800) >> 11; r1 = (r1 << 3 | r1 >> 2);
-                                            int g1 = (c1 & 0x07E0) >> 5;  g1 = (g1 << 2 | g1 >> 4);
-                                            int b1 = (c1 & 0x001F);       b1 = (b1 << 3 | b1 >> 2);
-
-                                            MAKE_COLOR( color_table[0], r0, g0, b0, format );
-                                            MAKE_COLOR( color_table[1], r1, g1, b1, format );
-
-                                            MAKE_COLOR( color_table[2], (2*r0+r1)/3, (2*g0+g1)/3, (2*b0+b1)/3, format );
-                                            MAKE_COLOR( color_table[3], (r0+2*r1)/3, (g0+2*g1)/3, (b0+2*b1)/3, format );
-                                        }
-
-                                        // Alpha table
-                                        unsigned int alpha_table[8];
-                                        alpha_table[0] = a0 << format.m_AShift & format.m_AMask;
-                                        alpha_table[1] = a1 << format.m_AShift & format.m_AMask;
-                                        if ( a0 > a1 ) {
-                                            alpha_table[2] = (((6*a0 + 1*a1) / 7) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[3] = (((5*a0 + 2*a1) / 7) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[4] = (((4*a0 + 3*a1) / 7) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[5] = (((3*a0 + 4*a1) / 7) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[6] = (((2*a0 + 5*a1) / 7) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[7] = (((1*a0 + 6*a1) / 7) << format.m_AShift) & format.m_AMask ;
-                                        } else {
-                                            alpha_table[2] = (((4*a0 + 1*a1) / 5) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[3] = (((3*a0 + 2*a1) / 5) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[4] = (((2*a0 + 3*a1) / 5) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[5] = (((1*a0 + 4*a1) / 5) << format.m_AShift) & format.m_AMask ;
-                                            alpha_table[6] = 0;
-                                            alpha_table[7] = format.m_AMask ;
-                                        }
-
-                                        for ( int j = 0; j < 4; j++ )
-                                        {
-                                            unsigned int *d = dest + j * width;
-                                            for ( int i = 0; i < 4; i++ )
-                                            {
-                                                // I might need to pre shift those bits
-                                                int ai = (int)(alphabits & 0x07); alphabits >>= 3;
-                                                int ci = (colorbits & 0x03); colorbits >>= 2;
-                                                // write back pixel
-                                                *d++ = color_table[ ci ] | alpha_table[ai] ;
-                                            }
-                                        }
-                                        pix += 16; // advance 128 bits ( = 16 * 8 )
-                                    }
-                                }
-                            }
-                            result = true;
-                            break;
-                        }
+                case DDS_COMPRESS_BC1: m_FormatString = "DXT1"; m_Compression = BC1; result = true; break;
+                case DDS_COMPRESS_BC2: m_FormatString = "DXT3"; m_Compression = BC2; result = true; break;
+                case DDS_COMPRESS_BC3: m_FormatString = "DXT5"; m_Compression = BC3; result = true; break;
+                case DDS_COMPRESS_BC4: m_FormatString = "ATI1"; m_Compression = BC4; result = true; break;
+                case DDS_COMPRESS_BC5: m_FormatString = "ATI2"; m_Compression = BC5; result = true; break;
+                default: break;
+                }
+                if ( result )
+                {
+                    // stored mips follow level 0, each level in whole blocks. Never more than down to 1x1
+                    unsigned int maxLevels = 1;
+                    while ( ( m_Width >> maxLevels ) || ( m_Height >> maxLevels ) ) ++maxLevels;
+                    m_NumLevels = 1;
+                    if ( ( hdr.m_Flags & DDSD_MIPMAPCOUNT ) && hdr.m_NumMipMaps > 1 ) {
+                        m_NumLevels = std::min( hdr.m_NumMipMaps, maxLevels );
+                    }
+                    size = 0;
+                    for ( unsigned int level = 0; level < m_NumLevels; ++level ) {
+                        size += GetLevelSize( level );
                     }
+                    ASSERT( Brush::IsValid( m_Width, m_Height, sizeof(DdsHeader), size, dataSize ), "Truncated DDS file (%s)", name );
+                    m_Size   = size;
+                    m_Pixels = (const char*)ddsLoader.LoadPixels( size, 0 );
                 }
             }
-            else if( (hdr.m_PixelFormat.m_Flags & (DDPF_RGB|DDPF_ALPHA|DDPF_ALPHAPIXELS)) != 0 )
-            {
-                m_FormatString = "DDS Uncompressed";
-
-                Format fmt = { MaskToColorShift( hdr.m_PixelFormat.m_RMask ),
-                               MaskToColorShift( hdr.m_PixelFormat.m_GMask ),
-                               MaskToColorShift( hdr.m_PixelFormat.m_BMask ),
-                               MaskToColorShift( hdr.m_PixelFormat.m_AMask ),
+        }
+        // raw pixels of a flat image - cube and volume maps aren't loaded at all
+        if( ( hdr.m_Caps.m_Caps2 & (DDSCAPS2_CUBEMAP|DDSCAPS2_VOLUME)) == 0 && ( hdr.m_PixelFormat.m_Flags & DDPF_FOURCC ) == 0 &&
+            (hdr.m_PixelFormat.m_Flags & (DDPF_RGB|DDPF_ALPHA|DDPF_ALPHAPIXELS)) != 0 )
+        {
+            m_FormatString = "DDS Uncompressed";
 
-                               hdr.m_PixelFormat.m_RMask ,
-                               hdr.m_PixelFormat.m_GMask ,
-                               hdr.m_PixelFormat.m_BMask ,
-                               hdr.m_PixelFormat.m_AMask };
+            // uploaded as they are - there is no conversion for other masks. Without alpha they are opaque
+            const DdsPixelFormat& pf = hdr.m_PixelFormat;
+            ASSERT( bpp == 4 && pf.m_RMask == 0x00ff0000 && pf.m_GMask == 0x0000ff00 && pf.m_BMask == 0x000000ff &&
+                    ( pf.m_AMask == 0xff000000 || pf.m_AMask == 0 ), "Unsupported DDS pixel format - 32 bit BGRA only (%s)", name );
 
-                // not sure why there would be a DDSD_PITCH without DDSD_LINEARSIZE - change later.
-                if ( hdr.m_Flags & DDSD_LINEARSIZE )
-                {
-                    m_Width  = width;
-                    m_Height = height;
-                    m_BytesPerPixel = bpp;
-                    // we must convert these to RGBA
-                    m_Pixels = new char [ m_Width * m_BytesPerPixel * m_Height ];
-                    const unsigned char* pix = ddsLoader.LoadPixels( size, 0 );
-                    std::memcpy( const_cast<char*>(m_Pixels), pix, size );
-                    result = true;
+            // not sure why there would be a DDSD_PITCH without DDSD_LINEARSIZE - change later.
+            if ( hdr.m_Flags & DDSD_LINEARSIZE )
+            {
+                // exactly one level - whatever the header claims for its size
+                size = std::size_t( width ) * height * bpp;
+                ASSERT( Brush::IsValid( width, height, sizeof(DdsHeader), size, dataSize ), "Truncated DDS file (%s)", name );
+                m_Width  = width;
+                m_Height = height;
+                m_BytesPerPixel = bpp;
+                m_Size   = size;
+                // we must convert these to RGBA
+                m_Pixels = new char [ size ];
+                const unsigned char* pix = ddsLoader.LoadPixels( size, 0 );
+                std::memcpy( const_cast<char*>(m_Pixels), pix, size );
+                if ( pf.m_AMask == 0 ) {
+                    char* pixels = const_cast<char*>(m_Pixels);
+                    for ( std::size_t offset = 3; offset < size; offset += 4 ) {
+                        pixels[ offset ] = char(255);
+                    }
                 }
-                else if ( hdr.m_Flags & DDSD_PITCH )
-                {
-                    ASSERT( hdr.m_Flags & DDSD_PITCH, "Per line decoder not implemented!");
+                result = true;
+            }
+            else if ( hdr.m_Flags & DDSD_PITCH )
+            {
+                ASSERT( hdr.m_Flags & DDSD_PITCH, "Per line decoder not implemented!");
 //                    m_Width  = width;
 //                    m_Height = (hdr.m_Flags & DDSD_LINEARSIZE) ? height : 1;
 //                    m_BytesPerPixel = bpp;
 
-                    //                fmt.m_Depth  = hdr.m_PixelFormat.m_BitsPerPixel;
-                    //                fmt.m_Pitch  = width * bpp;
+                //                fmt.m_Depth  = hdr.m_PixelFormat.m_BitsPerPixel;
+                //                fmt.m_Pitch  = width * bpp;
 
-                    // this will need some work because we will need to convert pixels...too much for demo code....just bail for now
+                // this will need some work because we will need to convert pixels...too much for demo code....just bail for now
 
-                    // from pei::Engine
+                // from pei::Engine
 //                    m_Surface = SurfacePtr( new pei::Surface( width, height ));
 //                    pei::Blitter blitter( pei::PixOpPtr( new pei::PixOpCopySrcAlpha( ddsLineBuffer->GetFormat(), m_Surface->GetFormat() )) );
 //                     load one line at the time
@@ -701,12 +494,11 @@ bool DdsBrush::Load( const char* filename ) throw(std::exception)
 //                    {
 //                        blitter.Blit( ddsLineBuffer, m_Surface, 0, y++, width, 1 );
 //                    }
-                    result = false;
-                }
+                result = false;
             }
-        } else {
-            ASSERT( 0, "File open error! Invalid file or file size! (%s)", filename );
         }
+    } else {
+        ASSERT( 0, "File open error! Invalid file or file size! (%s)", name );
     }
     return result;
 }
@@ -18,8 +18,13 @@ TgaBrush::TgaBrush()
 {
     m_Width = 0;
     m_Height = 0;
-    m_BytesPerPixel = 0; /* 3:RGB, 4:RGBA */
+    m_BytesPerPixel = 0; /* 1:luminance, 3:RGB, 4:RGBA */
+    m_Compression = NONE;
+    m_Size = 0;
+    m_NumLevels = 1;
     m_Pixels = nullptr;
+    m_Pitch = 0;
+    m_TopDown = false;
 }
 
 TgaBrush::~TgaBrush()
@@ -32,6 +37,16 @@ TgaBrush::~TgaBrush()
  * Pixels are raw const char* from file!
  */
 bool TgaBrush::Load( const char* filename ) throw(std::exception)
+{
+    if ( filename && (std::strlen(filename) > 4) && (std::strncmp(&filename[std::strlen(filename)-4],".tga",4) == 0) && !m_FileHandle.is_open() ) {
+        m_FileHandle.open( filename, std::ios_base::binary | std::ios_base::in );
+        ASSERT( m_FileHandle.is_open(), "File open error! Invalid file or file size! (%s)", filename );
+        return Load( filename, m_FileHandle.const_data(), m_FileHandle.size() );
+    }
+    return this->m_Pixels != nullptr;
+}
+
+bool TgaBrush::Load( const char* name, const char* data, std::size_t size, boost::shared_ptr<const void> source ) throw(std::exception)
 {
     // make sure compiler does not add padding
 #pragma pack( push, 1 )
@@ -53,31 +68,39 @@ bool TgaBrush::Load( const char* filename ) throw(std::exception)
     };
 #pragma pack( pop )
 
-    if ( filename && (std::strlen(filename) > 4) && (std::strncmp(&filename[std::strlen(filename)-4],".tga",4) == 0) && !m_FileHandle.is_open() ) {
-        this->m_Pixels = nullptr;
-        m_FileHandle.open( filename, std::ios_base::binary | std::ios_base::in );
-        if ( m_FileHandle.is_open() && m_FileHandle.size() >= sizeof(TgaHeader) ) {
-            const TgaHeader* tga = (const TgaHeader*)m_FileHandle.const_data();
-            if (  tga->colorMapType == 0 &&
-                 (tga->imageType == 0 || tga->imageType == 2) &&
-                 (tga->bits == 8 || tga->bits == 24 || tga->bits == 32) )
-            {
-                this->m_Width  = tga->width;
-                this->m_Height = tga->height;
-                // 8 bit is luminance
-                this->m_BytesPerPixel = (tga->bits >> 3);
-                // we map our pixel straight into the mmaped file
-                this->m_Pixels = ((const char*)tga) + sizeof(TgaHeader) + tga->identsize;
-            } else {
-                ASSERT( 0, "Unsupported format. Cannot load TGA (%s)!", filename );
-            }
-//                ASSERT( 0, "File '%s' is not a TGA format!", filename );
+    this->m_Pixels = nullptr;
+    m_Source = source;
+    if ( data && size >= sizeof(TgaHeader) ) {
+        const TgaHeader* tga = (const TgaHeader*)data;
+        // 10 and 11 are 2 and 3 run length encoded
+        const bool rle = tga->imageType == 10 || tga->imageType == 11;
+        if (  tga->colorMapType == 0 &&
+             (tga->imageType == 0 || tga->imageType == 2 || tga->imageType == 3 || rle) &&
+             (tga->bits == 8 || tga->bits == 24 || tga->bits == 32) )
+        {
+            const std::size_t offset = sizeof(TgaHeader) + tga->identsize;
+            // 8 bit is luminance
+            const std::size_t bytes = std::size_t(tga->width) * tga->height * (tga->bits >> 3);
+            // packets have no length up front - the decoder checks each against the end. A packet
+            // (header and one pixel) covers at most 128 pixels, less data can't be the whole image
+            const std::size_t packets = ( std::size_t(tga->width) * tga->height + 127 ) / 128 * ( 1 + (tga->bits >> 3) );
+            ASSERT( Brush::IsValid( tga->width, tga->height, offset, rle ? packets : bytes, size ), "Invalid or truncated TGA (%s)!", name );
+
+            this->m_Width  = tga->width;
+            this->m_Height = tga->height;
+            this->m_BytesPerPixel = (tga->bits >> 3);
+            // descriptor bit 5: origin top left, rows top down
+            this->m_TopDown = (tga->descriptor & 0x20) != 0;
+            // we map our pixel straight into the mmaped file
+            this->m_Pixels = ((const char*)tga) + offset;
+            // packets are decoded while the texture is prepared - all there is up to the end
+            this->m_Compression = rle ? RLE : NONE;
+            this->m_Size = rle ? size - offset : bytes;
         } else {
-            ASSERT( 0, "File open error! Invalid file or file size! (%s)", filename );
+            ASSERT( 0, "Unsupported format. Cannot load TGA (%s)!", name );
         }
+    } else {
+        ASSERT( 0, "File open error! Invalid file or file size! (%s)", name );
     }
     return this->m_Pixels != nullptr;
 }
-
-
-
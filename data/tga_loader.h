@@ -16,6 +16,7 @@ namespace bios = boost::iostreams;
 class TgaBrush : public Brush
 {
     bios::mapped_file m_FileHandle;
+    boost::shared_ptr<const void> m_Source;    // keeps memory given to Load() alive
 public:
     TgaBrush();
 
@@ -27,6 +28,13 @@ public:
      */
     bool Load( const char* filename ) throw(std::exception);
 
+    /**
+     * Parse a brush from memory, e.g. an entry of a PackFile. Pixels may
+     * point into data - source is held as long as the brush lives.
+     */
+    bool Load( const char* name, const char* data, std::size_t size,
+               boost::shared_ptr<const void> source = boost::shared_ptr<const void>() ) throw(std::exception);
+
 };
 
 
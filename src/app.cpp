@@ -208,6 +208,11 @@ void App::InitScene( int width, int height )
 
 void App::Init(int argc, char* argv[])
 {
+    // assets from the archive if there is one, loose files in data/ otherwise
+    if ( boost::filesystem::exists( "data/data.pack" ) ) {
+        PackFile::Mount( PackFile::Open( "data/data.pack" ) );
+    }
+
     int err = SDL_Init(SDL_INIT_VIDEO|SDL_INIT_JOYSTICK);
     ASSERT( err != -1, "Failed to initialize SDL video system! SDL Error: %s\n", SDL_GetError());
 
@@ -0,0 +1,432 @@
+/*
+ * blockdecoder.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "blockdecoder.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// split into jobs from this size on, and into chunks of at least this many pixels
+static const int _parallelMinPixels = 256*256;
+
+static inline uint32_t MakeColor( uint32_t r, uint32_t g, uint32_t b, uint32_t a )
+{
+    // B, G, R, A in memory
+    return b | ( g << 8 ) | ( r << 16 ) | ( a << 24 );
+}
+
+static inline uint16_t Read16( const unsigned char* p )
+{
+    return p[0] | ( p[1] << 8 );
+}
+
+static inline uint32_t Read32( const unsigned char* p )
+{
+    return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( uint32_t(p[3]) << 24 );
+}
+
+// 48 bit of 3 bit indices following the two end points of a BC3 alpha / BC4 block
+static inline uint64_t Read48( const unsigned char* p )
+{
+    uint64_t bits(0);
+    for ( int i = 0; i < 6; ++i ) {
+        bits |= uint64_t( p[i] ) << ( i*8 );
+    }
+    return bits;
+}
+
+// color part of BC1-3: two r5g6b5 end points and 2 bit indices. Alpha is 0xFF
+// unless BC1 uses the 3 color mode, where index 3 is transparent black
+static void DecodeColors( const unsigned char* block, bool hasTransparent, uint32_t out[16] )
+{
+    const uint32_t c0 = Read16( block );
+    const uint32_t c1 = Read16( block + 2 );
+
+    // r5g6b5 -> r8g8b8, top bits replicated into the low ones
+    int r0 = c0 >> 11, g0 = ( c0 >> 5 ) & 0x3F, b0 = c0 & 0x1F;
+    int r1 = c1 >> 11, g1 = ( c1 >> 5 ) & 0x3F, b1 = c1 & 0x1F;
+    r0 = r0 << 3 | r0 >> 2; g0 = g0 << 2 | g0 >> 4; b0 = b0 << 3 | b0 >> 2;
+    r1 = r1 << 3 | r1 >> 2; g1 = g1 << 2 | g1 >> 4; b1 = b1 << 3 | b1 >> 2;
+
+    uint32_t table[4];
+    table[0] = MakeColor( r0, g0, b0, 0xFF );
+    table[1] = MakeColor( r1, g1, b1, 0xFF );
+    if ( c0 > c1 || !hasTransparent ) {
+        table[2] = MakeColor( (2*r0+r1)/3, (2*g0+g1)/3, (2*b0+b1)/3, 0xFF );
+        table[3] = MakeColor( (r0+2*r1)/3, (g0+2*g1)/3, (b0+2*b1)/3, 0xFF );
+    } else {
+        table[2] = MakeColor( (r0+r1+1)/2, (g0+g1+1)/2, (b0+b1+1)/2, 0xFF );
+        table[3] = 0;
+    }
+
+    uint32_t indices = Read32( block + 4 );
+    for ( int i = 0; i < 16; ++i, indices >>= 2 ) {
+        out[i] = table[ indices & 0x03 ];
+    }
+}
+
+// BC2: 4 bit alpha per pixel
+static void DecodeExplicitAlpha( const unsigned char* block, uint32_t out[16] )
+{
+    for ( int i = 0; i < 16; ++i ) {
+        const uint32_t alpha = ( block[ i/2 ] >> ( ( i & 1 ) * 4 ) ) & 0x0F;
+        out[i] = ( out[i] & 0x00FFFFFF ) | ( alpha * 17 ) << 24;
+    }
+}
+
+// BC3 alpha, BC4 and both halves of BC5: two 8 bit end points and 3 bit indices
+static void DecodeChannel( const unsigned char* block, uint32_t out[16] )
+{
+    const uint32_t a0 = block[0];
+    const uint32_t a1 = block[1];
+    uint32_t table[8] = { a0, a1 };
+    if ( a0 > a1 ) {
+        for ( int i = 1; i < 7; ++i ) {
+            table[ i+1 ] = ( ( 7-i )*a0 + i*a1 ) / 7;
+        }
+    } else {
+        for ( int i = 1; i < 5; ++i ) {
+            table[ i+1 ] = ( ( 5-i )*a0 + i*a1 ) / 5;
+        }
+        table[6] = 0;
+        table[7] = 0xFF;
+    }
+
+    uint64_t indices = Read48( block + 2 );
+    for ( int i = 0; i < 16; ++i, indices >>= 3 ) {
+        out[i] = table[ indices & 0x07 ];
+    }
+}
+
+// one block as BGRA
+static void DecodeBlock( int compression, const unsigned char* block, uint32_t texels[16] )
+{
+    uint32_t channel[16];
+    switch ( compression ) {
+    case Brush::BC1:
+        DecodeColors( block, true, texels );
+        break;
+    case Brush::BC2:
+        DecodeColors( block + 8, false, texels );
+        DecodeExplicitAlpha( block, texels );
+        break;
+    case Brush::BC3:
+        DecodeColors( block + 8, false, texels );
+        DecodeChannel( block, channel );
+        for ( int i = 0; i < 16; ++i ) {
+            texels[i] = ( texels[i] & 0x00FFFFFF ) | channel[i] << 24;
+        }
+        break;
+    case Brush::BC4:
+        // red only, like GL samples RGTC1
+        DecodeChannel( block, channel );
+        for ( int i = 0; i < 16; ++i ) {
+            texels[i] = MakeColor( channel[i], 0, 0, 0xFF );
+        }
+        break;
+    case Brush::BC5:
+        DecodeChannel( block, texels );
+        DecodeChannel( block + 8, channel );
+        for ( int i = 0; i < 16; ++i ) {
+            texels[i] = MakeColor( texels[i], channel[i], 0, 0xFF );
+        }
+        break;
+    }
+}
+
+// write a decoded block, clipped to the image
+static inline void WriteBlock( const uint32_t texels[16], uint32_t* out, int x, int y, int width, int height )
+{
+    const int rows    = std::min( 4, height - y );
+    const int columns = std::min( 4, width - x );
+    for ( int j = 0; j < rows; ++j ) {
+        std::copy( texels + j*4, texels + j*4 + columns, out + ( y + j )*width + x );
+    }
+}
+
+// block rows [begin, end), one block at a time
+static void DecodeRowsScalar( int compression, const char* blocks, int width, int height, char* pixels, int begin, int end )
+{
+    const int blockSize = BlockDecoder::GetBlockSize( compression );
+    const int blocksX   = ( width + 3 ) / 4;
+    uint32_t texels[16];
+    for ( int by = begin; by < end; ++by ) {
+        const unsigned char* block = (const unsigned char*)blocks + std::size_t( by )*blocksX*blockSize;
+        for ( int bx = 0; bx < blocksX; ++bx, block += blockSize ) {
+            DecodeBlock( compression, block, texels );
+            WriteBlock( texels, (uint32_t*)pixels, bx*4, by*4, width, height );
+        }
+    }
+}
+
+#ifdef __SSE2__
+
+/*
+ * Four blocks per iteration, one per 32 bit lane: the palettes of all four
+ * are built at once, divisions by 3, 5 and 7 are fixed point multiplies.
+ * Texels are then picked a row of 4 at a time with compare masks instead
+ * of table lookups - SSE2 has no byte shuffle.
+ */
+
+// mask ? a : b
+static inline __m128i Select( __m128i mask, __m128i a, __m128i b )
+{
+    return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+// x / d for x < 2^16 in 32 bit lanes: (x * ceil(2^16/d)) >> 16 is exact for the ranges used here
+static inline __m128i DivideBy( __m128i x, int reciprocal )
+{
+    return _mm_mulhi_epu16( x, _mm_set1_epi32( reciprocal ) );
+}
+
+static inline __m128i MultiplyBy( __m128i x, int factor )
+{
+    return _mm_mullo_epi16( x, _mm_set1_epi32( factor ) );
+}
+
+static inline __m128i PackColor( __m128i r, __m128i g, __m128i b, __m128i a )
+{
+    return _mm_or_si128( _mm_or_si128( b, _mm_slli_epi32( g, 8 ) ), _mm_or_si128( _mm_slli_epi32( r, 16 ), a ) );
+}
+
+// palette entry x of lane b in table[x][b]
+static void MakeColorTables( const unsigned char* const block[4], bool hasTransparent, uint32_t table[4][4] )
+{
+    const __m128i c0 = _mm_set_epi32( Read16( block[3] ), Read16( block[2] ), Read16( block[1] ), Read16( block[0] ) );
+    const __m128i c1 = _mm_set_epi32( Read16( block[3]+2 ), Read16( block[2]+2 ), Read16( block[1]+2 ), Read16( block[0]+2 ) );
+    const __m128i mask5 = _mm_set1_epi32( 0x1F );
+    const __m128i mask6 = _mm_set1_epi32( 0x3F );
+    const __m128i alpha = _mm_set1_epi32( 0xFF000000 );
+
+    // r5g6b5 -> r8g8b8
+    __m128i r0 = _mm_srli_epi32( c0, 11 ), g0 = _mm_and_si128( _mm_srli_epi32( c0, 5 ), mask6 ), b0 = _mm_and_si128( c0, mask5 );
+    __m128i r1 = _mm_srli_epi32( c1, 11 ), g1 = _mm_and_si128( _mm_srli_epi32( c1, 5 ), mask6 ), b1 = _mm_and_si128( c1, mask5 );
+    r0 = _mm_or_si128( _mm_slli_epi32( r0, 3 ), _mm_srli_epi32( r0, 2 ) );
+    g0 = _mm_or_si128( _mm_slli_epi32( g0, 2 ), _mm_srli_epi32( g0, 4 ) );
+    b0 = _mm_or_si128( _mm_slli_epi32( b0, 3 ), _mm_srli_epi32( b0, 2 ) );
+    r1 = _mm_or_si128( _mm_slli_epi32( r1, 3 ), _mm_srli_epi32( r1, 2 ) );
+    g1 = _mm_or_si128( _mm_slli_epi32( g1, 2 ), _mm_srli_epi32( g1, 4 ) );
+    b1 = _mm_or_si128( _mm_slli_epi32( b1, 3 ), _mm_srli_epi32( b1, 2 ) );
+
+    const __m128i r01 = _mm_add_epi32( r0, r1 ), g01 = _mm_add_epi32( g0, g1 ), b01 = _mm_add_epi32( b0, b1 );
+    const __m128i t2 = PackColor( DivideBy( _mm_add_epi32( r01, r0 ), 0x5556 ), DivideBy( _mm_add_epi32( g01, g0 ), 0x5556 ),
+                                  DivideBy( _mm_add_epi32( b01, b0 ), 0x5556 ), alpha );
+    const __m128i t3 = PackColor( DivideBy( _mm_add_epi32( r01, r1 ), 0x5556 ), DivideBy( _mm_add_epi32( g01, g1 ), 0x5556 ),
+                                  DivideBy( _mm_add_epi32( b01, b1 ), 0x5556 ), alpha );
+    const __m128i one = _mm_set1_epi32( 1 );
+    const __m128i half = PackColor( _mm_srli_epi32( _mm_add_epi32( r01, one ), 1 ), _mm_srli_epi32( _mm_add_epi32( g01, one ), 1 ),
+                                    _mm_srli_epi32( _mm_add_epi32( b01, one ), 1 ), alpha );
+    const __m128i fourColors = hasTransparent ? _mm_cmpgt_epi32( c0, c1 ) : _mm_set1_epi32( -1 );
+
+    _mm_storeu_si128( (__m128i*)table[0], PackColor( r0, g0, b0, alpha ) );
+    _mm_storeu_si128( (__m128i*)table[1], PackColor( r1, g1, b1, alpha ) );
+    _mm_storeu_si128( (__m128i*)table[2], Select( fourColors, t2, half ) );
+    _mm_storeu_si128( (__m128i*)table[3], _mm_and_si128( fourColors, t3 ) );
+}
+
+static void MakeChannelTables( const unsigned char* const block[4], uint32_t table[8][4] )
+{
+    const __m128i a0 = _mm_set_epi32( block[3][0], block[2][0], block[1][0], block[0][0] );
+    const __m128i a1 = _mm_set_epi32( block[3][1], block[2][1], block[1][1], block[0][1] );
+    const __m128i eight = _mm_cmpgt_epi32( a0, a1 );
+
+    _mm_storeu_si128( (__m128i*)table[0], a0 );
+    _mm_storeu_si128( (__m128i*)table[1], a1 );
+    for ( int i = 1; i < 7; ++i ) {
+        __m128i e7 = DivideBy( _mm_add_epi32( MultiplyBy( a0, 7-i ), MultiplyBy( a1, i ) ), 0x2493 );
+        __m128i e5 = _mm_setzero_si128();
+        if ( i < 5 ) {
+            e5 = DivideBy( _mm_add_epi32( MultiplyBy( a0, 5-i ), MultiplyBy( a1, i ) ), 0x3334 );
+        } else if ( i == 6 ) {
+            e5 = _mm_set1_epi32( 0xFF );
+        }
+        _mm_storeu_si128( (__m128i*)table[ i+1 ], Select( eight, e7, e5 ) );
+    }
+}
+
+// row of 4 texels from 2 bit indices (bits 0-7) and a broadcast table
+static inline __m128i SelectColors( uint32_t indices, const __m128i t[4] )
+{
+    const __m128i bit0 = _mm_set_epi32( 1<<6, 1<<4, 1<<2, 1<<0 );
+    const __m128i bit1 = _mm_set_epi32( 1<<7, 1<<5, 1<<3, 1<<1 );
+    const __m128i v  = _mm_set1_epi32( indices );
+    const __m128i s0 = _mm_cmpeq_epi32( _mm_and_si128( v, bit0 ), bit0 );
+    const __m128i s1 = _mm_cmpeq_epi32( _mm_and_si128( v, bit1 ), bit1 );
+    return Select( s1, Select( s0, t[3], t[2] ), Select( s0, t[1], t[0] ) );
+}
+
+// row of 4 texels from 3 bit indices (bits 0-11)
+static inline __m128i SelectChannel( uint32_t indices, const __m128i t[8] )
+{
+    const __m128i bit0 = _mm_set_epi32( 1<<9,  1<<6, 1<<3, 1<<0 );
+    const __m128i bit1 = _mm_set_epi32( 1<<10, 1<<7, 1<<4, 1<<1 );
+    const __m128i bit2 = _mm_set_epi32( 1<<11, 1<<8, 1<<5, 1<<2 );
+    const __m128i v  = _mm_set1_epi32( indices );
+    const __m128i s0 = _mm_cmpeq_epi32( _mm_and_si128( v, bit0 ), bit0 );
+    const __m128i s1 = _mm_cmpeq_epi32( _mm_and_si128( v, bit1 ), bit1 );
+    const __m128i s2 = _mm_cmpeq_epi32( _mm_and_si128( v, bit2 ), bit2 );
+    return Select( s2, Select( s1, Select( s0, t[7], t[6] ), Select( s0, t[5], t[4] ) ),
+                       Select( s1, Select( s0, t[3], t[2] ), Select( s0, t[1], t[0] ) ) );
+}
+
+static inline void Broadcast( const uint32_t table[][4], int lane, int count, __m128i* out )
+{
+    for ( int i = 0; i < count; ++i ) {
+        out[i] = _mm_set1_epi32( table[i][lane] );
+    }
+}
+
+static void DecodeRowsSSE2( int compression, const char* blocks, int width, int height, char* pixels, int begin, int end )
+{
+    const int blockSize = BlockDecoder::GetBlockSize( compression );
+    const int blocksX   = ( width + 3 ) / 4;
+    const int colorOffset = compression == Brush::BC1 ? 0 : 8;
+    const bool hasColors  = compression <= Brush::BC3;
+    const __m128i rgbMask = _mm_set1_epi32( 0x00FFFFFF );
+    const __m128i alpha   = _mm_set1_epi32( 0xFF000000 );
+    uint32_t* out = (uint32_t*)pixels;
+
+    uint32_t colorTable[4][4], channelTable[2][8][4];
+    __m128i colors[4], channels[2][8];
+    for ( int by = begin; by < end; ++by ) {
+        const unsigned char* row = (const unsigned char*)blocks + std::size_t( by )*blocksX*blockSize;
+        for ( int bx = 0; bx < blocksX; bx += 4 ) {
+            // the last group repeats its last block - decoded, but not written
+            const int count = std::min( 4, blocksX - bx );
+            const unsigned char* block[4];
+            for ( int i = 0; i < 4; ++i ) {
+                block[i] = row + ( bx + std::min( i, count - 1 ) )*blockSize;
+            }
+            const unsigned char* channelBlock[2][4];
+            for ( int i = 0; i < 4; ++i ) {
+                channelBlock[0][i] = block[i];
+                channelBlock[1][i] = block[i] + 8;
+            }
+            if ( hasColors ) {
+                const unsigned char* colorBlock[4] = { block[0] + colorOffset, block[1] + colorOffset, block[2] + colorOffset, block[3] + colorOffset };
+                MakeColorTables( colorBlock, compression == Brush::BC1, colorTable );
+            }
+            if ( compression == Brush::BC3 || compression == Brush::BC4 || compression == Brush::BC5 ) {
+                MakeChannelTables( channelBlock[0], channelTable[0] );
+            }
+            if ( compression == Brush::BC5 ) {
+                MakeChannelTables( channelBlock[1], channelTable[1] );
+            }
+
+            for ( int b = 0; b < count; ++b ) {
+                const unsigned char* p = block[b];
+                const int x = ( bx + b )*4;
+                const int y = by*4;
+                uint32_t colorIndices(0);
+                uint64_t channelIndices[2] = { 0, 0 };
+                if ( hasColors ) {
+                    Broadcast( colorTable, b, 4, colors );
+                    colorIndices = Read32( p + colorOffset + 4 );
+                }
+                if ( compression >= Brush::BC3 ) {
+                    Broadcast( channelTable[0], b, 8, channels[0] );
+                    channelIndices[0] = Read48( p + 2 );
+                }
+                if ( compression == Brush::BC5 ) {
+                    Broadcast( channelTable[1], b, 8, channels[1] );
+                    channelIndices[1] = Read48( p + 10 );
+                }
+
+                __m128i texels[4];
+                for ( int j = 0; j < 4; ++j ) {
+                    __m128i v;
+                    switch ( compression ) {
+                    case Brush::BC1:
+                        v = SelectColors( colorIndices >> ( j*8 ), colors );
+                        break;
+                    case Brush::BC2: {
+                        const uint32_t nibbles = Read16( p + j*2 );
+                        const __m128i a = _mm_set_epi32( nibbles >> 12, ( nibbles >> 8 ) & 0x0F, ( nibbles >> 4 ) & 0x0F, nibbles & 0x0F );
+                        v = _mm_or_si128( _mm_and_si128( SelectColors( colorIndices >> ( j*8 ), colors ), rgbMask ),
+                                          _mm_slli_epi32( MultiplyBy( a, 17 ), 24 ) );
+                        break;
+                    }
+                    case Brush::BC3:
+                        v = _mm_or_si128( _mm_and_si128( SelectColors( colorIndices >> ( j*8 ), colors ), rgbMask ),
+                                          _mm_slli_epi32( SelectChannel( uint32_t( channelIndices[0] >> ( j*12 ) ), channels[0] ), 24 ) );
+                        break;
+                    case Brush::BC4:
+                        v = _mm_or_si128( _mm_slli_epi32( SelectChannel( uint32_t( channelIndices[0] >> ( j*12 ) ), channels[0] ), 16 ), alpha );
+                        break;
+                    default:
+                        v = _mm_or_si128( _mm_or_si128( _mm_slli_epi32( SelectChannel( uint32_t( channelIndices[0] >> ( j*12 ) ), channels[0] ), 16 ),
+                                                        _mm_slli_epi32( SelectChannel( uint32_t( channelIndices[1] >> ( j*12 ) ), channels[1] ), 8 ) ),
+                                          alpha );
+                        break;
+                    }
+                    texels[j] = v;
+                }
+
+                if ( x + 4 <= width && y + 4 <= height ) {
+                    for ( int j = 0; j < 4; ++j ) {
+                        _mm_storeu_si128( (__m128i*)( out + ( y + j )*width + x ), texels[j] );
+                    }
+                } else {
+                    uint32_t clipped[16];
+                    for ( int j = 0; j < 4; ++j ) {
+                        _mm_storeu_si128( (__m128i*)( clipped + j*4 ), texels[j] );
+                    }
+                    WriteBlock( clipped, out, x, y, width, height );
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+int BlockDecoder::GetBlockSize( int compression ) throw(std::exception)
+{
+    switch ( compression ) {
+    case Brush::BC1:
+    case Brush::BC4: return 8;
+    case Brush::BC2:
+    case Brush::BC3:
+    case Brush::BC5: return 16;
+    default: THROW( "Not a block compressed format (%d)", compression ); break;
+    }
+    return 0;
+}
+
+std::size_t BlockDecoder::GetSize( int compression, int width, int height ) throw(std::exception)
+{
+    return std::size_t( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * GetBlockSize( compression );
+}
+
+void BlockDecoder::Decode( int compression, const char* blocks, int width, int height, char* pixels, JobQueuePtr jobQueue ) throw(std::exception)
+{
+    GetBlockSize( compression );
+    const int blockRows = ( height + 3 ) / 4;
+#ifdef __SSE2__
+    JobQueue::RangeJob rows = boost::bind( &DecodeRowsSSE2, compression, blocks, width, height, pixels, _1, _2 );
+#else
+    JobQueue::RangeJob rows = boost::bind( &DecodeRowsScalar, compression, blocks, width, height, pixels, _1, _2 );
+#endif
+    // block rows don't overlap in the output - no locking
+    if ( jobQueue && width*height >= _parallelMinPixels ) {
+        jobQueue->ParallelFor( 0, blockRows, rows, std::max( _parallelMinPixels / ( width*4 ), 1 ) );
+    } else {
+        rows( 0, blockRows );
+    }
+}
+
+void BlockDecoder::DecodeScalar( int compression, const char* blocks, int width, int height, char* pixels ) throw(std::exception)
+{
+    GetBlockSize( compression );
+    DecodeRowsScalar( compression, blocks, width, height, pixels, 0, ( height + 3 ) / 4 );
+}
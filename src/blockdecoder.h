@@ -0,0 +1,46 @@
+/*
+ * blockdecoder.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef BLOCKDECODER_H_
+#define BLOCKDECODER_H_
+
+#include "err.h"
+#include "brush.h"
+#include "jobqueue.h"
+
+#include <cstddef>
+
+/*!
+ * CPU decoder for block compressed (BC1-5) brushes. Only used when the GL
+ * can't take the blocks as they are - without EXT_texture_compression_s3tc
+ * or ARB_texture_compression_rgtc, i.e. software GL.
+ * Decodes into BGRA like the other brushes, little endian only. BC4 and BC5
+ * end up in red and red/green like GL samples them.
+ */
+class BlockDecoder
+{
+public:
+    // bytes per 4x4 block of a Brush::Compression
+    static int GetBlockSize( int compression ) throw(std::exception);
+
+    // bytes of all blocks of a width x height image
+    static std::size_t GetSize( int compression, int width, int height ) throw(std::exception);
+
+    /*!
+     * Decode width x height pixels into pixels - 4 bytes per pixel, no
+     * padding. Blocks on the right and bottom edge are clipped.
+     * Four blocks at a time with SSE2, large images are split into block
+     * rows on the job queue.
+     */
+    static void Decode( int compression, const char* blocks, int width, int height, char* pixels,
+                        JobQueuePtr jobQueue = JobQueuePtr() ) throw(std::exception);
+
+    // one block at a time, one thread - the reference for Decode()
+    static void DecodeScalar( int compression, const char* blocks, int width, int height, char* pixels ) throw(std::exception);
+};
+
+#endif /* BLOCKDECODER_H_ */
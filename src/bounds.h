@@ -0,0 +1,186 @@
+/*
+ * bounds.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef BOUNDS_H_
+#define BOUNDS_H_
+
+#include "err.h"
+#include "vector.h"
+#include "matrix.h"
+
+#include <limits>
+#include <algorithm>
+
+/*!
+ * Transform a point by an OpenGL (column major) matrix. Returns the full
+ * homogeneous result - w is not divided out.
+ */
+inline Vector TransformPoint( const Matrix& m, const Vector& v )
+{
+    const float* a = m;
+    return Vector( a[0]*v[Vector::X] + a[4]*v[Vector::Y] + a[8] *v[Vector::Z] + a[12]*v[Vector::W],
+                   a[1]*v[Vector::X] + a[5]*v[Vector::Y] + a[9] *v[Vector::Z] + a[13]*v[Vector::W],
+                   a[2]*v[Vector::X] + a[6]*v[Vector::Y] + a[10]*v[Vector::Z] + a[14]*v[Vector::W],
+                   a[3]*v[Vector::X] + a[7]*v[Vector::Y] + a[11]*v[Vector::Z] + a[15]*v[Vector::W] );
+}
+
+/*!
+ * Rectangle in normalized device coordinates (-1..1) plus the depth range
+ * (window depth 0..1) of whatever has been projected into it.
+ */
+struct ScreenRect
+{
+    float m_MinX, m_MinY;
+    float m_MaxX, m_MaxY;
+    float m_MinZ, m_MaxZ;
+
+    bool Overlaps( const ScreenRect& o ) const
+    {
+        return m_MinX <= o.m_MaxX && o.m_MinX <= m_MaxX &&
+               m_MinY <= o.m_MaxY && o.m_MinY <= m_MaxY;
+    }
+
+    ScreenRect& Merge( const ScreenRect& o )
+    {
+        m_MinX = std::min( m_MinX, o.m_MinX ); m_MaxX = std::max( m_MaxX, o.m_MaxX );
+        m_MinY = std::min( m_MinY, o.m_MinY ); m_MaxY = std::max( m_MaxY, o.m_MaxY );
+        m_MinZ = std::min( m_MinZ, o.m_MinZ ); m_MaxZ = std::max( m_MaxZ, o.m_MaxZ );
+        return *this;
+    }
+};
+
+/*!
+ * Axis aligned bounding box. An empty box has min > max. Like Vector this is
+ * a plain value type - no vtable, everything inlined.
+ */
+struct BoundingBox
+{
+    Vector m_Min;
+    Vector m_Max;
+
+    BoundingBox()
+        : m_Min(  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max() )
+        , m_Max( -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() )
+    {
+    }
+
+    BoundingBox( const Vector& min, const Vector& max )
+        : m_Min( min )
+        , m_Max( max )
+    {
+    }
+
+    bool IsEmpty() const
+    {
+        return m_Min[Vector::X] > m_Max[Vector::X];
+    }
+
+    void Clear()
+    {
+        *this = BoundingBox();
+    }
+
+    BoundingBox& Add( const Vector& p )
+    {
+        m_Min[Vector::X] = std::min( m_Min[Vector::X], p[Vector::X] );
+        m_Min[Vector::Y] = std::min( m_Min[Vector::Y], p[Vector::Y] );
+        m_Min[Vector::Z] = std::min( m_Min[Vector::Z], p[Vector::Z] );
+        m_Max[Vector::X] = std::max( m_Max[Vector::X], p[Vector::X] );
+        m_Max[Vector::Y] = std::max( m_Max[Vector::Y], p[Vector::Y] );
+        m_Max[Vector::Z] = std::max( m_Max[Vector::Z], p[Vector::Z] );
+        return *this;
+    }
+
+    BoundingBox& Merge( const BoundingBox& o )
+    {
+        if ( !o.IsEmpty() ) {
+            Add( o.m_Min );
+            Add( o.m_Max );
+        }
+        return *this;
+    }
+
+    Vector GetCorner( int i ) const
+    {
+        // bit 0: x, bit 1: y, bit 2: z
+        return Vector( (i & 1) ? m_Max[Vector::X] : m_Min[Vector::X],
+                       (i & 2) ? m_Max[Vector::Y] : m_Min[Vector::Y],
+                       (i & 4) ? m_Max[Vector::Z] : m_Min[Vector::Z] );
+    }
+
+    Vector GetCenter() const
+    {
+        return Vector( (m_Min[Vector::X] + m_Max[Vector::X]) * 0.5f,
+                       (m_Min[Vector::Y] + m_Max[Vector::Y]) * 0.5f,
+                       (m_Min[Vector::Z] + m_Max[Vector::Z]) * 0.5f );
+    }
+
+    /*!
+     * Box enclosing this box after transformation by matrix (8 corners).
+     */
+    BoundingBox Transformed( const Matrix& m ) const
+    {
+        BoundingBox box;
+        if ( !IsEmpty() ) {
+            for ( int i = 0; i < 8; ++i ) {
+                box.Add( TransformPoint( m, GetCorner(i) ) );
+            }
+        }
+        return box;
+    }
+
+    /*!
+     * Project into NDC with a model-view-projection matrix. Returns false if
+     * the box reaches behind the near plane - in that case the rect is
+     * meaningless and the caller must treat the box as visible.
+     */
+    bool Project( const Matrix& mvp, ScreenRect& rect ) const
+    {
+        rect.m_MinX = rect.m_MinY = rect.m_MinZ = std::numeric_limits<float>::max();
+        rect.m_MaxX = rect.m_MaxY = rect.m_MaxZ = -std::numeric_limits<float>::max();
+        for ( int i = 0; i < 8; ++i ) {
+            Vector c = TransformPoint( mvp, GetCorner(i) );
+            float w = c[Vector::W];
+            if ( w <= 1e-5f ) {
+                return false;
+            }
+            float iw = 1.0f / w;
+            float x = c[Vector::X] * iw;
+            float y = c[Vector::Y] * iw;
+            float z = c[Vector::Z] * iw * 0.5f + 0.5f;
+            rect.m_MinX = std::min( rect.m_MinX, x ); rect.m_MaxX = std::max( rect.m_MaxX, x );
+            rect.m_MinY = std::min( rect.m_MinY, y ); rect.m_MaxY = std::max( rect.m_MaxY, y );
+            rect.m_MinZ = std::min( rect.m_MinZ, z ); rect.m_MaxZ = std::max( rect.m_MaxZ, z );
+        }
+        return true;
+    }
+
+    /*!
+     * Frustum test in clip space. False only if all corners are outside the
+     * same clip plane - boxes crossing the near plane are handled correctly.
+     */
+    bool Intersects( const Matrix& mvp ) const
+    {
+        int outside[6] = { 0 };
+        for ( int i = 0; i < 8; ++i ) {
+            Vector c = TransformPoint( mvp, GetCorner(i) );
+            float w = c[Vector::W];
+            outside[0] += c[Vector::X] < -w;
+            outside[1] += c[Vector::X] >  w;
+            outside[2] += c[Vector::Y] < -w;
+            outside[3] += c[Vector::Y] >  w;
+            outside[4] += c[Vector::Z] < -w;
+            outside[5] += c[Vector::Z] >  w;
+        }
+        for ( int p = 0; p < 6; ++p ) {
+            if ( outside[p] == 8 ) return false;
+        }
+        return true;
+    }
+};
+
+#endif /* BOUNDS_H_ */
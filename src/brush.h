@@ -10,11 +10,73 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <cstddef>
+
 struct Brush {
+    enum Compression {
+        NONE,       /* m_Pixels are raw BGR(A) pixels */
+        BC1,        /* DXT1, 1 bit alpha */
+        BC2,        /* DXT3 */
+        BC3,        /* DXT5 */
+        BC4,        /* ATI1, one channel */
+        BC5,        /* ATI2, two channels */
+        RLE,        /* TGA run length packets of raw pixels, level 0 only */
+    };
+    enum {
+        MAX_DIMENSION = 16384,      /* larger is a corrupt header - all levels fit m_Size */
+    };
     unsigned int   m_Width;
     unsigned int   m_Height;
-    unsigned int   m_BytesPerPixel; /* 3:RGB, 4:RGBA */
+    unsigned int   m_BytesPerPixel; /* 1:luminance, 3:RGB, 4:RGBA */
+    unsigned int   m_Compression;   /* m_Pixels are 4x4 blocks (or packets) of m_Size bytes if not NONE */
+    unsigned int   m_Size;          /* all levels */
+    unsigned int   m_NumLevels;     /* mip levels in m_Pixels, largest first and tightly packed. 1: no mips */
     const char    *m_Pixels;
+    unsigned int   m_Pitch;         /* bytes per row of a raw level 0 without mips. 0: tightly packed */
+    bool           m_TopDown;       /* first row is the top one - GL wants the bottom one first */
+
+    unsigned int GetLevelWidth( unsigned int level ) const
+    {
+        return m_Width >> level ? m_Width >> level : 1;
+    }
+
+    unsigned int GetLevelHeight( unsigned int level ) const
+    {
+        return m_Height >> level ? m_Height >> level : 1;
+    }
+
+    std::size_t GetLevelSize( unsigned int level ) const
+    {
+        const std::size_t width  = GetLevelWidth( level );
+        const std::size_t height = GetLevelHeight( level );
+        switch ( m_Compression ) {
+        case NONE: return width * height * m_BytesPerPixel;
+        case RLE:  return m_Size;
+        case BC1:
+        case BC4:  return ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * 8;
+        default:   return ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * 16;
+        }
+    }
+
+    /*!
+     * For loaders, once per file: the header's image size is sane and bytes
+     * at offset lie within a file of size bytes - for any header values.
+     * Decoders trust brushes that passed it.
+     */
+    static bool IsValid( unsigned int width, unsigned int height, std::size_t offset, std::size_t bytes, std::size_t size )
+    {
+        return width > 0 && height > 0 && width <= MAX_DIMENSION && height <= MAX_DIMENSION &&
+               offset <= size && bytes <= size - offset;
+    }
+
+    const char* GetLevel( unsigned int level ) const
+    {
+        const char* pixels = m_Pixels;
+        for ( unsigned int i = 0; i < level; ++i ) {
+            pixels += GetLevelSize( i );
+        }
+        return pixels;
+    }
 };
 
 typedef boost::shared_ptr<Brush> BrushPtr;
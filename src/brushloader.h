@@ -9,6 +9,7 @@
 #define BRUSHLOADER_H_
 
 #include "err.h"
+#include "packfile.h"
 
 #include <bmp_loader.h>
 #include <dds_loader.h>
@@ -16,15 +17,23 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cctype>
+#include <string>
+
 template < class T >
 BrushPtr LoadBrush( const char* name ) throw(std::exception)
 {
     BrushPtr brushPtr;
     try {
         T* brush( new T );
-        std::string file("data/");
-        file += name;
-        ASSERT( brush->Load( file.c_str() ), "Error loading base texture" );
+        PackFile::Data data;
+        if ( PackFile::Resolve( name, data ) ) {
+            ASSERT( brush->Load( name, data.m_Data, data.m_Size, data.m_Source ), "Error loading base texture" );
+        } else {
+            std::string file("data/");
+            file += name;
+            ASSERT( brush->Load( file.c_str() ), "Error loading base texture" );
+        }
         brushPtr = BrushPtr(brush);
     } catch ( boost::filesystem::filesystem_error &ex ) {
         THROW( "Error loading texture '%s'.\n%s", name, ex.what() );
@@ -41,5 +50,21 @@ BrushPtr LoadBrush( const char* name ) throw(std::exception)
     return brushPtr;
 }
 
+/*!
+ * Brush type by file extension - .tga, .bmp or .dds
+ */
+inline BrushPtr LoadBrush( const char* name ) throw(std::exception)
+{
+    std::string extension = boost::filesystem::path( name ).extension().string();
+    for ( auto& c : extension ) {
+        c = std::tolower( c );
+    }
+    if ( extension == ".tga" ) return LoadBrush<TgaBrush>( name );
+    if ( extension == ".bmp" ) return LoadBrush<BmpBrush>( name );
+    if ( extension == ".dds" ) return LoadBrush<DdsBrush>( name );
+    THROW( "Unknown texture type '%s'", name );
+    return BrushPtr();
+}
+
 
 #endif /* BRUSHLOADER_H_ */
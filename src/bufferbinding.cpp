@@ -0,0 +1,39 @@
+/*
+ * bufferbinding.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "bufferbinding.h"
+
+// GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER
+static GLuint _bound[2] = { 0, 0 };
+
+static inline GLuint* Slot( GLenum target )
+{
+    switch ( target ) {
+    case GL_ARRAY_BUFFER:         return &_bound[0];
+    case GL_ELEMENT_ARRAY_BUFFER: return &_bound[1];
+    default:                      return nullptr;
+    }
+}
+
+void BufferBinding::Bind( GLenum target, GLuint buffer )
+{
+    GLuint* bound = Slot( target );
+    if ( bound ) {
+        if ( *bound == buffer ) return;
+        *bound = buffer;
+    }
+    glBindBuffer( target, buffer );
+}
+
+void BufferBinding::Forget( GLuint buffer )
+{
+    for ( auto& bound : _bound ) {
+        if ( bound == buffer ) {
+            bound = 0;
+        }
+    }
+}
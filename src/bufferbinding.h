@@ -0,0 +1,30 @@
+/*
+ * bufferbinding.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef BUFFERBINDING_H_
+#define BUFFERBINDING_H_
+
+#include <GL/glew.h>
+
+/*!
+ * glBindBuffer() that remembers what is bound to GL_ARRAY_BUFFER and
+ * GL_ELEMENT_ARRAY_BUFFER and skips binding it again. Meshes leave the
+ * geometry arena bound between draws, so every bind of these two targets
+ * must go through here - a glBindBuffer() behind its back leaves the next
+ * mesh drawing from the wrong buffer. Other targets are passed on.
+ * Render thread only.
+ */
+class BufferBinding
+{
+public:
+    static void Bind( GLenum target, GLuint buffer );
+
+    // before glDeleteBuffers() - GL unbinds a deleted buffer, and its name is reused
+    static void Forget( GLuint buffer );
+};
+
+#endif /* BUFFERBINDING_H_ */
@@ -7,8 +7,10 @@
  */
 
 #include "cube.h"
+#include "renderer.h"
 #include "err.h"
 
+
 // cube ///////////////////////////////////////////////////////////////////////
 //    v6----- v5
 //   /|      /|
@@ -100,121 +102,86 @@ GLfloat texCoords[] = { 1,1,  0,1,  0,0,      // v0-v1-v2 (front)
 };
 
 Cube::Cube()
-    : m_VboID(0)
 {
     GetRenderState()->SetFlag( BLEND_COLOR_F );
+    SetBounds( BoundingBox( Vector( -1, -1, -1 ), Vector( 1, 1, 1 ) ) );
 }
 
-Cube::Cube( std::vector<BrushPtr> assetList )
-    : m_VboID(0)
-    , m_Assets( assetList )
+Cube::Cube( std::vector<std::string> assetList )
+    : m_Assets( assetList )
 {
     GetRenderState()->SetFlag( BLEND_COLOR_F );
+    SetBounds( BoundingBox( Vector( -1, -1, -1 ), Vector( 1, 1, 1 ) ) );
 }
 
 Cube::~Cube()
 {
-    if ( m_VboID > 0 ) {
-        glDeleteBuffers(1, &m_VboID);
+}
+
+void Cube::MakeCube( MeshData& data )
+{
+    // the four arrays as streams, uploaded interleaved and compact
+    const int numVertices = 36;
+    for ( int v = 0; v < numVertices; ++v ) {
+        data.m_Streams[ Mesh::POSITION ].push_back( Vector( vertices[v*3], vertices[v*3+1], vertices[v*3+2] ) );
+        data.m_Streams[ Mesh::NORMAL ].push_back( Vector( normals[v*3], normals[v*3+1], normals[v*3+2] ) );
+        data.m_Streams[ Mesh::COLOR ].push_back( Vector( colors[v*4], colors[v*4+1], colors[v*4+2], colors[v*4+3] ) );
+        data.m_Streams[ Mesh::TEXCOORD ].push_back( Vector( texCoords[v*2], texCoords[v*2+1], 0 ) );
     }
+    data.m_Bounds = BoundingBox( Vector( -1, -1, -1 ), Vector( 1, 1, 1 ) );
 }
 
-bool Cube::DoInitialize( Renderer* renderer ) throw(std::exception)
+std::string Cube::GetMeshKey()
+{
+    return MeshCache::MakeKey( "cube", "" );
+}
+
+MeshCache::Builder Cube::GetMeshBuilder()
 {
-    bool hasVBO = glewGetExtension("GL_ARB_vertex_buffer_object");
-    ASSERT( hasVBO, "VBOs not supported!" );
+    return &Cube::MakeCube;
+}
 
+bool Cube::DoInitialize( Renderer* renderer ) throw(std::exception)
+{
     if ( m_Assets.size() ) {
         for (auto& asset : m_Assets ) {
-            TexturePtr texture( new Texture );
-            texture->Load( *asset.get() );
-            m_Textures.push_back( texture );
+            m_Textures.push_back( renderer->GetTextureCache()->Get( asset ) );
         }
         GetRenderState()->ClearFlag( BLEND_COLOR_F );
     }
 
-    glGenBuffers(1, &m_VboID);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VboID);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices)+sizeof(normals)+sizeof(colors)+sizeof(texCoords), 0, GL_STATIC_DRAW_ARB);
-    std::size_t offset(0);
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(vertices), vertices);                             // copy vertices starting from 0 offest
-    offset += sizeof(vertices);
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(normals), normals);                // copy normals after vertices
-    offset += sizeof(normals);
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(colors), colors);  // copy colors after normals
-    if ( m_Textures.size() ) {
-        offset += sizeof(texCoords);
-        glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(texCoords), texCoords);  // copy colors after normals
-    }
+    // textured or not, all cubes use the same buffer
+    m_Mesh = renderer->GetMeshCache()->Get( GetMeshKey(), GetMeshBuilder() );
     return true;
 }
 
 void Cube::DoRender( int pass ) throw(std::exception)
 {
-    int normalArrayEnabled;
-    int colorArrayEnabled;
-    int vertexArrayEnabled;
-    int texCoordArrayEnabled;
-
-    // enable vertex arrays
-    glGetIntegerv( GL_NORMAL_ARRAY, &normalArrayEnabled );
-    if ( !normalArrayEnabled )  {
-        glEnableClientState(GL_NORMAL_ARRAY);
-    }
-    glGetIntegerv( GL_COLOR_ARRAY, &colorArrayEnabled );
-    if ( !colorArrayEnabled && (GetRenderState()->GetFlags() & BLEND_COLOR_F) ) {
-        glEnableClientState(GL_COLOR_ARRAY);
-    }
-    glGetIntegerv( GL_VERTEX_ARRAY, &vertexArrayEnabled );
-    if (!vertexArrayEnabled) {
-        glEnableClientState(GL_VERTEX_ARRAY);
+    unsigned int attributes = Mesh::POSITION_F | Mesh::NORMAL_F;
+    if ( GetRenderState()->GetFlags() & BLEND_COLOR_F ) {
+        attributes |= Mesh::COLOR_F;
     }
-    glGetIntegerv( GL_TEXTURE_COORD_ARRAY, &texCoordArrayEnabled );
-    if ( m_Textures.size() && !texCoordArrayEnabled ) {
-        if (!texCoordArrayEnabled) {
-            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        }
+    if ( m_Textures.size() ) {
+        attributes |= Mesh::TEXCOORD_F;
     }
 
     int blend_enabled;
     glGetIntegerv(GL_BLEND, &blend_enabled);
 
-    // Render with VBO - if available
-    glBindBuffer(GL_ARRAY_BUFFER, m_VboID);
-    // before draw, specify vertex and index arrays with their offsets
-    std::size_t offset(0);
-    glVertexPointer(3, GL_FLOAT, 0, (void*)offset); offset += sizeof(vertices);
-    glNormalPointer(   GL_FLOAT, 0, (void*)offset); offset += sizeof(normals);
-    glColorPointer (4, GL_FLOAT, 0, (void*)offset);
+    unsigned int enabled = m_Mesh->Enable( attributes );
     if ( m_Textures.size()) {
         m_Textures[0]->Enable();
-        offset += sizeof(texCoords);
-        glTexCoordPointer(2, GL_FLOAT, 0, (void*)offset );
         if (blend_enabled) {
             glDisable( GL_BLEND );
         }
     }
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_Mesh->Draw();
 
     if ( m_Textures.size() ) {
         m_Textures[0]->Disable();
-        if (!texCoordArrayEnabled) {
-            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-        }
         if (blend_enabled) {
             glEnable( GL_BLEND );
         }
     }
-    if (!vertexArrayEnabled)  {
-        glDisableClientState(GL_VERTEX_ARRAY);  // disable vertex arrays
-    }
-    if (!colorArrayEnabled)   {
-        glDisableClientState(GL_COLOR_ARRAY);
-    }
-    if (!normalArrayEnabled) {
-        glDisableClientState(GL_NORMAL_ARRAY);
-    }
-
+    m_Mesh->Disable( enabled );
 }
@@ -11,6 +11,8 @@
 #include "entity.h"
 #include "brush.h"
 #include "texture.h"
+#include "mesh.h"
+#include "meshcache.h"
 
 #include <GL/glew.h>
 
@@ -22,17 +24,24 @@ public:
         BLEND_COLOR_F = 1<<RenderState::USER_B
     };
 private:
-	GLuint m_VboID;
+	MeshPtr m_Mesh;     // one mesh for all cubes
 
 protected:
-	std::vector<BrushPtr>    m_Assets;
+	std::vector<std::string> m_Assets;     // texture files, relative to data/
 	std::vector<TexturePtr>  m_Textures;
 public:
 	Cube();
 
-	Cube( std::vector<BrushPtr> assetList );
+	Cube( std::vector<std::string> assetList );
 
 	virtual ~Cube();
+
+	virtual MeshPtr GetMesh() const { return m_Mesh; }
+
+	// MeshCache key and builder of the cube - shared with the meshcook tool
+	static std::string GetMeshKey();
+
+	static MeshCache::Builder GetMeshBuilder();
 protected:
 	virtual bool DoInitialize( Renderer* renderer ) throw(std::exception);
 
@@ -40,6 +49,9 @@ protected:
 
 	virtual void DoUpdate( float ticks ) throw(std::exception) {}
 
+private:
+	static void MakeCube( MeshData& data );
+
 };
 
 
@@ -1,31 +1,37 @@
 #include "cylinder.h"
+#include "renderer.h"
+#include "meshoptimizer.h"
+#include "sincostable.h"
 
 #include <GL/glew.h>
 
 #include <cmath>
+#include <algorithm>
 
 #include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
 
 const int _columns = 32;
 const int _rows    = 2;
 
+// each level halves the columns. Minimum projected diameter in pixels
+const int   _numLods = 3;
+const float _lodMinSize[ _numLods ] = { 160.0f, 48.0f, 0.0f };
+
+// levels with fewer vertices are generated on the calling thread
+const int   _parallelMinVertices = 16384;
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 Cylinder::Cylinder( float length /* = 1.0f */ )
-    : m_Buffers( { -1 } )
-    , m_Stride(1) // needed if/when we pack color + vertex into one array
-    , m_VertexBuffer( _columns*_rows*m_Stride )    // use the same memory pool for vertex and texture coords
-    , m_ColorBuffer( _columns*_rows*m_Stride )
-    , m_Radius(1.0f)
+    : m_Radius(1.0f)
 {
 }
 
 Cylinder::~Cylinder()
 {
-    // shouldn't be done in d'tor...might be weakly linked to e.g. event handler...but vbo must be released from render thread
-    glDeleteBuffers( MAX_BUFFERS, (GLuint*)m_Buffers);
 }
 
 void Cylinder::SetColors( const Vector& colorFrom, const Vector& colorTo )
@@ -34,184 +40,186 @@ void Cylinder::SetColors( const Vector& colorFrom, const Vector& colorTo )
     m_ColorTo   = colorTo;
 }
 
-void Cylinder::MakeCylinder( float columns, float rows )
+// one level of detail, shared by the ring kernels
+struct CylinderLod
 {
-    const float RAD360 = M_PI*2; // 2*PI in RAD
-
-    int lastColumn = columns - 1;
-    int lastRow = rows;
-    ++rows; // one extra row to top off the poly
+    int            m_Columns;
+    int            m_Rings;        // rows + 1
+    float          m_Radius;
+    float          m_Height;
+    SinCosTable    m_Phi;          // per column
+    Vector*        m_Vertices;     // planar streams
+    Vector*        m_Normals;
+    Vector*        m_Colors;
+    unsigned int*  m_Indices;      // 6 per vertex of all but the last ring
+
+    CylinderLod( int columns, int rings, float radius, float height )
+        : m_Columns( columns )
+        , m_Rings( rings )
+        , m_Radius( radius )
+        , m_Height( height )
+        , m_Phi( columns, float(M_PI*2)/columns )
+    {
+    }
+};
 
-    // Add two extra vertices at center bottom and top
-    m_VertexBuffer.resize( columns*rows*m_Stride + 2 );
-    m_NormalBuffer.resize( columns*rows*m_Stride + 2 );
-    m_ColorBuffer.resize( columns*rows*m_Stride + 2 );
+// rings [begin, end) - vertices, normals, colors and the two triangles of each quad. Called from workers
+static void MakeCylinderRings( const CylinderLod& lod, int begin, int end )
+{
+    const int columns    = lod.m_Columns;
+    const int lastColumn = columns - 1;
+    const int lastRing   = lod.m_Rings - 1;
+    for ( int y = begin; y < end; ++y ) {
+        const float vpy = float(y) / lastRing * lod.m_Height - lod.m_Height/2;
+        const Vector ringColor( 1.0f - float(y)/lod.m_Rings, 1.0f, float(y)/lod.m_Rings, 1.0f );
+        Vector* vertex = lod.m_Vertices + y*columns;
+        Vector* normal = lod.m_Normals  + y*columns;
+        Vector* color  = lod.m_Colors   + y*columns;
+        for ( int x = 0; x < columns; ++x ) {
+            // normal points away from the axis (at y pos)
+            const float cosPhi = lod.m_Phi.Cos( x );
+            const float sinPhi = lod.m_Phi.Sin( x );
+            vertex[x] = Vector( cosPhi * lod.m_Radius, vpy, sinPhi * lod.m_Radius );
+            normal[x] = Vector( cosPhi, 0, sinPhi );
+            color[x]  = ringColor;
+        }
 
-    // generate index array; we got rows * columns * 2 tris
-    m_IndexArray.resize( columns * rows * 3 * 2 + columns*3*2 ); // 3 vertices per tri, 2 tri per quad = 6 entries per iteration
+        // skip last row - already indexed
+        if ( y == lastRing ) continue;
+
+        const int row     = y*columns;
+        const int nextRow = row + columns;
+        unsigned int* index = lod.m_Indices + row*6;
+        for ( int x = 0; x < columns; ++x ) {
+            const int x0 = x == lastColumn ? 0 : x;
+            const int x1 = x + 1 >= lastColumn ? x + 1 - lastColumn : x + 1;
+            // top tri
+            *index++ = x0 + row;        // 0x0
+            *index++ = x1 + row;        // 1x0
+            *index++ = x0 + nextRow;    // 1x1 - bottom row
+            // bottom tri
+            *index++ = x1 + row;        // 0x0
+            *index++ = x1 + nextRow;    // 0x1 - bottom row
+            *index++ = x0 + nextRow;    // 1x1 - bottom row
+        }
+    }
+}
 
+void Cylinder::MakeCylinderLod( int columns, int rows, float radius, JobQueuePtr jobQueue,
+                                std::vector<Vector>& vertexBuffer, std::vector<unsigned int>& indexArray )
+{
     const float height = 6;
-    auto vit = m_VertexBuffer.begin();
-    auto nit = m_NormalBuffer.begin();
-    auto cit = m_ColorBuffer.begin();
-    int looper(0);
-
-    // need one extra ring to close the gap (overlaps 0)
-    float segmentSize  = RAD360/columns;
-    for( float y = 0; y < rows; ++y ){  // must <= because 2 "rows" are actually 3 vertex rings
-        std::vector< Vector > segments;
-        float vpy = y / lastRow * height - height/2;
-        for( float x = 0; x < columns; ++x ) { //0-2PI
-            float phi = x * segmentSize;
-            // vertex
-            auto& vertex = *vit; ++vit;
-            // Cylinder
-            vertex[ Vector::X ] = std::cos(phi) * m_Radius; //std::cos(theta) * std::sin(phi);
-            vertex[ Vector::Y ] = vpy; // std::sin(theta) * std::cos(phi);
-            vertex[ Vector::Z ] = std::sin(phi) * m_Radius; // std::cos(phi);
-
-            // Add normal vectors - at vertex direction from center (at y pos)
-            auto& normal = *nit; ++nit;
-            normal = Vector( vertex ).Sub( {  0, vpy, 0  } ).Normalize();
-
-            // vertex color
-            auto& color = *cit; ++cit;
-            color = { 1.0f - y/rows, 1.0f, y/rows, 1.0f };
-
-            // skip last column/row - already indexed
-            if ( y < lastRow ) {
-                // vertices don't need to be set just yet. We just index them here
-
-                // top tri
-                int
-                idx = int((int(x + 0) % lastColumn) + columns*y);     m_IndexArray[ looper++ ] = idx;  // 0x0
-                idx = int((int(x + 1) % lastColumn) + columns*y);     m_IndexArray[ looper++ ] = idx;  // 1x0
-                idx = int((int(x + 0) % lastColumn) + columns*(y+1)); m_IndexArray[ looper++ ] = idx;  // 1x1 - bottom row
-
-                // bottom tri
-                idx = int((int(x + 1) % lastColumn) + columns*y);     m_IndexArray[ looper++ ] = idx; // 0x0
-                idx = int((int(x + 1) % lastColumn) + columns*(y+1)); m_IndexArray[ looper++ ] = idx; // 0x1 - bottom row
-                idx = int((int(x + 0) % lastColumn) + columns*(y+1)); m_IndexArray[ looper++ ] = idx; // 1x1 - bottom row
-            }
-        }
+
+    // one extra row to top off the poly
+    CylinderLod lod( columns, rows + 1, radius, height );
+    const int ringVertices = columns*lod.m_Rings;
+
+    // Add two extra vertices at center bottom and top
+    const int numVertices = ringVertices + 2;
+    // planar: all vertices, then all normals, then all colors
+    vertexBuffer.resize( numVertices*3 );
+    // 2 tris per quad between the rings, 1 per column for each cap
+    indexArray.resize( columns*rows*3*2 + columns*3*2 );
+    lod.m_Vertices = &vertexBuffer[0];
+    lod.m_Normals  = lod.m_Vertices + numVertices;
+    lod.m_Colors   = lod.m_Normals + numVertices;
+    lod.m_Indices  = &indexArray[0];
+
+    if ( jobQueue && ringVertices >= _parallelMinVertices ) {
+        jobQueue->ParallelFor( 0, lod.m_Rings, boost::bind( &MakeCylinderRings, boost::cref( lod ), _1, _2 ),
+                               std::max( _parallelMinVertices / 4 / columns, 1 ) );
+    } else {
+        MakeCylinderRings( lod, 0, lod.m_Rings );
     }
 
     // we share vertices with first and last ring -> problem with normals. This point away from center, only center is correct
-    auto& vb = *vit; ++vit;
-    vb = { 0,-height/2, 0 };   // bottom - center
-    auto& nb = *nit; ++nit;
-    nb = { 0, -1, 0 };         // point down
-    auto& cb = *cit; ++cit;
-    cb = { 1.0f, 1.0f, 0.0f, 1.0f };
-    int bottomIdx = columns * rows * m_Stride;
+    const int bottomIdx = ringVertices;
+    const int topIdx    = bottomIdx + 1;
+    lod.m_Vertices[ bottomIdx ] = Vector( 0, -height/2, 0 );            // bottom - center
+    lod.m_Normals[ bottomIdx ]  = Vector( 0, -1, 0 );                   // point down
+    lod.m_Colors[ bottomIdx ]   = Vector( 1.0f, 1.0f, 0.0f, 1.0f );
+    lod.m_Vertices[ topIdx ]    = Vector( 0, height/2, 0 );             // top - center
+    lod.m_Normals[ topIdx ]     = Vector( 0, +1, 0 );                   // point up
+    lod.m_Colors[ topIdx ]      = Vector( 0.0f, 1.0f, 1.0f, 1.0f );
+
     // close top and bottom
+    const int lastColumn = columns - 1;
+    const int topRow     = columns*rows;
+    unsigned int* index = lod.m_Indices + columns*rows*6;
     for( int x = 0; x < columns; ++x ) { //0-2PI
+        const int x0 = x == lastColumn ? 0 : x;
+        const int x1 = x + 1 >= lastColumn ? x + 1 - lastColumn : x + 1;
         // bottom
-        int
-        idx = (x + 0) % lastColumn; m_IndexArray[ looper++ ] = idx;  // 0x0 - readability!
-        idx = (x + 1) % lastColumn; m_IndexArray[ looper++ ] = idx;  // 1x0
-        idx = bottomIdx;            m_IndexArray[ looper++ ] = idx;  // 1x1 - bottom row
+        *index++ = x0;
+        *index++ = x1;
+        *index++ = bottomIdx;
     }
-    auto& vt = *vit; ++vit;
-    vt = { 0, height/2, 0 };   // top - center
-    auto& nt = *nit; ++nit;
-    nt = { 0, +1, 0 };       // point up
-    auto& ct = *cit; ++cit;
-    ct = { 0.0f, 1.0f, 1.0f, 1.0f };
-    int topIdx = bottomIdx+1;
     for( int x = 0; x < columns; ++x ) { //0-2PI
-        int
-        idx = (x + 1) % lastColumn + columns*lastRow; m_IndexArray[ looper++ ] = idx;  // 1x0
-        idx = (x + 0) % lastColumn + columns*lastRow; m_IndexArray[ looper++ ] = idx;  // 0x0 - readability!
-        idx = topIdx;               m_IndexArray[ looper++ ] = idx;  // 1x1 - bottom row
+        const int x0 = x == lastColumn ? 0 : x;
+        const int x1 = x + 1 >= lastColumn ? x + 1 - lastColumn : x + 1;
+        // top
+        *index++ = x1 + topRow;
+        *index++ = x0 + topRow;
+        *index++ = topIdx;
     }
 }
 
-bool Cylinder::DoInitialize( Renderer* renderer ) throw(std::exception)
+void Cylinder::MakeCylinder( JobQueuePtr jobQueue, int columns, int rows, float radius, MeshData& data )
 {
-    bool hasVBO  = glewGetExtension("GL_ARB_vertex_buffer_object");
-    ASSERT( hasVBO, "VBOs not supported!" );
-
-    // we might just want to create this in DoInitialize - and throw away the data we don't need locally
-    MakeCylinder( _columns, _rows );
-
-    glGenBuffers( MAX_BUFFERS, (GLuint*)m_Buffers);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[ VERTEX_BUFFER ]);
-    int bufSize = sizeof(Vector)*m_VertexBuffer.size()
-                + sizeof(Vector)*m_NormalBuffer.size()
-                + sizeof(Vector)*m_ColorBuffer.size();
-    glBufferData(GL_ARRAY_BUFFER, bufSize, 0, GL_STATIC_DRAW);
-    std::size_t offset(0);
-    // Vertex buffer
-    float *vertices = (float*)&m_VertexBuffer[0];
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(Vector)*m_VertexBuffer.size(), vertices);
-    // Normal buffer
-    offset += sizeof(Vector)*m_VertexBuffer.size();
-    float *normals = (float*)&m_NormalBuffer[0];
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(Vector)*m_NormalBuffer.size(), normals);
-    // Color buffer
-    offset += sizeof(Vector)*m_NormalBuffer.size();
-    float *colors = (float*)&m_ColorBuffer[0];
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(Vector)*m_ColorBuffer.size(), colors);
-
-    // Index Buffer
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[ INDEX_BUFFER ]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int)*m_IndexArray.size(), &m_IndexArray[0], GL_STATIC_DRAW);
-
-    // TODO: We can delete local storage here
+    const float height = 6;
 
-    return true;
+    // all levels go into one vertex buffer. Generated planar, uploaded interleaved and compact
+    std::vector<Vector>* planes = data.m_Streams;
+    std::vector<int> lodIndices;
+    float misses[2] = { 0, 0 };
+    for ( int lod = 0; lod < _numLods; ++lod ) {
+        // only the columns get coarser - there are just two rows
+        std::vector<Vector> vertexBuffer;
+        std::vector<unsigned int> indexArray;
+        MakeCylinderLod( std::max( columns >> lod, 8 ), rows, radius, jobQueue, vertexBuffer, indexArray );
+        lodIndices.push_back( data.m_Indices.size() );
+        MeshOptimizer::AppendLod( vertexBuffer, indexArray, 3, planes, data.m_Indices, misses );
+    }
+    lodIndices.push_back( data.m_Indices.size() );
+    for ( int lod = 0; lod < _numLods; ++lod ) {
+        Mesh::Lod range = { lodIndices[lod], lodIndices[lod+1] - lodIndices[lod], _lodMinSize[lod] };
+        data.m_Lods.push_back( range );
+    }
+    const int numTriangles = data.m_Indices.size() / 3;
+    data.m_ACMR[0] = misses[0] / numTriangles;
+    data.m_ACMR[1] = misses[1] / numTriangles;
+    data.m_Bounds  = BoundingBox( Vector( -radius, -height/2, -radius ), Vector( radius, height/2, radius ) );
 }
 
-void Cylinder::DoUpdate( float ticks ) throw(std::exception)
+std::string Cylinder::GetMeshKey( float radius )
 {
+    return MeshCache::MakeKey( "cylinder", "%d %d %.9g", _columns, _rows, radius );
 }
 
-void Cylinder::DoRender( int pass ) throw(std::exception)
+MeshCache::Builder Cylinder::GetMeshBuilder( JobQueuePtr jobQueue, float radius )
 {
-    int vertexArrayEnabled;
-    glGetIntegerv( GL_VERTEX_ARRAY, &vertexArrayEnabled );
-    if (!vertexArrayEnabled) {
-        glEnableClientState(GL_VERTEX_ARRAY);
-    }
-    int normalArrayEnabled;
-    glGetIntegerv( GL_NORMAL_ARRAY, &normalArrayEnabled );
-    if ( !normalArrayEnabled )  {
-        glEnableClientState(GL_NORMAL_ARRAY);
-    }
-    int colorArrayEnabled;
-    glGetIntegerv( GL_COLOR_ARRAY, &colorArrayEnabled );
-    if ( !colorArrayEnabled) {
-        glEnableClientState(GL_COLOR_ARRAY);
-    }
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[ VERTEX_BUFFER ]);
-    // before draw, specify vertex and index arrays with their offsets
-    std::size_t offset(0);
-    glVertexPointer(4, GL_FLOAT, m_Stride*sizeof(Vector), (void*)offset);
-
-    offset += sizeof(Vector)*m_VertexBuffer.size();
-    glNormalPointer(GL_FLOAT, m_Stride*sizeof(Vector), (void*)offset);
-
-    offset += sizeof(Vector)*m_NormalBuffer.size();
-    glColorPointer(4, GL_FLOAT, m_Stride*sizeof(Vector), (void*)offset);
+    return boost::bind( &Cylinder::MakeCylinder, jobQueue, _columns, _rows, radius, _1 );
+}
 
-    // use index array
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[ INDEX_BUFFER ]);
-    glDrawElements( GL_TRIANGLES, m_IndexArray.size(), GL_UNSIGNED_INT, (void*)0 );
+bool Cylinder::DoInitialize( Renderer* renderer ) throw(std::exception)
+{
+    // identical cylinders share one mesh - only the first one generates (or loads) and uploads it
+    m_Mesh = renderer->GetMeshCache()->Get( GetMeshKey( m_Radius ), GetMeshBuilder( renderer->GetJobQueue(), m_Radius ) );
+    SetBounds( m_Mesh->GetBounds() );
+    return true;
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+void Cylinder::DoUpdate( float ticks ) throw(std::exception)
+{
+}
 
-    if (!vertexArrayEnabled)  {
-        glDisableClientState(GL_VERTEX_ARRAY);  // disable vertex arrays
-    }
-    if ( !normalArrayEnabled )  {
-        glDisableClientState(GL_NORMAL_ARRAY);
-    }
-    if ( !colorArrayEnabled) {
-        glDisableClientState(GL_COLOR_ARRAY);
+void Cylinder::DoRender( int pass ) throw(std::exception)
+{
+    int lod = m_Lod.Select( *m_Mesh, GetBounds(), pass );
+    if ( m_Lod.CasterLevelChanged() ) {
+        GeometryChanged();
     }
+    unsigned int enabled = m_Mesh->Enable( Mesh::POSITION_F | Mesh::NORMAL_F | Mesh::COLOR_F );
+    m_Mesh->Draw( lod );
+    m_Mesh->Disable( enabled );
 }
-
@@ -4,31 +4,18 @@
 #include "err.h"
 #include "entity.h"
 #include "vector.h"
+#include "mesh.h"
+#include "meshcache.h"
+#include "lodselector.h"
+#include "jobqueue.h"
 
 #include <vector>
 
 class Cylinder : public Entity
 {
-public:
-    enum {
-        VERTEX_BUFFER = 0,
-        INDEX_BUFFER,
-
-        MAX_BUFFERS
-    };
-
 private:
-    int m_Buffers[ MAX_BUFFERS ];
-
-    typedef std::vector<Vector> VertexArray;
-    typedef std::vector<Vector> ColorArray;
-    typedef std::vector<unsigned int> IndexArray;
-
-    int         m_Stride;
-    VertexArray m_VertexBuffer; // linear buffer
-    VertexArray m_NormalBuffer; // linear buffer
-    ColorArray  m_ColorBuffer;  // color buffer overlays Vertex Array
-    IndexArray  m_IndexArray;   // standard array to map vertices to tris
+    MeshPtr     m_Mesh;         // shared by all cylinders with the same radius
+    LodSelector m_Lod;
 
     float       m_Radius;
     Vector      m_ColorFrom,
@@ -38,10 +25,21 @@ public:
 
     virtual ~Cylinder();
 
+    virtual MeshPtr GetMesh() const { return m_Mesh; }
+
     void SetColors( const Vector& colorFrom, const Vector& colorTo );
 
+    // MeshCache key and builder of a cylinder - shared with the meshcook tool
+    static std::string GetMeshKey( float radius );
+
+    static MeshCache::Builder GetMeshBuilder( JobQueuePtr jobQueue, float radius );
+
 private:
-    void MakeCylinder( float meridians, float parallels );
+    // all levels of detail, starting with meridians x parallels. Large levels are split into rings on the job queue
+    static void MakeCylinder( JobQueuePtr jobQueue, int meridians, int parallels, float radius, MeshData& data );
+
+    static void MakeCylinderLod( int meridians, int parallels, float radius, JobQueuePtr jobQueue,
+                                 std::vector<Vector>& vertexBuffer, std::vector<unsigned int>& indexArray );
 
 protected:
     virtual bool DoInitialize( Renderer* renderer ) throw(std::exception);
@@ -16,6 +16,8 @@ Entity::Entity() throw ()
     : m_Flags(F_ENABLE)
     , m_OrderNum(0)
     , m_RenderState( new RenderState ) // create a default RenderState
+    , m_BoundsVersion(0)
+    , m_BoundsDirty(true)
 {
 }
 
@@ -28,6 +30,18 @@ RenderStatePtr Entity::GetRenderState()
     return m_RenderState;
 }
 
+const BoundingBox& Entity::GetWorldBounds()
+{
+    const Matrix& matrix = GetRenderState()->GetMatrix();
+    if ( m_BoundsDirty || matrix != m_WorldBoundsMatrix ) {
+        m_BoundsDirty = false;
+        m_WorldBoundsMatrix = matrix;
+        m_WorldBounds = m_Bounds.Transformed( matrix );
+        ++m_BoundsVersion;
+    }
+    return m_WorldBounds;
+}
+
 void Entity::AddEntity( EntityPtr entity, int priority /*= 0*/  )
 {
     entity->SetOrder( priority );
@@ -66,7 +80,8 @@ void Entity::SetupRender( int pass )
     // if regular mode do transform, if replay read & load projection matrix from render state
     glMatrixMode(GL_MODELVIEW); // not sure how much overhead this generates
     glPushMatrix();
-    glLoadMatrixf( GetRenderState()->GetMatrix() );
+    // relative to parent - same as Light. Loading the matrix would drop the camera transform
+    glMultMatrixf( GetRenderState()->GetMatrix() );
 }
 
 void Entity::CleanupRender( int pass )
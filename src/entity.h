@@ -9,13 +9,16 @@
 #define ENTITY_H_
 
 #include "vector.h"
+#include "bounds.h"
 #include "renderstate.h"
+#include "mesh.h"
 
 #include <SDL/SDL_events.h>
 
 #include <boost/shared_ptr.hpp>
 
 #include <list>
+#include <vector>
 
 class Renderer;
 
@@ -59,6 +62,13 @@ protected:
 
     EntityList  	m_RenderList;
     EntityList  	m_InitList;
+
+private:
+    BoundingBox     m_Bounds;           // local (object space) bounds of this entity's geometry. Empty = unknown
+    BoundingBox     m_WorldBounds;      // cached - recalculated when the matrix changes
+    Matrix          m_WorldBoundsMatrix;
+    unsigned int    m_BoundsVersion;    // incremented each time the world bounds or the geometry change
+    bool            m_BoundsDirty;
 public:
     Entity() throw ();
 
@@ -91,6 +101,30 @@ public:
 
     void AddEntity( EntityPtr entity, int priority = 0 );
 
+    const BoundingBox& GetBounds() const { return m_Bounds; }
+
+    /*!
+     * Local bounds transformed by the entity matrix. Bounds only cover the
+     * entity's own geometry, not its children.
+     */
+    const BoundingBox& GetWorldBounds();
+
+    unsigned int GetBoundsVersion() const { return m_BoundsVersion; }
+
+    /*!
+     * Occluder geometry in object space (triangle list) or nullptr if this
+     * entity should not occlude anything. eye is the viewer position in
+     * world space. Must stay valid and unchanged until the next frame - it is
+     * read from worker threads.
+     */
+    virtual const std::vector<Vector>* GetOccluder( const Vector& eye ) { return nullptr; }
+
+    /*!
+     * Shared geometry of this entity, if it is drawn from a single mesh.
+     * Valid after Initialize(). Used to batch identical entities.
+     */
+    virtual MeshPtr GetMesh() const { return MeshPtr(); }
+
 	// Only renderer has access to these below
 private:
     void SetOrder( int order ) { m_OrderNum = order; }
@@ -99,6 +133,11 @@ private:
 
     bool CompareEntityPriorities( const EntityPtr& a, const EntityPtr& b );
 protected:
+    void SetBounds( const BoundingBox& bounds ) { m_Bounds = bounds; m_BoundsDirty = true; }
+
+    // geometry changed within the same bounds - cached shadows of it are stale
+    void GeometryChanged() { ++m_BoundsVersion; }
+
     virtual bool DoInitialize( Renderer* renderer ) throw( std::exception ) = 0;
 
     virtual void DoRender( int pass ) throw( std::exception ) = 0;
@@ -32,7 +32,8 @@ FrameBuffer::~FrameBuffer()
             glDeleteRenderbuffers(1,(GLuint*)&m_DepthBufferID);
         }
         // delete frame buffer
-        glDeleteFramebuffers(1,(GLuint*)&m_DepthBufferID);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1,(GLuint*)&m_FrameBufferID);
     }
 }
 
@@ -66,7 +67,7 @@ bool FrameBuffer::Allocate( int width, int height, int type /* = GL_RGBA */ )
         }
 
         // create a texture to render into
-        b = m_Texture->Allocate( width, height, type );
+        b = m_Texture->AllocateFormat( width, height, type );
         ASSERT( b, "Error allocating texture!" );
         // Set "renderedTexture" as our colour attachement #0
         glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_Texture->GetTextureId(), 0);
@@ -75,11 +76,12 @@ bool FrameBuffer::Allocate( int width, int height, int type /* = GL_RGBA */ )
     else if ( m_Flags & F_ENABLE_DEPTH_BUFFER_F ) {
         // depth buffer only
         // create a texture to render into
-        b = m_Texture->Allocate( width, height, 16 ); // 16 bit float depth texture!
+        b = m_Texture->AllocateFormat( width, height, GL_DEPTH_COMPONENT24 ); // 24 bit depth texture!
         ASSERT( b, "Error allocating texture!" );
         // Set "renderedTexture" as our depth attachement #0
         glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_Texture->GetTextureId(), 0);
         glDrawBuffer( GL_NONE );
+        glReadBuffer( GL_NONE );
     }
 
     b &= ( glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE );
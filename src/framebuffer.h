@@ -29,6 +29,10 @@ public:
 
     virtual ~FrameBuffer();
 
+    /*!
+     * type is the internal format of the color texture (e.g. GL_RGBA8, GL_RG32F).
+     * A depth only frame buffer always uses a 24 bit depth texture.
+     */
     virtual bool Allocate( int width, int height, int type = GL_RGBA );
 
     void Enable();
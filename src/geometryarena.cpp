@@ -0,0 +1,249 @@
+/*
+ * geometryarena.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "geometryarena.h"
+#include "bufferbinding.h"
+
+#include <algorithm>
+
+static inline std::size_t AlignUp( std::size_t offset, std::size_t alignment )
+{
+    return ( offset + alignment - 1 ) / alignment * alignment;
+}
+
+static bool CompareBlockOffsets( const GeometryArena::Block* a, const GeometryArena::Block* b )
+{
+    return a->m_Offset < b->m_Offset;
+}
+
+GeometryArena::GeometryArena()
+    : m_HasCopyBuffer(false)
+    , m_HasBaseVertex(false)
+    , m_NumMoves(0)
+{
+    static const GLenum glTargets[ NUM_TARGETS ] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER };
+    static const std::size_t capacities[ NUM_TARGETS ] = { INITIAL_VERTEX_BYTES, INITIAL_INDEX_BYTES };
+    for ( int i = 0; i < NUM_TARGETS; ++i ) {
+        Buffer& buffer    = m_Buffers[i];
+        buffer.m_Buffer   = 0;
+        buffer.m_GLTarget = glTargets[i];
+        buffer.m_Capacity = capacities[i];
+        buffer.m_Used     = 0;
+    }
+}
+
+GeometryArena::~GeometryArena()
+{
+    // shouldn't be done in d'tor...but vbo must be released from render thread
+    for ( auto& buffer : m_Buffers ) {
+        if ( buffer.m_Buffer ) {
+            BufferBinding::Forget( buffer.m_Buffer );
+            glDeleteBuffers( 1, &buffer.m_Buffer );
+        }
+    }
+}
+
+void GeometryArena::Create() throw(std::exception)
+{
+    bool hasVBO  = glewGetExtension("GL_ARB_vertex_buffer_object");
+    ASSERT( hasVBO, "VBOs not supported!" );
+    m_HasCopyBuffer = glewGetExtension("GL_ARB_copy_buffer");
+    m_HasBaseVertex = glewGetExtension("GL_ARB_draw_elements_base_vertex");
+
+    for ( auto& buffer : m_Buffers ) {
+        glGenBuffers( 1, &buffer.m_Buffer );
+        BufferBinding::Bind( buffer.m_GLTarget, buffer.m_Buffer );
+        glBufferData( buffer.m_GLTarget, buffer.m_Capacity, nullptr, GL_STATIC_DRAW );
+        BufferBinding::Bind( buffer.m_GLTarget, 0 );
+        buffer.m_Free[0] = buffer.m_Capacity;
+    }
+}
+
+bool GeometryArena::Take( Buffer& buffer, std::size_t size, std::size_t alignment, std::size_t& offset )
+{
+    for ( auto it = buffer.m_Free.begin(); it != buffer.m_Free.end(); ++it ) {
+        std::size_t begin = it->first;
+        std::size_t end   = it->first + it->second;
+        std::size_t aligned = AlignUp( begin, alignment );
+        if ( aligned + size > end ) continue;
+
+        buffer.m_Free.erase( it );
+        if ( aligned > begin ) {
+            buffer.m_Free[ begin ] = aligned - begin;
+        }
+        if ( aligned + size < end ) {
+            buffer.m_Free[ aligned + size ] = end - ( aligned + size );
+        }
+        offset = aligned;
+        return true;
+    }
+    return false;
+}
+
+void GeometryArena::Release( Buffer& buffer, std::size_t offset, std::size_t size )
+{
+    auto next = buffer.m_Free.lower_bound( offset );
+    if ( next != buffer.m_Free.end() && offset + size == next->first ) {
+        size += next->second;
+        next = buffer.m_Free.erase( next );
+    }
+    if ( next != buffer.m_Free.begin() ) {
+        auto prev = next; --prev;
+        if ( prev->first + prev->second == offset ) {
+            prev->second += size;
+            return;
+        }
+    }
+    buffer.m_Free[ offset ] = size;
+}
+
+GeometryArena::BlockPtr GeometryArena::Allocate( Target target, std::size_t size, std::size_t alignment ) throw(std::exception)
+{
+    ASSERT( size > 0 && alignment > 0, "Invalid geometry block: %d bytes, alignment %d", int(size), int(alignment) );
+    if ( !m_Buffers[0].m_Buffer ) {
+        Create();
+    }
+    Buffer& buffer = m_Buffers[ target ];
+    std::size_t offset(0);
+    if ( !Take( buffer, size, alignment, offset ) ) {
+        Grow( buffer, size + alignment );
+        bool taken = Take( buffer, size, alignment, offset );
+        ASSERT( taken, "Geometry arena can't fit %d bytes", int(size) );
+    }
+    BlockPtr block( new Block );
+    block->m_Target    = target;
+    block->m_Offset    = offset;
+    block->m_Size      = size;
+    block->m_Alignment = alignment;
+    buffer.m_Blocks.push_back( block.get() );
+    buffer.m_Used += size;
+    return block;
+}
+
+void GeometryArena::Upload( const BlockPtr& block, const void* data )
+{
+    const Buffer& buffer = m_Buffers[ block->m_Target ];
+    BufferBinding::Bind( buffer.m_GLTarget, buffer.m_Buffer );
+    glBufferSubData( buffer.m_GLTarget, block->m_Offset, block->m_Size, data );
+    BufferBinding::Bind( buffer.m_GLTarget, 0 );
+}
+
+void GeometryArena::Free( const BlockPtr& block )
+{
+    Buffer& buffer = m_Buffers[ block->m_Target ];
+    auto it = std::find( buffer.m_Blocks.begin(), buffer.m_Blocks.end(), block.get() );
+    ASSERT( it != buffer.m_Blocks.end(), "Geometry block freed twice!" );
+    buffer.m_Blocks.erase( it );
+    buffer.m_Used -= block->m_Size;
+    Release( buffer, block->m_Offset, block->m_Size );
+}
+
+void GeometryArena::Move( Buffer& buffer, std::size_t capacity, const std::vector<std::size_t>& newOffsets )
+{
+    GLuint newBuffer(0);
+    glGenBuffers( 1, &newBuffer );
+    if ( m_HasCopyBuffer ) {
+        glBindBuffer( GL_COPY_READ_BUFFER, buffer.m_Buffer );
+        glBindBuffer( GL_COPY_WRITE_BUFFER, newBuffer );
+        glBufferData( GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW );
+        for ( std::size_t i = 0; i < buffer.m_Blocks.size(); ++i ) {
+            const Block* block = buffer.m_Blocks[i];
+            glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, block->m_Offset, newOffsets[i], block->m_Size );
+        }
+        glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+        glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+    } else {
+        // round trip through system memory
+        std::vector<char> old( buffer.m_Capacity );
+        BufferBinding::Bind( buffer.m_GLTarget, buffer.m_Buffer );
+        glGetBufferSubData( buffer.m_GLTarget, 0, old.size(), &old[0] );
+        std::vector<char> data( capacity );
+        for ( std::size_t i = 0; i < buffer.m_Blocks.size(); ++i ) {
+            const Block* block = buffer.m_Blocks[i];
+            std::copy( &old[ block->m_Offset ], &old[ block->m_Offset ] + block->m_Size, &data[ newOffsets[i] ] );
+        }
+        BufferBinding::Bind( buffer.m_GLTarget, newBuffer );
+        glBufferData( buffer.m_GLTarget, capacity, &data[0], GL_STATIC_DRAW );
+        BufferBinding::Bind( buffer.m_GLTarget, 0 );
+    }
+    // the GPU may still read the old one - GL keeps it alive until then
+    BufferBinding::Forget( buffer.m_Buffer );
+    glDeleteBuffers( 1, &buffer.m_Buffer );
+    buffer.m_Buffer   = newBuffer;
+    buffer.m_Capacity = capacity;
+    for ( std::size_t i = 0; i < buffer.m_Blocks.size(); ++i ) {
+        buffer.m_Blocks[i]->m_Offset = newOffsets[i];
+    }
+    ++m_NumMoves;
+}
+
+void GeometryArena::Grow( Buffer& buffer, std::size_t size ) throw(std::exception)
+{
+    std::size_t oldCapacity = buffer.m_Capacity;
+    std::size_t capacity    = std::max( oldCapacity*2, oldCapacity + size );
+    std::vector<std::size_t> offsets;
+    for ( auto block : buffer.m_Blocks ) {
+        offsets.push_back( block->m_Offset );
+    }
+    Move( buffer, capacity, offsets );
+    Release( buffer, oldCapacity, capacity - oldCapacity );
+}
+
+void GeometryArena::Defragment( Target target ) throw(std::exception)
+{
+    Buffer& buffer = m_Buffers[ target ];
+    if ( !buffer.m_Buffer ) return;
+
+    std::sort( buffer.m_Blocks.begin(), buffer.m_Blocks.end(), CompareBlockOffsets );
+    std::vector<std::size_t> offsets;
+    std::size_t end(0);
+    for ( auto block : buffer.m_Blocks ) {
+        end = AlignUp( end, block->m_Alignment );
+        offsets.push_back( end );
+        end += block->m_Size;
+    }
+    Move( buffer, buffer.m_Capacity, offsets );
+    buffer.m_Free.clear();
+    if ( end < buffer.m_Capacity ) {
+        buffer.m_Free[ end ] = buffer.m_Capacity - end;
+    }
+}
+
+float GeometryArena::GetFragmentation( Target target ) const
+{
+    const Buffer& buffer = m_Buffers[ target ];
+    std::size_t total(0), largest(0);
+    for ( auto& range : buffer.m_Free ) {
+        total  += range.second;
+        largest = std::max( largest, range.second );
+    }
+    return total ? 1.0f - float(largest) / float(total) : 0.0f;
+}
+
+void GeometryArena::Update()
+{
+    for ( int i = 0; i < NUM_TARGETS; ++i ) {
+        const Buffer& buffer = m_Buffers[i];
+        // only worth a copy of the whole buffer if a good part of it is wasted
+        if ( buffer.m_Buffer && buffer.m_Capacity - buffer.m_Used > buffer.m_Capacity / 4 &&
+             GetFragmentation( Target(i) ) > 0.5f ) {
+            Defragment( Target(i) );
+        }
+    }
+}
+
+void GeometryArena::Dump( std::ostream& out ) const
+{
+    static const char* names[ NUM_TARGETS ] = { "vertices", "indices" };
+    for ( int i = 0; i < NUM_TARGETS; ++i ) {
+        const Buffer& buffer = m_Buffers[i];
+        out << "Arena " << names[i] << ": " << buffer.m_Used / 1024 << "/" << buffer.m_Capacity / 1024 << " KB, "
+            << buffer.m_Blocks.size() << " blocks, " << buffer.m_Free.size() << " free ranges, fragmentation "
+            << GetFragmentation( Target(i) ) << "\n";
+    }
+    out << "Arena moves: " << m_NumMoves << "\n";
+}
@@ -0,0 +1,121 @@
+/*
+ * geometryarena.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef GEOMETRYARENA_H_
+#define GEOMETRYARENA_H_
+
+#include "err.h"
+
+#include <GL/glew.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <vector>
+#include <ostream>
+
+/*!
+ * All static geometry lives in one vertex and one index buffer. Meshes get
+ * blocks of them from a first fit free list, freed blocks are merged with
+ * their neighbours. A full buffer grows (doubles), Defragment() packs the
+ * blocks at the start of a fresh buffer - both move blocks, so offsets must
+ * be read from the block at draw time, never cached.
+ *
+ * Vertex blocks are aligned to the vertex size: an interleaved mesh starts
+ * at a whole vertex and is drawn with glDrawElementsBaseVertex() - meshes of
+ * the same format share their attribute pointers.
+ * Render thread only.
+ */
+class GeometryArena
+{
+public:
+    enum Target {
+        VERTICES = 0,
+        INDICES,
+
+        NUM_TARGETS
+    };
+    enum {
+        INITIAL_VERTEX_BYTES = 4<<20,
+        INITIAL_INDEX_BYTES  = 1<<20,
+    };
+
+    struct Block
+    {
+        Target      m_Target;
+        std::size_t m_Offset;       // bytes - changes when the arena grows or is defragmented
+        std::size_t m_Size;
+        std::size_t m_Alignment;
+    };
+    typedef boost::shared_ptr<Block> BlockPtr;
+private:
+    struct Buffer
+    {
+        GLuint      m_Buffer;
+        GLenum      m_GLTarget;
+        std::size_t m_Capacity;
+        std::size_t m_Used;
+        std::map< std::size_t, std::size_t > m_Free;  // offset -> size, no two adjacent
+        std::vector< Block* > m_Blocks;              // live blocks
+    };
+    Buffer m_Buffers[ NUM_TARGETS ];
+    bool   m_HasCopyBuffer;
+    bool   m_HasBaseVertex;
+    int    m_NumMoves;          // grows and defragmentations
+public:
+    GeometryArena();
+
+    ~GeometryArena();
+
+    /*!
+     * alignment: any value > 0 - vertex size, index size
+     */
+    BlockPtr Allocate( Target target, std::size_t size, std::size_t alignment ) throw(std::exception);
+
+    void Upload( const BlockPtr& block, const void* data );
+
+    void Free( const BlockPtr& block );
+
+    GLuint GetBuffer( Target target ) const { return m_Buffers[ target ].m_Buffer; }
+
+    bool HasBaseVertex() const { return m_HasBaseVertex; }
+
+    /*!
+     * 0 = all free space in one piece
+     */
+    float GetFragmentation( Target target ) const;
+
+    /*!
+     * Pack all blocks of target at the start of a new buffer
+     */
+    void Defragment( Target target ) throw(std::exception);
+
+    /*!
+     * Once per frame - defragments a buffer if most of its free space is in
+     * pieces too small to be useful
+     */
+    void Update();
+
+    void Dump( std::ostream& out ) const;
+
+private:
+    void Create() throw(std::exception);
+
+    // first fit, false if no free block is large enough
+    bool Take( Buffer& buffer, std::size_t size, std::size_t alignment, std::size_t& offset );
+
+    void Release( Buffer& buffer, std::size_t offset, std::size_t size );
+
+    void Grow( Buffer& buffer, std::size_t size ) throw(std::exception);
+
+    // new buffer of capacity, blocks copied to the offsets in newOffsets (same order as m_Blocks)
+    void Move( Buffer& buffer, std::size_t capacity, const std::vector<std::size_t>& newOffsets );
+};
+
+typedef boost::shared_ptr<GeometryArena> GeometryArenaPtr;
+
+#endif /* GEOMETRYARENA_H_ */
@@ -0,0 +1,283 @@
+/*
+ * instancedbatch.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "instancedbatch.h"
+#include "renderer.h"
+#include "bufferbinding.h"
+
+#include <boost/bind.hpp>
+
+// instance attributes are per vertex constants in pseudo instancing mode - same shader for both.
+// Light 0 only, like the fixed function setup of the stage
+static const char* sInstanceVertexShader =
+    "#version 120\n"
+    "attribute vec4 a_Model0;\n" // instance matrix columns
+    "attribute vec4 a_Model1;\n"
+    "attribute vec4 a_Model2;\n"
+    "attribute vec4 a_Model3;\n"
+    "attribute vec4 a_Color;\n"
+    "uniform bool u_Lighting;\n"
+    "void main()\n"
+    "{\n"
+    "    mat4 model  = mat4( a_Model0, a_Model1, a_Model2, a_Model3 );\n"
+    "    vec4 eye    = gl_ModelViewMatrix * ( model * gl_Vertex );\n"
+    "    gl_Position = gl_ProjectionMatrix * eye;\n"
+    "    vec4 color  = gl_Color * a_Color;\n"
+    "    if ( u_Lighting ) {\n"
+    "        vec3 n = normalize( gl_NormalMatrix * ( mat3( model[0].xyz, model[1].xyz, model[2].xyz ) * gl_Normal ) );\n"
+    "        vec3 l = normalize( gl_LightSource[0].position.xyz - eye.xyz * gl_LightSource[0].position.w );\n"
+    "        vec3 lit = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb +\n"
+    "                   gl_LightSource[0].diffuse.rgb * max( dot( n, l ), 0.0 );\n"
+    "        color.rgb *= lit;\n"
+    "    }\n"
+    "    gl_FrontColor = color;\n"
+    "}\n";
+
+static const char* sInstanceFragmentShader =
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n";
+
+InstancedBatch::InstancedBatch( EntityPtr prototype )
+    : m_Prototype( prototype )
+    , m_InstancesDirty( true )
+    , m_Mode( MODE_FIXED_FUNCTION )
+    , m_ColorLocation( -1 )
+    , m_NumVisible( 0 )
+{
+    std::fill( m_ModelLocation, m_ModelLocation + 4, -1 );
+}
+
+InstancedBatch::~InstancedBatch()
+{
+}
+
+int InstancedBatch::AddInstance( const Matrix& matrix, const Vector& color /* = Vector( 1.0f, 1.0f, 1.0f, 1.0f ) */ )
+{
+    Instance instance = { matrix, color };
+    m_Instances.push_back( instance );
+    m_InstancesDirty = true;
+    return m_Instances.size() - 1;
+}
+
+void InstancedBatch::SetInstance( int index, const Matrix& matrix, const Vector& color )
+{
+    ASSERT( index >= 0 && index < int(m_Instances.size()), "Invalid instance %d", index );
+    m_Instances[ index ].m_Matrix = matrix;
+    m_Instances[ index ].m_Color  = color;
+    m_InstancesDirty = true;
+}
+
+void InstancedBatch::SetInstanceMatrix( int index, const Matrix& matrix )
+{
+    ASSERT( index >= 0 && index < int(m_Instances.size()), "Invalid instance %d", index );
+    m_Instances[ index ].m_Matrix = matrix;
+    m_InstancesDirty = true;
+}
+
+void InstancedBatch::RemoveAllInstances()
+{
+    m_Instances.clear();
+    m_InstancesDirty = true;
+}
+
+bool InstancedBatch::DoInitialize( Renderer* renderer ) throw(std::exception)
+{
+    // prototype is never rendered - we only need its mesh
+    m_Prototype->Initialize( renderer );
+    m_Mesh = m_Prototype->GetMesh();
+    ASSERT( m_Mesh, "Prototype of an instanced batch has no mesh!" );
+
+    m_JobQueue = renderer->GetJobQueue();
+
+    if ( Program::IsSupported() ) {
+        m_Program = ProgramPtr( new Program );
+        m_Program->Load( sInstanceVertexShader, sInstanceFragmentShader );
+        static const char* columns[4] = { "a_Model0", "a_Model1", "a_Model2", "a_Model3" };
+        for ( int c = 0; c < 4; ++c ) {
+            m_ModelLocation[c] = m_Program->GetAttributeLocation( columns[c] );
+        }
+        m_ColorLocation = m_Program->GetAttributeLocation( "a_Color" );
+
+        if ( glewGetExtension("GL_ARB_draw_instanced") && glewGetExtension("GL_ARB_instanced_arrays") ) {
+            m_StreamBuffer = renderer->GetStreamBuffer();
+            m_Mode = MODE_INSTANCED;
+        } else {
+            m_Mode = MODE_PSEUDO_INSTANCED;
+        }
+    }
+    UpdateBounds();
+    return true;
+}
+
+void InstancedBatch::UpdateBounds()
+{
+    if ( !m_Mesh ) return;
+
+    BoundingBox bounds;
+    for ( auto& instance : m_Instances ) {
+        bounds.Merge( m_Mesh->GetBounds().Transformed( instance.m_Matrix ) );
+    }
+    SetBounds( bounds );
+    m_InstancesDirty = false;
+}
+
+void InstancedBatch::Cull( const Matrix& viewProjection, int begin, int end )
+{
+    const BoundingBox& bounds = m_Mesh->GetBounds();
+    for ( int i = begin; i < end; ++i ) {
+        // GL order: projection * view * instance
+        m_Visible[i] = bounds.IsEmpty() || bounds.Intersects( Matrix( m_Instances[i].m_Matrix ).Mul( viewProjection ) );
+    }
+}
+
+void InstancedBatch::DoRender( int pass ) throw(std::exception)
+{
+    m_NumVisible = 0;
+    if ( m_Instances.empty() || !m_Mesh ) return;
+
+    if ( m_InstancesDirty ) {
+        UpdateBounds();
+    }
+
+    // frustum of this pass - shadow passes see other instances than the camera
+    Matrix view, projection;
+    glGetFloatv( GL_MODELVIEW_MATRIX, view );
+    glGetFloatv( GL_PROJECTION_MATRIX, projection );
+    Matrix viewProjection = Matrix( view ).Mul( projection );
+
+    int numInstances = m_Instances.size();
+    m_Visible.resize( numInstances );
+    if ( numInstances >= PARALLEL_CULL_MIN && m_JobQueue ) {
+        m_JobQueue->ParallelFor( 0, numInstances, boost::bind( &InstancedBatch::Cull, this, boost::cref( viewProjection ), _1, _2 ), 128 );
+    } else {
+        Cull( viewProjection, 0, numInstances );
+    }
+
+    int currentProgram(0);
+    if ( m_Program ) {
+        glGetIntegerv( GL_CURRENT_PROGRAM, &currentProgram );
+    }
+    Mode mode = currentProgram ? MODE_FIXED_FUNCTION : m_Mode;
+
+    // instance streams go straight into the stream buffer - sized for all, only the visible are written
+    StreamBuffer::Region region = { nullptr, 0, 0 };
+    float* data;
+    if ( mode == MODE_INSTANCED ) {
+        region = m_StreamBuffer->Allocate( numInstances*FLOATS_PER_INSTANCE*sizeof(float) );
+        data = (float*)region.m_Data;
+    } else {
+        m_InstanceData.resize( numInstances*FLOATS_PER_INSTANCE );
+        data = &m_InstanceData[0];
+    }
+    for ( int i = 0; i < numInstances; ++i ) {
+        if ( !m_Visible[i] ) continue;
+        const Instance& instance = m_Instances[i];
+        std::copy( (const float*)instance.m_Matrix, (const float*)instance.m_Matrix + 16, data );
+        for ( int c = 0; c < 4; ++c ) {
+            data[16 + c] = instance.m_Color[c];
+        }
+        data += FLOATS_PER_INSTANCE;
+        ++m_NumVisible;
+    }
+    if ( region.m_Data ) {
+        m_StreamBuffer->Commit( region );
+    }
+    if ( m_NumVisible == 0 ) return;
+
+    glPushAttrib( GL_CURRENT_BIT );
+    // meshes without colors get the instance color only
+    glColor4f( 1.0f, 1.0f, 1.0f, 1.0f );
+
+    switch ( mode ) {
+    case MODE_INSTANCED:        DrawInstanced( region.m_Offset ); break;
+    case MODE_PSEUDO_INSTANCED: DrawPseudoInstanced(); break;
+    default:                    DrawFixedFunction(); break;
+    }
+    glPopAttrib();
+}
+
+void InstancedBatch::SetLighting()
+{
+    m_Program->SetUniform( "u_Lighting", int( glIsEnabled( GL_LIGHTING ) && glIsEnabled( GL_LIGHT0 ) ) );
+}
+
+void InstancedBatch::DrawInstanced( std::size_t offset )
+{
+    const int stride = FLOATS_PER_INSTANCE*sizeof(float);
+
+    BufferBinding::Bind( GL_ARRAY_BUFFER, m_StreamBuffer->GetBuffer() );
+    for ( int c = 0; c < 4; ++c ) {
+        if ( m_ModelLocation[c] < 0 ) continue;
+        glEnableVertexAttribArray( m_ModelLocation[c] );
+        glVertexAttribPointer( m_ModelLocation[c], 4, GL_FLOAT, GL_FALSE, stride, (void*)( offset + c*4*sizeof(float) ) );
+        glVertexAttribDivisorARB( m_ModelLocation[c], 1 );
+    }
+    if ( m_ColorLocation >= 0 ) {
+        glEnableVertexAttribArray( m_ColorLocation );
+        glVertexAttribPointer( m_ColorLocation, 4, GL_FLOAT, GL_FALSE, stride, (void*)( offset + 16*sizeof(float) ) );
+        glVertexAttribDivisorARB( m_ColorLocation, 1 );
+    }
+
+    m_Program->Enable();
+    SetLighting();
+    // binds the mesh's own vertex buffer - instance pointers are already latched
+    unsigned int enabled = m_Mesh->Enable();
+    m_Mesh->DrawInstanced( m_NumVisible );
+    m_Mesh->Disable( enabled );
+    m_Program->Disable();
+
+    for ( int c = 0; c < 4; ++c ) {
+        if ( m_ModelLocation[c] < 0 ) continue;
+        glVertexAttribDivisorARB( m_ModelLocation[c], 0 );
+        glDisableVertexAttribArray( m_ModelLocation[c] );
+    }
+    if ( m_ColorLocation >= 0 ) {
+        glVertexAttribDivisorARB( m_ColorLocation, 0 );
+        glDisableVertexAttribArray( m_ColorLocation );
+    }
+}
+
+void InstancedBatch::DrawPseudoInstanced()
+{
+    m_Program->Enable();
+    SetLighting();
+    unsigned int enabled = m_Mesh->Enable();
+    const float* data = &m_InstanceData[0];
+    for ( int i = 0; i < m_NumVisible; ++i, data += FLOATS_PER_INSTANCE ) {
+        // attribute arrays are off - these are constant for the whole draw
+        for ( int c = 0; c < 4; ++c ) {
+            if ( m_ModelLocation[c] >= 0 ) {
+                glVertexAttrib4fv( m_ModelLocation[c], data + c*4 );
+            }
+        }
+        if ( m_ColorLocation >= 0 ) {
+            glVertexAttrib4fv( m_ColorLocation, data + 16 );
+        }
+        m_Mesh->Draw();
+    }
+    m_Mesh->Disable( enabled );
+    m_Program->Disable();
+}
+
+void InstancedBatch::DrawFixedFunction()
+{
+    // instance colors only show on meshes without a color array
+    unsigned int enabled = m_Mesh->Enable();
+    glMatrixMode( GL_MODELVIEW );
+    const float* data = &m_InstanceData[0];
+    for ( int i = 0; i < m_NumVisible; ++i, data += FLOATS_PER_INSTANCE ) {
+        glPushMatrix();
+        glMultMatrixf( data );
+        glColor4fv( data + 16 );
+        m_Mesh->Draw();
+        glPopMatrix();
+    }
+    m_Mesh->Disable( enabled );
+}
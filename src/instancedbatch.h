@@ -0,0 +1,118 @@
+/*
+ * instancedbatch.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef INSTANCEDBATCH_H_
+#define INSTANCEDBATCH_H_
+
+#include "err.h"
+#include "entity.h"
+#include "mesh.h"
+#include "program.h"
+#include "jobqueue.h"
+#include "streambuffer.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/*!
+ * Draws many copies of one mesh. The mesh comes from a prototype entity
+ * (Sphere, Cylinder, Cube - anything with GetMesh()), only its geometry is
+ * used. Instances are a matrix (relative to the batch) and a color that is
+ * multiplied with the vertex colors.
+ *
+ * Instances outside the view frustum are dropped, the rest is written into
+ * the renderer's StreamBuffer and drawn with one glDrawElementsInstanced(). Without
+ * instancing support the same shader is fed per instance through constant
+ * vertex attributes (pseudo instancing) - still no matrix stack traffic.
+ * If another program is bound already (shadow test, VSM casters) that
+ * program must see the instances through the fixed function matrices, so
+ * each one is drawn with push/mult/pop.
+ */
+class InstancedBatch : public Entity
+{
+public:
+    enum Mode {
+        MODE_INSTANCED = 0,     // GL_ARB_draw_instanced + GL_ARB_instanced_arrays
+        MODE_PSEUDO_INSTANCED,  // shader, one draw per instance
+        MODE_FIXED_FUNCTION,    // matrix stack, one draw per instance
+
+        NUM_MODES
+    };
+    enum {
+        FLOATS_PER_INSTANCE = 16 + 4,   // matrix, color
+        PARALLEL_CULL_MIN   = 512,      // cull on the job queue from this many instances
+    };
+private:
+    struct Instance
+    {
+        Matrix m_Matrix;
+        Vector m_Color;
+    };
+
+    EntityPtr             m_Prototype;
+    MeshPtr               m_Mesh;
+    std::vector<Instance> m_Instances;
+    bool                  m_InstancesDirty;   // bounds need an update
+
+    Mode                  m_Mode;             // best mode the hardware supports
+    ProgramPtr            m_Program;
+    int                   m_ModelLocation[4]; // matrix columns
+    int                   m_ColorLocation;
+    StreamBufferPtr       m_StreamBuffer;     // instance streams, instanced mode only
+
+    JobQueuePtr           m_JobQueue;
+    std::vector<char>     m_Visible;          // scratch - written by workers, no vector<bool>
+    std::vector<float>    m_InstanceData;     // scratch - visible instances, not instanced modes
+    int                   m_NumVisible;
+public:
+    InstancedBatch( EntityPtr prototype );
+
+    virtual ~InstancedBatch();
+
+    /*!
+     * Returns the instance index
+     */
+    int AddInstance( const Matrix& matrix, const Vector& color = Vector( 1.0f, 1.0f, 1.0f, 1.0f ) );
+
+    void SetInstance( int index, const Matrix& matrix, const Vector& color );
+
+    void SetInstanceMatrix( int index, const Matrix& matrix );
+
+    void RemoveAllInstances();
+
+    int GetNumInstances() const { return m_Instances.size(); }
+
+    // instances that passed the frustum test in the last draw
+    int GetNumVisible() const { return m_NumVisible; }
+
+    Mode GetMode() const { return m_Mode; }
+
+    virtual MeshPtr GetMesh() const { return m_Mesh; }
+
+protected:
+    virtual bool DoInitialize( Renderer* renderer ) throw(std::exception);
+
+    virtual void DoRender( int pass ) throw(std::exception);
+
+private:
+    void UpdateBounds();
+
+    void Cull( const Matrix& viewProjection, int begin, int end );
+
+    void DrawInstanced( std::size_t offset );
+
+    void DrawPseudoInstanced();
+
+    void DrawFixedFunction();
+
+    void SetLighting();
+};
+
+typedef boost::shared_ptr<InstancedBatch> InstancedBatchPtr;
+
+#endif /* INSTANCEDBATCH_H_ */
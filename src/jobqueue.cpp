@@ -0,0 +1,140 @@
+/*
+ * jobqueue.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "jobqueue.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+JobQueue::JobQueue( int numThreads /* = 0 */ )
+    : m_Terminate(false)
+    , m_NumThreads(numThreads)
+{
+    if ( m_NumThreads <= 0 ) {
+        m_NumThreads = std::max( 1, int(boost::thread::hardware_concurrency()) - 1 );
+    }
+    for ( int i = 0; i < m_NumThreads; ++i ) {
+        m_Threads.create_thread( boost::bind( &JobQueue::Run, this ) );
+    }
+}
+
+JobQueue::~JobQueue()
+{
+    {
+        boost::lock_guard< boost::mutex > lock( m_Mutex );
+        m_Terminate = true;
+    }
+    m_JobAvailable.notify_all();
+    m_Threads.join_all();
+}
+
+JobQueue::BatchPtr JobQueue::Post( const Job& job, BatchPtr batch /* = BatchPtr() */ )
+{
+    if ( !batch ) {
+        batch = BatchPtr( new Batch );
+    }
+    {
+        boost::lock_guard< boost::mutex > lock( m_Mutex );
+        ++batch->m_Pending;
+        Entry entry = { job, batch };
+        m_Queue.push_back( entry );
+        if ( batch->m_Waiting > 0 ) {
+            // a job adding to its own batch - the waiting thread can help with it
+            m_JobDone.notify_all();
+        }
+    }
+    m_JobAvailable.notify_one();
+    return batch;
+}
+
+bool JobQueue::RunOne( boost::unique_lock< boost::mutex >& lock, const Batch* batch /* = nullptr */ )
+{
+    auto it = m_Queue.begin();
+    if ( batch ) {
+        while ( it != m_Queue.end() && it->m_Batch.get() != batch ) ++it;
+    }
+    if ( it == m_Queue.end() ) {
+        return false;
+    }
+    Entry entry = *it;
+    m_Queue.erase( it );
+    lock.unlock();
+
+    std::string error;
+    try {
+        entry.m_Job();
+    } catch ( std::exception& ex ) {
+        error = ex.what();
+    } catch ( ... ) {
+        error = "Unknown error in job!";
+    }
+
+    lock.lock();
+    if ( !error.empty() && entry.m_Batch->m_Error.empty() ) {
+        entry.m_Batch->m_Error = error;
+    }
+    if ( --entry.m_Batch->m_Pending == 0 ) {
+        m_JobDone.notify_all();
+    }
+    return true;
+}
+
+void JobQueue::Run()
+{
+    boost::unique_lock< boost::mutex > lock( m_Mutex );
+    while ( !m_Terminate ) {
+        if ( !RunOne( lock ) ) {
+            m_JobAvailable.wait( lock );
+        }
+    }
+}
+
+bool JobQueue::IsDone( BatchPtr batch )
+{
+    boost::lock_guard< boost::mutex > lock( m_Mutex );
+    return !batch || batch->m_Pending == 0;
+}
+
+void JobQueue::Wait( BatchPtr batch ) throw(std::exception)
+{
+    if ( !batch ) return;
+
+    std::string error;
+    {
+        boost::unique_lock< boost::mutex > lock( m_Mutex );
+        ++batch->m_Waiting;
+        while ( batch->m_Pending > 0 ) {
+            // help out instead of idling - with this batch only, other jobs may take much longer
+            if ( !RunOne( lock, batch.get() ) ) {
+                m_JobDone.wait( lock );
+            }
+        }
+        --batch->m_Waiting;
+        error = batch->m_Error;
+    }
+    ASSERT( error.empty(), "Job failed: %s", error.c_str() );
+}
+
+void JobQueue::ParallelFor( int begin, int end, const RangeJob& job, int grain /* = 1 */ ) throw(std::exception)
+{
+    int count = end - begin;
+    if ( count <= 0 ) return;
+
+    // a few more chunks than threads to balance uneven work
+    int chunks = std::max( 1, std::min( (m_NumThreads + 1) * 2, count / std::max( 1, grain ) ) );
+    if ( chunks == 1 ) {
+        job( begin, end );
+        return;
+    }
+    BatchPtr batch( new Batch );
+    int step = (count + chunks - 1) / chunks;
+    for ( int first = begin; first < end; first += step ) {
+        Post( boost::bind( job, first, std::min( first + step, end ) ), batch );
+    }
+    Wait( batch );
+}
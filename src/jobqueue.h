@@ -0,0 +1,103 @@
+/*
+ * jobqueue.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef JOBQUEUE_H_
+#define JOBQUEUE_H_
+
+#include "err.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <string>
+
+/*!
+ * A small pool of worker threads. Jobs are posted into a batch and the
+ * caller waits on the batch. Waiting threads help with the jobs of the batch
+ * they wait for - and only those, so a ParallelFor() on the render thread
+ * never picks up a long job (say a texture to prepare) that happens to be
+ * queued in front of its own.
+ * Jobs must not touch GL - only the render thread owns the context.
+ */
+class JobQueue
+{
+public:
+    typedef boost::function< void() > Job;
+    typedef boost::function< void( int, int ) > RangeJob;
+
+    class Batch
+    {
+        int         m_Pending;
+        int         m_Waiting;      // threads in Wait() - woken when a job is added
+        std::string m_Error;
+
+        friend class JobQueue;
+    public:
+        Batch() : m_Pending(0), m_Waiting(0) {}
+    };
+    typedef boost::shared_ptr< Batch > BatchPtr;
+
+private:
+    struct Entry
+    {
+        Job      m_Job;
+        BatchPtr m_Batch;
+    };
+
+    bool                      m_Terminate;
+    std::deque< Entry >       m_Queue;
+    boost::mutex              m_Mutex;
+    boost::condition_variable m_JobAvailable;
+    boost::condition_variable m_JobDone;
+    boost::thread_group       m_Threads;
+    int                       m_NumThreads;
+public:
+    /*!
+     * numThreads = 0 uses one thread less than cores available (the render
+     * thread is busy as well)
+     */
+    JobQueue( int numThreads = 0 );
+
+    ~JobQueue();
+
+    int GetNumThreads() const { return m_NumThreads; }
+
+    /*!
+     * Add a job. If no batch is given a new one is created. Returns the batch
+     * the job was added to.
+     */
+    BatchPtr Post( const Job& job, BatchPtr batch = BatchPtr() );
+
+    /*!
+     * Block until all jobs of a batch are done. Rethrows the first error of
+     * a failed job.
+     */
+    void Wait( BatchPtr batch ) throw(std::exception);
+
+    /*!
+     * Non blocking check if all jobs of a batch are done.
+     */
+    bool IsDone( BatchPtr batch );
+
+    /*!
+     * Split [begin, end) into chunks of at least grain elements and run
+     * them in parallel. Blocks until done.
+     */
+    void ParallelFor( int begin, int end, const RangeJob& job, int grain = 1 ) throw(std::exception);
+
+private:
+    void Run();
+
+    // run one job (of batch if given) - expects the lock to be held. Returns false if there is none
+    bool RunOne( boost::unique_lock< boost::mutex >& lock, const Batch* batch = nullptr );
+};
+
+typedef boost::shared_ptr< JobQueue > JobQueuePtr;
+
+#endif /* JOBQUEUE_H_ */
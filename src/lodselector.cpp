@@ -0,0 +1,140 @@
+/*
+ * lodselector.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "lodselector.h"
+#include "entity.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+LodSelector::LodSelector( float hysteresis /* = 0.15f */ )
+    : m_NumViews(0)
+    , m_Counter(0)
+    , m_Hysteresis( hysteresis )
+    , m_CasterLevel(-1)
+    , m_CasterChanged(false)
+{
+}
+
+float LodSelector::GetScreenSize( const BoundingBox& bounds, const Matrix& modelview, const Matrix& projection, int viewportHeight )
+{
+    if ( bounds.IsEmpty() ) return std::numeric_limits<float>::max();
+
+    const float* m = modelview;
+    const float* p = projection;
+    // largest scale of the modelview - radius of the bounding sphere in eye space
+    float scale(0);
+    for ( int c = 0; c < 3; ++c ) {
+        scale = std::max( scale, m[c*4]*m[c*4] + m[c*4+1]*m[c*4+1] + m[c*4+2]*m[c*4+2] );
+    }
+    Vector extent = Vector( bounds.m_Max ).Sub( bounds.m_Min );
+    float radius = 0.5f * std::sqrt( scale * ( extent[Vector::X]*extent[Vector::X] +
+                                               extent[Vector::Y]*extent[Vector::Y] +
+                                               extent[Vector::Z]*extent[Vector::Z] ) );
+    if ( p[15] == 1.0f ) {
+        // orthographic: p[5] = 2/(top-bottom)
+        return radius * p[5] * viewportHeight;
+    }
+    Vector center = TransformPoint( modelview, bounds.GetCenter() );
+    float distance = -center[Vector::Z];
+    if ( distance <= radius ) {
+        return std::numeric_limits<float>::max();
+    }
+    // p[5] = cot(fovy/2): diameter 2r/d in NDC units of 2 per viewport height
+    return radius / distance * p[5] * viewportHeight;
+}
+
+int LodSelector::Step( const Mesh& mesh, int level, float size ) const
+{
+    // one direction only, until it is stable - Select() must give the same answer when called twice
+    const int numLods = mesh.GetNumLods();
+    while ( level > 0 && size > mesh.GetLodMinSize( level - 1 ) * ( 1.0f + m_Hysteresis ) ) {
+        --level;
+    }
+    while ( level < numLods - 1 && size < mesh.GetLodMinSize( level ) * ( 1.0f - m_Hysteresis ) ) {
+        ++level;
+    }
+    return level;
+}
+
+int LodSelector::Select( const Mesh& mesh, const BoundingBox& bounds, int pass )
+{
+    const int numLods = mesh.GetNumLods();
+    if ( numLods == 1 ) return 0;
+    ++m_Counter;
+
+    if ( pass & Entity::PASS_SHADOW_MAP_F ) {
+        int level = GetCasterLevel( numLods );
+        if ( level < numLods ) {
+            return level;
+        }
+        // no camera has seen it yet - fall through, select for the light's view
+    }
+
+    GLint viewport[4];
+    glGetIntegerv( GL_VIEWPORT, viewport );
+    Matrix modelview, projection;
+    glGetFloatv( GL_MODELVIEW_MATRIX, modelview );
+    glGetFloatv( GL_PROJECTION_MATRIX, projection );
+    float size = GetScreenSize( bounds, modelview, projection, viewport[3] );
+
+    if ( pass & Entity::PASS_SHADOW_MAP_F ) {
+        return Step( mesh, numLods - 1, size );
+    }
+
+    View* view(nullptr);
+    for ( int i = 0; i < m_NumViews; ++i ) {
+        if ( std::equal( viewport, viewport + 4, m_Views[i].m_Viewport ) ) {
+            view = &m_Views[i];
+            break;
+        }
+    }
+    if ( !view ) {
+        if ( m_NumViews < MAX_VIEWS ) {
+            view = &m_Views[ m_NumViews++ ];
+        } else {
+            view = &m_Views[0];
+            for ( int i = 1; i < m_NumViews; ++i ) {
+                if ( m_Views[i].m_LastUsed < view->m_LastUsed ) view = &m_Views[i];
+            }
+        }
+        std::copy( viewport, viewport + 4, view->m_Viewport );
+        // start from the coarsest - Step() goes straight to the right level
+        view->m_Level = numLods - 1;
+    }
+    view->m_LastUsed = m_Counter;
+    view->m_Level = Step( mesh, std::min( view->m_Level, numLods - 1 ), size );
+
+    int casterLevel = GetCasterLevel( numLods );
+    if ( casterLevel != m_CasterLevel ) {
+        m_CasterLevel   = casterLevel;
+        m_CasterChanged = true;
+    }
+    return view->m_Level;
+}
+
+bool LodSelector::CasterLevelChanged()
+{
+    bool changed = m_CasterChanged;
+    m_CasterChanged = false;
+    return changed;
+}
+
+int LodSelector::GetCasterLevel( int numLods ) const
+{
+    int level = numLods;
+    for ( int i = 0; i < m_NumViews; ++i ) {
+        // ignore views that weren't rendered for a while (resized window)
+        if ( m_Counter - m_Views[i].m_LastUsed < 4*MAX_VIEWS ) {
+            level = std::min( level, m_Views[i].m_Level );
+        }
+    }
+    return level;
+}
@@ -0,0 +1,70 @@
+/*
+ * lodselector.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef LODSELECTOR_H_
+#define LODSELECTOR_H_
+
+#include "err.h"
+#include "bounds.h"
+#include "mesh.h"
+
+/*!
+ * Picks the level of detail of a mesh from the projected size of the entity
+ * bounds - call it from DoRender(), it reads the current modelview, projection
+ * and viewport.
+ *
+ * Every viewport (main view, lighting preview, ...) keeps its own level. A
+ * level only changes once the size is clearly past the threshold, so objects
+ * sitting at the boundary don't pop back and forth. The selection is stable:
+ * the shadow test pass picks the same level as the lighting pass before it,
+ * both must rasterize the same triangles.
+ * Shadow map passes use the finest level any camera uses - coarser casters
+ * than receivers would shadow themselves (concave parts of the wave).
+ */
+class LodSelector
+{
+public:
+    enum {
+        MAX_VIEWS = 4,
+    };
+private:
+    struct View
+    {
+        int          m_Viewport[4];
+        int          m_Level;
+        unsigned int m_LastUsed;
+    };
+    View         m_Views[ MAX_VIEWS ];
+    int          m_NumViews;
+    unsigned int m_Counter;     // Select() calls - for LRU
+    float        m_Hysteresis;
+    int          m_CasterLevel;
+    bool         m_CasterChanged;
+public:
+    LodSelector( float hysteresis = 0.15f );
+
+    int Select( const Mesh& mesh, const BoundingBox& bounds, int pass );
+
+    /*!
+     * True once after the level for shadow casters changed - the entity
+     * should call GeometryChanged() so cached shadow maps get redrawn.
+     */
+    bool CasterLevelChanged();
+
+    /*!
+     * Projected size (diameter of the bounding sphere) in pixels. Any size
+     * if the eye is inside the bounds.
+     */
+    static float GetScreenSize( const BoundingBox& bounds, const Matrix& modelview, const Matrix& projection, int viewportHeight );
+
+private:
+    int GetCasterLevel( int numLods ) const;
+
+    int Step( const Mesh& mesh, int level, float size ) const;
+};
+
+#endif /* LODSELECTOR_H_ */
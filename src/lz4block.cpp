@@ -0,0 +1,135 @@
+/*
+ * lz4block.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "lz4block.h"
+
+#include <cstdint>
+#include <cstring>
+
+static const int         _hashBits     = 16;
+static const std::size_t _minMatch     = 4;
+static const std::size_t _lastLiterals = 5;     // a block ends with at least this many literals
+static const std::size_t _matchLimit   = 12;    // ...and the last match starts before this many bytes from the end
+static const std::size_t _maxOffset    = 65535;
+
+static std::uint32_t Read32( const char* p )
+{
+    std::uint32_t value;
+    std::memcpy( &value, p, sizeof(value) );
+    return value;
+}
+
+static std::uint32_t Hash( std::uint32_t sequence )
+{
+    return ( sequence * 2654435761u ) >> ( 32 - _hashBits );
+}
+
+// 15 in the token, then bytes of 255 and the rest
+static void WriteLength( std::vector<char>& dst, std::size_t length )
+{
+    for ( ; length >= 255; length -= 255 ) {
+        dst.push_back( char(255) );
+    }
+    dst.push_back( char( length ) );
+}
+
+static void WriteLiterals( std::vector<char>& dst, const char* literals, std::size_t count, unsigned int match )
+{
+    dst.push_back( char( ( count < 15 ? count : 15 ) << 4 | match ) );
+    if ( count >= 15 ) {
+        WriteLength( dst, count - 15 );
+    }
+    dst.insert( dst.end(), literals, literals + count );
+}
+
+static std::size_t ReadLength( const unsigned char*& in, const unsigned char* end ) throw(std::exception)
+{
+    std::size_t length(0);
+    unsigned char byte;
+    do {
+        ASSERT( in < end, "Corrupt LZ4 block - truncated length" );
+        byte = *in++;
+        length += byte;
+    } while ( byte == 255 );
+    return length;
+}
+
+void Lz4Block::Compress( const char* src, std::size_t size, std::vector<char>& dst )
+{
+    dst.clear();
+    dst.reserve( GetBound( size ) );
+
+    std::vector<std::size_t> table( std::size_t(1) << _hashBits, std::size_t(-1) );
+    std::size_t anchor(0), pos(0);
+    while ( size > _matchLimit && pos < size - _matchLimit ) {
+        const std::uint32_t sequence = Read32( src + pos );
+        std::size_t& entry = table[ Hash( sequence ) ];
+        const std::size_t candidate = entry;
+        entry = pos;
+        if ( candidate == std::size_t(-1) || pos - candidate > _maxOffset || Read32( src + candidate ) != sequence ) {
+            ++pos;
+            continue;
+        }
+        std::size_t end = pos + _minMatch;
+        while ( end < size - _lastLiterals && src[ end ] == src[ candidate + end - pos ] ) {
+            ++end;
+        }
+
+        const std::size_t length = end - pos - _minMatch;
+        WriteLiterals( dst, src + anchor, pos - anchor, length < 15 ? length : 15 );
+        const std::size_t offset = pos - candidate;
+        dst.push_back( char( offset & 0xff ) );
+        dst.push_back( char( offset >> 8 ) );
+        if ( length >= 15 ) {
+            WriteLength( dst, length - 15 );
+        }
+        pos = anchor = end;
+    }
+    WriteLiterals( dst, src + anchor, size - anchor, 0 );
+}
+
+void Lz4Block::Decompress( const char* src, std::size_t size, char* dst, std::size_t rawSize ) throw(std::exception)
+{
+    const unsigned char* in  = (const unsigned char*)src;
+    const unsigned char* end = in + size;
+    std::size_t out(0);
+    while ( in < end ) {
+        const unsigned int token = *in++;
+        std::size_t literals = token >> 4;
+        if ( literals == 15 ) {
+            literals += ReadLength( in, end );
+        }
+        ASSERT( literals <= std::size_t( end - in ) && literals <= rawSize - out, "Corrupt LZ4 block - literals out of range" );
+        if ( literals > 0 ) {
+            // dst may be null for an empty block
+            std::memcpy( dst + out, in, literals );
+        }
+        in  += literals;
+        out += literals;
+        if ( in == end ) break;     // the last sequence has no match
+
+        ASSERT( end - in >= 2, "Corrupt LZ4 block - truncated offset" );
+        const std::size_t offset = in[0] | in[1] << 8;
+        in += 2;
+        std::size_t length = ( token & 15 ) + _minMatch;
+        if ( ( token & 15 ) == 15 ) {
+            length += ReadLength( in, end );
+        }
+        ASSERT( offset > 0 && offset <= out && length <= rawSize - out, "Corrupt LZ4 block - match out of range" );
+        const char* match = dst + out - offset;
+        if ( offset >= length ) {
+            std::memcpy( dst + out, match, length );
+        } else {
+            // overlapping - repeats the last offset bytes
+            for ( std::size_t i = 0; i < length; ++i ) {
+                dst[ out + i ] = match[ i ];
+            }
+        }
+        out += length;
+    }
+    ASSERT( out == rawSize, "Corrupt LZ4 block - %d of %d bytes", int( out ), int( rawSize ) );
+}
@@ -0,0 +1,36 @@
+/*
+ * lz4block.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef LZ4BLOCK_H_
+#define LZ4BLOCK_H_
+
+#include "err.h"
+
+#include <cstddef>
+#include <vector>
+
+/*!
+ * LZ4 block format (no frame) - compatible with lz4's LZ4_decompress_safe()
+ * and LZ4_compress_default(). The compressor is a plain greedy one for the
+ * packer tool, the decompressor checks every length against both buffers
+ * so a corrupt archive throws instead of writing past them.
+ */
+class Lz4Block
+{
+public:
+    // worst case size of a compressed block
+    static std::size_t GetBound( std::size_t size ) { return size + size / 255 + 16; }
+
+    static void Compress( const char* src, std::size_t size, std::vector<char>& dst );
+
+    /*!
+     * Exactly rawSize bytes into dst
+     */
+    static void Decompress( const char* src, std::size_t size, char* dst, std::size_t rawSize ) throw(std::exception);
+};
+
+#endif /* LZ4BLOCK_H_ */
@@ -23,7 +23,7 @@ public:
         SCALE_Z = 10,
 
         POS_X = 12,
-        POX_Y = 13,
+        POS_Y = 13,
         POS_Z = 14,
     };
 private:
@@ -292,6 +292,75 @@ public:
         return *this;
     }
 
+    /*!
+     * General 4x4 inverse (cofactor expansion). Leaves the matrix untouched and
+     * returns false if it is singular.
+     */
+    inline bool Invert()
+    {
+        float inv[16];
+        inv[0]  =  m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15] + m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+        inv[4]  = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15] - m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+        inv[8]  =  m[4]*m[9] *m[15] - m[4]*m[11]*m[13] - m[8]*m[5]*m[15] + m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[9];
+        inv[12] = -m[4]*m[9] *m[14] + m[4]*m[10]*m[13] + m[8]*m[5]*m[14] - m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[9];
+        inv[1]  = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15] - m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+        inv[5]  =  m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15] + m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+        inv[9]  = -m[0]*m[9] *m[15] + m[0]*m[11]*m[13] + m[8]*m[1]*m[15] - m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[9];
+        inv[13] =  m[0]*m[9] *m[14] - m[0]*m[10]*m[13] - m[8]*m[1]*m[14] + m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[9];
+        inv[2]  =  m[1]*m[6] *m[15] - m[1]*m[7] *m[14] - m[5]*m[2]*m[15] + m[5]*m[3]*m[14] + m[13]*m[2]*m[7]  - m[13]*m[3]*m[6];
+        inv[6]  = -m[0]*m[6] *m[15] + m[0]*m[7] *m[14] + m[4]*m[2]*m[15] - m[4]*m[3]*m[14] - m[12]*m[2]*m[7]  + m[12]*m[3]*m[6];
+        inv[10] =  m[0]*m[5] *m[15] - m[0]*m[7] *m[13] - m[4]*m[1]*m[15] + m[4]*m[3]*m[13] + m[12]*m[1]*m[7]  - m[12]*m[3]*m[5];
+        inv[14] = -m[0]*m[5] *m[14] + m[0]*m[6] *m[13] + m[4]*m[1]*m[14] - m[4]*m[2]*m[13] - m[12]*m[1]*m[6]  + m[12]*m[2]*m[5];
+        inv[3]  = -m[1]*m[6] *m[11] + m[1]*m[7] *m[10] + m[5]*m[2]*m[11] - m[5]*m[3]*m[10] - m[9] *m[2]*m[7]  + m[9] *m[3]*m[6];
+        inv[7]  =  m[0]*m[6] *m[11] - m[0]*m[7] *m[10] - m[4]*m[2]*m[11] + m[4]*m[3]*m[10] + m[8] *m[2]*m[7]  - m[8] *m[3]*m[6];
+        inv[11] = -m[0]*m[5] *m[11] + m[0]*m[7] *m[9]  + m[4]*m[1]*m[11] - m[4]*m[3]*m[9]  - m[8] *m[1]*m[7]  + m[8] *m[3]*m[5];
+        inv[15] =  m[0]*m[5] *m[10] - m[0]*m[6] *m[9]  - m[4]*m[1]*m[10] + m[4]*m[2]*m[9]  + m[8] *m[1]*m[6]  - m[8] *m[2]*m[5];
+
+        float det = m[0]*inv[0] + m[1]*inv[4] + m[2]*inv[8] + m[3]*inv[12];
+        if ( det == 0 ) {
+            return false;
+        }
+        det = 1.0f / det;
+        for ( int i = 0; i < 16; ++i ) {
+            m[i] = inv[i] * det;
+        }
+        return true;
+    }
+
+    inline Matrix Inverse() const
+    {
+        Matrix inv( *this );
+        inv.Invert();
+        return inv;
+    }
+
+    /*!
+     * Load a view matrix looking from eye to center - same as gluLookAt, but
+     * without touching the GL matrix stack.
+     */
+    inline Matrix& LookAt( const float eye[4], const float center[4], const float up[4] )
+    {
+        float f[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] };
+        float fl = std::sqrt( f[0]*f[0] + f[1]*f[1] + f[2]*f[2] );
+        f[0] /= fl; f[1] /= fl; f[2] /= fl;
+        // s = f x up
+        float s[3] = { f[1]*up[2] - f[2]*up[1], f[2]*up[0] - f[0]*up[2], f[0]*up[1] - f[1]*up[0] };
+        float sl = std::sqrt( s[0]*s[0] + s[1]*s[1] + s[2]*s[2] );
+        s[0] /= sl; s[1] /= sl; s[2] /= sl;
+        // u = s x f
+        float u[3] = { s[1]*f[2] - s[2]*f[1], s[2]*f[0] - s[0]*f[2], s[0]*f[1] - s[1]*f[0] };
+
+        m[0] = s[0]; m[4] = s[1]; m[8]  = s[2];
+        m[1] = u[0]; m[5] = u[1]; m[9]  = u[2];
+        m[2] =-f[0]; m[6] =-f[1]; m[10] =-f[2];
+        m[3] = 0;    m[7] = 0;    m[11] = 0;
+        m[12] = -( s[0]*eye[0] + s[1]*eye[1] + s[2]*eye[2] );
+        m[13] = -( u[0]*eye[0] + u[1]*eye[1] + u[2]*eye[2] );
+        m[14] =  ( f[0]*eye[0] + f[1]*eye[1] + f[2]*eye[2] );
+        m[15] = 1;
+        return *this;
+    }
+
     inline Matrix& operator=( const float ma[16] )
     {
         std::memcpy( m, ma, sizeof(m) );
@@ -0,0 +1,191 @@
+/*
+ * mesh.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "mesh.h"
+#include "bufferbinding.h"
+
+#include <algorithm>
+
+static const GLenum sClientStates[ Mesh::NUM_ATTRIBUTES ] = {
+    GL_VERTEX_ARRAY, GL_NORMAL_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY
+};
+
+static inline std::size_t IndexSize( GLenum type )
+{
+    return type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+Mesh::Mesh( GeometryArenaPtr arena, GLenum primitive /* = GL_TRIANGLES */ )
+    : m_Arena( arena )
+    , m_Primitive( primitive )
+    , m_NumVertices(0)
+    , m_NumIndices(0)
+    , m_IndexType( GL_UNSIGNED_INT )
+    , m_VertexBytes(0)
+    , m_VertexSize(0)
+{
+    ASSERT( m_Arena, "Mesh without geometry arena!" );
+    m_ACMR[0] = m_ACMR[1] = 0;
+}
+
+Mesh::~Mesh()
+{
+    // last user is gone. Like all GL objects this must happen on the render thread
+    if ( m_VertexBlock ) {
+        m_Arena->Free( m_VertexBlock );
+    }
+    if ( m_IndexBlock ) {
+        m_Arena->Free( m_IndexBlock );
+    }
+}
+
+void Mesh::SetVertexData( const void* data, std::size_t size, int numVertices ) throw(std::exception)
+{
+    ASSERT( numVertices > 0 && size % numVertices == 0, "Vertex data is not made of whole vertices" );
+    if ( m_VertexBlock ) {
+        m_Arena->Free( m_VertexBlock );
+    }
+    m_VertexSize  = size / numVertices;
+    m_VertexBlock = m_Arena->Allocate( GeometryArena::VERTICES, size, m_VertexSize );
+    m_Arena->Upload( m_VertexBlock, data );
+    m_NumVertices = numVertices;
+    m_VertexBytes = size;
+}
+
+void Mesh::SetAttribute( Attribute attribute, int size, int stride, std::size_t offset )
+{
+    m_Format.Set( attribute, VertexFormat::FLOAT, size, stride, offset );
+}
+
+void Mesh::SetIndices( const std::vector<unsigned int>& indices ) throw(std::exception)
+{
+    ASSERT( !indices.empty(), "Mesh without indices!" );
+    if ( *std::max_element( indices.begin(), indices.end() ) <= 0xFFFF ) {
+        // half the index bandwidth
+        std::vector<unsigned short> shortIndices( indices.begin(), indices.end() );
+        SetIndexData( &shortIndices[0], shortIndices.size(), GL_UNSIGNED_SHORT );
+    } else {
+        SetIndexData( &indices[0], indices.size(), GL_UNSIGNED_INT );
+    }
+}
+
+void Mesh::SetIndexData( const void* data, int numIndices, GLenum type ) throw(std::exception)
+{
+    ASSERT( numIndices > 0, "Mesh without indices!" );
+    ASSERT( type == GL_UNSIGNED_SHORT || type == GL_UNSIGNED_INT, "Invalid index type 0x%x", type );
+    if ( m_IndexBlock ) {
+        m_Arena->Free( m_IndexBlock );
+    }
+    m_IndexBlock = m_Arena->Allocate( GeometryArena::INDICES, IndexSize( type )*numIndices, IndexSize( type ) );
+    m_Arena->Upload( m_IndexBlock, data );
+    m_IndexType  = type;
+    m_NumIndices = numIndices;
+    m_Lods.clear();
+}
+
+void Mesh::AddLod( int firstIndex, int numIndices, float minSize ) throw(std::exception)
+{
+    ASSERT( firstIndex >= 0 && numIndices > 0 && firstIndex + numIndices <= m_NumIndices,
+            "LOD out of index range: %d+%d/%d", firstIndex, numIndices, m_NumIndices );
+    ASSERT( int(m_Lods.size()) < MAX_LODS, "Too many LODs" );
+    ASSERT( m_Lods.empty() || minSize < m_Lods.back().m_MinSize, "LODs must get coarser" );
+    Lod lod = { firstIndex, numIndices, minSize };
+    m_Lods.push_back( lod );
+}
+
+bool Mesh::IsInterleaved() const
+{
+    for ( int i = 0; i < NUM_ATTRIBUTES; ++i ) {
+        if ( !m_Format.Has( i ) ) continue;
+        if ( m_Format.GetStride( i ) != int(m_VertexSize) || m_Format.GetOffset( i ) >= m_VertexSize ) return false;
+    }
+    return true;
+}
+
+unsigned int Mesh::Enable( unsigned int attributes /* = ALL_ATTRIBUTES_F */ ) const
+{
+    unsigned int enabled(0);
+    // with a base vertex the pointers are the same for all meshes of this format
+    const std::size_t base = UsesBaseVertex() ? 0 : GetVertexOffset();
+    // the arena stays bound after Disable() - the next mesh binds nothing
+    BufferBinding::Bind( GL_ARRAY_BUFFER, GetVertexBuffer() );
+    for ( int i = 0; i < NUM_ATTRIBUTES; ++i ) {
+        if ( !( attributes & (1<<i) ) || !m_Format.Has( i ) ) continue;
+
+        int arrayEnabled;
+        glGetIntegerv( sClientStates[i], &arrayEnabled );
+        if ( !arrayEnabled ) {
+            glEnableClientState( sClientStates[i] );
+            enabled |= 1<<i;
+        }
+        const int    size   = m_Format.GetSize( i );
+        const GLenum type   = m_Format.GetType( i );
+        const int    stride = m_Format.GetStride( i );
+        void* offset = (void*)( base + m_Format.GetOffset( i ) );
+        switch ( i ) {
+        case POSITION: glVertexPointer( size, type, stride, offset ); break;
+        case NORMAL:   glNormalPointer( type, stride, offset ); break;
+        case COLOR:    glColorPointer( size, type, stride, offset ); break;
+        case TEXCOORD: glTexCoordPointer( size, type, stride, offset ); break;
+        }
+    }
+    if ( m_IndexBlock ) {
+        BufferBinding::Bind( GL_ELEMENT_ARRAY_BUFFER, GetIndexBuffer() );
+    }
+    return enabled;
+}
+
+std::size_t Mesh::GetIndexOffset( int lod ) const
+{
+    const int first = m_Lods.empty() ? 0 : m_Lods[ lod ].m_FirstIndex;
+    return m_IndexBlock->m_Offset + first*IndexSize( m_IndexType );
+}
+
+void Mesh::Draw( int lod /* = 0 */ ) const
+{
+    if ( m_IndexBlock ) {
+        void* indices = (void*)GetIndexOffset( lod );
+        if ( UsesBaseVertex() ) {
+            glDrawElementsBaseVertex( m_Primitive, GetNumIndices( lod ), m_IndexType, indices, m_VertexBlock->m_Offset / m_VertexSize );
+        } else {
+            glDrawElements( m_Primitive, GetNumIndices( lod ), m_IndexType, indices );
+        }
+    } else {
+        const int first = UsesBaseVertex() ? m_VertexBlock->m_Offset / m_VertexSize : 0;
+        glDrawArrays( m_Primitive, first, m_NumVertices );
+    }
+}
+
+void Mesh::DrawInstanced( int count, int lod /* = 0 */ ) const
+{
+    if ( m_IndexBlock ) {
+        void* indices = (void*)GetIndexOffset( lod );
+        if ( UsesBaseVertex() ) {
+            glDrawElementsInstancedBaseVertex( m_Primitive, GetNumIndices( lod ), m_IndexType, indices, count,
+                                               m_VertexBlock->m_Offset / m_VertexSize );
+        } else {
+            glDrawElementsInstancedARB( m_Primitive, GetNumIndices( lod ), m_IndexType, indices, count );
+        }
+    } else {
+        const int first = UsesBaseVertex() ? m_VertexBlock->m_Offset / m_VertexSize : 0;
+        glDrawArraysInstancedARB( m_Primitive, first, m_NumVertices, count );
+    }
+}
+
+void Mesh::Disable( unsigned int enabled ) const
+{
+    for ( int i = 0; i < NUM_ATTRIBUTES; ++i ) {
+        if ( enabled & (1<<i) ) {
+            glDisableClientState( sClientStates[i] );
+        }
+    }
+}
+
+std::size_t Mesh::GetMemoryUsage() const
+{
+    return m_VertexBytes + IndexSize( m_IndexType )*m_NumIndices;
+}
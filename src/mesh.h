@@ -0,0 +1,183 @@
+/*
+ * mesh.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef MESH_H_
+#define MESH_H_
+
+#include "err.h"
+#include "bounds.h"
+#include "geometryarena.h"
+#include "vertexformat.h"
+
+#include <GL/glew.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+/*!
+ * Static GPU geometry: a vertex block with any number of attribute streams
+ * (planar or interleaved) plus an optional index block, both in the
+ * GeometryArena. Meshes are immutable once uploaded and shared between
+ * entities through MeshCache.
+ * Interleaved meshes are drawn with a base vertex - their attribute pointers
+ * don't depend on where the mesh is in the arena. Planar ones point the
+ * attributes at their block.
+ * Must be created, used and destroyed on the render thread.
+ */
+class Mesh
+{
+public:
+    enum Attribute {
+        POSITION = VertexFormat::POSITION,
+        NORMAL   = VertexFormat::NORMAL,
+        COLOR    = VertexFormat::COLOR,
+        TEXCOORD = VertexFormat::TEXCOORD,
+
+        NUM_ATTRIBUTES = VertexFormat::MAX_ATTRIBUTES
+    };
+    enum AttributeFlag {
+        POSITION_F = 1<<POSITION,
+        NORMAL_F   = 1<<NORMAL,
+        COLOR_F    = 1<<COLOR,
+        TEXCOORD_F = 1<<TEXCOORD,
+
+        ALL_ATTRIBUTES_F = (1<<NUM_ATTRIBUTES)-1
+    };
+    enum {
+        MAX_LODS = 4
+    };
+    /*!
+     * A level of detail is a range of the index buffer. All levels share the
+     * vertex buffer. Level 0 is the finest.
+     */
+    struct Lod
+    {
+        int         m_FirstIndex;
+        int         m_NumIndices;
+        float       m_MinSize;      // smallest projected size (pixels) this level is used for
+    };
+private:
+    GeometryArenaPtr          m_Arena;
+    GeometryArena::BlockPtr   m_VertexBlock;
+    GeometryArena::BlockPtr   m_IndexBlock;
+    VertexFormat m_Format;
+    GLenum      m_Primitive;
+    int         m_NumVertices;
+    int         m_NumIndices;
+    GLenum      m_IndexType;        // GL_UNSIGNED_SHORT if all indices fit
+    std::size_t m_VertexBytes;
+    std::size_t m_VertexSize;       // bytes per vertex - vertex block alignment
+    float       m_ACMR[2];          // before/after optimization, 0 = unknown
+    BoundingBox m_Bounds;
+    std::vector<Lod> m_Lods;        // empty = one level, all indices
+public:
+    Mesh( GeometryArenaPtr arena, GLenum primitive = GL_TRIANGLES );
+
+    ~Mesh();
+
+    /*!
+     * Upload the vertex buffer. Attributes are described by SetFormat() or SetAttribute().
+     */
+    void SetVertexData( const void* data, std::size_t size, int numVertices ) throw(std::exception);
+
+    void SetFormat( const VertexFormat& format ) { m_Format = format; }
+
+    const VertexFormat& GetFormat() const { return m_Format; }
+
+    /*!
+     * Float attribute. size: components (normals always use 3). stride and offset in bytes.
+     */
+    void SetAttribute( Attribute attribute, int size, int stride, std::size_t offset );
+
+    /*!
+     * Without indices the mesh is drawn with glDrawArrays(). Stored as 16 bit
+     * if the largest index allows it.
+     */
+    void SetIndices( const std::vector<unsigned int>& indices ) throw(std::exception);
+
+    /*!
+     * Upload indices as they are - type is GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+     */
+    void SetIndexData( const void* data, int numIndices, GLenum type ) throw(std::exception);
+
+    /*!
+     * Add the next coarser level - a range of the indices set with SetIndices().
+     * minSize must decrease from level to level, the last one should be 0.
+     */
+    void AddLod( int firstIndex, int numIndices, float minSize ) throw(std::exception);
+
+    int GetNumLods() const { return m_Lods.empty() ? 1 : m_Lods.size(); }
+
+    float GetLodMinSize( int lod ) const { return m_Lods.empty() ? 0 : m_Lods[ lod ].m_MinSize; }
+
+    int GetNumIndices( int lod ) const { return m_Lods.empty() ? m_NumIndices : m_Lods[ lod ].m_NumIndices; }
+
+    /*!
+     * Average cache miss ratio of the generated and the optimized index order
+     */
+    void SetACMR( float before, float after ) { m_ACMR[0] = before; m_ACMR[1] = after; }
+
+    float GetACMR( bool optimized = true ) const { return m_ACMR[ optimized ? 1 : 0 ]; }
+
+    void SetBounds( const BoundingBox& bounds ) { m_Bounds = bounds; }
+
+    const BoundingBox& GetBounds() const { return m_Bounds; }
+
+    bool HasAttribute( Attribute attribute ) const { return m_Format.Has( attribute ); }
+
+    int GetNumVertices() const { return m_NumVertices; }
+
+    int GetNumIndices() const { return m_NumIndices; }
+
+    GLuint GetVertexBuffer() const { return m_Arena->GetBuffer( GeometryArena::VERTICES ); }
+
+    // bytes into GetVertexBuffer(). May change between frames (arena defragmentation)
+    std::size_t GetVertexOffset() const { return m_VertexBlock ? m_VertexBlock->m_Offset : 0; }
+
+    GLuint GetIndexBuffer() const { return m_Arena->GetBuffer( GeometryArena::INDICES ); }
+
+    GLenum GetIndexType() const { return m_IndexType; }
+
+    /*!
+     * All attributes in one stream of whole vertices
+     */
+    bool IsInterleaved() const;
+
+    /*!
+     * Bind the buffers and set the array pointers of the requested (and
+     * present) attributes. Returns the client states it had to switch on -
+     * pass them to Disable(). Texture coords go to the active client texture unit.
+     * The arena buffers stay bound (see BufferBinding) - code drawing from
+     * client memory binds 0 itself.
+     */
+    unsigned int Enable( unsigned int attributes = ALL_ATTRIBUTES_F ) const;
+
+    void Draw( int lod = 0 ) const;
+
+    /*!
+     * Needs GL_ARB_draw_instanced - see InstancedBatch
+     */
+    void DrawInstanced( int count, int lod = 0 ) const;
+
+    void Disable( unsigned int enabled ) const;
+
+private:
+    bool UsesBaseVertex() const { return m_VertexBlock && m_Arena->HasBaseVertex() && IsInterleaved(); }
+
+    // first index of lod, in bytes into GetIndexBuffer()
+    std::size_t GetIndexOffset( int lod ) const;
+
+public:
+
+    // GPU memory used by this mesh
+    std::size_t GetMemoryUsage() const;
+};
+
+typedef boost::shared_ptr<Mesh> MeshPtr;
+
+#endif /* MESH_H_ */
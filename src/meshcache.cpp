@@ -0,0 +1,142 @@
+/*
+ * meshcache.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "meshcache.h"
+#include "meshfile.h"
+
+#include <cstdio>
+#include <cstdarg>
+#include <iomanip>
+#include <iostream>
+
+#include <boost/filesystem/operations.hpp>
+
+namespace bfs = boost::filesystem;
+
+MeshCache::MeshCache( GeometryArenaPtr arena )
+    : m_Arena( arena )
+    , m_CookedPath( "data/meshes" )
+    , m_NumHits(0)
+    , m_NumBuilds(0)
+    , m_NumLoads(0)
+{
+}
+
+MeshPtr MeshCache::Get( const std::string& key, const Builder& builder ) throw(std::exception)
+{
+    MeshMap::iterator it = m_Meshes.find( key );
+    if ( it != m_Meshes.end() ) {
+        MeshPtr mesh = it->second.lock();
+        if ( mesh ) {
+            ++m_NumHits;
+            return mesh;
+        }
+    }
+    MeshPtr mesh = Load( key );
+    if ( !mesh ) {
+        MeshData data;
+        builder( data );
+        mesh = data.Upload( m_Arena, VertexFormat::MakeCompact( data.GetAttributes() ) );
+        ++m_NumBuilds;
+    }
+    Add( key, mesh );
+    return mesh;
+}
+
+MeshPtr MeshCache::GetCooked( const std::string& key ) throw(std::exception)
+{
+    MeshMap::iterator it = m_Meshes.find( key );
+    if ( it != m_Meshes.end() ) {
+        MeshPtr mesh = it->second.lock();
+        if ( mesh ) {
+            ++m_NumHits;
+            return mesh;
+        }
+    }
+    MeshPtr mesh = Load( key );
+    ASSERT( mesh, "No cooked mesh for '%s' in '%s'", key.c_str(), m_CookedPath.c_str() );
+    Add( key, mesh );
+    return mesh;
+}
+
+MeshPtr MeshCache::Load( const std::string& key ) throw(std::exception)
+{
+    if ( m_CookedPath.empty() ) return MeshPtr();
+
+    std::string filename = MeshFile::GetFileName( m_CookedPath, key );
+    if ( !bfs::exists( filename ) ) return MeshPtr();
+
+    MeshFile file;
+    try {
+        file.Load( filename.c_str() );
+    } catch ( std::exception& ex ) {
+        // cooked by an older version or broken - built like a missing one
+        std::cerr << "Ignoring cooked mesh '" << filename << "': " << ex.what() << std::endl;
+        return MeshPtr();
+    }
+    // cooked for better hardware - build it for this one
+    if ( !file.IsSupported() ) return MeshPtr();
+
+    ++m_NumLoads;
+    return file.Upload( m_Arena );
+}
+
+void MeshCache::Add( const std::string& key, MeshPtr mesh )
+{
+    // drop the dead ones before we grow
+    Prune();
+    m_Meshes[ key ] = mesh;
+}
+
+int MeshCache::GetNumMeshes() const
+{
+    int count(0);
+    for ( auto& entry : m_Meshes ) {
+        count += !entry.second.expired();
+    }
+    return count;
+}
+
+std::string MeshCache::MakeKey( const char* type, const char* format, ... )
+{
+    char buffer[256];
+    int n = std::snprintf( buffer, sizeof(buffer), "%s:", type );
+    va_list args;
+    va_start( args, format );
+    std::vsnprintf( buffer + n, sizeof(buffer) - n, format, args );
+    va_end( args );
+    return buffer;
+}
+
+void MeshCache::Dump( std::ostream& out ) const
+{
+    out << "meshes: " << GetNumMeshes() << " live, " << m_NumBuilds << " built, " << m_NumLoads << " cooked, " << m_NumHits << " shared" << std::endl;
+    for ( auto& entry : m_Meshes ) {
+        MeshPtr mesh = entry.second.lock();
+        if ( !mesh ) continue;
+        out << std::setw(40) << std::left << entry.first
+            << " users " << std::setw(4) << std::right << mesh.use_count() - 1
+            << " vertices " << std::setw(6) << mesh->GetNumVertices()
+            << " indices " << std::setw(6) << mesh->GetNumIndices()
+            << ( mesh->GetIndexType() == GL_UNSIGNED_SHORT ? " (16)" : " (32)" )
+            << " kb " << std::setw(6) << mesh->GetMemoryUsage() / 1024
+            << std::fixed << std::setprecision(3)
+            << " acmr " << mesh->GetACMR( false ) << " -> " << mesh->GetACMR( true )
+            << std::endl;
+    }
+}
+
+void MeshCache::Prune()
+{
+    for ( MeshMap::iterator it = m_Meshes.begin(); it != m_Meshes.end(); ) {
+        if ( it->second.expired() ) {
+            it = m_Meshes.erase( it );
+        } else {
+            ++it;
+        }
+    }
+}
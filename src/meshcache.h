@@ -0,0 +1,99 @@
+/*
+ * meshcache.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef MESHCACHE_H_
+#define MESHCACHE_H_
+
+#include "err.h"
+#include "mesh.h"
+#include "meshdata.h"
+#include "geometryarena.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <string>
+#include <ostream>
+
+/*!
+ * Shares meshes between entities. A mesh is identified by a key made of its
+ * primitive type and all generation parameters (see MakeKey()). The cache
+ * only holds weak references: the mesh and its GPU buffers go away with
+ * the last entity using it and are rebuilt on the next request.
+ * A mesh is loaded from the cooked mesh directory if the meshcook tool
+ * wrote a file for its key, otherwise the builder generates it.
+ * Render thread only.
+ */
+class MeshCache
+{
+public:
+    // fills the CPU side of the mesh - no GL, may use the job queue
+    typedef boost::function< void( MeshData& ) > Builder;
+private:
+    typedef boost::unordered_map< std::string, boost::weak_ptr<Mesh> > MeshMap;
+
+    GeometryArenaPtr m_Arena;
+    std::string      m_CookedPath;
+    MeshMap m_Meshes;
+    int     m_NumHits;
+    int     m_NumBuilds;
+    int     m_NumLoads;
+public:
+    MeshCache( GeometryArenaPtr arena );
+
+    /*!
+     * Directory of cooked meshes. Empty = always build
+     */
+    void SetCookedPath( const std::string& path ) { m_CookedPath = path; }
+
+    const std::string& GetCookedPath() const { return m_CookedPath; }
+
+    /*!
+     * Shared mesh for key. Only loaded or built if there is no live mesh for
+     * key yet.
+     */
+    MeshPtr Get( const std::string& key, const Builder& builder ) throw(std::exception);
+
+    /*!
+     * Meshes without a builder - external meshes must be cooked
+     */
+    MeshPtr GetCooked( const std::string& key ) throw(std::exception);
+
+    // number of live meshes
+    int GetNumMeshes() const;
+
+    int GetNumHits() const { return m_NumHits; }
+
+    int GetNumBuilds() const { return m_NumBuilds; }
+
+    int GetNumLoads() const { return m_NumLoads; }
+
+    /*!
+     * Key from the primitive type and a printf style parameter list. Print
+     * floats with %.9g - equal keys must mean equal geometry.
+     */
+    static std::string MakeKey( const char* type, const char* format, ... );
+
+    /*!
+     * Live meshes with their size and vertex cache efficiency
+     */
+    void Dump( std::ostream& out ) const;
+
+private:
+    // null if there is no usable cooked file for key - missing, stale, corrupt or too demanding
+    MeshPtr Load( const std::string& key ) throw(std::exception);
+
+    void Add( const std::string& key, MeshPtr mesh );
+
+    void Prune();
+};
+
+typedef boost::shared_ptr<MeshCache> MeshCachePtr;
+
+#endif /* MESHCACHE_H_ */
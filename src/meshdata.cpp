@@ -0,0 +1,57 @@
+/*
+ * meshdata.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "meshdata.h"
+
+MeshData::MeshData()
+    : m_Primitive( GL_TRIANGLES )
+{
+    m_ACMR[0] = m_ACMR[1] = 0;
+}
+
+unsigned int MeshData::GetAttributes() const
+{
+    unsigned int attributes(0);
+    for ( int i = 0; i < Mesh::NUM_ATTRIBUTES; ++i ) {
+        if ( !m_Streams[i].empty() ) {
+            attributes |= 1<<i;
+        }
+    }
+    return attributes;
+}
+
+void MeshData::Encode( const VertexFormat& format, std::vector<char>& vertices ) const
+{
+    const int numVertices = GetNumVertices();
+    const Vector* streams[ Mesh::NUM_ATTRIBUTES ];
+    for ( int i = 0; i < Mesh::NUM_ATTRIBUTES; ++i ) {
+        ASSERT( m_Streams[i].empty() || int(m_Streams[i].size()) == numVertices, "Vertex stream %d has %d of %d vertices",
+                i, int(m_Streams[i].size()), numVertices );
+        streams[i] = m_Streams[i].empty() ? nullptr : &m_Streams[i][0];
+    }
+    format.Interleave( streams, numVertices, vertices );
+}
+
+MeshPtr MeshData::Upload( GeometryArenaPtr arena, const VertexFormat& format ) const throw(std::exception)
+{
+    MeshPtr mesh( new Mesh( arena, m_Primitive ) );
+    if ( GetNumVertices() > 0 ) {
+        std::vector<char> vertices;
+        Encode( format, vertices );
+        mesh->SetFormat( format );
+        mesh->SetVertexData( &vertices[0], vertices.size(), GetNumVertices() );
+    }
+    if ( !m_Indices.empty() ) {
+        mesh->SetIndices( m_Indices );
+    }
+    for ( auto& lod : m_Lods ) {
+        mesh->AddLod( lod.m_FirstIndex, lod.m_NumIndices, lod.m_MinSize );
+    }
+    mesh->SetACMR( m_ACMR[0], m_ACMR[1] );
+    mesh->SetBounds( m_Bounds );
+    return mesh;
+}
@@ -0,0 +1,48 @@
+/*
+ * meshdata.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef MESHDATA_H_
+#define MESHDATA_H_
+
+#include "err.h"
+#include "mesh.h"
+#include "vertexformat.h"
+#include "geometryarena.h"
+
+#include <vector>
+
+/*!
+ * CPU side of a mesh as the builders generate it: one float stream per
+ * attribute, 32 bit indices. No GL - builders run on workers and in the
+ * mesh cook tool. Upload() encodes it into a vertex format and creates the
+ * GPU mesh, MeshFile::Save() cooks it.
+ */
+struct MeshData
+{
+    GLenum                    m_Primitive;
+    std::vector<Vector>       m_Streams[ Mesh::NUM_ATTRIBUTES ];   // empty = attribute not present
+    std::vector<unsigned int> m_Indices;                           // empty = glDrawArrays()
+    std::vector<Mesh::Lod>    m_Lods;
+    BoundingBox               m_Bounds;
+    float                     m_ACMR[2];
+
+    MeshData();
+
+    int GetNumVertices() const { return m_Streams[ Mesh::POSITION ].size(); }
+
+    // Mesh::AttributeFlag of all present streams
+    unsigned int GetAttributes() const;
+
+    /*!
+     * Interleaved vertices in format - all its attributes must be present
+     */
+    void Encode( const VertexFormat& format, std::vector<char>& vertices ) const;
+
+    MeshPtr Upload( GeometryArenaPtr arena, const VertexFormat& format ) const throw(std::exception);
+};
+
+#endif /* MESHDATA_H_ */
@@ -0,0 +1,184 @@
+/*
+ * meshfile.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "meshfile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+static inline uint32_t AlignUp( uint32_t offset )
+{
+    return ( offset + MeshFile::STREAM_ALIGNMENT - 1 ) & ~uint32_t( MeshFile::STREAM_ALIGNMENT - 1 );
+}
+
+// [offset, offset + bytes) inside the file and aligned. 64 bit - offset + bytes must not wrap
+static inline bool IsValidRange( uint32_t offset, uint32_t bytes, std::size_t fileSize )
+{
+    return offset % MeshFile::STREAM_ALIGNMENT == 0 && uint64_t(offset) + bytes <= fileSize;
+}
+
+MeshFile::MeshFile()
+    : m_Header( nullptr )
+{
+}
+
+MeshFile::~MeshFile()
+{
+}
+
+bool MeshFile::Load( const char* filename ) throw(std::exception)
+{
+    m_Header = nullptr;
+    m_FileHandle.open( filename, std::ios_base::binary | std::ios_base::in );
+    ASSERT( m_FileHandle.is_open() && m_FileHandle.size() >= sizeof(Header), "File open error! Invalid file or file size! (%s)", filename );
+
+    const Header* header = (const Header*)m_FileHandle.const_data();
+    ASSERT( header->m_Magic == MAGIC && header->m_Version == VERSION, "Not a cooked mesh or wrong version (%s)", filename );
+    ASSERT( header->m_Primitive <= GL_POLYGON, "Invalid primitive 0x%x (%s)", header->m_Primitive, filename );
+
+    // vertices: whole vertices of the format
+    ASSERT( IsValidRange( header->m_VertexOffset, header->m_VertexBytes, m_FileHandle.size() ) &&
+            uint64_t(header->m_NumVertices) * header->m_VertexSize == header->m_VertexBytes &&
+            ( header->m_NumVertices == 0 || header->m_VertexSize > 0 ),
+            "Invalid vertex stream (%s)", filename );
+    for ( int i = 0; i < Mesh::NUM_ATTRIBUTES; ++i ) {
+        const auto& attribute = header->m_Attributes[i];
+        if ( attribute.m_Encoding == VertexFormat::NONE ) continue;
+        ASSERT( attribute.m_Encoding < VertexFormat::NUM_ENCODINGS && attribute.m_Size >= 1 && attribute.m_Size <= 4 &&
+                attribute.m_Stride == header->m_VertexSize && attribute.m_Offset < header->m_VertexSize,
+                "Invalid vertex attribute %d (%s)", i, filename );
+        m_Format.Set( i, VertexFormat::Encoding( attribute.m_Encoding ), attribute.m_Size, attribute.m_Stride, attribute.m_Offset );
+    }
+
+    // indices: in range of the vertices is the GPU's problem, but the levels must be inside the index stream
+    const uint32_t indexSize = header->m_IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    ASSERT( header->m_NumIndices == 0 || header->m_IndexType == GL_UNSIGNED_SHORT || header->m_IndexType == GL_UNSIGNED_INT,
+            "Invalid index type 0x%x (%s)", header->m_IndexType, filename );
+    ASSERT( IsValidRange( header->m_IndexOffset, header->m_IndexBytes, m_FileHandle.size() ) &&
+            uint64_t(header->m_NumIndices) * indexSize == header->m_IndexBytes,
+            "Invalid index stream (%s)", filename );
+    ASSERT( header->m_NumLods <= Mesh::MAX_LODS, "Too many LODs (%s)", filename );
+    for ( uint32_t lod = 0; lod < header->m_NumLods; ++lod ) {
+        const auto& range = header->m_Lods[ lod ];
+        ASSERT( range.m_FirstIndex >= 0 && range.m_NumIndices > 0 &&
+                uint64_t(range.m_FirstIndex) + range.m_NumIndices <= header->m_NumIndices,
+                "Invalid LOD %d (%s)", lod, filename );
+    }
+    m_Header = header;
+    return true;
+}
+
+bool MeshFile::IsSupported() const
+{
+    for ( int i = 0; i < Mesh::NUM_ATTRIBUTES; ++i ) {
+        if ( m_Format.Has( i ) && !VertexFormat::IsSupported( m_Format.GetEncoding( i ) ) ) return false;
+    }
+    return true;
+}
+
+MeshPtr MeshFile::Upload( GeometryArenaPtr arena ) const throw(std::exception)
+{
+    ASSERT( m_Header, "No mesh loaded!" );
+    const char* file = (const char*)m_Header;
+
+    // straight from the mapping into the arena
+    MeshPtr mesh( new Mesh( arena, m_Header->m_Primitive ) );
+    if ( m_Header->m_NumVertices ) {
+        mesh->SetFormat( m_Format );
+        mesh->SetVertexData( file + m_Header->m_VertexOffset, m_Header->m_VertexBytes, m_Header->m_NumVertices );
+    }
+    if ( m_Header->m_NumIndices ) {
+        mesh->SetIndexData( file + m_Header->m_IndexOffset, m_Header->m_NumIndices, m_Header->m_IndexType );
+    }
+    for ( uint32_t lod = 0; lod < m_Header->m_NumLods; ++lod ) {
+        const auto& range = m_Header->m_Lods[ lod ];
+        mesh->AddLod( range.m_FirstIndex, range.m_NumIndices, range.m_MinSize );
+    }
+    mesh->SetACMR( m_Header->m_ACMR[0], m_Header->m_ACMR[1] );
+    const float* min = m_Header->m_BoundsMin;
+    const float* max = m_Header->m_BoundsMax;
+    mesh->SetBounds( BoundingBox( Vector( min[0], min[1], min[2] ), Vector( max[0], max[1], max[2] ) ) );
+    return mesh;
+}
+
+void MeshFile::Save( const char* filename, const MeshData& data, const VertexFormat& format ) throw(std::exception)
+{
+    ASSERT( int(data.m_Lods.size()) <= Mesh::MAX_LODS, "Too many LODs" );
+
+    std::vector<char> vertices;
+    if ( data.GetNumVertices() > 0 ) {
+        data.Encode( format, vertices );
+    }
+    // same choice as Mesh::SetIndices()
+    std::vector<char> indices;
+    GLenum indexType = GL_UNSIGNED_INT;
+    if ( !data.m_Indices.empty() ) {
+        if ( *std::max_element( data.m_Indices.begin(), data.m_Indices.end() ) <= 0xFFFF ) {
+            std::vector<uint16_t> shortIndices( data.m_Indices.begin(), data.m_Indices.end() );
+            indices.assign( (const char*)&shortIndices[0], (const char*)&shortIndices[0] + sizeof(uint16_t)*shortIndices.size() );
+            indexType = GL_UNSIGNED_SHORT;
+        } else {
+            indices.assign( (const char*)&data.m_Indices[0], (const char*)&data.m_Indices[0] + sizeof(uint32_t)*data.m_Indices.size() );
+        }
+    }
+
+    Header header;
+    std::memset( &header, 0, sizeof(header) );
+    header.m_Magic       = MAGIC;
+    header.m_Version     = VERSION;
+    header.m_Primitive   = data.m_Primitive;
+    header.m_NumVertices = data.GetNumVertices();
+    header.m_VertexSize  = data.GetNumVertices() ? vertices.size() / data.GetNumVertices() : 0;
+    header.m_NumIndices  = data.m_Indices.size();
+    header.m_IndexType   = indexType;
+    header.m_NumLods     = data.m_Lods.size();
+    for ( std::size_t lod = 0; lod < data.m_Lods.size(); ++lod ) {
+        header.m_Lods[lod].m_FirstIndex = data.m_Lods[lod].m_FirstIndex;
+        header.m_Lods[lod].m_NumIndices = data.m_Lods[lod].m_NumIndices;
+        header.m_Lods[lod].m_MinSize    = data.m_Lods[lod].m_MinSize;
+    }
+    for ( int i = 0; i < Mesh::NUM_ATTRIBUTES; ++i ) {
+        if ( !format.Has( i ) ) continue;
+        header.m_Attributes[i].m_Encoding = format.GetEncoding( i );
+        header.m_Attributes[i].m_Size     = format.GetSize( i );
+        header.m_Attributes[i].m_Stride   = format.GetStride( i );
+        header.m_Attributes[i].m_Offset   = format.GetOffset( i );
+    }
+    for ( int c = 0; c < 3; ++c ) {
+        header.m_BoundsMin[c] = data.m_Bounds.m_Min[c];
+        header.m_BoundsMax[c] = data.m_Bounds.m_Max[c];
+    }
+    header.m_ACMR[0]      = data.m_ACMR[0];
+    header.m_ACMR[1]      = data.m_ACMR[1];
+    header.m_VertexOffset = AlignUp( sizeof(Header) );
+    header.m_VertexBytes  = vertices.size();
+    header.m_IndexOffset  = AlignUp( header.m_VertexOffset + header.m_VertexBytes );
+    header.m_IndexBytes   = indices.size();
+
+    std::vector<char> file( header.m_IndexOffset + header.m_IndexBytes, 0 );
+    std::memcpy( &file[0], &header, sizeof(header) );
+    std::copy( vertices.begin(), vertices.end(), file.begin() + header.m_VertexOffset );
+    std::copy( indices.begin(), indices.end(), file.begin() + header.m_IndexOffset );
+
+    std::ofstream out( filename, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc );
+    ASSERT( out.is_open(), "Can't write cooked mesh '%s'", filename );
+    out.write( &file[0], file.size() );
+    ASSERT( out.good(), "Error writing cooked mesh '%s'", filename );
+}
+
+std::string MeshFile::GetFileName( const std::string& directory, const std::string& key )
+{
+    // keys are printf'ed parameters - keep what is safe in a file name, '.' and '-' keep numbers apart
+    std::string name( key );
+    for ( auto& c : name ) {
+        if ( !std::isalnum( (unsigned char)c ) && c != '.' && c != '-' ) {
+            c = '_';
+        }
+    }
+    return directory + "/" + name + ".mesh";
+}
@@ -0,0 +1,99 @@
+/*
+ * meshfile.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef MESHFILE_H_
+#define MESHFILE_H_
+
+#include "err.h"
+#include "mesh.h"
+#include "meshdata.h"
+#include "vertexformat.h"
+#include "geometryarena.h"
+
+#include <string>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+namespace bios = boost::iostreams;
+
+/*!
+ * Cooked mesh: a fixed size header followed by the encoded, interleaved
+ * vertices and the indices in their final (16 or 32 bit) type, both
+ * aligned to STREAM_ALIGNMENT. The file is mmaped like the brushes and
+ * uploaded straight from the mapping - nothing is parsed or converted.
+ *
+ * Files are written by the meshcook tool. Little endian only, like the
+ * brush loaders.
+ */
+class MeshFile
+{
+public:
+    enum {
+        MAGIC            = 0x4853454D,   // "MESH"
+        VERSION          = 1,
+        STREAM_ALIGNMENT = 64,
+    };
+#pragma pack( push, 1 )
+    struct Header
+    {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint32_t m_Primitive;
+        uint32_t m_NumVertices;
+        uint32_t m_VertexSize;
+        uint32_t m_NumIndices;
+        uint32_t m_IndexType;           // GL_UNSIGNED_SHORT, GL_UNSIGNED_INT
+        uint32_t m_NumLods;
+        struct {
+            int32_t  m_FirstIndex;
+            int32_t  m_NumIndices;
+            float    m_MinSize;
+        } m_Lods[ Mesh::MAX_LODS ];
+        struct {
+            uint32_t m_Encoding;        // VertexFormat::Encoding, 0 = not present
+            uint32_t m_Size;
+            uint32_t m_Stride;
+            uint32_t m_Offset;
+        } m_Attributes[ Mesh::NUM_ATTRIBUTES ];
+        float    m_BoundsMin[3];
+        float    m_BoundsMax[3];
+        float    m_ACMR[2];
+        uint32_t m_VertexOffset;        // bytes from the start of the file
+        uint32_t m_VertexBytes;
+        uint32_t m_IndexOffset;
+        uint32_t m_IndexBytes;
+    };
+#pragma pack( pop )
+private:
+    bios::mapped_file m_FileHandle;
+    const Header*     m_Header;
+    VertexFormat      m_Format;
+public:
+    MeshFile();
+
+    ~MeshFile();
+
+    /*!
+     * mmap and validate a cooked mesh
+     */
+    bool Load( const char* filename ) throw(std::exception);
+
+    const VertexFormat& GetFormat() const { return m_Format; }
+
+    // all encodings of the file can be drawn on this hardware
+    bool IsSupported() const;
+
+    MeshPtr Upload( GeometryArenaPtr arena ) const throw(std::exception);
+
+    static void Save( const char* filename, const MeshData& data, const VertexFormat& format ) throw(std::exception);
+
+    /*!
+     * File name of a MeshCache key in directory
+     */
+    static std::string GetFileName( const std::string& directory, const std::string& key );
+};
+
+#endif /* MESHFILE_H_ */
@@ -0,0 +1,176 @@
+/*
+ * meshoptimizer.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "meshoptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// scoring constants from Forsyth's paper
+static const float sCacheDecayPower   = 1.5f;
+static const float sLastTriangleScore = 0.75f;
+static const float sValenceBoostScale = 2.0f;
+static const float sValenceBoostPower = 0.5f;
+
+static float VertexScore( int cachePosition, int remainingTriangles )
+{
+    if ( remainingTriangles == 0 ) {
+        // no triangle needs it any more
+        return -1.0f;
+    }
+    float score(0);
+    if ( cachePosition >= 0 ) {
+        if ( cachePosition < 3 ) {
+            // used by the last triangle - fixed score, or a strip would be preferred over a fan
+            score = sLastTriangleScore;
+        } else {
+            const float scale = 1.0f / ( MeshOptimizer::CACHE_SIZE - 3 );
+            score = std::pow( 1.0f - ( cachePosition - 3 ) * scale, sCacheDecayPower );
+        }
+    }
+    // boost vertices with few triangles left - gets rid of lone triangles early
+    score += sValenceBoostScale * std::pow( float(remainingTriangles), -sValenceBoostPower );
+    return score;
+}
+
+float MeshOptimizer::GetACMR( const std::vector<unsigned int>& indices, int numVertices, int cacheSize /* = FIFO_CACHE_SIZE */ )
+{
+    if ( indices.size() < 3 ) return 0;
+
+    // FIFO: a hit does not move the vertex, cacheSize misses later it is gone
+    std::vector<int> timestamps( numVertices, -cacheSize-1 );
+    int misses(0);
+    for ( auto index : indices ) {
+        if ( misses - timestamps[ index ] >= cacheSize ) {
+            timestamps[ index ] = ++misses;
+        }
+    }
+    return float(misses) / float( indices.size() / 3 );
+}
+
+void MeshOptimizer::OptimizeVertexCache( std::vector<unsigned int>& indices, int numVertices )
+{
+    const int numTriangles = indices.size() / 3;
+    if ( numTriangles == 0 ) return;
+
+    // vertex -> triangles adjacency, packed
+    std::vector<int> remaining( numVertices, 0 );
+    for ( auto index : indices ) {
+        ASSERT( int(index) < numVertices, "Index out of range: %d", int(index) );
+        ++remaining[ index ];
+    }
+    std::vector<int> offsets( numVertices + 1, 0 );
+    for ( int v = 0; v < numVertices; ++v ) {
+        offsets[ v + 1 ] = offsets[v] + remaining[v];
+    }
+    std::vector<int> adjacency( indices.size() );
+    {
+        std::vector<int> fill( offsets.begin(), offsets.end() - 1 );
+        for ( int t = 0; t < numTriangles; ++t ) {
+            for ( int k = 0; k < 3; ++k ) {
+                adjacency[ fill[ indices[ t*3 + k ] ]++ ] = t;
+            }
+        }
+    }
+
+    std::vector<int>   cachePosition( numVertices, -1 );
+    std::vector<float> vertexScore( numVertices );
+    for ( int v = 0; v < numVertices; ++v ) {
+        vertexScore[v] = VertexScore( -1, remaining[v] );
+    }
+    std::vector<float> triangleScore( numTriangles );
+    std::vector<char>  emitted( numTriangles, 0 );
+    int bestTriangle(0);
+    for ( int t = 0; t < numTriangles; ++t ) {
+        triangleScore[t] = vertexScore[ indices[t*3] ] + vertexScore[ indices[t*3+1] ] + vertexScore[ indices[t*3+2] ];
+        if ( triangleScore[t] > triangleScore[ bestTriangle ] ) {
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve( indices.size() );
+    std::vector<int> cache, newCache;
+    cache.reserve( CACHE_SIZE + 3 );
+    newCache.reserve( CACHE_SIZE + 3 );
+    int scanStart(0);    // all triangles before this are emitted
+
+    for ( int n = 0; n < numTriangles; ++n ) {
+        if ( bestTriangle < 0 ) {
+            // nothing adjacent to the cache left - pick the best of the rest
+            while ( emitted[ scanStart ] ) ++scanStart;
+            bestTriangle = scanStart;
+            for ( int t = scanStart + 1; t < numTriangles; ++t ) {
+                if ( !emitted[t] && triangleScore[t] > triangleScore[ bestTriangle ] ) {
+                    bestTriangle = t;
+                }
+            }
+        }
+        const unsigned int* tri = &indices[ bestTriangle*3 ];
+        result.insert( result.end(), tri, tri + 3 );
+        emitted[ bestTriangle ] = 1;
+
+        // the triangle's vertices go to the front of the cache
+        newCache.assign( tri, tri + 3 );
+        for ( int k = 0; k < 3; ++k ) {
+            int v = tri[k];
+            --remaining[v];
+            // drop the triangle from the vertex' list of open triangles
+            int* begin = &adjacency[ offsets[v] ];
+            int* end   = begin + remaining[v] + 1;
+            *std::find( begin, end, bestTriangle ) = *( end - 1 );
+        }
+        for ( auto v : cache ) {
+            if ( v != int(tri[0]) && v != int(tri[1]) && v != int(tri[2]) ) {
+                newCache.push_back( v );
+            }
+        }
+
+        // rescore everything that was or is in the cache and their triangles
+        for ( int i = 0; i < int(newCache.size()); ++i ) {
+            int v = newCache[i];
+            cachePosition[v] = i < CACHE_SIZE ? i : -1;
+            vertexScore[v]   = VertexScore( cachePosition[v], remaining[v] );
+        }
+        bestTriangle = -1;
+        float bestScore(-1);
+        for ( int i = 0; i < int(newCache.size()); ++i ) {
+            int v = newCache[i];
+            for ( int a = offsets[v]; a < offsets[v] + remaining[v]; ++a ) {
+                int t = adjacency[a];
+                triangleScore[t] = vertexScore[ indices[t*3] ] + vertexScore[ indices[t*3+1] ] + vertexScore[ indices[t*3+2] ];
+                if ( triangleScore[t] > bestScore ) {
+                    bestScore    = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+        if ( int(newCache.size()) > CACHE_SIZE ) {
+            newCache.resize( CACHE_SIZE );
+        }
+        cache.swap( newCache );
+    }
+    indices.swap( result );
+}
+
+void MeshOptimizer::OptimizeVertexFetch( std::vector<unsigned int>& indices, int numVertices, std::vector<unsigned int>& remap )
+{
+    const unsigned int unused = ~0u;
+    remap.assign( numVertices, unused );
+    unsigned int next(0);
+    for ( auto& index : indices ) {
+        if ( remap[ index ] == unused ) {
+            remap[ index ] = next++;
+        }
+        index = remap[ index ];
+    }
+    for ( auto& r : remap ) {
+        if ( r == unused ) {
+            r = next++;
+        }
+    }
+}
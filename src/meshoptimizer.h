@@ -0,0 +1,91 @@
+/*
+ * meshoptimizer.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef MESHOPTIMIZER_H_
+#define MESHOPTIMIZER_H_
+
+#include "err.h"
+
+#include <vector>
+
+/*!
+ * Offline style optimizations for generated triangle lists - run once when a
+ * mesh is built, not per frame.
+ *
+ *  - OptimizeVertexCache(): reorders triangles for the post transform cache
+ *    (Tom Forsyth's linear speed vertex cache optimisation, LRU cache model)
+ *  - OptimizeVertexFetch(): renumbers vertices in order of first use, so the
+ *    vertex fetch walks memory linearly. Vertex arrays are then reordered
+ *    with RemapVertices()
+ *  - GetACMR(): average cache miss ratio (transformed vertices per triangle)
+ *    of a FIFO cache like most hardware has. 0.5 is the best possible for
+ *    large grids, 3.0 the worst
+ */
+class MeshOptimizer
+{
+public:
+    enum {
+        CACHE_SIZE      = 32,   // LRU size the scoring assumes
+        FIFO_CACHE_SIZE = 16,   // default for GetACMR()
+    };
+
+    static float GetACMR( const std::vector<unsigned int>& indices, int numVertices, int cacheSize = FIFO_CACHE_SIZE );
+
+    static void OptimizeVertexCache( std::vector<unsigned int>& indices, int numVertices );
+
+    /*!
+     * Rewrites indices and fills remap with remap[oldVertex] = newVertex.
+     * Vertices that are not referenced go to the end, in their old order.
+     */
+    static void OptimizeVertexFetch( std::vector<unsigned int>& indices, int numVertices, std::vector<unsigned int>& remap );
+
+    /*!
+     * Reorder numVertices elements according to remap. Call it once for each
+     * attribute array (or plane of a planar buffer).
+     */
+    template< class T >
+    static void RemapVertices( T* vertices, int numVertices, const std::vector<unsigned int>& remap )
+    {
+        ASSERT( int(remap.size()) == numVertices, "Vertex remap table doesn't match: %d/%d", int(remap.size()), numVertices );
+        std::vector<T> copy( vertices, vertices + numVertices );
+        for ( int i = 0; i < numVertices; ++i ) {
+            vertices[ remap[i] ] = copy[i];
+        }
+    }
+
+    /*!
+     * Optimizes one level of detail - a planar buffer of numPlanes arrays with
+     * numVertices each - and appends it to planes/indices, indices offset to
+     * the vertices already there. misses[] sums up the cache misses before
+     * and after, divide by the total triangle count for the ACMR.
+     */
+    template< class T >
+    static void AppendLod( std::vector<T>& vertexBuffer, std::vector<unsigned int>& indexArray, int numPlanes,
+                           std::vector<T>* planes, std::vector<unsigned int>& indices, float misses[2] )
+    {
+        const int numVertices  = vertexBuffer.size() / numPlanes;
+        const int numTriangles = indexArray.size() / 3;
+        const unsigned int firstVertex = planes[0].size();
+
+        // post transform cache order first, then vertices in order of first use
+        misses[0] += GetACMR( indexArray, numVertices ) * numTriangles;
+        OptimizeVertexCache( indexArray, numVertices );
+        std::vector<unsigned int> remap;
+        OptimizeVertexFetch( indexArray, numVertices, remap );
+        misses[1] += GetACMR( indexArray, numVertices ) * numTriangles;
+        for ( int plane = 0; plane < numPlanes; ++plane ) {
+            T* begin = &vertexBuffer[ plane*numVertices ];
+            RemapVertices( begin, numVertices, remap );
+            planes[plane].insert( planes[plane].end(), begin, begin + numVertices );
+        }
+        for ( auto index : indexArray ) {
+            indices.push_back( index + firstVertex );
+        }
+    }
+};
+
+#endif /* MESHOPTIMIZER_H_ */
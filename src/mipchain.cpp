@@ -0,0 +1,101 @@
+/*
+ * mipchain.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "mipchain.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+// split a level into jobs from this many destination pixels on
+static const int _parallelMinPixels = 128*128;
+
+// rows [begin, end) of the half size level. Odd sizes clamp the last row/column
+static void Downsample( const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst, int bpp, int begin, int end )
+{
+    const int width = std::max( srcWidth / 2, 1 );
+    const int srcPitch = srcWidth * bpp;
+    for ( int y = begin; y < end; ++y ) {
+        const unsigned char* row0 = src + std::min( y*2,     srcHeight - 1 ) * srcPitch;
+        const unsigned char* row1 = src + std::min( y*2 + 1, srcHeight - 1 ) * srcPitch;
+        unsigned char* out = dst + y * width * bpp;
+        for ( int x = 0; x < width; ++x ) {
+            const int x0 = std::min( x*2,     srcWidth - 1 ) * bpp;
+            const int x1 = std::min( x*2 + 1, srcWidth - 1 ) * bpp;
+            for ( int c = 0; c < bpp; ++c ) {
+                *out++ = ( row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2 ) >> 2;
+            }
+        }
+    }
+}
+
+int MipChain::GetNumLevels( int width, int height )
+{
+    int levels = 1;
+    while ( ( width >> levels ) || ( height >> levels ) ) ++levels;
+    return levels;
+}
+
+std::size_t MipChain::GetSize( int width, int height, int bpp )
+{
+    std::size_t size(0);
+    for ( int level = 0; level < GetNumLevels( width, height ); ++level ) {
+        size += std::size_t( std::max( width >> level, 1 ) ) * std::max( height >> level, 1 ) * bpp;
+    }
+    return size;
+}
+
+void MipChain::Generate( const char* pixels, int width, int height, int bpp, std::vector<char>& chain, JobQueuePtr jobQueue,
+                         std::size_t pitch /* = 0 */ ) throw(std::exception)
+{
+    const std::size_t row = std::size_t( width ) * bpp;
+    chain.resize( GetSize( width, height, bpp ) );
+    if ( pitch == 0 || pitch == row ) {
+        std::copy( pixels, pixels + row * height, chain.begin() );
+    } else {
+        // the levels below are filtered from tightly packed rows
+        ASSERT( pitch > row, "Row pitch (%d) too small!", int(pitch) );
+        for ( int y = 0; y < height; ++y ) {
+            std::copy( pixels + y * pitch, pixels + y * pitch + row, chain.begin() + y * row );
+        }
+    }
+    Generate( &chain[0], width, height, bpp, jobQueue );
+}
+
+void MipChain::Generate( char* chain, int width, int height, int bpp, JobQueuePtr jobQueue ) throw(std::exception)
+{
+    ASSERT( bpp == 3 || bpp == 4, "Mip levels of %d bytes per pixel not supported", bpp );
+    const int numLevels = GetNumLevels( width, height );
+
+    // each level from the one before
+    unsigned char* src = (unsigned char*)chain;
+    for ( int level = 1; level < numLevels; ++level ) {
+        const int srcWidth  = std::max( width  >> ( level - 1 ), 1 );
+        const int srcHeight = std::max( height >> ( level - 1 ), 1 );
+        const int dstWidth  = std::max( width  >> level, 1 );
+        const int dstHeight = std::max( height >> level, 1 );
+        unsigned char* dst = src + std::size_t( srcWidth ) * srcHeight * bpp;
+        if ( jobQueue && dstWidth * dstHeight >= _parallelMinPixels ) {
+            jobQueue->ParallelFor( 0, dstHeight, boost::bind( &Downsample, src, srcWidth, srcHeight, dst, bpp, _1, _2 ),
+                                   std::max( _parallelMinPixels / dstWidth, 1 ) );
+        } else {
+            Downsample( src, srcWidth, srcHeight, dst, bpp, 0, dstHeight );
+        }
+        src = dst;
+    }
+}
+
+Brush MipChain::MakeBrush( const Brush& brush, const std::vector<char>& chain )
+{
+    Brush levels( brush );
+    levels.m_NumLevels = GetNumLevels( brush.m_Width, brush.m_Height );
+    levels.m_Size      = chain.size();
+    levels.m_Pixels    = &chain[0];
+    levels.m_Pitch     = 0;
+    levels.m_TopDown   = false;
+    return levels;
+}
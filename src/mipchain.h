@@ -0,0 +1,52 @@
+/*
+ * mipchain.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef MIPCHAIN_H_
+#define MIPCHAIN_H_
+
+#include "err.h"
+#include "brush.h"
+#include "jobqueue.h"
+
+#include <vector>
+
+/*!
+ * Mip levels for brushes that don't store them (TGA, BMP). Generated on the
+ * CPU with a 2x2 box filter - on the job queue for large images - so the
+ * driver never has to (GL_GENERATE_MIPMAP stalls the upload).
+ */
+class MipChain
+{
+public:
+    // levels of a width x height image down to 1x1
+    static int GetNumLevels( int width, int height );
+
+    // bytes of all levels down to 1x1
+    static std::size_t GetSize( int width, int height, int bpp );
+
+    /*!
+     * All levels of a raw (3 or 4 bytes per pixel) image, level 0 first and
+     * tightly packed like Brush expects them. pitch: bytes per row of pixels,
+     * 0 if they are tightly packed - padded rows (BMP) are packed on the copy.
+     */
+    static void Generate( const char* pixels, int width, int height, int bpp, std::vector<char>& chain,
+                          JobQueuePtr jobQueue = JobQueuePtr(), std::size_t pitch = 0 ) throw(std::exception);
+
+    /*!
+     * Levels 1 and on in place - chain holds GetSize() bytes, level 0 first
+     */
+    static void Generate( char* chain, int width, int height, int bpp,
+                          JobQueuePtr jobQueue = JobQueuePtr() ) throw(std::exception);
+
+    /*!
+     * Brush over chain with the same pixel format as brush, tightly packed
+     * and bottom up
+     */
+    static Brush MakeBrush( const Brush& brush, const std::vector<char>& chain );
+};
+
+#endif /* MIPCHAIN_H_ */
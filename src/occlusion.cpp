@@ -0,0 +1,262 @@
+/*
+ * occlusion.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "occlusion.h"
+
+#include <boost/bind.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+OcclusionCuller::OcclusionCuller( JobQueuePtr jobQueue )
+    : m_JobQueue( jobQueue )
+    , m_Depth( WIDTH * HEIGHT, 1.0f )
+    , m_NumCulled(0)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    // never leave jobs behind that point into this instance
+    if ( m_Batch ) {
+        try {
+            m_JobQueue->Wait( m_Batch );
+        } catch ( ... ) {
+        }
+    }
+}
+
+void OcclusionCuller::Begin( const Matrix& view, const Matrix& projection, const EntityList& entities )
+{
+    BOOST_ASSERT( !m_Batch );
+
+    // GL order: projection * view
+    m_ViewProjection = Matrix( view ).Mul( projection );
+
+    // eye in world space - occluders may depend on it (e.g. a height field is only a valid occluder from one side)
+    Vector eye = TransformPoint( view.Inverse(), Vector( 0, 0, 0 ) );
+
+    bool hasOccluders(false);
+    m_Items.resize( entities.size() );
+    auto item = m_Items.begin();
+    for ( auto& entity : entities ) {
+        item->m_Occluder = entity->GetOccluder( eye );
+        item->m_Matrix   = entity->GetRenderState()->GetMatrix();
+        item->m_Bounds   = entity->GetWorldBounds();
+        item->m_Visible  = true;
+        hasOccluders |= ( item->m_Occluder != nullptr );
+        ++item;
+    }
+    m_NumCulled = 0;
+
+    // nothing to rasterize, nothing to test against
+    if ( hasOccluders ) {
+        // created up front - the setup job posts the bands into it and must never read m_Batch
+        m_Batch = JobQueue::BatchPtr( new JobQueue::Batch );
+        m_JobQueue->Post( boost::bind( &OcclusionCuller::SetupTriangles, this, m_Batch ), m_Batch );
+    }
+}
+
+void OcclusionCuller::Finish() throw(std::exception)
+{
+    if ( !m_Batch ) return;
+
+    try {
+        m_JobQueue->Wait( m_Batch );
+    } catch ( ... ) {
+        m_Batch.reset();
+        throw;
+    }
+    m_Batch.reset();
+
+    m_JobQueue->ParallelFor( 0, m_Items.size(), boost::bind( &OcclusionCuller::TestRange, this, _1, _2 ), 16 );
+
+    for ( auto& item : m_Items ) {
+        if ( !item.m_Visible ) ++m_NumCulled;
+    }
+}
+
+void OcclusionCuller::SetupTriangles( JobQueue::BatchPtr batch )
+{
+    m_Triangles.clear();
+    for ( auto& item : m_Items ) {
+        if ( !item.m_Occluder ) continue;
+
+        Matrix mvp = Matrix( item.m_Matrix ).Mul( m_ViewProjection );
+        const std::vector<Vector>& tris = *item.m_Occluder;
+        for ( std::size_t i = 0; i + 2 < tris.size(); i += 3 ) {
+            Triangle t;
+            bool valid(true);
+            for ( int v = 0; v < 3 && valid; ++v ) {
+                Vector c = TransformPoint( mvp, tris[i+v] );
+                float w = c[Vector::W];
+                // anything crossing the near plane is dropped - not drawing an occluder is always safe
+                valid = w > 1e-5f;
+                if ( valid ) {
+                    float iw = 1.0f / w;
+                    t.m_X[v] = ( c[Vector::X] * iw * 0.5f + 0.5f ) * WIDTH;
+                    t.m_Y[v] = ( c[Vector::Y] * iw * 0.5f + 0.5f ) * HEIGHT;
+                    t.m_Z[v] =   c[Vector::Z] * iw * 0.5f + 0.5f;
+                    valid = t.m_Z[v] >= 0.0f;
+                }
+            }
+            if ( valid ) {
+                m_Triangles.push_back( t );
+            }
+        }
+    }
+
+    // fan out: one job per band. We are still part of the batch, so it can't complete before these are queued
+    for ( int band = 0; band < HEIGHT/BAND_ROWS; ++band ) {
+        m_JobQueue->Post( boost::bind( &OcclusionCuller::RasterizeBand, this, band, band+1 ), batch );
+    }
+}
+
+void OcclusionCuller::RasterizeBand( int firstBand, int lastBand )
+{
+    const int y0 = firstBand * BAND_ROWS;
+    const int y1 = lastBand  * BAND_ROWS;
+
+    std::fill( m_Depth.begin() + y0*WIDTH, m_Depth.begin() + y1*WIDTH, 1.0f );
+
+    for ( auto& t : m_Triangles ) {
+        float minX = std::min( t.m_X[0], std::min( t.m_X[1], t.m_X[2] ) );
+        float maxX = std::max( t.m_X[0], std::max( t.m_X[1], t.m_X[2] ) );
+        float minY = std::min( t.m_Y[0], std::min( t.m_Y[1], t.m_Y[2] ) );
+        float maxY = std::max( t.m_Y[0], std::max( t.m_Y[1], t.m_Y[2] ) );
+
+        int px0 = std::max( 0,        int( std::floor( minX ) ) );
+        int px1 = std::min( WIDTH-1,  int( std::ceil ( maxX ) ) );
+        int py0 = std::max( y0,       int( std::floor( minY ) ) );
+        int py1 = std::min( y1-1,     int( std::ceil ( maxY ) ) );
+        if ( px0 > px1 || py0 > py1 ) continue;
+
+        // orient counter clockwise so inside is >= 0 for all edges
+        int i1(1), i2(2);
+        float area = (t.m_X[1] - t.m_X[0]) * (t.m_Y[2] - t.m_Y[0]) - (t.m_Y[1] - t.m_Y[0]) * (t.m_X[2] - t.m_X[0]);
+        if ( std::fabs( area ) < 1e-6f ) continue;
+        if ( area < 0 ) {
+            std::swap( i1, i2 );
+            area = -area;
+        }
+        const float x[3] = { t.m_X[0], t.m_X[i1], t.m_X[i2] };
+        const float y[3] = { t.m_Y[0], t.m_Y[i1], t.m_Y[i2] };
+        const float z[3] = { t.m_Z[0], t.m_Z[i1], t.m_Z[i2] };
+
+        // edge i is opposite vertex i: E(p) = A*px + B*py + C
+        float A[3], B[3], C[3];
+        for ( int e = 0; e < 3; ++e ) {
+            int a = (e + 1) % 3;
+            int b = (e + 2) % 3;
+            A[e] = y[a] - y[b];
+            B[e] = x[b] - x[a];
+            C[e] = -( A[e]*x[a] + B[e]*y[a] );
+        }
+        // depth plane from barycentrics
+        float ia = 1.0f / area;
+        float zA = ( A[0]*z[0] + A[1]*z[1] + A[2]*z[2] ) * ia;
+        float zB = ( B[0]*z[0] + B[1]*z[1] + B[2]*z[2] ) * ia;
+        float zC = ( C[0]*z[0] + C[1]*z[1] + C[2]*z[2] ) * ia;
+
+        int xs = px0 & ~3;
+        for ( int py = py0; py <= py1; ++py ) {
+            float fy = float(py) + 0.5f;
+            float* row = &m_Depth[ py * WIDTH ];
+#ifdef __SSE2__
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 step = _mm_set_ps( 3.5f, 2.5f, 1.5f, 0.5f );
+            __m128 e0r = _mm_set1_ps( B[0]*fy + C[0] );
+            __m128 e1r = _mm_set1_ps( B[1]*fy + C[1] );
+            __m128 e2r = _mm_set1_ps( B[2]*fy + C[2] );
+            __m128 zr  = _mm_set1_ps( zB*fy + zC );
+            __m128 a0  = _mm_set1_ps( A[0] );
+            __m128 a1  = _mm_set1_ps( A[1] );
+            __m128 a2  = _mm_set1_ps( A[2] );
+            __m128 za  = _mm_set1_ps( zA );
+            for ( int px = xs; px <= px1; px += 4 ) {
+                __m128 fx = _mm_add_ps( _mm_set1_ps( float(px) ), step );
+                __m128 e0 = _mm_add_ps( _mm_mul_ps( a0, fx ), e0r );
+                __m128 e1 = _mm_add_ps( _mm_mul_ps( a1, fx ), e1r );
+                __m128 e2 = _mm_add_ps( _mm_mul_ps( a2, fx ), e2r );
+                __m128 inside = _mm_and_ps( _mm_cmpge_ps( e0, zero ),
+                                _mm_and_ps( _mm_cmpge_ps( e1, zero ), _mm_cmpge_ps( e2, zero ) ) );
+                if ( _mm_movemask_ps( inside ) == 0 ) continue;
+                __m128 depth = _mm_add_ps( _mm_mul_ps( za, fx ), zr );
+                __m128 old   = _mm_loadu_ps( row + px );
+                __m128 nz    = _mm_min_ps( old, depth );
+                _mm_storeu_ps( row + px, _mm_or_ps( _mm_and_ps( inside, nz ), _mm_andnot_ps( inside, old ) ) );
+            }
+#else
+            for ( int px = xs; px <= px1; ++px ) {
+                float fx = float(px) + 0.5f;
+                if ( A[0]*fx + B[0]*fy + C[0] >= 0 &&
+                     A[1]*fx + B[1]*fy + C[1] >= 0 &&
+                     A[2]*fx + B[2]*fy + C[2] >= 0 )
+                {
+                    row[px] = std::min( row[px], zA*fx + zB*fy + zC );
+                }
+            }
+#endif
+        }
+    }
+}
+
+bool OcclusionCuller::TestRect( const ScreenRect& rect ) const
+{
+    // conservative: round outwards. Blocks of 4 may test a few extra pixels - that only makes us more visible
+    int x0 = std::max( 0,        int( std::floor( (rect.m_MinX * 0.5f + 0.5f) * WIDTH  ) ) );
+    int x1 = std::min( WIDTH-1,  int( std::floor( (rect.m_MaxX * 0.5f + 0.5f) * WIDTH  ) ) );
+    int y0 = std::max( 0,        int( std::floor( (rect.m_MinY * 0.5f + 0.5f) * HEIGHT ) ) );
+    int y1 = std::min( HEIGHT-1, int( std::floor( (rect.m_MaxY * 0.5f + 0.5f) * HEIGHT ) ) );
+    float z = rect.m_MinZ;
+
+    int xs = x0 & ~3;
+    for ( int py = y0; py <= y1; ++py ) {
+        const float* row = &m_Depth[ py * WIDTH ];
+#ifdef __SSE2__
+        __m128 zv = _mm_set1_ps( z );
+        for ( int px = xs; px <= x1; px += 4 ) {
+            if ( _mm_movemask_ps( _mm_cmple_ps( zv, _mm_loadu_ps( row + px ) ) ) ) {
+                return true;
+            }
+        }
+#else
+        for ( int px = x0; px <= x1; ++px ) {
+            if ( z <= row[px] ) return true;
+        }
+#endif
+    }
+    return false;
+}
+
+void OcclusionCuller::TestRange( int first, int last )
+{
+    for ( int i = first; i < last; ++i ) {
+        Item& item = m_Items[i];
+        if ( item.m_Occluder || item.m_Bounds.IsEmpty() ) {
+            continue;
+        }
+        ScreenRect rect;
+        if ( !item.m_Bounds.Project( m_ViewProjection, rect ) ) {
+            // crosses the near plane - can't tell
+            continue;
+        }
+        if ( rect.m_MaxX < -1.0f || rect.m_MinX > 1.0f ||
+             rect.m_MaxY < -1.0f || rect.m_MinY > 1.0f ||
+             rect.m_MinZ > 1.0f )
+        {
+            // outside the view anyway
+            item.m_Visible = false;
+            continue;
+        }
+        item.m_Visible = TestRect( rect );
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * occlusion.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef OCCLUSION_H_
+#define OCCLUSION_H_
+
+#include "err.h"
+#include "entity.h"
+#include "bounds.h"
+#include "jobqueue.h"
+
+#include <vector>
+
+/*!
+ * Software occlusion culler. Large occluders (entities returning geometry
+ * from Entity::GetOccluder) are rasterized into a small CPU depth buffer on
+ * the job queue, split into horizontal bands. All other entities test their
+ * projected world bounds against that buffer.
+ *
+ * Usage per view (render thread):
+ *   Begin()   - snapshot matrices & bounds, kick rasterization on workers
+ *   ...         render occluders while workers are busy
+ *   Finish()  - wait, test the remaining entities in parallel
+ *   IsVisible()
+ */
+class OcclusionCuller
+{
+public:
+    enum {
+        WIDTH     = 256,
+        HEIGHT    = 128,
+        BAND_ROWS = 16,     // rows per raster job
+    };
+private:
+    struct Item
+    {
+        const std::vector<Vector>* m_Occluder; // local space triangle list - null if not an occluder
+        Matrix      m_Matrix;                   // entity (world) matrix
+        BoundingBox m_Bounds;                   // world bounds
+        bool        m_Visible;
+    };
+    struct Triangle
+    {
+        float m_X[3], m_Y[3];  // pixel coords
+        float m_Z[3];          // window depth 0..1
+    };
+
+    JobQueuePtr           m_JobQueue;
+    JobQueue::BatchPtr    m_Batch;
+    Matrix                m_ViewProjection;
+    std::vector<Item>     m_Items;
+    std::vector<Triangle> m_Triangles;
+    std::vector<float>    m_Depth;
+    int                   m_NumCulled;
+public:
+    OcclusionCuller( JobQueuePtr jobQueue );
+
+    ~OcclusionCuller();
+
+    /*!
+     * Snapshot all entities of the list and start rasterizing occluders.
+     * view and projection are the current GL matrices the list is rendered with.
+     */
+    void Begin( const Matrix& view, const Matrix& projection, const EntityList& entities );
+
+    /*!
+     * Wait for the rasterizer and test all non-occluders.
+     */
+    void Finish() throw(std::exception);
+
+    /*!
+     * Index is the position in the entity list passed to Begin()
+     */
+    bool IsVisible( int index ) const { return m_Items[index].m_Visible; }
+
+    bool IsOccluder( int index ) const { return m_Items[index].m_Occluder != nullptr; }
+
+    int GetNumCulled() const { return m_NumCulled; }
+
+    const float* GetDepthBuffer() const { return &m_Depth[0]; }
+
+private:
+    // on a worker - fans out the bands into batch
+    void SetupTriangles( JobQueue::BatchPtr batch );
+
+    void RasterizeBand( int firstBand, int lastBand );
+
+    void TestRange( int first, int last );
+
+    bool TestRect( const ScreenRect& rect ) const;
+};
+
+typedef boost::shared_ptr<OcclusionCuller> OcclusionCullerPtr;
+
+#endif /* OCCLUSION_H_ */
@@ -0,0 +1,110 @@
+/*
+ * packfile.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "packfile.h"
+#include "lz4block.h"
+
+#include <algorithm>
+#include <cstring>
+
+// searched last to first
+static std::vector<PackFilePtr> _mounted;
+
+PackFile::PackFile()
+    : m_Index( nullptr )
+    , m_NumEntries(0)
+{
+}
+
+PackFilePtr PackFile::Open( const std::string& filename ) throw(std::exception)
+{
+    PackFilePtr pack( new PackFile );
+    pack->m_FileName = filename;
+    try {
+        pack->m_File.open( filename );
+    } catch ( std::exception& ex ) {
+        THROW( "Can't open pack file '%s'.\n%s", filename.c_str(), ex.what() );
+    }
+    ASSERT( pack->m_File.is_open() && pack->m_File.size() >= sizeof(Header), "Invalid pack file '%s'", filename.c_str() );
+
+    const char* data = pack->m_File.data();
+    const std::size_t size = pack->m_File.size();
+    const Header* header = (const Header*)data;
+    ASSERT( std::memcmp( header->m_Magic, "PACK", 4 ) == 0, "'%s' is not a pack file", filename.c_str() );
+    ASSERT( header->m_Version == VERSION, "Pack file '%s' has version %d, expected %d", filename.c_str(), int( header->m_Version ), int( VERSION ) );
+    ASSERT( header->m_NumEntries <= ( size - sizeof(Header) ) / sizeof(IndexEntry), "Truncated pack file index (%s)", filename.c_str() );
+
+    pack->m_Index      = (const IndexEntry*)( data + sizeof(Header) );
+    pack->m_NumEntries = header->m_NumEntries;
+    for ( std::uint32_t i = 0; i < pack->m_NumEntries; ++i ) {
+        const IndexEntry& entry = pack->m_Index[i];
+        ASSERT( entry.m_Offset <= size && entry.m_Size <= size - entry.m_Offset && entry.m_Format < NUM_FORMATS &&
+                ( i == 0 || pack->m_Index[i-1].m_Hash < entry.m_Hash ),
+                "Invalid pack file entry %d (%s)", int(i), filename.c_str() );
+        // checked here, not when the buffer is allocated - a corrupt size would take gigabytes
+        ASSERT( entry.m_Format == RAW ? entry.m_RawSize == entry.m_Size :
+                entry.m_RawSize <= MAX_RAW_SIZE && entry.m_RawSize <= std::uint64_t( entry.m_Size ) * MAX_RATIO,
+                "Invalid size of pack file entry %d (%s)", int(i), filename.c_str() );
+    }
+    return pack;
+}
+
+bool PackFile::Find( const std::string& name, Data& data ) throw(std::exception)
+{
+    IndexEntry key;
+    key.m_Hash = Hash( name );
+    const IndexEntry* end = m_Index + m_NumEntries;
+    const IndexEntry* entry = std::lower_bound( m_Index, end, key,
+        []( const IndexEntry& a, const IndexEntry& b ) { return a.m_Hash < b.m_Hash; } );
+    if ( entry == end || entry->m_Hash != key.m_Hash ) return false;
+
+    const char* payload = m_File.data() + entry->m_Offset;
+    if ( entry->m_Format == RAW ) {
+        data.m_Data   = payload;
+        data.m_Size   = entry->m_Size;
+        data.m_Source = shared_from_this();
+        return true;
+    }
+    boost::shared_ptr< std::vector<char> > buffer( new std::vector<char>( entry->m_RawSize ) );
+    try {
+        Lz4Block::Decompress( payload, entry->m_Size, buffer->data(), buffer->size() );
+    } catch ( std::exception& ex ) {
+        THROW( "Error unpacking '%s' from '%s'.\n%s", name.c_str(), m_FileName.c_str(), ex.what() );
+    }
+    data.m_Data   = buffer->data();
+    data.m_Size   = buffer->size();
+    data.m_Source = buffer;
+    return true;
+}
+
+std::uint64_t PackFile::Hash( const std::string& name )
+{
+    // FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for ( auto c : name ) {
+        hash = ( hash ^ (unsigned char)c ) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void PackFile::Mount( PackFilePtr pack )
+{
+    _mounted.push_back( pack );
+}
+
+void PackFile::UnmountAll()
+{
+    _mounted.clear();
+}
+
+bool PackFile::Resolve( const std::string& name, Data& data ) throw(std::exception)
+{
+    for ( auto it = _mounted.rbegin(); it != _mounted.rend(); ++it ) {
+        if ( (*it)->Find( name, data ) ) return true;
+    }
+    return false;
+}
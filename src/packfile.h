@@ -0,0 +1,118 @@
+/*
+ * packfile.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef PACKFILE_H_
+#define PACKFILE_H_
+
+#include "err.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class PackFile;
+typedef boost::shared_ptr<PackFile> PackFilePtr;
+
+/*!
+ * All assets in one archive, mapped once. Layout (little endian):
+ *
+ *   Header
+ *   IndexEntry[ m_NumEntries ]    sorted by hash
+ *   payloads                      each at a multiple of ALIGNMENT
+ *
+ * Entries are found by the 64 bit hash of their name (relative to data/,
+ * '/' separated) with a binary search - names aren't stored. Raw entries
+ * are handed out as pointers into the mapping, LZ4 entries are decompressed
+ * into a buffer of their own. The packer tool writes archives.
+ *
+ * Mounted archives are searched by LoadBrush() before the files in data/.
+ * Mount at startup - the mount list isn't locked.
+ */
+class PackFile : public boost::enable_shared_from_this<PackFile>
+{
+public:
+    enum Format {
+        RAW = 0,
+        LZ4,
+
+        NUM_FORMATS
+    };
+    enum {
+        VERSION   = 1,
+        ALIGNMENT = 4096,       // of payloads - a page, mapped without copies
+        MAX_RAW_SIZE = 256<<20, // of an LZ4 entry - Find() allocates it up front
+        MAX_RATIO = 255,        // LZ4 expands a byte of input into at most this many
+    };
+
+    struct Header
+    {
+        char          m_Magic[4];   // "PACK"
+        std::uint32_t m_Version;
+        std::uint32_t m_NumEntries;
+        std::uint32_t m_Reserved;
+    };
+
+    struct IndexEntry
+    {
+        std::uint64_t m_Hash;
+        std::uint64_t m_Offset;     // from the start of the file
+        std::uint32_t m_Size;       // stored
+        std::uint32_t m_RawSize;    // decompressed
+        std::uint32_t m_Format;
+        std::uint32_t m_Reserved;
+    };
+
+    struct Data
+    {
+        const char*                   m_Data;
+        std::size_t                   m_Size;
+        boost::shared_ptr<const void> m_Source;     // keeps m_Data alive
+    };
+private:
+    boost::iostreams::mapped_file_source m_File;
+    std::string       m_FileName;
+    const IndexEntry* m_Index;
+    std::uint32_t     m_NumEntries;
+
+
+    PackFile();
+public:
+    /*!
+     * Map and validate an archive
+     */
+    static PackFilePtr Open( const std::string& filename ) throw(std::exception);
+
+    /*!
+     * Contents of name, false if the archive doesn't have it
+     */
+    bool Find( const std::string& name, Data& data ) throw(std::exception);
+
+    int GetNumEntries() const { return m_NumEntries; }
+
+    const std::string& GetFileName() const { return m_FileName; }
+
+    // of an entry name
+    static std::uint64_t Hash( const std::string& name );
+
+    /*!
+     * Searched by Resolve() - the last mounted first
+     */
+    static void Mount( PackFilePtr pack );
+
+    static void UnmountAll();
+
+    /*!
+     * name from the mounted archives. false: load it from the file system
+     */
+    static bool Resolve( const std::string& name, Data& data ) throw(std::exception);
+};
+
+#endif /* PACKFILE_H_ */
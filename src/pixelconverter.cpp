@@ -0,0 +1,183 @@
+/*
+ * pixelconverter.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "pixelconverter.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// split into jobs from this size on, and into chunks of at least this many pixels
+static const int _parallelMinPixels = 256*256;
+
+// round( c * a / 255 ) without a division
+static inline unsigned char Scale( unsigned int c, unsigned int a )
+{
+    const unsigned int t = c * a + 128;
+    return ( t + ( t >> 8 ) ) >> 8;
+}
+
+// rows [begin, end) of the destination, bottom row first
+static void ConvertRows( const Brush& brush, unsigned char* pixels, unsigned int flags, int begin, int end )
+{
+    const int width = brush.m_Width;
+    const int bpp   = brush.m_BytesPerPixel;
+    const std::size_t pitch = brush.m_Pitch ? brush.m_Pitch : std::size_t( width ) * bpp;
+    for ( int y = begin; y < end; ++y ) {
+        const int row = brush.m_TopDown ? brush.m_Height - 1 - y : y;
+        const unsigned char* src = (const unsigned char*)brush.m_Pixels + row * pitch;
+        unsigned char* dst = pixels + std::size_t( y ) * width * 4;
+        switch ( bpp ) {
+        case 1:  PixelConverter::ExpandLuminance( src, dst, width ); break;
+        case 3:  PixelConverter::ExpandBGR( src, dst, width ); break;
+        default:
+            if ( flags & PixelConverter::SWIZZLE ) {
+                PixelConverter::Swizzle( src, dst, width );
+            } else {
+                std::memcpy( dst, src, std::size_t( width ) * 4 );
+            }
+            break;
+        }
+        if ( flags & PixelConverter::PREMULTIPLY ) {
+            PixelConverter::Premultiply( dst, width );
+        }
+    }
+}
+
+bool PixelConverter::IsUploadable( const Brush& brush, unsigned int flags )
+{
+    if ( brush.m_Compression == Brush::RLE ) return false;
+    return brush.m_Compression != Brush::NONE ||
+        ( brush.m_BytesPerPixel == 4 && ( brush.m_Pitch == 0 || brush.m_Pitch == brush.m_Width * 4 ) &&
+          !brush.m_TopDown && flags == 0 );
+}
+
+void PixelConverter::Convert( const Brush& brush, char* pixels, unsigned int flags, JobQueuePtr jobQueue ) throw(std::exception)
+{
+    ASSERT( brush.m_Pixels && brush.m_Compression == Brush::NONE, "Only raw brushes can be converted!" );
+    ASSERT( brush.m_BytesPerPixel == 1 || brush.m_BytesPerPixel == 3 || brush.m_BytesPerPixel == 4,
+            "Invalid Bytes per Pixel (%d). Must be 1, 3 or 4.", brush.m_BytesPerPixel );
+    ASSERT( brush.m_Pitch == 0 || brush.m_Pitch >= brush.m_Width * brush.m_BytesPerPixel, "Row pitch (%d) too small!", brush.m_Pitch );
+
+    const int width  = brush.m_Width;
+    const int height = brush.m_Height;
+    const std::size_t row = std::size_t( width ) * brush.m_BytesPerPixel;
+    // once here, not per row - 0 is a brush made in memory, not loaded
+    ASSERT( brush.m_Size == 0 || height == 0 || brush.m_Size >= ( brush.m_Pitch ? brush.m_Pitch : row ) * ( height - 1 ) + row,
+            "Brush smaller (%d bytes) than its pixels!", brush.m_Size );
+    // rows don't overlap in the output - no locking
+    if ( jobQueue && width*height >= _parallelMinPixels ) {
+        jobQueue->ParallelFor( 0, height, boost::bind( &ConvertRows, boost::cref( brush ), (unsigned char*)pixels, flags, _1, _2 ),
+                               std::max( _parallelMinPixels / width, 1 ) );
+    } else {
+        ConvertRows( brush, (unsigned char*)pixels, flags, 0, height );
+    }
+}
+
+void PixelConverter::ExpandLuminance( const unsigned char* src, unsigned char* dst, int count )
+{
+    int i(0);
+#ifdef __SSE2__
+    // 16 pixels: L -> LL and LA pairs -> LLLA
+    const __m128i alpha = _mm_set1_epi8( char(255) );
+    for ( ; i + 16 <= count; i += 16 ) {
+        const __m128i l   = _mm_loadu_si128( (const __m128i*)( src + i ) );
+        const __m128i llLo = _mm_unpacklo_epi8( l, l );
+        const __m128i llHi = _mm_unpackhi_epi8( l, l );
+        const __m128i laLo = _mm_unpacklo_epi8( l, alpha );
+        const __m128i laHi = _mm_unpackhi_epi8( l, alpha );
+        __m128i* out = (__m128i*)( dst + i*4 );
+        _mm_storeu_si128( out,     _mm_unpacklo_epi16( llLo, laLo ) );
+        _mm_storeu_si128( out + 1, _mm_unpackhi_epi16( llLo, laLo ) );
+        _mm_storeu_si128( out + 2, _mm_unpacklo_epi16( llHi, laHi ) );
+        _mm_storeu_si128( out + 3, _mm_unpackhi_epi16( llHi, laHi ) );
+    }
+#endif
+    for ( ; i < count; ++i ) {
+        dst[i*4 + 0] = dst[i*4 + 1] = dst[i*4 + 2] = src[i];
+        dst[i*4 + 3] = 255;
+    }
+}
+
+void PixelConverter::ExpandBGR( const unsigned char* src, unsigned char* dst, int count )
+{
+    int i(0);
+#ifdef __SSE2__
+    // 4 pixels from a 16 byte load - SSE2 has no byte shuffle, so whole register shifts move
+    // each pixel into a lane. Stops 2 pixels early to never read past the row
+    const __m128i alpha = _mm_set1_epi32( 0xff000000 );
+    for ( ; i + 6 <= count; i += 4 ) {
+        const __m128i v  = _mm_loadu_si128( (const __m128i*)( src + i*3 ) );
+        const __m128i p01 = _mm_unpacklo_epi32( v, _mm_srli_si128( v, 3 ) );
+        const __m128i p23 = _mm_unpacklo_epi32( _mm_srli_si128( v, 6 ), _mm_srli_si128( v, 9 ) );
+        _mm_storeu_si128( (__m128i*)( dst + i*4 ), _mm_or_si128( _mm_unpacklo_epi64( p01, p23 ), alpha ) );
+    }
+#endif
+    for ( ; i < count; ++i ) {
+        dst[i*4 + 0] = src[i*3 + 0];
+        dst[i*4 + 1] = src[i*3 + 1];
+        dst[i*4 + 2] = src[i*3 + 2];
+        dst[i*4 + 3] = 255;
+    }
+}
+
+void PixelConverter::Swizzle( const unsigned char* src, unsigned char* dst, int count )
+{
+    int i(0);
+#ifdef __SSE2__
+    // swap bytes 0 and 2 of each 32 bit lane
+    const __m128i keep = _mm_set1_epi32( 0xff00ff00 );
+    const __m128i low  = _mm_set1_epi32( 0x000000ff );
+    const __m128i high = _mm_set1_epi32( 0x00ff0000 );
+    for ( ; i + 4 <= count; i += 4 ) {
+        const __m128i p = _mm_loadu_si128( (const __m128i*)( src + i*4 ) );
+        const __m128i r = _mm_or_si128( _mm_and_si128( p, keep ),
+                          _mm_or_si128( _mm_and_si128( _mm_srli_epi32( p, 16 ), low ), _mm_and_si128( _mm_slli_epi32( p, 16 ), high ) ) );
+        _mm_storeu_si128( (__m128i*)( dst + i*4 ), r );
+    }
+#endif
+    for ( ; i < count; ++i ) {
+        dst[i*4 + 0] = src[i*4 + 2];
+        dst[i*4 + 1] = src[i*4 + 1];
+        dst[i*4 + 2] = src[i*4 + 0];
+        dst[i*4 + 3] = src[i*4 + 3];
+    }
+}
+
+void PixelConverter::Premultiply( unsigned char* pixels, int count )
+{
+    int i(0);
+#ifdef __SSE2__
+    // 4 pixels in 16 bit channels: c * a + 128 < 2^16, so the low half of the product is exact
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i bias  = _mm_set1_epi16( 128 );
+    const __m128i alpha = _mm_set1_epi32( 0xff000000 );
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m128i* p = (__m128i*)( pixels + i*4 );
+        const __m128i v = _mm_loadu_si128( p );
+        __m128i scaled[2] = { _mm_unpacklo_epi8( v, zero ), _mm_unpackhi_epi8( v, zero ) };
+        for ( int h = 0; h < 2; ++h ) {
+            const __m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( scaled[h], 0xff ), 0xff );
+            const __m128i t = _mm_add_epi16( _mm_mullo_epi16( scaled[h], a ), bias );
+            scaled[h] = _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+        }
+        const __m128i r = _mm_packus_epi16( scaled[0], scaled[1] );
+        _mm_storeu_si128( p, _mm_or_si128( _mm_andnot_si128( alpha, r ), _mm_and_si128( alpha, v ) ) );
+    }
+#endif
+    for ( ; i < count; ++i ) {
+        unsigned char* p = pixels + i*4;
+        p[0] = Scale( p[0], p[3] );
+        p[1] = Scale( p[1], p[3] );
+        p[2] = Scale( p[2], p[3] );
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * pixelconverter.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef PIXELCONVERTER_H_
+#define PIXELCONVERTER_H_
+
+#include "err.h"
+#include "brush.h"
+#include "jobqueue.h"
+
+/*!
+ * Brings raw brushes into the one layout every driver uploads without
+ * touching it: tightly packed BGRA rows, bottom row first (GL_BGRA with
+ * GL_UNSIGNED_INT_8_8_8_8_REV into GL_RGBA8). Luminance and BGR pixels are
+ * expanded, padded rows (BMP) packed and top down images flipped on the
+ * way - SSE2 kernels where available, rows split over the job queue for
+ * large images.
+ */
+class PixelConverter
+{
+public:
+    enum Flags {
+        SWIZZLE     = 1<<0,     // 4 byte source is RGBA, not BGRA
+        PREMULTIPLY = 1<<1,     // colour times alpha
+    };
+
+    // level 0 of brush can be uploaded as it is
+    static bool IsUploadable( const Brush& brush, unsigned int flags = 0 );
+
+    /*!
+     * Level 0 of a raw brush (1, 3 or 4 bytes per pixel) converted into
+     * pixels, which holds width * height * 4 bytes - typically the start of
+     * the storage the levels are uploaded from.
+     */
+    static void Convert( const Brush& brush, char* pixels, unsigned int flags = 0,
+                         JobQueuePtr jobQueue = JobQueuePtr() ) throw(std::exception);
+
+    // kernels over count pixels. dst never overlaps src
+    static void ExpandLuminance( const unsigned char* src, unsigned char* dst, int count );
+
+    static void ExpandBGR( const unsigned char* src, unsigned char* dst, int count );
+
+    // BGRA <-> RGBA
+    static void Swizzle( const unsigned char* src, unsigned char* dst, int count );
+
+    // BGRA in place, rounded like c * a / 255
+    static void Premultiply( unsigned char* pixels, int count );
+};
+
+#endif /* PIXELCONVERTER_H_ */
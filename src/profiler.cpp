@@ -0,0 +1,126 @@
+/*
+ * profiler.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "profiler.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <iomanip>
+
+Profiler::Profiler()
+    : m_Frame(0)
+    , m_HasTimerQuery( false )
+    , m_GpuBusy(false)
+    , m_Smoothing(0.9f)
+{
+}
+
+Profiler::~Profiler()
+{
+    for ( auto& it : m_Sections ) {
+        if ( it.second.m_Queries[0] ) {
+            glDeleteQueries( QUERY_FRAMES, it.second.m_Queries );
+        }
+    }
+}
+
+void Profiler::BeginFrame()
+{
+    if ( m_Frame == 0 ) {
+        // first frame - GL context is current by now
+        m_HasTimerQuery = glewGetExtension("GL_ARB_timer_query") || glewGetExtension("GL_EXT_timer_query");
+    }
+    ++m_Frame;
+}
+
+void Profiler::ReadBack( Section& section, int slot )
+{
+    if ( !section.m_Pending[slot] ) return;
+
+    unsigned int available(0);
+    glGetQueryObjectuiv( section.m_Queries[slot], GL_QUERY_RESULT_AVAILABLE, &available );
+    if ( available ) {
+        unsigned int ns(0);
+        glGetQueryObjectuiv( section.m_Queries[slot], GL_QUERY_RESULT, &ns );
+        section.m_GpuTime = section.m_GpuTime * m_Smoothing + double(ns) * 1e-6 * (1.0 - m_Smoothing);
+        section.m_Pending[slot] = false;
+    }
+}
+
+void Profiler::Begin( const std::string& name )
+{
+    auto it = m_Sections.find( name );
+    if ( it == m_Sections.end() ) {
+        Section s;
+        std::fill( s.m_Queries, s.m_Queries + QUERY_FRAMES, 0 );
+        std::fill( s.m_Pending, s.m_Pending + QUERY_FRAMES, false );
+        s.m_CpuTime = s.m_GpuTime = 0;
+        s.m_LastFrame = 0;
+        it = m_Sections.insert( std::make_pair( name, s ) ).first;
+        if ( m_HasTimerQuery ) {
+            glGenQueries( QUERY_FRAMES, it->second.m_Queries );
+        }
+    }
+    Section& section = it->second;
+    section.m_Start = boost::posix_time::microsec_clock::local_time();
+
+    if ( m_HasTimerQuery && !m_GpuBusy ) {
+        int slot = m_Frame % QUERY_FRAMES;
+        // result from QUERY_FRAMES ago - if still not there we drop it rather than wait
+        ReadBack( section, slot );
+        if ( !section.m_Pending[slot] ) {
+            glBeginQuery( GL_TIME_ELAPSED, section.m_Queries[slot] );
+            section.m_Pending[slot] = true;
+            section.m_LastFrame = m_Frame;
+            m_GpuBusy = true;
+        }
+    }
+}
+
+void Profiler::End( const std::string& name )
+{
+    auto it = m_Sections.find( name );
+    BOOST_ASSERT( it != m_Sections.end() );
+    Section& section = it->second;
+
+    double ms = double( ( boost::posix_time::microsec_clock::local_time() - section.m_Start ).total_microseconds() ) * 1e-3;
+    section.m_CpuTime = section.m_CpuTime * m_Smoothing + ms * (1.0 - m_Smoothing);
+
+    if ( m_GpuBusy && section.m_LastFrame == m_Frame && section.m_Pending[ m_Frame % QUERY_FRAMES ] ) {
+        glEndQuery( GL_TIME_ELAPSED );
+        m_GpuBusy = false;
+    }
+}
+
+double Profiler::GetCpuTime( const std::string& name ) const
+{
+    auto it = m_Sections.find( name );
+    return it != m_Sections.end() ? it->second.m_CpuTime : 0.0;
+}
+
+double Profiler::GetGpuTime( const std::string& name ) const
+{
+    auto it = m_Sections.find( name );
+    return it != m_Sections.end() ? it->second.m_GpuTime : 0.0;
+}
+
+double Profiler::GetTime( const std::string& name ) const
+{
+    return std::max( GetCpuTime( name ), GetGpuTime( name ) );
+}
+
+void Profiler::Dump( std::ostream& out ) const
+{
+    out << std::fixed << std::setprecision(3);
+    for ( auto& it : m_Sections ) {
+        out << std::setw(32) << std::left << it.first
+            << " cpu " << std::setw(8) << std::right << it.second.m_CpuTime << " ms"
+            << "  gpu " << std::setw(8) << it.second.m_GpuTime << " ms\n";
+    }
+    out.flush();
+}
@@ -0,0 +1,100 @@
+/*
+ * profiler.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "err.h"
+
+#include <GL/glew.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <map>
+#include <string>
+#include <ostream>
+
+/*!
+ * Named CPU and GPU timers. GPU times come from GL_TIME_ELAPSED queries,
+ * which are read back a few frames later to not stall the pipeline. GPU
+ * sections must not nest (a GL restriction), CPU sections may.
+ * All times are in milliseconds and smoothed over a couple of frames.
+ * Render thread only.
+ */
+class Profiler
+{
+public:
+    enum {
+        QUERY_FRAMES = 3    // frames in flight before a query result is read
+    };
+
+    /*!
+     * Begin()/End() for a C++ scope
+     */
+    class Scope
+    {
+        Profiler*   m_Profiler;
+        std::string m_Name;
+    public:
+        Scope( Profiler* profiler, const std::string& name ) : m_Profiler( profiler ), m_Name( name )
+        {
+            if ( m_Profiler ) m_Profiler->Begin( m_Name );
+        }
+        ~Scope()
+        {
+            if ( m_Profiler ) m_Profiler->End( m_Name );
+        }
+    };
+private:
+    struct Section
+    {
+        unsigned int m_Queries[ QUERY_FRAMES ];
+        bool         m_Pending[ QUERY_FRAMES ];
+        boost::posix_time::ptime m_Start;
+        double       m_CpuTime;
+        double       m_GpuTime;
+        unsigned int m_LastFrame;
+    };
+    typedef std::map< std::string, Section > SectionMap;
+
+    SectionMap   m_Sections;
+    unsigned int m_Frame;
+    bool         m_HasTimerQuery;
+    bool         m_GpuBusy;         // a GPU query is running - they can't nest
+    float        m_Smoothing;       // weight of the old value
+public:
+    Profiler();
+
+    ~Profiler();
+
+    /*!
+     * Call once per frame before any section
+     */
+    void BeginFrame();
+
+    void Begin( const std::string& name );
+
+    void End( const std::string& name );
+
+    double GetCpuTime( const std::string& name ) const;
+
+    double GetGpuTime( const std::string& name ) const;
+
+    /*!
+     * Larger of CPU and GPU time
+     */
+    double GetTime( const std::string& name ) const;
+
+    void Dump( std::ostream& out ) const;
+private:
+    void ReadBack( Section& section, int slot );
+};
+
+typedef boost::shared_ptr<Profiler> ProfilerPtr;
+
+#endif /* PROFILER_H_ */
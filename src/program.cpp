@@ -0,0 +1,171 @@
+/*
+ * program.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "program.h"
+
+#include <vector>
+
+// u_Wave: amplitude, radians per column, columns, phase in columns. The
+// undisplaced y of a wave vertex holds its grid column
+static const char* sDisplaceSource =
+    "invariant gl_Position;\n"
+    "uniform vec4 u_Wave;\n"
+    "vec4 Displace( vec4 vertex )\n"
+    "{\n"
+    "    if ( u_Wave.z > 0.0 ) {\n"
+    "        vertex.y = sin( mod( vertex.y + u_Wave.w, u_Wave.z ) * u_Wave.y ) * u_Wave.x;\n"
+    "    }\n"
+    "    return vertex;\n"
+    "}\n";
+
+Program::Program()
+    : m_ProgramID(-1)
+{
+}
+
+Program::~Program()
+{
+    // shaders are flagged for deletion after linking - they go with the program
+    if ( m_ProgramID > 0 ) {
+        glDeleteProgram( m_ProgramID );
+    }
+}
+
+bool Program::IsSupported()
+{
+    return glewGetExtension("GL_ARB_shader_objects") &&
+           glewGetExtension("GL_ARB_vertex_shader") &&
+           glewGetExtension("GL_ARB_fragment_shader");
+}
+
+const char* Program::GetDisplaceSource()
+{
+    return sDisplaceSource;
+}
+
+int Program::Compile( int type, const std::string& source ) throw(std::exception)
+{
+    int shader = glCreateShader( type );
+    GL_ASSERT( shader > 0, "Error creating shader!" );
+
+    const char* src = source.c_str();
+    glShaderSource( shader, 1, &src, nullptr );
+    glCompileShader( shader );
+
+    int status(0);
+    glGetShaderiv( shader, GL_COMPILE_STATUS, &status );
+    if ( !status ) {
+        int length(0);
+        glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &length );
+        std::vector<char> log( length + 1, 0 );
+        glGetShaderInfoLog( shader, length, nullptr, &log[0] );
+        glDeleteShader( shader );
+        THROW( "Error compiling %s shader:\n%s", type == GL_VERTEX_SHADER ? "vertex" : "fragment", &log[0] );
+    }
+    return shader;
+}
+
+void Program::Load( const std::string& vertexSource, const std::string& fragmentSource ) throw(std::exception)
+{
+    ASSERT( IsSupported(), "GLSL programs not supported!" );
+
+    if ( m_ProgramID > 0 ) {
+        glDeleteProgram( m_ProgramID );
+        m_Uniforms.clear();
+    }
+
+    int vs = Compile( GL_VERTEX_SHADER, vertexSource );
+    int fs(0);
+    if ( !fragmentSource.empty() ) {
+        try {
+            fs = Compile( GL_FRAGMENT_SHADER, fragmentSource );
+        } catch ( ... ) {
+            glDeleteShader( vs );
+            throw;
+        }
+    }
+
+    m_ProgramID = glCreateProgram();
+    glAttachShader( m_ProgramID, vs );
+    if ( fs ) {
+        glAttachShader( m_ProgramID, fs );
+    }
+    glLinkProgram( m_ProgramID );
+    glDeleteShader( vs );
+    if ( fs ) {
+        glDeleteShader( fs );
+    }
+
+    int status(0);
+    glGetProgramiv( m_ProgramID, GL_LINK_STATUS, &status );
+    if ( !status ) {
+        int length(0);
+        glGetProgramiv( m_ProgramID, GL_INFO_LOG_LENGTH, &length );
+        std::vector<char> log( length + 1, 0 );
+        glGetProgramInfoLog( m_ProgramID, length, nullptr, &log[0] );
+        glDeleteProgram( m_ProgramID );
+        m_ProgramID = -1;
+        THROW( "Error linking program:\n%s", &log[0] );
+    }
+}
+
+void Program::Enable() const
+{
+    ASSERT( m_ProgramID > 0, "Program not loaded!" );
+    glUseProgram( m_ProgramID );
+}
+
+void Program::Disable() const
+{
+    glUseProgram( 0 );
+}
+
+int Program::GetUniformLocation( const std::string& name )
+{
+    auto it = m_Uniforms.find( name );
+    if ( it != m_Uniforms.end() ) {
+        return it->second;
+    }
+    int location = glGetUniformLocation( m_ProgramID, name.c_str() );
+    m_Uniforms[ name ] = location;
+    return location;
+}
+
+int Program::GetAttributeLocation( const std::string& name ) const
+{
+    return glGetAttribLocation( m_ProgramID, name.c_str() );
+}
+
+void Program::SetUniform( const std::string& name, int value )
+{
+    int location = GetUniformLocation( name );
+    if ( location > -1 ) glUniform1i( location, value );
+}
+
+void Program::SetUniform( const std::string& name, float value )
+{
+    int location = GetUniformLocation( name );
+    if ( location > -1 ) glUniform1f( location, value );
+}
+
+void Program::SetUniform( const std::string& name, float x, float y )
+{
+    int location = GetUniformLocation( name );
+    if ( location > -1 ) glUniform2f( location, x, y );
+}
+
+void Program::SetUniform( const std::string& name, const Vector& value )
+{
+    int location = GetUniformLocation( name );
+    if ( location > -1 ) glUniform4fv( location, 1, (const float*)value );
+}
+
+void Program::SetUniform( const std::string& name, const Matrix& value )
+{
+    int location = GetUniformLocation( name );
+    if ( location > -1 ) glUniformMatrix4fv( location, 1, GL_FALSE, (const float*)value );
+}
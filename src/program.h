@@ -0,0 +1,86 @@
+/*
+ * program.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef PROGRAM_H_
+#define PROGRAM_H_
+
+#include "err.h"
+#include "vector.h"
+#include "matrix.h"
+
+#include <GL/glew.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <string>
+
+/*!
+ * A GLSL program (vertex + fragment shader). Sources are plain strings -
+ * shaders are small and embedded with the code using them.
+ * Must be created, used and destroyed on the render thread.
+ */
+class Program
+{
+    int m_ProgramID;
+
+    boost::unordered_map< std::string, int > m_Uniforms; // location cache
+public:
+    Program();
+
+    ~Program();
+
+    /*!
+     * Compile and link. Throws with the info log on errors. Without a
+     * fragment source the fragment stage stays fixed function.
+     */
+    void Load( const std::string& vertexSource, const std::string& fragmentSource ) throw(std::exception);
+
+    bool IsLoaded() const { return m_ProgramID > 0; }
+
+    unsigned int GetProgramId() const { return m_ProgramID; }
+
+    void Enable() const;
+
+    void Disable() const;
+
+    int GetUniformLocation( const std::string& name );
+
+    int GetAttributeLocation( const std::string& name ) const;
+
+    // Program must be enabled for these. Unknown names are ignored (optimized out by the compiler)
+    void SetUniform( const std::string& name, int value );
+
+    void SetUniform( const std::string& name, float value );
+
+    void SetUniform( const std::string& name, float x, float y );
+
+    void SetUniform( const std::string& name, const Vector& value );
+
+    void SetUniform( const std::string& name, const Matrix& value );
+
+    /*!
+     * True if GLSL programs are available at all
+     */
+    static bool IsSupported();
+
+    /*!
+     * GLSL snippet (goes right after #version) with vec4 Displace( vec4 vertex ).
+     * Every vertex program that may draw a Surface uses it - the wave is
+     * evaluated on the GPU and set per draw through the u_Wave uniform, which
+     * is off (0) for everything else. gl_Position is invariant, so a displaced
+     * surface gives the same depth in all passes.
+     */
+    static const char* GetDisplaceSource();
+
+private:
+    static int Compile( int type, const std::string& source ) throw(std::exception);
+};
+
+typedef boost::shared_ptr<Program> ProgramPtr;
+
+#endif /* PROGRAM_H_ */
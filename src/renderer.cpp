@@ -27,6 +27,13 @@ Renderer::Renderer()
 #endif
     , m_TimeBase(1.0f)
     , m_Pause(1)
+    , m_JobQueue( new JobQueue )
+    , m_Profiler( new Profiler )
+    , m_GeometryArena( new GeometryArena )
+    , m_MeshCache( new MeshCache( m_GeometryArena ) )
+    , m_StreamBuffer( new StreamBuffer )
+    , m_TextureStreamer( new TextureStreamer( m_JobQueue ) )
+    , m_TextureCache( new TextureCache( m_TextureStreamer ) )
 {
 }
 
@@ -283,6 +290,7 @@ void Renderer::Run()
             }
 
             // third step: render all entities
+            m_Profiler->BeginFrame();
 
             float ticks = float(SDL_GetTicks());
 
@@ -296,6 +304,11 @@ void Renderer::Run()
                 ++doUpdate;
             }
 
+            // duplicates found by the prepare jobs are shared before their levels go up
+            m_TextureCache->Update();
+            // texture levels in before anything samples them
+            m_TextureStreamer->Update();
+
             glClearColor( m_ClearColor[ Vector::R ],
                           m_ClearColor[ Vector::G ],
                           m_ClearColor[ Vector::B ],
@@ -316,6 +329,8 @@ void Renderer::Run()
             // fourth: swap the buffers
             // Swap the buffer
             SDL_GL_SwapBuffers();
+            m_StreamBuffer->EndFrame();
+            m_GeometryArena->Update();
             // Store timestamp after we have rendered all entities
             timeStamp = ticks;
 
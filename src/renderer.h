@@ -10,6 +10,13 @@
 
 #include "worker.h"
 #include "entity.h"
+#include "jobqueue.h"
+#include "profiler.h"
+#include "meshcache.h"
+#include "streambuffer.h"
+#include "geometryarena.h"
+#include "texturestreamer.h"
+#include "texturecache.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
@@ -58,6 +65,14 @@ private:
 	Vector      m_ClearColor;
 
 	boost::unordered_map< long, UpdateFunction > m_Updaters;
+
+	JobQueuePtr m_JobQueue;
+	ProfilerPtr m_Profiler;
+	GeometryArenaPtr m_GeometryArena;
+	MeshCachePtr m_MeshCache;
+	StreamBufferPtr m_StreamBuffer;
+	TextureStreamerPtr m_TextureStreamer;
+	TextureCachePtr m_TextureCache;
 public:
 	Renderer();
 
@@ -77,6 +92,45 @@ public:
 
     virtual bool HandleEvent( const SDL_Event& event );
 
+    /*!
+     * Worker pool shared by all entities for CPU side work (culling, mesh
+     * generation, ...). Jobs must not call into GL.
+     */
+    JobQueuePtr GetJobQueue() const { return m_JobQueue; }
+
+    /*!
+     * CPU/GPU timers. Frames are started by the render loop.
+     */
+    ProfilerPtr GetProfiler() const { return m_Profiler; }
+
+    /*!
+     * Geometry shared between entities. Render thread only.
+     */
+    MeshCachePtr GetMeshCache() const { return m_MeshCache; }
+
+    /*!
+     * Ring buffer for per frame vertex data. Fenced at the end of each frame.
+     */
+    StreamBufferPtr GetStreamBuffer() const { return m_StreamBuffer; }
+
+    /*!
+     * One vertex and one index buffer for all static meshes. Defragmented
+     * between frames.
+     */
+    GeometryArenaPtr GetGeometryArena() const { return m_GeometryArena; }
+
+    /*!
+     * Textures from brushes, uploaded over the next frames within a byte
+     * budget. Render thread only.
+     */
+    TextureStreamerPtr GetTextureStreamer() const { return m_TextureStreamer; }
+
+    /*!
+     * Textures shared between entities by file name and content. Streamed,
+     * evicted over a VRAM budget. Render thread only.
+     */
+    TextureCachePtr GetTextureCache() const { return m_TextureCache; }
+
 private:
 	void InitGL();
 
@@ -0,0 +1,90 @@
+/*
+ * rledecoder.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "rledecoder.h"
+#include "pixelconverter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// rows per band are chosen to decode about this many bytes at a time
+static const std::size_t _bandSize = 64<<10;
+
+RleDecoder::RleDecoder( const char* data, std::size_t size, int bpp )
+    : m_Src( (const unsigned char*)data )
+    , m_End( (const unsigned char*)data + size )
+    , m_Bpp( bpp )
+    , m_Left(0)
+    , m_Repeat(false)
+{
+}
+
+void RleDecoder::Decode( char* pixels, std::size_t count ) throw(std::exception)
+{
+    const std::size_t bpp = m_Bpp;
+    while ( count > 0 ) {
+        if ( m_Left == 0 ) {
+            // packet header: bit 7 set repeats the next pixel, 7 bit count - 1
+            ASSERT( m_Src < m_End, "RLE data ends early!" );
+            m_Repeat = ( *m_Src & 0x80 ) != 0;
+            m_Left   = ( *m_Src & 0x7f ) + 1;
+            ++m_Src;
+            ASSERT( std::size_t( m_End - m_Src ) >= ( m_Repeat ? 1 : m_Left ) * bpp, "RLE data ends early!" );
+        }
+        const std::size_t n = std::min( m_Left, count );
+        if ( m_Repeat ) {
+            // one pixel, then doubling copies of what is already filled
+            std::memcpy( pixels, m_Src, bpp );
+            for ( std::size_t filled = 1; filled < n; filled *= 2 ) {
+                std::memcpy( pixels + filled*bpp, pixels, std::min( filled, n - filled ) * bpp );
+            }
+            if ( n == m_Left ) {
+                m_Src += bpp;
+            }
+        } else {
+            std::memcpy( pixels, m_Src, n * bpp );
+            m_Src += n * bpp;
+        }
+        pixels += n * bpp;
+        m_Left -= n;
+        count  -= n;
+    }
+}
+
+void RleDecoder::Decode( const Brush& brush, char* pixels, unsigned int flags ) throw(std::exception)
+{
+    ASSERT( brush.m_Pixels && brush.m_Compression == Brush::RLE, "Not an RLE brush!" );
+    ASSERT( brush.m_BytesPerPixel == 1 || brush.m_BytesPerPixel == 3 || brush.m_BytesPerPixel == 4,
+            "Invalid Bytes per Pixel (%d). Must be 1, 3 or 4.", brush.m_BytesPerPixel );
+
+    const int width  = brush.m_Width;
+    const int height = brush.m_Height;
+    RleDecoder decoder( brush.m_Pixels, brush.m_Size, brush.m_BytesPerPixel );
+
+    Brush band( brush );
+    band.m_Compression = Brush::NONE;
+    band.m_Pitch       = 0;
+    band.m_Size        = 0;
+    band.m_NumLevels   = 1;
+    if ( PixelConverter::IsUploadable( band, flags ) ) {
+        // BGRA, bottom row first - nothing to convert
+        decoder.Decode( pixels, std::size_t( width ) * height );
+        return;
+    }
+
+    const int rows = std::max( int( _bandSize / ( std::size_t( width ) * brush.m_BytesPerPixel ) ), 1 );
+    std::vector<char> decoded( std::size_t( width ) * std::min( rows, height ) * brush.m_BytesPerPixel );
+    for ( int row = 0; row < height; row += rows ) {
+        band.m_Height = std::min( rows, height - row );
+        band.m_Pixels = &decoded[0];
+        decoder.Decode( &decoded[0], std::size_t( width ) * band.m_Height );
+        // rows [row, row + band height) of the file, flipped within the band if the file is top down
+        const int first = brush.m_TopDown ? height - row - band.m_Height : row;
+        PixelConverter::Convert( band, pixels + std::size_t( first ) * width * 4, flags );
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * rledecoder.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef RLEDECODER_H_
+#define RLEDECODER_H_
+
+#include "err.h"
+#include "brush.h"
+
+#include <cstddef>
+
+/*!
+ * Decoder for run length encoded TGA pixels (Brush::RLE). Packets carry
+ * over from one Decode() to the next, so an image can be decoded in chunks
+ * of any number of pixels straight into the memory it is uploaded from -
+ * runs are filled and literal packets copied whole, not pixel by pixel.
+ * One decoder per thread; decoding can't be split, packets are sequential.
+ */
+class RleDecoder
+{
+    const unsigned char* m_Src;
+    const unsigned char* m_End;
+    int         m_Bpp;
+    std::size_t m_Left;     // pixels in the current packet
+    bool        m_Repeat;   // the packet repeats the pixel at m_Src
+public:
+    RleDecoder( const char* data, std::size_t size, int bpp );
+
+    /*!
+     * Next count pixels into pixels, tightly packed as in the file. Throws on
+     * data that ends early
+     */
+    void Decode( char* pixels, std::size_t count ) throw(std::exception);
+
+    /*!
+     * Level 0 of an RLE brush into pixels (width * height * 4 bytes) as BGRA,
+     * bottom row first - a band of rows at a time, each band converted (see
+     * PixelConverter) while it is still in the cache
+     */
+    static void Decode( const Brush& brush, char* pixels, unsigned int flags = 0 ) throw(std::exception);
+};
+
+#endif /* RLEDECODER_H_ */
@@ -0,0 +1,64 @@
+/*
+ * shadowbudget.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "shadowbudget.h"
+
+#include <algorithm>
+
+ShadowBudget::ShadowBudget( float budgetMs, int numLevels, int level )
+    : m_Budget( budgetMs )
+    , m_LevelCost( 2.5f )   // 4x the texels, but the test pass doesn't scale with the map
+    , m_Headroom( 0.8f )
+    , m_NumLevels( numLevels )
+    , m_Level( std::max( 0, std::min( numLevels - 1, level ) ) )
+    , m_OverFrames(0)
+    , m_UnderFrames(0)
+    , m_Cooldown( COOLDOWN_FRAMES )
+{
+}
+
+void ShadowBudget::SetNumLevels( int numLevels )
+{
+    m_NumLevels = std::max( 1, numLevels );
+    m_Level     = std::min( m_Level, m_NumLevels - 1 );
+}
+
+void ShadowBudget::Hold()
+{
+    m_OverFrames = m_UnderFrames = 0;
+    m_Cooldown   = COOLDOWN_FRAMES;
+}
+
+int ShadowBudget::Update( double shadowMs )
+{
+    if ( m_Cooldown > 0 ) {
+        --m_Cooldown;
+        return m_Level;
+    }
+
+    // hysteresis: between "over" and "next level fits" nothing happens
+    if ( shadowMs > m_Budget ) {
+        ++m_OverFrames;
+        m_UnderFrames = 0;
+    } else if ( shadowMs * m_LevelCost < m_Budget * m_Headroom ) {
+        ++m_UnderFrames;
+        m_OverFrames = 0;
+    } else {
+        m_OverFrames = m_UnderFrames = 0;
+    }
+
+    if ( m_OverFrames >= DOWN_FRAMES && m_Level > 0 ) {
+        --m_Level;
+        m_OverFrames = 0;
+        m_Cooldown   = COOLDOWN_FRAMES;
+    } else if ( m_UnderFrames >= UP_FRAMES && m_Level < m_NumLevels - 1 ) {
+        ++m_Level;
+        m_UnderFrames = 0;
+        m_Cooldown    = COOLDOWN_FRAMES;
+    }
+    return m_Level;
+}
@@ -0,0 +1,61 @@
+/*
+ * shadowbudget.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef SHADOWBUDGET_H_
+#define SHADOWBUDGET_H_
+
+#include "err.h"
+
+/*!
+ * Picks a shadow map resolution level from the measured shadow cost.
+ *
+ * Goes down a level if the cost stays above the budget for a few frames and
+ * only goes up again if the estimated cost of the next level fits well into
+ * the budget for a much longer time. After each switch the measurements are
+ * ignored for a while - the profiler needs time to settle.
+ */
+class ShadowBudget
+{
+public:
+    enum {
+        DOWN_FRAMES     = 10,   // frames over budget before going down
+        UP_FRAMES       = 90,   // frames well under budget before going up
+        COOLDOWN_FRAMES = 30,   // frames to ignore after a switch
+    };
+private:
+    float m_Budget;         // ms per frame for all shadow passes
+    float m_LevelCost;      // estimated cost factor from one level to the next
+    float m_Headroom;       // next level must fit into this fraction of the budget
+    int   m_NumLevels;
+    int   m_Level;
+    int   m_OverFrames;
+    int   m_UnderFrames;
+    int   m_Cooldown;
+public:
+    ShadowBudget( float budgetMs, int numLevels, int level );
+
+    void SetBudget( float budgetMs ) { m_Budget = budgetMs; }
+
+    float GetBudget() const { return m_Budget; }
+
+    void SetNumLevels( int numLevels );
+
+    /*!
+     * Ignore measurements for a while, e.g. after the filter changed
+     */
+    void Hold();
+
+    /*!
+     * Feed the (smoothed) shadow cost of the last frame in ms. Returns the
+     * level to use for the next frame.
+     */
+    int Update( double shadowMs );
+
+    int GetLevel() const { return m_Level; }
+};
+
+#endif /* SHADOWBUDGET_H_ */
@@ -0,0 +1,129 @@
+/*
+ * shadowcull.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "shadowcull.h"
+
+#include <algorithm>
+
+ShadowCasterCuller::ShadowCasterCuller()
+    : m_HasReceiverView(false)
+    , m_Frame(0)
+    , m_NumCasters(0)
+    , m_NumRebuilds(0)
+{
+}
+
+void ShadowCasterCuller::SetReceiverView( const Matrix& view, const Matrix& projection )
+{
+    // GL order: projection * view
+    m_ReceiverViewProjection = Matrix( view ).Mul( projection );
+    m_HasReceiverView = true;
+    ++m_Frame;
+}
+
+const std::vector<bool>& ShadowCasterCuller::GetCasters( const Matrix& lightViewProjection, const EntityList& entities )
+{
+    // receivers the camera can see - a frustum test is cheap enough to do for each light
+    unsigned int version(0);
+    m_Receivers.assign( entities.size(), true );
+    int i(0);
+    for ( auto& entity : entities ) {
+        const BoundingBox& bounds = entity->GetWorldBounds();
+        version += entity->GetBoundsVersion();
+        if ( m_HasReceiverView && !bounds.IsEmpty() ) {
+            m_Receivers[i] = bounds.Intersects( m_ReceiverViewProjection );
+        }
+        ++i;
+    }
+
+    CasterSet* set(nullptr);
+    for ( auto& s : m_CasterSets ) {
+        if ( s.m_LightViewProjection == lightViewProjection ) {
+            set = &s;
+            break;
+        }
+    }
+    bool valid = set && set->m_BoundsVersion == version && set->m_Receivers == m_Receivers;
+    if ( !set ) {
+        if ( m_CasterSets.size() < MAX_CACHED_LIGHTS ) {
+            m_CasterSets.push_back( CasterSet() );
+            set = &m_CasterSets.back();
+        } else {
+            // recycle the least recently used one - light moved or is gone
+            set = &m_CasterSets[0];
+            for ( auto& s : m_CasterSets ) {
+                if ( s.m_LastUsed < set->m_LastUsed ) set = &s;
+            }
+        }
+    }
+    if ( !valid ) {
+        set->m_LightViewProjection = lightViewProjection;
+        set->m_BoundsVersion = version;
+        set->m_Receivers     = m_Receivers;
+        Build( *set, entities );
+        ++m_NumRebuilds;
+    }
+    set->m_LastUsed = m_Frame;
+
+    m_NumCasters = std::count( set->m_Casters.begin(), set->m_Casters.end(), true );
+    return set->m_Casters;
+}
+
+void ShadowCasterCuller::Build( CasterSet& set, const EntityList& entities )
+{
+    const Matrix& lightViewProjection = set.m_LightViewProjection;
+
+    // receiver footprints in light space
+    m_ReceiverRects.clear();
+    int i(0);
+    for ( auto& entity : entities ) {
+        if ( set.m_Receivers[i++] ) {
+            const BoundingBox& bounds = entity->GetWorldBounds();
+            ScreenRect rect = { -1, -1, 1, 1, 0, 1 };
+            if ( !bounds.IsEmpty() ) {
+                if ( !bounds.Intersects( lightViewProjection ) ) {
+                    // outside the shadow map - nothing to receive
+                    continue;
+                }
+                if ( bounds.Project( lightViewProjection, rect ) ) {
+                    rect.m_MinX = std::max( rect.m_MinX, -1.0f ); rect.m_MaxX = std::min( rect.m_MaxX, 1.0f );
+                    rect.m_MinY = std::max( rect.m_MinY, -1.0f ); rect.m_MaxY = std::min( rect.m_MaxY, 1.0f );
+                } else {
+                    // reaches behind the light: may be shadowed by anything in the frustum
+                    rect = { -1, -1, 1, 1, 0, 1 };
+                }
+            }
+            m_ReceiverRects.push_back( rect );
+        }
+    }
+
+    set.m_Casters.assign( entities.size(), false );
+    if ( m_ReceiverRects.empty() ) {
+        return;
+    }
+    i = 0;
+    for ( auto& entity : entities ) {
+        const BoundingBox& bounds = entity->GetWorldBounds();
+        bool keep(true);
+        if ( !bounds.IsEmpty() ) {
+            ScreenRect rect;
+            if ( !bounds.Intersects( lightViewProjection ) ) {
+                keep = false;
+            } else if ( bounds.Project( lightViewProjection, rect ) ) {
+                // a caster must be in front of (closer to the light than) the far end of a receiver it overlaps
+                keep = false;
+                for ( auto& receiver : m_ReceiverRects ) {
+                    if ( rect.Overlaps( receiver ) && rect.m_MinZ <= receiver.m_MaxZ ) {
+                        keep = true;
+                        break;
+                    }
+                }
+            }
+        }
+        set.m_Casters[i++] = keep;
+    }
+}
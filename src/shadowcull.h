@@ -0,0 +1,82 @@
+/*
+ * shadowcull.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef SHADOWCULL_H_
+#define SHADOWCULL_H_
+
+#include "err.h"
+#include "entity.h"
+#include "bounds.h"
+
+#include <vector>
+
+/*!
+ * Selects the shadow casters for a light. A caster is kept if its bounds are
+ * inside the light frustum and it can throw a shadow onto a receiver the
+ * camera sees: in light space (light looks down +z) its rect must overlap
+ * the receiver's rect and it must start in front of the receiver's far end.
+ * That is the receiver volume swept towards the light.
+ *
+ * Caster sets are cached per light (keyed by the light view projection) and
+ * reused as long as light, entity bounds and visible receivers don't change.
+ * Render thread only.
+ */
+class ShadowCasterCuller
+{
+public:
+    enum {
+        MAX_CACHED_LIGHTS = 8
+    };
+private:
+    struct CasterSet
+    {
+        Matrix            m_LightViewProjection;
+        unsigned int      m_BoundsVersion;  // sum of all entity bounds versions
+        std::vector<bool> m_Receivers;      // camera visible receivers the set was built for
+        std::vector<bool> m_Casters;
+        unsigned int      m_LastUsed;
+    };
+
+    std::vector<CasterSet> m_CasterSets;
+    Matrix                 m_ReceiverViewProjection;
+    bool                   m_HasReceiverView;
+    unsigned int           m_Frame;
+
+    // scratch - kept to avoid allocations each pass
+    std::vector<bool>       m_Receivers;
+    std::vector<ScreenRect> m_ReceiverRects;
+
+    int                    m_NumCasters;
+    int                    m_NumRebuilds;
+public:
+    ShadowCasterCuller();
+
+    /*!
+     * Camera the receivers are seen with. Set once per frame, before the
+     * shadow passes. Without it every entity counts as a receiver.
+     */
+    void SetReceiverView( const Matrix& view, const Matrix& projection );
+
+    /*!
+     * Caster flags for entities (same order as the list) as seen from a
+     * light. The reference stays valid until the next call.
+     */
+    const std::vector<bool>& GetCasters( const Matrix& lightViewProjection, const EntityList& entities );
+
+    // number of casters kept by the last GetCasters() call
+    int GetNumCasters() const { return m_NumCasters; }
+
+    // number of caster sets that had to be rebuilt - for profiling
+    int GetNumRebuilds() const { return m_NumRebuilds; }
+
+private:
+    void Build( CasterSet& set, const EntityList& entities );
+};
+
+typedef boost::shared_ptr<ShadowCasterCuller> ShadowCasterCullerPtr;
+
+#endif /* SHADOWCULL_H_ */
@@ -0,0 +1,81 @@
+/*
+ * shadowdirty.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "shadowdirty.h"
+
+#include <algorithm>
+
+ShadowDirtyTracker::ShadowDirtyTracker()
+    : m_Valid(false)
+{
+}
+
+const ScreenRect& ShadowDirtyTracker::GetFullRect()
+{
+    static const ScreenRect full = { -1, -1, 1, 1, 0, 1 };
+    return full;
+}
+
+ScreenRect ShadowDirtyTracker::GetFootprint( const EntityPtr& entity, const Matrix& lightViewProjection )
+{
+    const BoundingBox& bounds = entity->GetWorldBounds();
+    ScreenRect rect;
+    if ( bounds.IsEmpty() || !bounds.Project( lightViewProjection, rect ) ) {
+        // no bounds or reaches behind the light - could be anywhere
+        return GetFullRect();
+    }
+    rect.m_MinX = std::max( rect.m_MinX, -1.0f ); rect.m_MaxX = std::min( rect.m_MaxX, 1.0f );
+    rect.m_MinY = std::max( rect.m_MinY, -1.0f ); rect.m_MaxY = std::min( rect.m_MaxY, 1.0f );
+    return rect;
+}
+
+bool ShadowDirtyTracker::Update( const Matrix& lightViewProjection, const EntityList& entities,
+                                 const std::vector<bool>& casters, ScreenRect& dirty )
+{
+    bool full = !m_Valid || !( m_LightViewProjection == lightViewProjection ) ||
+                m_Footprints.size() != entities.size();
+
+    bool changed(false);
+    m_Current.resize( entities.size() );
+    int i(0);
+    for ( auto& entity : entities ) {
+        Footprint& now = m_Current[i];
+        now.m_Entity        = entity.get();
+        now.m_BoundsVersion = entity->GetBoundsVersion();
+        now.m_Caster        = casters[i];
+        if ( !full ) {
+            const Footprint& old = m_Footprints[i];
+            if ( old.m_Entity != now.m_Entity ) {
+                // list was re-ordered or replaced
+                full = true;
+            } else if ( old.m_BoundsVersion == now.m_BoundsVersion && old.m_Caster == now.m_Caster ) {
+                now.m_Rect = old.m_Rect;
+                ++i;
+                continue;
+            } else if ( old.m_Caster ) {
+                // clear where it was
+                dirty = changed ? dirty.Merge( old.m_Rect ) : old.m_Rect;
+                changed = true;
+            }
+        }
+        now.m_Rect = GetFootprint( entity, lightViewProjection );
+        if ( !full && now.m_Caster ) {
+            dirty = changed ? dirty.Merge( now.m_Rect ) : now.m_Rect;
+            changed = true;
+        }
+        ++i;
+    }
+    m_Footprints.swap( m_Current );
+
+    if ( full ) {
+        m_LightViewProjection = lightViewProjection;
+        m_Valid = true;
+        dirty   = GetFullRect();
+        return true;
+    }
+    return changed;
+}
@@ -0,0 +1,59 @@
+/*
+ * shadowdirty.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef SHADOWDIRTY_H_
+#define SHADOWDIRTY_H_
+
+#include "err.h"
+#include "entity.h"
+#include "bounds.h"
+
+#include <vector>
+
+/*!
+ * Remembers which casters a shadow map holds and where (light space
+ * footprint). Update() compares that with the current casters and returns
+ * the region of the map that must be redrawn: old and new footprint of every
+ * caster that moved, changed its geometry, appeared or disappeared.
+ *
+ * One tracker per shadow map. Invalidate() whenever the map content is lost
+ * (light moved, other resolution, other filter) - the next update is a full one.
+ */
+class ShadowDirtyTracker
+{
+    struct Footprint
+    {
+        const Entity* m_Entity;
+        unsigned int  m_BoundsVersion;
+        bool          m_Caster;
+        ScreenRect    m_Rect;           // NDC in light space. Whole map if unknown
+    };
+
+    std::vector<Footprint> m_Footprints;   // as rendered into the map
+    std::vector<Footprint> m_Current;      // scratch
+    Matrix                 m_LightViewProjection;
+    bool                   m_Valid;
+public:
+    ShadowDirtyTracker();
+
+    void Invalidate() { m_Valid = false; }
+
+    /*!
+     * casters: flags per entity (same order as the list) of what goes into the
+     * map. Returns false if the map is up to date, otherwise the dirty region
+     * in light space NDC. The tracker assumes the region is redrawn.
+     */
+    bool Update( const Matrix& lightViewProjection, const EntityList& entities,
+                 const std::vector<bool>& casters, ScreenRect& dirty );
+
+    static const ScreenRect& GetFullRect();
+
+private:
+    static ScreenRect GetFootprint( const EntityPtr& entity, const Matrix& lightViewProjection );
+};
+
+#endif /* SHADOWDIRTY_H_ */
@@ -0,0 +1,497 @@
+/*
+ * shadowmap.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "shadowmap.h"
+#include "bufferbinding.h"
+
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+
+// shared by all test programs: shadow coords from eye space. ftransform() keeps the depth
+// bit-identical to the fixed function pass we blend onto, displaced surfaces have their own program there
+static const char* sTestVertexShader =
+    "uniform mat4 u_ShadowMatrix;\n"
+    "varying vec4 v_ShadowCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 vertex   = Displace( gl_Vertex );\n"
+    "    gl_Position   = u_Wave.z > 0.0 ? gl_ModelViewProjectionMatrix * vertex : ftransform();\n"
+    "    v_ShadowCoord = u_ShadowMatrix * ( gl_ModelViewMatrix * vertex );\n"
+    "}\n";
+
+// common head of all test fragment shaders - lit is 1.0 outside of the light frustum
+static const char* sTestFragmentHead =
+    "#version 120\n"
+    "uniform float u_Darkness;\n"
+    "uniform float u_Bias;\n"
+    "varying vec4  v_ShadowCoord;\n"
+    "float Lookup( vec3 coord );\n"
+    "void main()\n"
+    "{\n"
+    "    vec3 coord = v_ShadowCoord.xyz / v_ShadowCoord.w;\n"
+    "    float lit = 1.0;\n"
+    "    if ( v_ShadowCoord.w > 0.0 && all( greaterThanEqual( coord, vec3( 0.0 ) ) ) && all( lessThanEqual( coord, vec3( 1.0 ) ) ) ) {\n"
+    "        coord.z -= u_Bias;\n"
+    "        lit = Lookup( coord );\n"
+    "    }\n"
+    "    gl_FragColor = vec4( 0.0, 0.0, 0.0, ( 1.0 - lit ) * u_Darkness );\n"
+    "}\n";
+
+static const char* sHardwarePCF =
+    "uniform sampler2DShadow u_ShadowMap;\n"
+    "float Lookup( vec3 coord )\n"
+    "{\n"
+    "    return shadow2D( u_ShadowMap, coord ).r;\n"
+    "}\n";
+
+// best candidate ordered - any prefix of the disk is well distributed
+static const char* sPoissonPCF =
+    "uniform sampler2DShadow u_ShadowMap;\n"
+    "uniform float u_Radius;\n" // in shadow map uv
+    "const vec2 cDisk[32] = vec2[32](\n"
+    "    vec2(  0.3320,  0.4622 ), vec2( -0.6023, -0.7722 ), vec2(  0.5223, -0.6518 ), vec2( -0.8623,  0.4056 ),\n"
+    "    vec2(  0.9814, -0.0511 ), vec2( -0.2493,  0.9536 ), vec2( -0.1495, -0.1520 ), vec2( -0.9473, -0.1730 ),\n"
+    "    vec2( -0.0301, -0.9507 ), vec2( -0.3158,  0.4051 ), vec2(  0.4616, -0.1148 ), vec2(  0.7313,  0.6611 ),\n"
+    "    vec2( -0.2255, -0.5766 ), vec2(  0.3645,  0.9055 ), vec2( -0.6048,  0.0766 ), vec2(  0.1372, -0.4216 ),\n"
+    "    vec2(  0.1309,  0.1296 ), vec2( -0.6141,  0.7635 ), vec2(  0.6704,  0.2169 ), vec2( -0.4803, -0.2515 ),\n"
+    "    vec2(  0.7497, -0.3609 ), vec2(  0.0123,  0.6410 ), vec2( -0.7114, -0.4896 ), vec2(  0.2254, -0.6806 ),\n"
+    "    vec2( -0.3354, -0.9047 ), vec2(  0.3893, -0.9072 ), vec2(  0.9268,  0.3379 ), vec2(  0.3988,  0.1864 ),\n"
+    "    vec2(  0.0305,  0.9545 ), vec2( -0.2923,  0.1112 ), vec2( -0.9711,  0.1361 ), vec2( -0.5899,  0.3429 ) );\n"
+    "float Lookup( vec3 coord )\n"
+    "{\n"
+    "    // per pixel rotation trades banding for noise\n"
+    "    float a = 6.2831853 * fract( sin( dot( gl_FragCoord.xy, vec2( 12.9898, 78.233 ) ) ) * 43758.5453 );\n"
+    "    mat2 rot = mat2( cos( a ), sin( a ), -sin( a ), cos( a ) );\n"
+    "    float sum = 0.0;\n"
+    "    for ( int i = 0; i < NUM_TAPS; ++i ) {\n"
+    "        sum += shadow2D( u_ShadowMap, vec3( coord.xy + rot * cDisk[i] * u_Radius, coord.z ) ).r;\n"
+    "    }\n"
+    "    return sum / float( NUM_TAPS );\n"
+    "}\n";
+
+static const char* sVSM =
+    "uniform sampler2D u_ShadowMap;\n"
+    "uniform float u_MinVariance;\n"
+    "uniform float u_LightBleed;\n"
+    "float Lookup( vec3 coord )\n"
+    "{\n"
+    "    vec2 moments = texture2D( u_ShadowMap, coord.xy ).rg;\n"
+    "    if ( coord.z <= moments.x ) return 1.0;\n"
+    "    // Chebyshev upper bound\n"
+    "    float variance = max( moments.y - moments.x * moments.x, u_MinVariance );\n"
+    "    float d = coord.z - moments.x;\n"
+    "    float pmax = variance / ( variance + d * d );\n"
+    "    // cut off the tail to reduce light bleeding\n"
+    "    return clamp( ( pmax - u_LightBleed ) / ( 1.0 - u_LightBleed ), 0.0, 1.0 );\n"
+    "}\n";
+
+static const char* sMomentsVertexShader =
+    "void main()\n"
+    "{\n"
+    "    gl_Position = u_Wave.z > 0.0 ? gl_ModelViewProjectionMatrix * Displace( gl_Vertex ) : ftransform();\n"
+    "}\n";
+
+static const char* sMomentsFragmentShader =
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    float z  = gl_FragCoord.z;\n"
+    "    float dx = dFdx( z );\n"
+    "    float dy = dFdy( z );\n"
+    "    gl_FragColor = vec4( z, z * z + 0.25 * ( dx * dx + dy * dy ), 0.0, 1.0 );\n"
+    "}\n";
+
+static const char* sBlurVertexShader =
+    "#version 120\n"
+    "varying vec2 v_UV;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = gl_Vertex;\n"
+    "    v_UV = gl_Vertex.xy * 0.5 + 0.5;\n"
+    "}\n";
+
+// 9 tap Gaussian, one direction per pass
+static const char* sBlurFragmentShader =
+    "#version 120\n"
+    "uniform sampler2D u_Source;\n"
+    "uniform vec2 u_Direction;\n" // one texel along the blur direction
+    "varying vec2 v_UV;\n"
+    "void main()\n"
+    "{\n"
+    "    const float w[5] = float[5]( 0.2270270, 0.1945946, 0.1216216, 0.0540541, 0.0162162 );\n"
+    "    vec4 sum = texture2D( u_Source, v_UV ) * w[0];\n"
+    "    for ( int i = 1; i < 5; ++i ) {\n"
+    "        sum += texture2D( u_Source, v_UV + u_Direction * float(i) ) * w[i];\n"
+    "        sum += texture2D( u_Source, v_UV - u_Direction * float(i) ) * w[i];\n"
+    "    }\n"
+    "    gl_FragColor = sum;\n"
+    "}\n";
+
+ShadowMap::ShadowMap( int level /* = 1 */ )
+    : m_NumLevels( NUM_LEVELS )
+    , m_Level( std::max( 0, std::min( int(NUM_LEVELS) - 1, level ) ) )
+    , m_ActiveLevel( m_Level )
+    , m_Filter( FILTER_HARDWARE_PCF )
+    , m_NumTaps( 16 )
+    , m_FilterRadius( 2.5f )
+    , m_Darkness( 0.6f )
+    , m_Bias( 0.0015f )
+    , m_Size( MIN_SIZE << m_Level )
+    , m_TestProgramDirty( true )
+{
+    std::fill( m_Viewport, m_Viewport + 4, 0 );
+    std::fill( m_Dirty, m_Dirty + 4, 0 );
+    for ( int i = 0; i < NUM_LEVELS; ++i ) {
+        m_Levels[i].m_Size  = MIN_SIZE << i;
+        m_Levels[i].m_Valid = false;
+    }
+}
+
+ShadowMap::~ShadowMap()
+{
+}
+
+const char* ShadowMap::GetFilterName( Filter filter )
+{
+    switch ( filter ) {
+    case FILTER_HARDWARE_PCF: return "hardware pcf";
+    case FILTER_POISSON_PCF:  return "poisson pcf";
+    case FILTER_VSM:          return "vsm";
+    default: break;
+    }
+    return "unknown";
+}
+
+void ShadowMap::SetFilter( Filter filter, int numTaps /* = 16 */ )
+{
+    numTaps = std::max( 1, std::min( int(MAX_POISSON_TAPS), numTaps ) );
+    if ( filter != m_Filter || numTaps != m_NumTaps ) {
+        if ( ( filter == FILTER_VSM ) != ( m_Filter == FILTER_VSM ) ) {
+            // other render target
+            Invalidate();
+        }
+        m_Filter  = filter;
+        m_NumTaps = numTaps;
+        m_TestProgramDirty = true;
+    }
+}
+
+void ShadowMap::SetLevel( int level )
+{
+    m_Level = std::max( 0, std::min( m_NumLevels - 1, level ) );
+}
+
+void ShadowMap::SetLight( const Matrix& view, const Matrix& projection )
+{
+    if ( !( view == m_LightView ) || !( projection == m_LightProjection ) ) {
+        Invalidate();
+    }
+    m_LightView       = view;
+    m_LightProjection = projection;
+}
+
+void ShadowMap::Invalidate()
+{
+    for ( int i = 0; i < NUM_LEVELS; ++i ) {
+        m_Levels[i].m_Valid = false;
+    }
+}
+
+void ShadowMap::Allocate() throw(std::exception)
+{
+    if ( !m_Levels[0].m_DepthMap ) {
+        // drop levels the hardware can't do
+        int maxSize(0);
+        glGetIntegerv( GL_MAX_TEXTURE_SIZE, &maxSize );
+        while ( m_NumLevels > 1 && m_Levels[ m_NumLevels-1 ].m_Size > maxSize ) {
+            --m_NumLevels;
+        }
+        m_Level = std::min( m_Level, m_NumLevels - 1 );
+    }
+    for ( int i = 0; i < m_NumLevels; ++i ) {
+        AllocateLevel( m_Levels[i] );
+    }
+    if ( m_Filter == FILTER_VSM && !m_MomentsProgram ) {
+        m_MomentsProgram = ProgramPtr( new Program );
+        m_MomentsProgram->Load( std::string( "#version 120\n" ) + Program::GetDisplaceSource() + sMomentsVertexShader, sMomentsFragmentShader );
+        m_BlurProgram = ProgramPtr( new Program );
+        m_BlurProgram->Load( sBlurVertexShader, sBlurFragmentShader );
+    }
+}
+
+void ShadowMap::AllocateLevel( Level& level ) throw(std::exception)
+{
+    if ( !level.m_DepthMap ) {
+        level.m_DepthMap = FrameBufferPtr( new FrameBuffer( FrameBuffer::F_ENABLE_DEPTH_BUFFER_F ) );
+        bool r = level.m_DepthMap->Allocate( level.m_Size, level.m_Size );
+        ASSERT( r, "Cannot allocate shadow map!" );
+
+        TexturePtr depth = level.m_DepthMap->GetTexture();
+        depth->Bind();
+        // hardware PCF: bilinear filtering on a compare texture returns the filtered compare result
+        depth->SetFilter( GL_LINEAR );
+        depth->SetWrapMode( GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+        glBindTexture( GL_TEXTURE_2D, 0 );
+        level.m_DepthMap->Disable();
+    }
+    // moments only once VSM is used at all
+    if ( m_Filter == FILTER_VSM && !level.m_Moments[0] ) {
+        int format = glewGetExtension("GL_ARB_texture_rg") ? GL_RG32F : GL_RGBA32F;
+        for ( int i = 0; i < 3; ++i ) {
+            // first one needs a depth buffer to render casters, the others are blur targets only
+            level.m_Moments[i] = FrameBufferPtr( new FrameBuffer( i == 0 ? FrameBuffer::F_ENABLE_COLOR_BUFFER_F|FrameBuffer::F_ENABLE_DEPTH_BUFFER_F
+                                                                         : FrameBuffer::F_ENABLE_COLOR_BUFFER_F ) );
+            bool r = level.m_Moments[i]->Allocate( level.m_Size, level.m_Size, format );
+            ASSERT( r, "Cannot allocate variance shadow map!" );
+            TexturePtr moments = level.m_Moments[i]->GetTexture();
+            moments->Bind();
+            moments->SetFilter( GL_LINEAR );
+            moments->SetWrapMode( GL_CLAMP_TO_EDGE );
+            glBindTexture( GL_TEXTURE_2D, 0 );
+            level.m_Moments[i]->Disable();
+        }
+    }
+}
+
+void ShadowMap::BuildTestProgram() throw(std::exception)
+{
+    std::stringstream fragment;
+    fragment << sTestFragmentHead;
+    switch ( m_Filter ) {
+    case FILTER_HARDWARE_PCF:
+        fragment << sHardwarePCF;
+        break;
+    case FILTER_POISSON_PCF:
+        fragment << "#define NUM_TAPS " << m_NumTaps << "\n" << sPoissonPCF;
+        break;
+    case FILTER_VSM:
+        fragment << sVSM;
+        break;
+    default:
+        THROW( "Invalid shadow filter %d", m_Filter );
+    }
+    m_TestProgram = ProgramPtr( new Program );
+    m_TestProgram->Load( std::string( "#version 120\n" ) + Program::GetDisplaceSource() + sTestVertexShader, fragment.str() );
+    m_TestProgramDirty = false;
+}
+
+void ShadowMap::BeginCasters( const ScreenRect& dirty ) throw(std::exception)
+{
+    Allocate();
+
+    // switch resolution only here - test and preview of this frame use the same level
+    m_ActiveLevel = m_Level;
+    Level& level  = m_Levels[ m_ActiveLevel ];
+    m_Size        = level.m_Size;
+    m_DepthMap    = level.m_DepthMap;
+    std::copy( level.m_Moments, level.m_Moments + 3, m_Moments );
+
+    if ( level.m_Valid ) {
+        // NDC -> texels, one extra texel for rasterization rules and the polygon offset
+        int x0 = int( std::floor( ( dirty.m_MinX * 0.5f + 0.5f ) * m_Size ) ) - 1;
+        int y0 = int( std::floor( ( dirty.m_MinY * 0.5f + 0.5f ) * m_Size ) ) - 1;
+        int x1 = int( std::ceil ( ( dirty.m_MaxX * 0.5f + 0.5f ) * m_Size ) ) + 1;
+        int y1 = int( std::ceil ( ( dirty.m_MaxY * 0.5f + 0.5f ) * m_Size ) ) + 1;
+        x0 = std::max( x0, 0 ); x1 = std::min( x1, m_Size );
+        y0 = std::max( y0, 0 ); y1 = std::min( y1, m_Size );
+        m_Dirty[0] = x0; m_Dirty[1] = y0;
+        m_Dirty[2] = std::max( x1 - x0, 0 ); m_Dirty[3] = std::max( y1 - y0, 0 );
+    } else {
+        m_Dirty[0] = m_Dirty[1] = 0;
+        m_Dirty[2] = m_Dirty[3] = m_Size;
+    }
+
+    glGetIntegerv( GL_VIEWPORT, m_Viewport );
+    // glClear() is scissored as well
+    glPushAttrib( GL_SCISSOR_BIT );
+    SetScissor( 0 );
+
+    if ( m_Filter == FILTER_VSM ) {
+        m_Moments[0]->Enable();
+        float clearColor[4];
+        glGetFloatv( GL_COLOR_CLEAR_VALUE, clearColor );
+        glClearColor( 1, 1, 1, 1 );    // far plane
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        glClearColor( clearColor[0], clearColor[1], clearColor[2], clearColor[3] );
+        m_MomentsProgram->Enable();
+    } else {
+        m_DepthMap->Enable();
+        glClear( GL_DEPTH_BUFFER_BIT );
+        // slope scaled bias against acne. VSM doesn't need it
+        glEnable( GL_POLYGON_OFFSET_FILL );
+        glPolygonOffset( 2.0f, 4.0f );
+    }
+    glViewport( 0, 0, m_Size, m_Size );
+
+    glMatrixMode( GL_PROJECTION );
+    glPushMatrix();
+    glLoadMatrixf( m_LightProjection );
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glLoadMatrixf( m_LightView );
+}
+
+void ShadowMap::EndCasters()
+{
+    glMatrixMode( GL_PROJECTION );
+    glPopMatrix();
+    glMatrixMode( GL_MODELVIEW );
+    glPopMatrix();
+
+    if ( m_Filter == FILTER_VSM ) {
+        m_MomentsProgram->Disable();
+        m_Moments[0]->Disable();
+    } else {
+        glDisable( GL_POLYGON_OFFSET_FILL );
+        m_DepthMap->Disable();
+    }
+    glPopAttrib();
+    glViewport( m_Viewport[0], m_Viewport[1], m_Viewport[2], m_Viewport[3] );
+
+    // other levels missed this update
+    for ( int i = 0; i < NUM_LEVELS; ++i ) {
+        m_Levels[i].m_Valid = ( i == m_ActiveLevel );
+    }
+}
+
+void ShadowMap::SetScissor( int border )
+{
+    int x0 = std::max( m_Dirty[0] - border, 0 );
+    int y0 = std::max( m_Dirty[1] - border, 0 );
+    int x1 = std::min( m_Dirty[0] + m_Dirty[2] + border, m_Size );
+    int y1 = std::min( m_Dirty[1] + m_Dirty[3] + border, m_Size );
+    glEnable( GL_SCISSOR_TEST );
+    glScissor( x0, y0, x1 - x0, y1 - y0 );
+}
+
+void ShadowMap::DrawFullScreenQuad()
+{
+    static const float quad[] = { -1, -1,   1, -1,   -1, 1,   1, 1 };
+
+    // client memory - meshes leave their buffer bound
+    BufferBinding::Bind( GL_ARRAY_BUFFER, 0 );
+    int vertexArrayEnabled;
+    glGetIntegerv( GL_VERTEX_ARRAY, &vertexArrayEnabled );
+    if (!vertexArrayEnabled) {
+        glEnableClientState(GL_VERTEX_ARRAY);
+    }
+    glVertexPointer( 2, GL_FLOAT, 0, quad );
+    glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+    if (!vertexArrayEnabled) {
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+}
+
+void ShadowMap::Blur() throw(std::exception)
+{
+    if ( m_Filter != FILTER_VSM ) return;
+
+    glGetIntegerv( GL_VIEWPORT, m_Viewport );
+    glViewport( 0, 0, m_Size, m_Size );
+    glPushAttrib( GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_SCISSOR_BIT );
+    glDisable( GL_DEPTH_TEST );
+    glDisable( GL_BLEND );
+    glDepthMask( GL_FALSE );
+
+    m_BlurProgram->Enable();
+    m_BlurProgram->SetUniform( "u_Source", int(TEXTURE_UNIT) );
+    glActiveTexture( GL_TEXTURE0 + TEXTURE_UNIT );
+
+    // horizontal: 0 -> 1, vertical: 1 -> 2. Raw moments stay for the next
+    // incremental update. Kernel radius is 4 texels: the vertical pass needs
+    // the horizontal result 4 texels around what it writes
+    const float texel = 1.0f / float(m_Size);
+    for ( int pass = 0; pass < 2; ++pass ) {
+        SetScissor( pass == 0 ? 8 : 4 );
+        m_Moments[ pass + 1 ]->Enable();
+        m_Moments[ pass ]->GetTexture()->Bind();
+        m_BlurProgram->SetUniform( "u_Direction", pass == 0 ? texel : 0.0f, pass == 0 ? 0.0f : texel );
+        DrawFullScreenQuad();
+    }
+    glBindTexture( GL_TEXTURE_2D, 0 );
+    glActiveTexture( GL_TEXTURE0 );
+
+    m_BlurProgram->Disable();
+    m_Moments[2]->Disable();
+    glPopAttrib();
+    glViewport( m_Viewport[0], m_Viewport[1], m_Viewport[2], m_Viewport[3] );
+}
+
+void ShadowMap::BeginTest( const Matrix& cameraView ) throw(std::exception)
+{
+    if ( m_TestProgramDirty || !m_TestProgram ) {
+        BuildTestProgram();
+    }
+
+    // eye space -> light clip space -> [0,1] texture space. Mul() right multiplies in GL order
+    static const Matrix bias( 0.5f, 0.0f, 0.0f, 0.0f,
+                              0.0f, 0.5f, 0.0f, 0.0f,
+                              0.0f, 0.0f, 0.5f, 0.0f,
+                              0.5f, 0.5f, 0.5f, 1.0f );
+    Matrix shadowMatrix = cameraView.Inverse();
+    shadowMatrix.Mul( m_LightView ).Mul( m_LightProjection ).Mul( bias );
+
+    glActiveTexture( GL_TEXTURE0 + TEXTURE_UNIT );
+    if ( m_Filter == FILTER_VSM ) {
+        m_Moments[2]->GetTexture()->Bind();
+    } else {
+        m_DepthMap->GetTexture()->Bind();
+    }
+    glActiveTexture( GL_TEXTURE0 );
+
+    m_TestProgram->Enable();
+    m_TestProgram->SetUniform( "u_ShadowMatrix", shadowMatrix );
+    m_TestProgram->SetUniform( "u_ShadowMap", int(TEXTURE_UNIT) );
+    m_TestProgram->SetUniform( "u_Darkness", m_Darkness );
+    m_TestProgram->SetUniform( "u_Bias", m_Filter == FILTER_VSM ? 0.0f : m_Bias );
+    m_TestProgram->SetUniform( "u_Radius", m_FilterRadius / float(m_Size) );
+    m_TestProgram->SetUniform( "u_MinVariance", 0.00002f );
+    m_TestProgram->SetUniform( "u_LightBleed", 0.2f );
+
+    // darken what's already there. Same geometry, same depth - don't write it again
+    glPushAttrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    glDepthFunc( GL_LEQUAL );
+    glDepthMask( GL_FALSE );
+}
+
+void ShadowMap::EndTest()
+{
+    glPopAttrib();
+    m_TestProgram->Disable();
+
+    glActiveTexture( GL_TEXTURE0 + TEXTURE_UNIT );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+    glActiveTexture( GL_TEXTURE0 );
+}
+
+TexturePtr ShadowMap::BeginPreview()
+{
+    if ( m_Filter == FILTER_VSM && m_Moments[2] ) {
+        return m_Moments[2]->GetTexture();
+    }
+    if ( !m_DepthMap ) {
+        return TexturePtr();
+    }
+    TexturePtr depth = m_DepthMap->GetTexture();
+    depth->Bind();
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE );
+    return depth;
+}
+
+void ShadowMap::EndPreview()
+{
+    if ( m_DepthMap ) {
+        m_DepthMap->GetTexture()->Bind();
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+        glBindTexture( GL_TEXTURE_2D, 0 );
+    }
+}
@@ -0,0 +1,185 @@
+/*
+ * shadowmap.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef SHADOWMAP_H_
+#define SHADOWMAP_H_
+
+#include "err.h"
+#include "matrix.h"
+#include "framebuffer.h"
+#include "program.h"
+#include "bounds.h"
+
+#include <GL/glew.h>
+
+#include <boost/shared_ptr.hpp>
+
+/*!
+ * Shadow map of a single light plus the programs to look it up.
+ *
+ * Casters are rendered between BeginCasters()/EndCasters() with the light's
+ * matrices loaded. The shadow test re-renders the scene from the camera
+ * between BeginTest()/EndTest(): the test program overrides whatever the
+ * entities draw and darkens shadowed fragments by blending.
+ *
+ * Filters:
+ *  - FILTER_HARDWARE_PCF: GL_COMPARE_REF_TO_TEXTURE, bilinear 2x2 compare in hardware
+ *  - FILTER_POISSON_PCF:  rotated Poisson disk, NumTaps hardware compares
+ *  - FILTER_VSM:          variance shadow map, moments blurred with a separable Gaussian
+ *
+ * All resolution levels are allocated up front. SetLevel() only picks one,
+ * the switch happens with the next BeginCasters() - never within a frame.
+ *
+ * The map keeps its content between frames. BeginCasters() only clears the
+ * dirty region and scissors rendering to it, IsValid() tells if the content
+ * can be reused at all. Only the level rendered last is kept valid.
+ */
+class ShadowMap
+{
+public:
+    enum Filter {
+        FILTER_HARDWARE_PCF = 0,
+        FILTER_POISSON_PCF,
+        FILTER_VSM,
+
+        NUM_FILTERS
+    };
+    enum {
+        TEXTURE_UNIT     = 2,   // units 0 & 1 are used by entity textures
+        MAX_POISSON_TAPS = 32,
+
+        NUM_LEVELS       = 3,   // 512, 1024, 2048
+        MIN_SIZE         = 512,
+    };
+private:
+    typedef boost::shared_ptr<FrameBuffer> FrameBufferPtr;
+
+    struct Level
+    {
+        int            m_Size;
+        bool           m_Valid;         // content matches light & filter
+        FrameBufferPtr m_DepthMap;
+        FrameBufferPtr m_Moments[3];
+    };
+    Level          m_Levels[ NUM_LEVELS ];
+    int            m_NumLevels;         // levels the hardware supports
+    int            m_Level;             // requested
+    int            m_ActiveLevel;       // used by the current frame
+
+    Filter         m_Filter;
+    int            m_NumTaps;
+    float          m_FilterRadius;      // Poisson radius in texels
+    float          m_Darkness;          // alpha of a fully shadowed fragment
+    float          m_Bias;
+
+    // active level
+    int            m_Size;
+    FrameBufferPtr m_DepthMap;          // depth texture, compare mode on
+    FrameBufferPtr m_Moments[3];        // VSM raw moments, blur temp, blurred moments
+    int            m_Dirty[4];          // x, y, w, h in texels of the last BeginCasters()
+
+    ProgramPtr     m_TestProgram;       // rebuilt when filter or tap count change
+    bool           m_TestProgramDirty;
+    ProgramPtr     m_MomentsProgram;
+    ProgramPtr     m_BlurProgram;
+
+    Matrix         m_LightView;
+    Matrix         m_LightProjection;
+
+    int            m_Viewport[4];       // saved in Begin*()
+public:
+    ShadowMap( int level = 1 );
+
+    ~ShadowMap();
+
+    /*!
+     * numTaps is only used by FILTER_POISSON_PCF (1..MAX_POISSON_TAPS)
+     */
+    void SetFilter( Filter filter, int numTaps = 16 );
+
+    Filter GetFilter() const { return m_Filter; }
+
+    int GetNumTaps() const { return m_NumTaps; }
+
+    void SetDarkness( float darkness ) { m_Darkness = darkness; }
+
+    int GetSize() const { return m_Size; }
+
+    /*!
+     * Resolution level 0 (MIN_SIZE) .. NUM_LEVELS-1, each doubles the size.
+     * Takes effect with the next BeginCasters().
+     */
+    void SetLevel( int level );
+
+    int GetLevel() const { return m_Level; }
+
+    int GetNumLevels() const { return m_NumLevels; }
+
+    /*!
+     * Invalidates the map if the matrices changed
+     */
+    void SetLight( const Matrix& view, const Matrix& projection );
+
+    const Matrix& GetLightView() const { return m_LightView; }
+
+    const Matrix& GetLightProjection() const { return m_LightProjection; }
+
+    /*!
+     * False if the content of the requested level can't be updated
+     * incrementally - the next BeginCasters() must cover the whole map.
+     */
+    bool IsValid() const { return m_Levels[ m_Level ].m_Valid; }
+
+    void Invalidate();
+
+    /*!
+     * Bind the render target, load the light matrices and clear the dirty
+     * region (light space NDC). Render casters after this - drawing is
+     * scissored to the region. Invalid maps are redrawn as a whole.
+     */
+    void BeginCasters( const ScreenRect& dirty ) throw(std::exception);
+
+    void EndCasters();
+
+    /*!
+     * VSM only: blur the moments of the dirty region. No-op for the PCF filters.
+     */
+    void Blur() throw(std::exception);
+
+    /*!
+     * Bind the test program. cameraView is the view matrix the scene is
+     * rendered with (modelview without the entity transforms).
+     */
+    void BeginTest( const Matrix& cameraView ) throw(std::exception);
+
+    void EndTest();
+
+    /*!
+     * Texture to show the map with the fixed function pipeline. Depth
+     * compare is switched off until EndPreview().
+     */
+    TexturePtr BeginPreview();
+
+    void EndPreview();
+
+    static const char* GetFilterName( Filter filter );
+
+private:
+    void Allocate() throw(std::exception);
+
+    void AllocateLevel( Level& level ) throw(std::exception);
+
+    void BuildTestProgram() throw(std::exception);
+
+    void DrawFullScreenQuad();
+
+    void SetScissor( int border );
+};
+
+typedef boost::shared_ptr<ShadowMap> ShadowMapPtr;
+
+#endif /* SHADOWMAP_H_ */
@@ -0,0 +1,40 @@
+/*
+ * sincostable.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef SINCOSTABLE_H_
+#define SINCOSTABLE_H_
+
+#include <vector>
+#include <cmath>
+
+/*!
+ * sin/cos of count evenly spaced angles, i*step. Mesh generators look up the
+ * angle of a column or ring instead of calling the trig functions per vertex.
+ */
+class SinCosTable
+{
+    std::vector<float> m_Sin;
+    std::vector<float> m_Cos;
+public:
+    SinCosTable( int count, float step )
+        : m_Sin( count )
+        , m_Cos( count )
+    {
+        for ( int i = 0; i < count; ++i ) {
+            m_Sin[i] = std::sin( i*step );
+            m_Cos[i] = std::cos( i*step );
+        }
+    }
+
+    float Sin( int i ) const { return m_Sin[i]; }
+
+    float Cos( int i ) const { return m_Cos[i]; }
+
+    int GetSize() const { return m_Sin.size(); }
+};
+
+#endif /* SINCOSTABLE_H_ */
@@ -0,0 +1,90 @@
+/*
+ * skylinepacker.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "skylinepacker.h"
+
+#include <algorithm>
+#include <climits>
+
+SkylinePacker::SkylinePacker( int width /* = 0 */, int height /* = 0 */ )
+{
+    Reset( width, height );
+}
+
+void SkylinePacker::Reset( int width, int height )
+{
+    m_Width  = width;
+    m_Height = height;
+    m_Used   = 0;
+    m_Skyline.clear();
+    Segment ground = { 0, 0, width };
+    m_Skyline.push_back( ground );
+}
+
+bool SkylinePacker::Fit( std::size_t index, int width, int height, int& y ) const
+{
+    if ( m_Skyline[index].m_X + width > m_Width ) return false;
+
+    // highest segment under the rectangle - the skyline covers the whole width, so it ends in range
+    y = 0;
+    for ( int left = width; left > 0; left -= m_Skyline[index++].m_Width ) {
+        y = std::max( y, m_Skyline[index].m_Y );
+        if ( y + height > m_Height ) return false;
+    }
+    return true;
+}
+
+bool SkylinePacker::Insert( int width, int height, int& x, int& y )
+{
+    if ( width <= 0 || height <= 0 ) return false;
+
+    // lowest top, then the narrowest segment - leaves the wide ones for wide rectangles
+    std::size_t best = m_Skyline.size();
+    int bestTop( INT_MAX ), bestWidth( INT_MAX );
+    for ( std::size_t i = 0; i < m_Skyline.size(); ++i ) {
+        int top;
+        if ( !Fit( i, width, height, top ) ) continue;
+        top += height;
+        if ( top < bestTop || ( top == bestTop && m_Skyline[i].m_Width < bestWidth ) ) {
+            best      = i;
+            bestTop   = top;
+            bestWidth = m_Skyline[i].m_Width;
+        }
+    }
+    if ( best == m_Skyline.size() ) return false;
+
+    x = m_Skyline[best].m_X;
+    y = bestTop - height;
+    Segment segment = { x, bestTop, width };
+    m_Skyline.insert( m_Skyline.begin() + best, segment );
+
+    // cut away what is under the new segment now
+    for ( std::size_t i = best + 1; i < m_Skyline.size(); ) {
+        const int overlap = m_Skyline[i-1].m_X + m_Skyline[i-1].m_Width - m_Skyline[i].m_X;
+        if ( overlap <= 0 ) break;
+        m_Skyline[i].m_X     += overlap;
+        m_Skyline[i].m_Width -= overlap;
+        if ( m_Skyline[i].m_Width > 0 ) break;
+        m_Skyline.erase( m_Skyline.begin() + i );
+    }
+    // neighbours at the same height are one segment
+    for ( std::size_t i = 0; i + 1 < m_Skyline.size(); ) {
+        if ( m_Skyline[i].m_Y == m_Skyline[i+1].m_Y ) {
+            m_Skyline[i].m_Width += m_Skyline[i+1].m_Width;
+            m_Skyline.erase( m_Skyline.begin() + i + 1 );
+        } else {
+            ++i;
+        }
+    }
+    m_Used += long( width ) * height;
+    return true;
+}
+
+float SkylinePacker::GetOccupancy() const
+{
+    return m_Width > 0 && m_Height > 0 ? float( m_Used ) / ( float( m_Width ) * m_Height ) : 0.0f;
+}
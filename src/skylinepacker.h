@@ -0,0 +1,52 @@
+/*
+ * skylinepacker.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef SKYLINEPACKER_H_
+#define SKYLINEPACKER_H_
+
+#include <vector>
+
+/*!
+ * Places rectangles in a fixed size area, e.g. images in a texture atlas.
+ * Keeps the skyline - the top edge of everything placed so far - and puts
+ * each rectangle where its top ends up lowest (bottom left rule). Good
+ * enough for a few hundred rectangles inserted largest first. No GL.
+ */
+class SkylinePacker
+{
+    struct Segment
+    {
+        int m_X, m_Y, m_Width;
+    };
+
+    int                  m_Width, m_Height;
+    std::vector<Segment> m_Skyline;     // left to right, covers the whole width
+    long                 m_Used;        // area of placed rectangles
+public:
+    SkylinePacker( int width = 0, int height = 0 );
+
+    // forget all rectangles
+    void Reset( int width, int height );
+
+    /*!
+     * Place a width x height rectangle. Returns false if it doesn't fit
+     */
+    bool Insert( int width, int height, int& x, int& y );
+
+    int GetWidth() const { return m_Width; }
+
+    int GetHeight() const { return m_Height; }
+
+    // placed area / total area
+    float GetOccupancy() const;
+
+private:
+    // y for a rectangle with its left edge on segment index, false if it doesn't fit
+    bool Fit( std::size_t index, int width, int height, int& y ) const;
+};
+
+#endif /* SKYLINEPACKER_H_ */
@@ -1,14 +1,26 @@
 #include "sphere.h"
+#include "renderer.h"
+#include "meshoptimizer.h"
+#include "sincostable.h"
 
 #include <GL/glew.h>
 
 #include <cmath>
+#include <algorithm>
 
 #include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
 
 const int _columns = 32;
 const int _rows    = 12;
 
+// each level halves the tessellation. Minimum projected diameter in pixels
+const int   _numLods = 3;
+const float _lodMinSize[ _numLods ] = { 160.0f, 48.0f, 0.0f };
+
+// levels with fewer vertices are generated on the calling thread
+const int   _parallelMinVertices = 16384;
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
@@ -18,17 +30,13 @@ const int _rows    = 12;
 #endif
 
 Sphere::Sphere( float radius /* = 1.0f */ )
-    : m_Buffers( { -1 } )
-    , m_Stride(1) // needed if/when we pack color + vertex into one array
-    , m_Radius(radius)
+    : m_Radius(radius)
     , m_Color( { 0.75, 0.75, 0.75 } )
 {
 }
 
 Sphere::~Sphere()
 {
-    // shouldn't be done in d'tor...might be weakly linked to e.g. event handler...but vbo must be released from render thread
-    glDeleteBuffers(MAX_BUFFERS, (GLuint*)m_Buffers);
 }
 
 void Sphere::SetColor( const Vector& color )
@@ -36,112 +44,142 @@ void Sphere::SetColor( const Vector& color )
     m_Color = color;
 }
 
-void Sphere::MakeSphere( float columns, float rows )
+// one level of detail, shared by the row kernels
+struct SphereLod
 {
-    const float RAD180 = M_PI; // PI in RAD
-    const float RAD360 = M_PI*2; // 2*PI in RAD
-
-    ++rows;
-    int lastColumn = columns - 1;
-    int lastRow = rows - 1;
-
-    // Add two extra vertices at center bottom and top
-    m_VertexBuffer.resize( columns*rows*m_Stride );
-    m_NormalBuffer.resize( columns*rows*m_Stride );
-    m_ColorBuffer.resize( columns*rows*m_Stride );
+    int            m_Columns;
+    int            m_Rings;        // rows + 1 - the last one wraps to the first
+    float          m_Radius;
+    Vector         m_Color;
+    SinCosTable    m_Phi;          // per column
+    SinCosTable    m_Theta;        // per ring
+    Vector*        m_Vertices;     // planar streams
+    Vector*        m_Normals;
+    Vector*        m_Colors;
+    unsigned int*  m_Indices;      // 6 per vertex
+
+    SphereLod( int columns, int rings, float radius, const Vector& color )
+        : m_Columns( columns )
+        , m_Rings( rings )
+        , m_Radius( radius )
+        , m_Color( color )
+        , m_Phi( columns, float(M_PI*2)/columns )
+        , m_Theta( rings, float(M_PI)/(rings-1) )
+    {
+    }
+};
 
-    // generate index array; we got rows * columns * 2 tris
-    m_IndexArray.resize( columns * rows * 3 * 2 ); // 3 vertices per tri, 2 tri per quad = 6 entries per iteration
+// rings [begin, end) - vertices, normals, colors and the two triangles of each quad. Called from workers
+static void MakeSphereRings( const SphereLod& lod, int begin, int end )
+{
+    const int columns    = lod.m_Columns;
+    const int lastColumn = columns - 1;
+    for ( int y = begin; y < end; ++y ) {
+        const float sinTheta = lod.m_Theta.Sin( y );
+        const float cosTheta = lod.m_Theta.Cos( y );
+        Vector* vertex = lod.m_Vertices + y*columns;
+        Vector* normal = lod.m_Normals  + y*columns;
+        Vector* color  = lod.m_Colors   + y*columns;
+        for ( int x = 0; x < columns; ++x ) {
+            // unit direction from the center is the normal
+            const float sinPhi = lod.m_Phi.Sin( x );
+            const Vector n( sinPhi * cosTheta, sinPhi * sinTheta, lod.m_Phi.Cos( x ) );
+            normal[x] = n;
+            vertex[x] = Vector( n[Vector::X] * lod.m_Radius, n[Vector::Y] * lod.m_Radius, n[Vector::Z] * lod.m_Radius );
+            color[x]  = lod.m_Color;
+        }
 
-    auto vit = m_VertexBuffer.begin();
-    auto nit = m_NormalBuffer.begin();
-    auto cit = m_ColorBuffer.begin();
-    int looper(0);
+        //        0  1  2...n
+        //        +--+--+...
+        //        |\ |\ |
+        //        | \| \|
+        //        +--+--+
+        // n*y +  0' 1' 2'...(n+1)*y
+        // the last column is closed with the first one, the last ring with the first
+        const int row     = y*columns;
+        const int nextRow = ( y + 1 == lod.m_Rings ? 0 : y + 1 )*columns;
+        unsigned int* index = lod.m_Indices + row*6;
+        for ( int x = 0; x < columns; ++x ) {
+            const int x0 = x == lastColumn ? 0 : x;
+            const int x1 = x + 1 >= lastColumn ? x + 1 - lastColumn : x + 1;
+            // top tri
+            *index++ = x0 + row;        // 0x0
+            *index++ = x1 + row;        // 1x0
+            *index++ = x0 + nextRow;    // 1x1 - bottom row
+            // bottom tri
+            *index++ = x1 + row;        // 0x0
+            *index++ = x1 + nextRow;    // 0x1 - bottom row
+            *index++ = x0 + nextRow;    // 1x1 - bottom row
+        }
+    }
+}
 
+void Sphere::MakeSphereLod( int columns, int rows, float radius, const Vector& sphereColor, JobQueuePtr jobQueue,
+                            std::vector<Vector>& vertexBuffer, std::vector<unsigned int>& indexArray )
+{
     // from http://www.math.montana.edu/frankw/ccp/multiworld/multipleIVP/spherical/learn.htm
 
     // need one extra ring to close the gap (overlaps 0)
-    float segmentAngle = RAD180/lastRow;
-    float segmentSize  = RAD360/columns;
-    for( float y = 0; y < rows; ++y ){  //0-PI
-        std::vector< Vector > segments;
-        float theta = y * segmentAngle;
-        for( float x = 0; x < columns; ++x ) { //0-2PI
-            float phi = x * segmentSize;
-            // vertex
-            auto& vertex = *vit; ++vit;
-            vertex[ Vector::X ] = m_Radius * std::sin(phi) * std::cos(theta);
-            vertex[ Vector::Y ] = m_Radius * std::sin(phi) * std::sin(theta);
-            vertex[ Vector::Z ] = m_Radius * std::cos(phi);
-
-            // Add normal vectors - at vertex direction from center (-{0,0,0})
-            auto& normal = *nit; ++nit;
-            normal = vertex.Normalized();
-
-            // vertex color
-            auto& color = *cit; ++cit;
-            color = m_Color;
-
-            // vertices don't need to be set just yet. We just index them here
-
-            // this needs work: we use a row * col vertex and texture array
-            // to extract triangles, the index array needs to be calculated appropriately
-            //        0  1  2...n
-            //        +--+--+...
-            //        |\ |\ |
-            //        | \| \|
-            //        +--+--+
-            // n*y +  0' 1' 2'...(n+1)*y
-
-            // e.g. t[0] = { 0,1,1'} { 1',0',1 } ...
-            // top tri
-            int
-            idx = int((int(x + 0) % lastColumn) + columns *(int(y+0)%(int)rows)); m_IndexArray[ looper++ ] = idx;  // 0x0
-            idx = int((int(x + 1) % lastColumn) + columns *(int(y+0)%(int)rows)); m_IndexArray[ looper++ ] = idx;  // 1x0
-            idx = int((int(x + 0) % lastColumn) + columns *(int(y+1)%(int)rows)); m_IndexArray[ looper++ ] = idx;  // 1x1 - bottom row
+    SphereLod lod( columns, rows + 1, radius, sphereColor );
+    const int numVertices = columns*lod.m_Rings;
+
+    // planar: all vertices, then all normals, then all colors
+    vertexBuffer.resize( numVertices*3 );
+    // 3 vertices per tri, 2 tri per quad = 6 entries per vertex
+    indexArray.resize( numVertices*6 );
+    lod.m_Vertices = &vertexBuffer[0];
+    lod.m_Normals  = lod.m_Vertices + numVertices;
+    lod.m_Colors   = lod.m_Normals + numVertices;
+    lod.m_Indices  = &indexArray[0];
+
+    if ( jobQueue && numVertices >= _parallelMinVertices ) {
+        jobQueue->ParallelFor( 0, lod.m_Rings, boost::bind( &MakeSphereRings, boost::cref( lod ), _1, _2 ),
+                               std::max( _parallelMinVertices / 4 / columns, 1 ) );
+    } else {
+        MakeSphereRings( lod, 0, lod.m_Rings );
+    }
+}
 
-            // bottom tri
-            idx = int((int(x + 1) % lastColumn) + columns *(int(y+0)%(int)rows)); m_IndexArray[ looper++ ] = idx; // 0x0
-            idx = int((int(x + 1) % lastColumn) + columns *(int(y+1)%(int)rows)); m_IndexArray[ looper++ ] = idx; // 0x1 - bottom row
-            idx = int((int(x + 0) % lastColumn) + columns *(int(y+1)%(int)rows)); m_IndexArray[ looper++ ] = idx; // 1x1 - bottom row
-        }
+void Sphere::MakeSphere( JobQueuePtr jobQueue, int columns, int rows, float radius, const Vector& sphereColor, MeshData& data )
+{
+    // all levels go into one vertex buffer. Generated planar, uploaded interleaved and compact
+    std::vector<Vector>* planes = data.m_Streams;
+    std::vector<int> lodIndices;
+    float misses[2] = { 0, 0 };
+    for ( int lod = 0; lod < _numLods; ++lod ) {
+        std::vector<Vector> vertexBuffer;
+        std::vector<unsigned int> indexArray;
+        MakeSphereLod( std::max( columns >> lod, 8 ), std::max( rows >> lod, 3 ), radius, sphereColor, jobQueue, vertexBuffer, indexArray );
+        lodIndices.push_back( data.m_Indices.size() );
+        MeshOptimizer::AppendLod( vertexBuffer, indexArray, 3, planes, data.m_Indices, misses );
+    }
+    lodIndices.push_back( data.m_Indices.size() );
+    for ( int lod = 0; lod < _numLods; ++lod ) {
+        Mesh::Lod range = { lodIndices[lod], lodIndices[lod+1] - lodIndices[lod], _lodMinSize[lod] };
+        data.m_Lods.push_back( range );
     }
+    const int numTriangles = data.m_Indices.size() / 3;
+    data.m_ACMR[0] = misses[0] / numTriangles;
+    data.m_ACMR[1] = misses[1] / numTriangles;
+    data.m_Bounds  = BoundingBox( Vector( -radius, -radius, -radius ), Vector( radius, radius, radius ) );
 }
 
-bool Sphere::DoInitialize( Renderer* renderer ) throw(std::exception)
+std::string Sphere::GetMeshKey( float radius, const Vector& color )
 {
-    bool hasVBO  = glewGetExtension("GL_ARB_vertex_buffer_object");
-    ASSERT( hasVBO, "VBOs not supported!" );
-
-    // we might just want to create this in DoInitialize - and throw away the data we don't need locally
-    MakeSphere( _columns, _rows );
-
-    glGenBuffers( MAX_BUFFERS, (GLuint*)m_Buffers);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[ VERTEX_BUFFER ]);
-    int bufSize = sizeof(Vector)*m_VertexBuffer.size()
-                + sizeof(Vector)*m_NormalBuffer.size()
-                + sizeof(Vector)*m_ColorBuffer.size();
-    glBufferData(GL_ARRAY_BUFFER, bufSize, 0, GL_STATIC_DRAW);
-    std::size_t offset(0);
-    // Vertex buffer
-    float *vertices = (float*)&m_VertexBuffer[0];
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(Vector)*m_VertexBuffer.size(), vertices);
-    // Normal buffer
-    offset += sizeof(Vector)*m_VertexBuffer.size();
-    float *normals = (float*)&m_NormalBuffer[0];
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(Vector)*m_NormalBuffer.size(), normals);
-    // Color buffer
-    offset += sizeof(Vector)*m_NormalBuffer.size();
-    float *colors = (float*)&m_ColorBuffer[0];
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(Vector)*m_ColorBuffer.size(), colors);
-
-    // Index Buffer
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[ INDEX_BUFFER ]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int)*m_IndexArray.size(), &m_IndexArray[0], GL_STATIC_DRAW);
-
-    // TODO: We can delete local storage here
+    return MeshCache::MakeKey( "sphere", "%d %d %.9g %.9g %.9g %.9g %.9g", _columns, _rows, radius,
+                               color[Vector::X], color[Vector::Y], color[Vector::Z], color[Vector::W] );
+}
+
+MeshCache::Builder Sphere::GetMeshBuilder( JobQueuePtr jobQueue, float radius, const Vector& color )
+{
+    return boost::bind( &Sphere::MakeSphere, jobQueue, _columns, _rows, radius, color, _1 );
+}
 
+bool Sphere::DoInitialize( Renderer* renderer ) throw(std::exception)
+{
+    // identical spheres share one mesh - only the first one generates (or loads) and uploads it
+    m_Mesh = renderer->GetMeshCache()->Get( GetMeshKey( m_Radius, m_Color ), GetMeshBuilder( renderer->GetJobQueue(), m_Radius, m_Color ) );
+    SetBounds( m_Mesh->GetBounds() );
     return true;
 }
 
@@ -151,48 +189,11 @@ void Sphere::DoUpdate( float ticks ) throw(std::exception)
 
 void Sphere::DoRender( int pass ) throw(std::exception)
 {
-    int vertexArrayEnabled;
-    glGetIntegerv( GL_VERTEX_ARRAY, &vertexArrayEnabled );
-    if (!vertexArrayEnabled) {
-        glEnableClientState(GL_VERTEX_ARRAY);
-    }
-    int normalArrayEnabled;
-    glGetIntegerv( GL_NORMAL_ARRAY, &normalArrayEnabled );
-    if ( !normalArrayEnabled )  {
-        glEnableClientState(GL_NORMAL_ARRAY);
-    }
-    int colorArrayEnabled;
-    glGetIntegerv( GL_COLOR_ARRAY, &colorArrayEnabled );
-    if ( !colorArrayEnabled) {
-        glEnableClientState(GL_COLOR_ARRAY);
-    }
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[ VERTEX_BUFFER ]);
-    // before draw, specify vertex and index arrays with their offsets
-    std::size_t offset(0);
-    glVertexPointer(4, GL_FLOAT, m_Stride*sizeof(Vector), (void*)offset);
-
-    offset += sizeof(Vector)*m_VertexBuffer.size();
-    glNormalPointer(GL_FLOAT, m_Stride*sizeof(Vector), (void*)offset);
-
-    offset += sizeof(Vector)*m_NormalBuffer.size();
-    glColorPointer(4, GL_FLOAT, m_Stride*sizeof(Vector), (void*)offset);
-
-    // use index array
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[ INDEX_BUFFER ]);
-    glDrawElements( GL_TRIANGLES, m_IndexArray.size(), GL_UNSIGNED_INT, (void*)0 );
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    if (!vertexArrayEnabled)  {
-        glDisableClientState(GL_VERTEX_ARRAY);  // disable vertex arrays
-    }
-    if ( !normalArrayEnabled )  {
-        glDisableClientState(GL_NORMAL_ARRAY);
-    }
-    if ( !colorArrayEnabled) {
-        glDisableClientState(GL_COLOR_ARRAY);
+    int lod = m_Lod.Select( *m_Mesh, GetBounds(), pass );
+    if ( m_Lod.CasterLevelChanged() ) {
+        GeometryChanged();
     }
+    unsigned int enabled = m_Mesh->Enable( Mesh::POSITION_F | Mesh::NORMAL_F | Mesh::COLOR_F );
+    m_Mesh->Draw( lod );
+    m_Mesh->Disable( enabled );
 }
-
@@ -4,6 +4,10 @@
 #include "err.h"
 #include "entity.h"
 #include "vector.h"
+#include "mesh.h"
+#include "meshcache.h"
+#include "lodselector.h"
+#include "jobqueue.h"
 
 #include <vector>
 
@@ -14,25 +18,10 @@ public:
         NORMAL,
         SPECULAR
     };
-    enum {
-        VERTEX_BUFFER = 0,
-        INDEX_BUFFER,
-
-        MAX_BUFFERS
-    };
 
 private:
-    int m_Buffers[ MAX_BUFFERS ];
-
-    typedef std::vector<Vector> VertexArray;
-    typedef std::vector<Vector> ColorArray;
-    typedef std::vector<unsigned int> IndexArray;
-
-    int         m_Stride;
-    VertexArray m_VertexBuffer; // linear buffer
-    VertexArray m_NormalBuffer; // linear buffer
-    ColorArray  m_ColorBuffer;  // color buffer overlays Vertex Array
-    IndexArray  m_IndexArray;   // standard array to map vertices to tris
+    MeshPtr     m_Mesh;         // shared by all spheres with the same radius & color
+    LodSelector m_Lod;
 
     float       m_Radius;
     Vector      m_Color;
@@ -41,10 +30,21 @@ public:
 
     virtual ~Sphere();
 
+    virtual MeshPtr GetMesh() const { return m_Mesh; }
+
     void SetColor( const Vector& color );
 
+    // MeshCache key and builder of a sphere - shared with the meshcook tool
+    static std::string GetMeshKey( float radius, const Vector& color );
+
+    static MeshCache::Builder GetMeshBuilder( JobQueuePtr jobQueue, float radius, const Vector& color );
+
 private:
-    void MakeSphere( float meridians, float parallels );
+    // all levels of detail, starting with meridians x parallels. Large levels are split into rings on the job queue
+    static void MakeSphere( JobQueuePtr jobQueue, int meridians, int parallels, float radius, const Vector& color, MeshData& data );
+
+    static void MakeSphereLod( int meridians, int parallels, float radius, const Vector& color, JobQueuePtr jobQueue,
+                               std::vector<Vector>& vertexBuffer, std::vector<unsigned int>& indexArray );
 
 protected:
     virtual bool DoInitialize( Renderer* renderer ) throw(std::exception);
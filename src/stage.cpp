@@ -7,12 +7,17 @@
 
 
 #include "stage.h"
+#include "renderer.h"
+#include "bufferbinding.h"
+
+#include <iostream>
+
+static const int sShadowMapSize = 1024;
 
 class DrawRectangle : public Entity
 {
     TexturePtr          m_Texture;
-    std::vector<Vector> m_VertexArray; // rectangle vertex array
-    bool                m_RefreshVertexArray; // don't really need to store this
+    StreamBufferPtr     m_StreamBuffer; // rectangle vertex array is written straight into it
 
     class RenderState : public ::RenderState
     {
@@ -30,9 +35,7 @@ class DrawRectangle : public Entity
 
 public:
     DrawRectangle()
-        : m_VertexArray( 2*6 )
-        , m_RefreshVertexArray(false)
-        , m_RenderStateProxy( new RenderState )
+        : m_RenderStateProxy( new RenderState )
     {
         m_RenderState = RenderStatePtr( m_RenderStateProxy );
     }
@@ -52,24 +55,22 @@ public:
         m_RenderStateProxy->m_X = (float)x;
         m_RenderStateProxy->m_Y = (float)y;
         m_RenderStateProxy->m_Z = (float)z;
-        m_RefreshVertexArray = true;
     }
 
     void SetSize( int w, int h )
     {
         m_RenderStateProxy->m_Width  = (float)w;
         m_RenderStateProxy->m_Height = (float)h;
-        m_RefreshVertexArray = true;
     }
 
 protected:
     bool DoInitialize( Renderer* renderer ) throw( std::exception )
     {
-        UpdateVertexArray();
+        m_StreamBuffer = renderer->GetStreamBuffer();
         return true;
     }
 
-    void UpdateVertexArray()
+    void UpdateVertexArray( Vector* vertexArray )
     {
         float x0 = m_RenderStateProxy->m_X;
         float y0 = m_RenderStateProxy->m_Y;
@@ -78,24 +79,25 @@ protected:
         float x1 = m_RenderStateProxy->m_X + m_RenderStateProxy->m_Width;
         float y1 = m_RenderStateProxy->m_Y + m_RenderStateProxy->m_Height;
 
-        // pair of vertex & texture
-        m_VertexArray = { { x0, y0, z0 }, { 0,0,0 },
-                          { x1, y0, z0 }, { 0,1,0},
-                          { x1, y1, z0 }, { 0,1,1 },
-
-                          { x1, y1, z0 }, { 0,1,1 },
-                          { x0, y1, z0 }, { 0,1,0 },
-                          { x1, y0, z0 }, { 0,1,0},
-                        };
-        m_RefreshVertexArray = false;
-
+        // pair of vertex & texture - mapped memory, write only
+        const Vector vertices[ 2*6 ] = { { x0, y0, z0 }, { 0,0,0 },
+                                         { x1, y0, z0 }, { 0,1,0},
+                                         { x1, y1, z0 }, { 0,1,1 },
+
+                                         { x1, y1, z0 }, { 0,1,1 },
+                                         { x0, y1, z0 }, { 0,1,0 },
+                                         { x1, y0, z0 }, { 0,1,0},
+                                       };
+        for ( int i = 0; i < 2*6; ++i ) {
+            vertexArray[i] = vertices[i];
+        }
     }
 
     void DoRender( int pass ) throw( std::exception )
     {
-        if ( m_RefreshVertexArray ) {
-            UpdateVertexArray();
-        }
+        StreamBuffer::Region region = m_StreamBuffer->Allocate( sizeof(Vector)*2*6 );
+        UpdateVertexArray( (Vector*)region.m_Data );
+        m_StreamBuffer->Commit( region );
 
         int stride = 2; // interleaved vec/tex
 
@@ -106,7 +108,8 @@ protected:
         }
 
         // no need for textures in shadow pass - for now. -> transparent shadows will need it
-        glVertexPointer(4, GL_FLOAT, stride*sizeof(Vector), &m_VertexArray[0] );
+        BufferBinding::Bind( GL_ARRAY_BUFFER, m_StreamBuffer->GetBuffer() );
+        glVertexPointer(4, GL_FLOAT, stride*sizeof(Vector), (void*)region.m_Offset );
         // Base texture. No special treatment. Just draw it
         if ( m_Texture ) {
             int texCoordArrayEnabled;
@@ -116,7 +119,7 @@ protected:
             }
 
             // interleave, 4 component vector, skip 2
-            glTexCoordPointer( 4, GL_FLOAT, stride*sizeof(Vector), (void*)&m_VertexArray[1] );
+            glTexCoordPointer( 4, GL_FLOAT, stride*sizeof(Vector), (void*)( region.m_Offset + sizeof(Vector) ) );
 
             m_Texture->Enable();
             glDrawArrays( GL_TRIANGLES, 0, 6 );
@@ -144,7 +147,13 @@ Stage::Stage( int width, int height, SDL_Joystick* joystick )
     , m_Camera( new Camera(joystick) )
     , m_ShadowProjection( new Viewport )
     , m_World( new World )
-    , m_ShadowMap( FrameBuffer::F_ENABLE_DEPTH_BUFFER_F | FrameBuffer::F_ENABLE_COLOR_BUFFER_F ) // depth buffer only!
+    , m_ShadowFilter( ShadowMap::FILTER_HARDWARE_PCF )
+    , m_ShadowTaps( 16 )
+    , m_RequestedFilter( m_ShadowFilter )
+    , m_RequestedTaps( m_ShadowTaps )
+    , m_FilterRequested(false)
+    , m_DumpRequested(false)
+    , m_ShadowBudget( 2.0f, ShadowMap::NUM_LEVELS, 1 )
 {
     // camera is attached to main stage
     m_MainStage->AddEntity( m_Camera );
@@ -156,7 +165,6 @@ Stage::Stage( int width, int height, SDL_Joystick* joystick )
     m_LightingStage->SetClearColor( Vector(0.0, 1.0, 0.0, 1.0 ) );
     m_LightingStage->SetClearFlags(0);
 
-    m_ShadowProjection->AddEntity( m_World );
     m_LightingStage->SetClearColor( Vector(1.0, 1.0, 0.0, 1.0 ) );
     m_LightingStage->SetClearFlags(0);
 
@@ -191,20 +199,19 @@ bool Stage::DoInitialize( Renderer* renderer ) throw( std::exception )
 {
     glEnable(GL_LIGHTING);
 
+    m_Profiler  = renderer->GetProfiler();
+    m_MeshCache = renderer->GetMeshCache();
+    m_GeometryArena = renderer->GetGeometryArena();
+
     // Default viewport (used for camera)
     m_MainStage->Reset( 45.0f, 1.0f, 100.0f );
-    // create offscreen shadowmap
-    int width(1024);
-    int height(1024);
-    bool r = m_ShadowMap.Allocate( width, height );
-    ASSERT( r, "Cannot allocate shadow map!");
+    // shadow maps are created on demand - one per light
 
-    // "virtual viewport"
-    m_ShadowProjection->SetSize( width, height );
-    m_ShadowProjection->Reset( 45.0f, 1.0f, 8.0f );
+    // "virtual viewport" - only provides the light frustum
+    m_ShadowProjection->SetSize( sShadowMapSize, sShadowMapSize );
+    m_ShadowProjection->Reset( 45.0f, 1.0f, 20.0f );
 
     m_ShadowRect = DrawRectanglePtr( new DrawRectangle );
-    m_ShadowRect->SetTexture( m_ShadowMap.GetTexture() );
     m_ShadowRect->SetSize( m_ShadowMapStage->GetWidth(), m_ShadowMapStage->GetHeight() );
     m_ShadowMapStage->AddEntity( m_ShadowRect );
 
@@ -213,6 +220,8 @@ bool Stage::DoInitialize( Renderer* renderer ) throw( std::exception )
 
 void Stage::Render( int pass ) throw(std::exception)
 {
+    ApplyRequests();
+
     SetupRender( pass );
 
     int lighting(false);
@@ -223,9 +232,9 @@ void Stage::Render( int pass ) throw(std::exception)
 
     // use a lookup table so we can actually reorder these if needed, or add new, or w/e
     int renderPasses[] = {
-//            PASS_SHADOW_MAP, // grey scale pass without lighting
+            PASS_SHADOW_MAP, // grey scale pass without lighting
             PASS_LIGHTING,  // default pass with lighting
-//            PASS_SHADOW_TEST
+            PASS_SHADOW_TEST
     };
     int renderPass(0);
     int numPasses( sizeof(renderPasses)/sizeof(int));
@@ -243,57 +252,66 @@ void Stage::Render( int pass ) throw(std::exception)
                 // do not use lighting for shadow map
                 glDisable(GL_LIGHTING);
 
-                // enable shadow texture - render into here
-                m_ShadowMap.Enable();
-
-                // set viewport to texture size
-                glViewport( 0, 0, (GLsizei)m_ShadowMap.GetWidth(), (GLsizei)m_ShadowMap.GetHeight());
-
-                // set perspective viewing frustum - copy from main stage
-                glMatrixMode(GL_PROJECTION);
-                // shouldn't I re-calc the frustum???
-                glLoadMatrixf( m_MainStage->GetRenderState()->GetProjectionMatrix() );
-
-                // switch to modelview matrix in order to set scene
-                glMatrixMode(GL_MODELVIEW);
-                glPushMatrix();
+                while ( m_ShadowMaps.size() < lights.size() ) {
+                    m_ShadowMaps.push_back( ShadowMapPtr( new ShadowMap( m_ShadowBudget.GetLevel() ) ) );
+                    m_ShadowTrackers.push_back( ShadowDirtyTracker() );
+                }
 
-                // clear texture (depth only)
-                glClear(GL_DEPTH_BUFFER_BIT);
+                // receivers are what the main camera sees
+                m_World->SetShadowReceiverView( GetCameraView(), m_MainStage->GetProjectionMatrix() );
 
                 // TODO: Tune GL to remove all unnecessary renderings
                 //       - no back faces
                 //       - no textures
 
-                // re-render the tree from each light position. Depth only, additive into same texture
+                // re-render the tree from each light position. Depth only, one map per light.
+                // Maps are kept between frames, only regions with changed casters are redrawn
+                auto shadowMap = m_ShadowMaps.begin();
+                auto tracker   = m_ShadowTrackers.begin();
                 for ( const auto& light : lights ) {
+                    ShadowMapPtr map = *shadowMap; ++shadowMap;
+                    ShadowDirtyTracker& dirtyTracker = *tracker; ++tracker;
+                    map->SetFilter( m_ShadowFilter, m_ShadowTaps );
+                    map->SetLevel( m_ShadowBudget.GetLevel() );
+                    map->SetLight( GetLightView( light ), m_ShadowProjection->GetProjectionMatrix() );
+                    if ( !map->IsValid() ) {
+                        dirtyTracker.Invalidate();
+                    }
+
                     // disable light
                     unsigned int flags = light->ClearFlags( ~0 );
-                    // move viewport to light position
-                    m_ShadowProjection->GetRenderState()->SetMatrix( light->GetRenderState()->GetMatrix() );
-                    // render from light
-                    m_ShadowProjection->Render( passMask );
+                    bool update(false);
+                    {
+                        // also measured if nothing is drawn - the budget should see the savings
+                        Profiler::Scope scope( m_Profiler.get(), GetShadowSection( "casters" ) );
+                        ScreenRect dirty;
+                        update = m_World->GetShadowDirtyRect( map->GetLightView(), map->GetLightProjection(), dirtyTracker, dirty );
+                        if ( update ) {
+                            map->BeginCasters( dirty );
+                            m_World->SetShadowRegion( dirty );
+                            m_World->Render( passMask );
+                            m_World->SetShadowRegion( ShadowDirtyTracker::GetFullRect() );
+                            map->EndCasters();
+                        }
+                    }
+                    if ( m_ShadowFilter == ShadowMap::FILTER_VSM ) {
+                        Profiler::Scope scope( m_Profiler.get(), GetShadowSection( "blur" ) );
+                        if ( update ) {
+                            map->Blur();
+                        }
+                    }
                     // re-enable it
                     light->SetFlags( flags );
-                    // 1) project light
-//                    glLoadMatrixf( (float*)light->GetRenderState()->GetMatrix() );
-                    // 2) render world from light position into offscreen buffer - need to set the frustum for the world
-                    //    Only depth component! no texturing, etc
-//                    m_World->Render( passMask ); // passMask );
                 }
-                glPopMatrix();
-                m_ShadowMap.Disable();
 
-                // render shadow map into 2D window - this only draws depth components...must overlay with some depth test grey scale or something (otherwise must copy depth component into grey texture)
-                // Keeps a texture instance - no need to update
+                // render shadow map of the first light into 2D window as grey scale
+                m_ShadowRect->SetTexture( m_ShadowMaps.front()->BeginPreview() );
                 m_ShadowMapStage->Render( PASS_LIGHTING_F );
+                m_ShadowMaps.front()->EndPreview();
 
                 // switch lighting back on
                 if ( lighting ) glEnable(GL_LIGHTING);
             }
-
-            // TODO: Render texture into shadow stage
-
             }break;
         case PASS_LIGHTING:
         default:
@@ -310,12 +328,33 @@ void Stage::Render( int pass ) throw(std::exception)
             if ( !lighting ) {
                 glEnable(GL_LIGHTING);
             }
-            // m_MainStage->Render( passMaskp );
+            {
+                const World::LightList& lights = m_World->GetLights();
+                Profiler::Scope scope( m_Profiler.get(), GetShadowSection( "test" ) );
+                // darken the lit scene once per light
+                Matrix cameraView = GetCameraView();
+                for ( std::size_t i = 0; i < lights.size() && i < m_ShadowMaps.size(); ++i ) {
+                    m_ShadowMaps[i]->BeginTest( cameraView );
+                    m_MainStage->Render( passMask );
+                    m_ShadowMaps[i]->EndTest();
+                }
+            }
             break;
         }
 
     } while (++renderPass < numPasses );
 
+    // pick the shadow map resolution for the next frame
+    if ( m_Profiler && !m_ShadowMaps.empty() ) {
+        double numLights = double( m_World->GetLights().size() );
+        // casters & blur sections are per light, the test covers all lights
+        double cost = ( m_Profiler->GetTime( GetShadowSection( "casters" ) ) +
+                        m_Profiler->GetTime( GetShadowSection( "blur" ) ) ) * numLights +
+                        m_Profiler->GetTime( GetShadowSection( "test" ) );
+        m_ShadowBudget.SetNumLevels( m_ShadowMaps.front()->GetNumLevels() );
+        m_ShadowBudget.Update( cost );
+    }
+
 
     // render overlay
     m_Overlay->Render( PASS_LIGHTING_F );
@@ -325,6 +364,77 @@ void Stage::Render( int pass ) throw(std::exception)
     CleanupRender( pass );
 }
 
+void Stage::SetShadowFilter( ShadowMap::Filter filter, int numTaps /* = 16 */ )
+{
+    boost::lock_guard< boost::mutex > lock( m_RequestMutex );
+    m_RequestedFilter = filter;
+    m_RequestedTaps   = std::max( 1, std::min( int(ShadowMap::MAX_POISSON_TAPS), numTaps ) );
+    m_FilterRequested = true;
+}
+
+void Stage::RequestShadowFilter( int filter, float tapScale )
+{
+    boost::lock_guard< boost::mutex > lock( m_RequestMutex );
+    if ( filter >= 0 ) {
+        m_RequestedFilter = ShadowMap::Filter( filter );
+    }
+    m_RequestedTaps   = std::max( 1, std::min( int(ShadowMap::MAX_POISSON_TAPS), int( m_RequestedTaps * tapScale ) ) );
+    m_FilterRequested = true;
+}
+
+void Stage::ApplyRequests()
+{
+    bool filter, dump;
+    {
+        boost::lock_guard< boost::mutex > lock( m_RequestMutex );
+        filter = m_FilterRequested;
+        dump   = m_DumpRequested;
+        m_FilterRequested = m_DumpRequested = false;
+        if ( filter ) {
+            m_ShadowFilter = m_RequestedFilter;
+            m_ShadowTaps   = m_RequestedTaps;
+        }
+    }
+    if ( filter ) {
+        // costs of the new filter are not known yet
+        m_ShadowBudget.Hold();
+    }
+    if ( dump ) {
+        // here, not in the event handler: the renderer updates (and defragments) the arena every frame
+        if ( m_Profiler ) m_Profiler->Dump( std::cout );
+        if ( m_MeshCache ) m_MeshCache->Dump( std::cout );
+        if ( m_GeometryArena ) m_GeometryArena->Dump( std::cout );
+    }
+}
+
+std::string Stage::GetShadowSection( const char* pass ) const
+{
+    return std::string( "shadow " ) + pass + " (" + ShadowMap::GetFilterName( m_ShadowFilter ) + ")";
+}
+
+Matrix Stage::GetCameraView() const
+{
+    // Mul() right multiplies in GL order: viewport * camera
+    return Matrix( m_Camera->GetRenderState()->GetMatrix() ).Mul( m_MainStage->GetRenderState()->GetMatrix() );
+}
+
+Matrix Stage::GetLightView( const LightPtr& light ) const
+{
+    // lights have no direction yet - they all look at the world origin
+    const Matrix& m = light->GetRenderState()->GetMatrix();
+    Vector eye( m[Matrix::POS_X], m[Matrix::POS_Y], m[Matrix::POS_Z] );
+    Vector center( 0, 0, 0 );
+    Vector up( 0, 1, 0 );
+    Vector dir = ( center - eye ).Normalize();
+    if ( std::fabs( dir[Vector::Y] ) > 0.99f ) {
+        // looking straight up or down
+        up = Vector( 0, 0, -1 );
+    }
+    Matrix view;
+    view.LookAt( eye, center, up );
+    return view;
+}
+
 void Stage::DoRender( int pass ) throw( std::exception )
 {
     // not really much to do here. This would be used if the stage would want to render something (like, hub, or info or w/e)
@@ -359,6 +469,25 @@ bool Stage::HandleEvent( const SDL_Event& event )
     case SDL_VIDEORESIZE:
         OnResize(event.resize.w, event.resize.h);
         break;
+    case SDL_KEYDOWN:
+        eventHandled = true;
+        switch (event.key.keysym.sym)
+        {
+        case SDLK_F1: RequestShadowFilter( ShadowMap::FILTER_HARDWARE_PCF, 1.0f ); break;
+        case SDLK_F2: RequestShadowFilter( ShadowMap::FILTER_POISSON_PCF, 1.0f ); break;
+        case SDLK_F3: RequestShadowFilter( ShadowMap::FILTER_VSM, 1.0f ); break;
+        case SDLK_F9: RequestShadowFilter( -1, 0.5f ); break;
+        case SDLK_F10:RequestShadowFilter( -1, 2.0f ); break;
+        case SDLK_F12: {
+            // profiler, mesh cache and arena are owned by the render thread - they dump with the next frame
+            boost::lock_guard< boost::mutex > lock( m_RequestMutex );
+            m_DumpRequested = true;
+            } break;
+        default:
+            eventHandled = false;
+            break;
+        }
+        break;
     default:
         break;
     }
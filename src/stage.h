@@ -16,6 +16,14 @@
 #include "camera.h"
 #include "world.h"
 #include "framebuffer.h"
+#include "shadowmap.h"
+#include "shadowbudget.h"
+#include "profiler.h"
+#include "meshcache.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
 
 class DrawRectangle;
 typedef boost::shared_ptr<DrawRectangle> DrawRectanglePtr;
@@ -39,17 +47,43 @@ private:
     ViewportPtr m_LightingStage;    // default lit side stage - no shadows
 
     CameraPtr   m_Camera;           // this is actually the projection matrix for the world from the camera position
-    ViewportPtr m_ShadowProjection; // this is a "virtual camera" from the light position
+    ViewportPtr m_ShadowProjection; // this is a "virtual camera" from the light position - only its frustum is used
     WorldPtr    m_World;            // this is the world we want to render
 
-    FrameBuffer m_ShadowMap;        // we render our "world" into a offscreen depth buffer
+    std::vector<ShadowMapPtr> m_ShadowMaps; // we render our "world" into a offscreen depth buffer - one per light
+    std::vector<ShadowDirtyTracker> m_ShadowTrackers; // what each shadow map holds
+    ShadowMap::Filter m_ShadowFilter;
+    int         m_ShadowTaps;       // Poisson PCF taps
+
+    // set by other threads (key events), applied by the render thread with the next frame
+    boost::mutex      m_RequestMutex;
+    ShadowMap::Filter m_RequestedFilter;
+    int         m_RequestedTaps;
+    bool        m_FilterRequested;
+    bool        m_DumpRequested;
+    ShadowBudget m_ShadowBudget;    // picks the shadow map resolution
 
     DrawRectanglePtr m_ShadowRect;  // rectangle to draw shadow map into
+
+    ProfilerPtr m_Profiler;
+    MeshCachePtr m_MeshCache;
+    GeometryArenaPtr m_GeometryArena;
 public:
     Stage( int w, int h, SDL_Joystick* joystick );
 
     virtual ~Stage();
 
+    /*!
+     * Shadow lookup filter for all lights. numTaps is only used by Poisson PCF.
+     * Any thread - takes effect with the next frame.
+     */
+    void SetShadowFilter( ShadowMap::Filter filter, int numTaps = 16 );
+
+    /*!
+     * Time for all shadow passes per frame. Shadow map resolution adapts to it.
+     */
+    void SetShadowBudget( float ms ) { m_ShadowBudget.SetBudget( ms ); }
+
     virtual bool Initialize( Renderer* renderer ) throw(std::exception);
 
     virtual void Render( int pass ) throw(std::exception);
@@ -62,6 +96,20 @@ protected:
     virtual void DoRender( int pass ) throw( std::exception );
 
     void OnResize( int w, int h );
+
+    // view matrix of the main stage: viewport matrix with the camera multiplied on
+    Matrix GetCameraView() const;
+
+    Matrix GetLightView( const LightPtr& light ) const;
+
+    // profiler section of a shadow pass for the current filter
+    std::string GetShadowSection( const char* pass ) const;
+
+    // filter < 0 keeps the requested filter, taps are scaled from the requested ones
+    void RequestShadowFilter( int filter, float tapScale );
+
+    // on the render thread, before anything reads the shadow settings
+    void ApplyRequests();
 };
 
 
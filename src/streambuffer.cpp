@@ -0,0 +1,171 @@
+/*
+ * streambuffer.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "streambuffer.h"
+#include "bufferbinding.h"
+
+StreamBuffer::StreamBuffer( std::size_t size /* = DEFAULT_SIZE */, GLenum target /* = GL_ARRAY_BUFFER */ )
+    : m_Buffer(0)
+    , m_Target( target )
+    , m_Mode( MODE_UNSYNCHRONIZED )
+    , m_HasSync(false)
+    , m_Size( size )
+    , m_Mapping( nullptr )
+    , m_Mapped(false)
+    , m_Head(0)
+    , m_Used(0)
+    , m_FrameBytes(0)
+    , m_Frame(0)
+    , m_Waits(0)
+{
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    // shouldn't be done in d'tor...but buffer and fences must be released from render thread
+    for ( auto& fence : m_Fences ) {
+        glDeleteSync( fence.m_Sync );
+    }
+    if ( m_Buffer ) {
+        if ( m_Mapping || ( m_Mapped && m_Mode == MODE_UNSYNCHRONIZED ) ) {
+            BufferBinding::Bind( m_Target, m_Buffer );
+            glUnmapBuffer( m_Target );
+            BufferBinding::Bind( m_Target, 0 );
+        }
+        BufferBinding::Forget( m_Buffer );
+        glDeleteBuffers( 1, &m_Buffer );
+    }
+}
+
+void StreamBuffer::Create() throw(std::exception)
+{
+    bool hasVBO  = glewGetExtension("GL_ARB_vertex_buffer_object");
+    ASSERT( hasVBO, "VBOs not supported!" );
+    bool hasMapRange = glewGetExtension("GL_ARB_map_buffer_range");
+    // fences only help if the GPU can be kept out of a mapped range
+    m_HasSync = hasMapRange && glewGetExtension("GL_ARB_sync");
+
+    glGenBuffers( 1, &m_Buffer );
+    BufferBinding::Bind( m_Target, m_Buffer );
+    if ( m_HasSync && glewGetExtension("GL_ARB_buffer_storage") ) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage( m_Target, m_Size, nullptr, flags );
+        m_Mapping = (char*)glMapBufferRange( m_Target, 0, m_Size, flags );
+        GL_ASSERT( m_Mapping, "Error mapping stream buffer!" );
+        m_Mode = MODE_PERSISTENT;
+    } else {
+        glBufferData( m_Target, m_Size, nullptr, GL_STREAM_DRAW );
+        m_Mode = hasMapRange ? MODE_UNSYNCHRONIZED : MODE_STAGED;
+        if ( m_Mode == MODE_STAGED ) {
+            m_Staging.resize( m_Size );
+        }
+    }
+    BufferBinding::Bind( m_Target, 0 );
+}
+
+void StreamBuffer::Reclaim( std::size_t size )
+{
+    // frames the GPU is done with - oldest first, no waiting
+    while ( !m_Fences.empty() &&
+            glClientWaitSync( m_Fences.front().m_Sync, 0, 0 ) != GL_TIMEOUT_EXPIRED ) {
+        glDeleteSync( m_Fences.front().m_Sync );
+        m_Used -= m_Fences.front().m_Bytes;
+        m_Fences.pop_front();
+    }
+    while ( m_Size - m_Used < size && !m_Fences.empty() ) {
+        // ring is too small for the data in flight
+        ++m_Waits;
+        glClientWaitSync( m_Fences.front().m_Sync, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(-1) );
+        glDeleteSync( m_Fences.front().m_Sync );
+        m_Used -= m_Fences.front().m_Bytes;
+        m_Fences.pop_front();
+    }
+}
+
+StreamBuffer::Region StreamBuffer::Allocate( std::size_t size ) throw(std::exception)
+{
+    if ( !m_Buffer ) {
+        Create();
+    }
+    ASSERT( !m_Mapped, "Stream buffer region not committed!" );
+    size = ( size + ALIGNMENT - 1 ) & ~std::size_t( ALIGNMENT - 1 );
+    ASSERT( size <= m_Size, "Stream buffer too small: %d bytes", int(size) );
+
+    bool orphan(false);
+    if ( m_Head + size > m_Size ) {
+        // no region crosses the end - the rest counts as used until this frame is done
+        if ( m_HasSync ) {
+            m_Used       += m_Size - m_Head;
+            m_FrameBytes += m_Size - m_Head;
+        } else {
+            // no fences: fresh storage, the old one goes once the GPU is done with it
+            orphan = true;
+            m_Used = m_FrameBytes = 0;
+        }
+        m_Head = 0;
+    }
+    if ( m_HasSync ) {
+        Reclaim( size );
+        ASSERT( m_Size - m_Used >= size, "Stream buffer overflow - more than %d bytes in one frame", int(m_Size) );
+    }
+
+    Region region = { nullptr, m_Head, size };
+    switch ( m_Mode ) {
+    case MODE_PERSISTENT:
+        region.m_Data = m_Mapping + m_Head;
+        break;
+    case MODE_UNSYNCHRONIZED:
+        BufferBinding::Bind( m_Target, m_Buffer );
+        if ( orphan ) {
+            glBufferData( m_Target, m_Size, nullptr, GL_STREAM_DRAW );
+        }
+        region.m_Data = glMapBufferRange( m_Target, m_Head, size,
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+        BufferBinding::Bind( m_Target, 0 );
+        GL_ASSERT( region.m_Data, "Error mapping stream buffer!" );
+        m_Mapped = true;
+        break;
+    default:
+        if ( orphan ) {
+            BufferBinding::Bind( m_Target, m_Buffer );
+            glBufferData( m_Target, m_Size, nullptr, GL_STREAM_DRAW );
+            BufferBinding::Bind( m_Target, 0 );
+        }
+        region.m_Data = &m_Staging[ m_Head ];
+        m_Mapped = true;
+        break;
+    }
+    m_Head       += size;
+    m_Used       += size;
+    m_FrameBytes += size;
+    return region;
+}
+
+void StreamBuffer::Commit( const Region& region )
+{
+    if ( m_Mode == MODE_PERSISTENT ) return;
+
+    ASSERT( m_Mapped, "Stream buffer region committed twice!" );
+    BufferBinding::Bind( m_Target, m_Buffer );
+    if ( m_Mode == MODE_UNSYNCHRONIZED ) {
+        glUnmapBuffer( m_Target );
+    } else {
+        glBufferSubData( m_Target, region.m_Offset, region.m_Size, &m_Staging[ region.m_Offset ] );
+    }
+    BufferBinding::Bind( m_Target, 0 );
+    m_Mapped = false;
+}
+
+void StreamBuffer::EndFrame()
+{
+    ++m_Frame;
+    if ( !m_Buffer || !m_HasSync || m_FrameBytes == 0 ) return;
+
+    Fence fence = { glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ), m_FrameBytes };
+    m_Fences.push_back( fence );
+    m_FrameBytes = 0;
+}
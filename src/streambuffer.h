@@ -0,0 +1,124 @@
+/*
+ * streambuffer.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef STREAMBUFFER_H_
+#define STREAMBUFFER_H_
+
+#include "err.h"
+
+#include <GL/glew.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <deque>
+#include <vector>
+
+/*!
+ * One large vertex buffer for geometry that changes every frame. Space is
+ * handed out as a ring: Allocate() returns mapped memory to write the
+ * vertices into directly, Commit() makes them visible to GL. A region lives
+ * until the end of the frame - EndFrame() puts a fence behind the frame's
+ * data and the space is only reused after the GPU passed it.
+ *
+ *  - GL_ARB_buffer_storage: mapped once, persistent and coherent. Commit()
+ *    does nothing and regions can be filled from worker threads
+ *  - GL_ARB_map_buffer_range: each region is mapped unsynchronized - the
+ *    fences (or orphaning the buffer at the wrap without GL_ARB_sync) keep
+ *    the GPU out of it. Only one region can be mapped at a time
+ *  - plain VBOs: regions are staged in system memory and copied with
+ *    glBufferSubData() on Commit(), the buffer is orphaned at the wrap
+ *
+ * Other targets than GL_ARRAY_BUFFER work the same way - GetBuffer() must be
+ * bound to the target while GL reads the offsets.
+ *
+ * Allocate(), Commit() and EndFrame() are render thread only. Memory of a
+ * region may be written from anywhere between Allocate() and Commit().
+ */
+class StreamBuffer
+{
+public:
+    enum Mode {
+        MODE_PERSISTENT = 0,
+        MODE_UNSYNCHRONIZED,
+        MODE_STAGED,
+
+        NUM_MODES
+    };
+    enum {
+        DEFAULT_SIZE = 8<<20,
+        ALIGNMENT    = 16,      // of every region - enough for Vector
+    };
+
+    struct Region
+    {
+        void*       m_Data;     // write only - mapped GPU memory
+        std::size_t m_Offset;   // bytes into GetBuffer(), pass as pointer offset
+        std::size_t m_Size;
+    };
+private:
+    struct Fence
+    {
+        GLsync      m_Sync;
+        std::size_t m_Bytes;    // allocated in that frame, incl. space skipped at the wrap
+    };
+
+    GLuint            m_Buffer;
+    GLenum            m_Target;
+    Mode              m_Mode;
+    bool              m_HasSync;
+    std::size_t       m_Size;
+    char*             m_Mapping;        // persistent mode
+    std::vector<char> m_Staging;        // staged mode
+    bool              m_Mapped;         // a region is mapped/staged, not committed yet
+    std::size_t       m_Head;
+    std::size_t       m_Used;           // in flight and this frame
+    std::size_t       m_FrameBytes;
+    std::deque<Fence> m_Fences;
+    unsigned int      m_Frame;
+    unsigned int      m_Waits;          // stalls on a fence since the start
+public:
+    /*!
+     * target is what the buffer is bound to, e.g. GL_PIXEL_UNPACK_BUFFER to
+     * stage texture uploads
+     */
+    StreamBuffer( std::size_t size = DEFAULT_SIZE, GLenum target = GL_ARRAY_BUFFER );
+
+    ~StreamBuffer();
+
+    /*!
+     * Blocks if the GPU still reads the space. size must be below GetSize().
+     */
+    Region Allocate( std::size_t size ) throw(std::exception);
+
+    void Commit( const Region& region );
+
+    /*!
+     * After the frame's last draw, e.g. after swapping buffers
+     */
+    void EndFrame();
+
+    GLuint GetBuffer() const { return m_Buffer; }
+
+    std::size_t GetSize() const { return m_Size; }
+
+    Mode GetMode() const { return m_Mode; }
+
+    // incremented by EndFrame() - regions of older frames are gone
+    unsigned int GetFrame() const { return m_Frame; }
+
+    unsigned int GetNumWaits() const { return m_Waits; }
+
+private:
+    void Create() throw(std::exception);
+
+    // release fenced frames; wait for them if less than size is free
+    void Reclaim( std::size_t size );
+};
+
+typedef boost::shared_ptr<StreamBuffer> StreamBufferPtr;
+
+#endif /* STREAMBUFFER_H_ */
@@ -11,6 +11,8 @@
 #include "cube.h"
 #include "brush.h"
 #include "brushloader.h"
+#include "meshoptimizer.h"
+#include "bufferbinding.h"
 
 #include <cmath>
 
@@ -20,6 +22,35 @@
 const int sColumns = 120;
 const int sRows    = 120;
 
+const float sAmplitude = 0.85f; // "height" of wave
+const float sNumWaves  = 16.0f; // num of sin loops (or waves)
+
+// the wave is a function of the grid column and the phase - y of the vertices holds the column.
+// Fragments stay fixed function (textures, light map blend)
+static const char* sWaveVertexShader =
+    "uniform bool u_Lighting;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 vertex    = Displace( gl_Vertex );\n"
+    "    gl_Position    = gl_ModelViewProjectionMatrix * vertex;\n"
+    "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "    gl_TexCoord[1] = gl_MultiTexCoord1;\n"
+    "    vec4 color     = gl_Color;\n"
+    "    if ( u_Lighting ) {\n"
+    "        vec3 eye = ( gl_ModelViewMatrix * vertex ).xyz;\n"
+    "        vec3 n   = normalize( gl_NormalMatrix * gl_Normal );\n"
+    "        vec3 l   = normalize( gl_LightSource[0].position.xyz - eye * gl_LightSource[0].position.w );\n"
+    "        vec3 lit = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb +\n"
+    "                   gl_LightSource[0].diffuse.rgb * max( dot( n, l ), 0.0 );\n"
+    "        color.rgb *= lit;\n"
+    "    }\n"
+    "    gl_FrontColor = color;\n"
+    "}\n";
+
+// each level skips every other grid line. Minimum projected diameter in pixels
+const int   sNumLods = 3;
+const float sLodMinSize[ sNumLods ] = { 600.0f, 250.0f, 0.0f };
+
 struct PoolDeleter
 {
     void operator()(void const *p) const
@@ -29,30 +60,33 @@ struct PoolDeleter
     }
 };
 
-Surface::Surface( const std::vector< BrushPtr >& assets )
-    : m_Buffers( { -1 } )
-    , m_Assets( assets )
+Surface::Surface( const std::vector< std::string >& assets )
+    : m_Assets( assets )
     , m_MemoryPool( EntityPool::CreatePool<Vector>( 0 ), PoolDeleter() )
     , m_Stride(2)// store two vectors per vertex
     , m_VertexBuffer( m_MemoryPool )    // use the same memory pool for vertex and texture coords
     , m_TimeEllapsed(0)
     , m_Speed(1.0)
+    , m_Phase(0)
+    , m_StreamFrame(~0u)
+    , m_StreamOffset(0)
 {
     m_Textures.resize( MAX_TEXTURES );
     m_Textures = { TexturePtr() };
+
+    // CPU wave in the stream buffer: vertex, tex coord - full Vectors
+    m_StreamFormat.Set( Mesh::POSITION, VertexFormat::FLOAT, 4, m_Stride*sizeof(Vector), 0 );
+    m_StreamFormat.Set( Mesh::TEXCOORD, VertexFormat::FLOAT, 2, m_Stride*sizeof(Vector), sizeof(Vector) );
 }
 
-void Surface::MakeSurface( int columns, int rows )
+static inline float WaveHeight( int column, int columns, int phase )
 {
-    // we might just want to create this in DoInitialize - and throw away the data we don't need locally
-
-    // allocate memory buffers for vertex and texture coord
-    m_VertexBuffer.resize( columns*rows*m_Stride );
-
-    // generate index array; we got rows * columns * 2 tris
-    m_IndexArray.resize( (rows-1) * (columns-1) * 3 * 2 ); // 3 vertices per tri, 2 tri per quad = 6 entries per iteration
+    // maybe I should shift this for each row, huh, norm x to "length" of column (0.0 - 1.0)
+    return std::sin( float( ( column + phase ) % columns ) / columns * sNumWaves ) * sAmplitude; // make z a big "wavy" -- fix this. Must be multiple if sin(360)
+}
 
-    int looper(0);
+void Surface::WriteRows( Vector* vertices, int columns, int rows, int phase, int begin, int end ) const
+{
     // width x height is always a quad, not a rect
     const float width_2 = 15.0f; // 4.4f - for columns = 45
     const float depth_2 = 15.0f;
@@ -62,61 +96,150 @@ void Surface::MakeSurface( int columns, int rows )
     // generate vertex array
     const float xstep = (2*width_2)/columns; // mesh sub divider - 0.2f
     const float zstep = (2*depth_2)/rows; // mesh sub divider - 0.2f
-    const float amp  = 0.85f; // "height" of wave
-    const float numWaves = 16.0f; // num of sin loops (or waves)
-    auto vit = m_VertexBuffer.begin();
+    Vector* vit = vertices + begin*columns*m_Stride;
 
     // I think we need an additional row/column to finish this mesh ??
-    for ( float z = 0; z < rows; ++z )
+    for ( int z = begin; z < end; ++z )
     {
-        for ( float x = 0; x < columns; ++x )
+        for ( int x = 0; x < columns; ++x )
         {
             Vector& vertex = *vit; ++vit;
             vertex[ Vector::X ] = x * xstep - width_2; // -4.4 ... +4.4
-            // maybe I should shift this for each row, huh, norm x to "length" of column (0.0 - 1.0)
-            vertex[ Vector::Y ] = std::sin( (x/columns) * numWaves ) * amp; // make z a big "wavy" -- fix this. Must be multiple if sin(360)
+            // the vertex program evaluates the wave from the column
+            vertex[ Vector::Y ] = m_Program ? float(x) : WaveHeight( x, columns, phase );
             vertex[ Vector::Z ] = z * zstep - depth_2; // -4.4 ... +4.4
+            vertex[ Vector::W ] = 1.0f;
 
             // calc texture positions
             Vector& texCoord = *vit; ++vit;
-            texCoord[ Vector::U ] = x/(columns-1);
-            texCoord[ Vector::V ] = z/(rows-1);
+            texCoord[ Vector::U ] = float(x)/(columns-1);
+            texCoord[ Vector::V ] = float(z)/(rows-1);
+        }
+    }
+}
+
+void Surface::MakeSurface( int columns, int rows )
+{
+    // we might just want to create this in DoInitialize - and throw away the data we don't need locally
+
+    // allocate memory buffers for vertex and texture coord
+    m_VertexBuffer.resize( columns*rows*m_Stride );
+    WriteRows( &m_VertexBuffer[0], columns, rows, 0, 0, rows );
+
+    // wave only moves along the rows, amplitude stays - bounds are fixed
+    BoundingBox bounds;
+    for ( int i = 0; i < columns*rows; ++i ) {
+        const Vector& vertex = m_VertexBuffer[ i*m_Stride ];
+        bounds.Add( Vector( vertex[ Vector::X ], WaveHeight( i % columns, columns, 0 ), vertex[ Vector::Z ] ) );
+    }
 
-            // this needs work: we use a row * col vertex and texture array
-            // to extract triangles, the index array needs to be calculated appropriately
-            //        0  1  2...n
-            //        +--+--+...
-            //        |\ |\ |
-            //        | \| \|
-            //        +--+--+
-            // n*y +  0' 1' 2'...(n+1)*y
+    SetBounds( bounds );
 
-            // e.g. t[0] = { 0,1,1'} { 1',0',1 } ...
+    // A quad at the lowest point of the wave hides everything below it, but only if looking down from above the wave
+    const float x0 = bounds.m_Min[Vector::X], x1 = bounds.m_Max[Vector::X];
+    const float z0 = bounds.m_Min[Vector::Z], z1 = bounds.m_Max[Vector::Z];
+    const float yb = bounds.m_Min[Vector::Y], ya = bounds.m_Max[Vector::Y];
+    m_OccluderBelow = { Vector( x0, yb, z0 ), Vector( x1, yb, z0 ), Vector( x0, yb, z1 ),
+                        Vector( x1, yb, z0 ), Vector( x1, yb, z1 ), Vector( x0, yb, z1 ) };
+    m_OccluderAbove = { Vector( x0, ya, z0 ), Vector( x1, ya, z0 ), Vector( x0, ya, z1 ),
+                        Vector( x1, ya, z0 ), Vector( x1, ya, z1 ), Vector( x0, ya, z1 ) };
+}
 
-            // skip last column/row - already indexed
-            if ( x < (columns-1) && z < (rows-1) ) {
-                // vertices don't need to be set just yet. We just index them here
+void Surface::MakeGrid( int columns, int rows, MeshData& data )
+{
+    // coarser levels skip grid lines but use the same vertices - they are animated per surface
+    std::vector<unsigned int>& indices = data.m_Indices;
+    std::vector<int> lodIndices;
+    float misses[2] = { 0, 0 };
+    for ( int lod = 0; lod < sNumLods; ++lod ) {
+        const int step = 1<<lod;
+        // grid lines used by this level - the last one is always included
+        std::vector<int> xs, zs;
+        for ( int x = 0; x < columns-1; x += step ) xs.push_back( x );
+        xs.push_back( columns-1 );
+        for ( int z = 0; z < rows-1; z += step ) zs.push_back( z );
+        zs.push_back( rows-1 );
+
+        // generate index array; we got rows * columns * 2 tris
+        std::vector<unsigned int> indexArray( (zs.size()-1) * (xs.size()-1) * 3 * 2 ); // 3 vertices per tri, 2 tri per quad = 6 entries per iteration
+
+        int looper(0);
+        for ( std::size_t j = 0; j < zs.size()-1; ++j )
+        {
+            for ( std::size_t i = 0; i < xs.size()-1; ++i )
+            {
+                // this needs work: we use a row * col vertex and texture array
+                // to extract triangles, the index array needs to be calculated appropriately
+                //        0  1  2...n
+                //        +--+--+...
+                //        |\ |\ |
+                //        | \| \|
+                //        +--+--+
+                // n*y +  0' 1' 2'...(n+1)*y
+
+                // e.g. t[0] = { 0,1,1'} { 1',0',1 } ...
+                const int x0 = xs[i], x1 = xs[i+1];
+                const int z0 = zs[j], z1 = zs[j+1];
 
                 // top tri
-                int
-                idx = int(x + 0 + columns*z);     m_IndexArray[ looper++ ] = idx;  // 0x0
-                idx = int(x + 1 + columns*z);     m_IndexArray[ looper++ ] = idx;  // 1x0
-                idx = int(x + 0 + columns*(z+1)); m_IndexArray[ looper++ ] = idx;  // 1x1 - bottom row
+                indexArray[ looper++ ] = x0 + columns*z0;   // 0x0
+                indexArray[ looper++ ] = x1 + columns*z0;   // 1x0
+                indexArray[ looper++ ] = x0 + columns*z1;   // 1x1 - bottom row
 
                 // bottom tri
-                idx = int(x + 1 + columns*z);     m_IndexArray[ looper++ ] = idx; // 0x0
-                idx = int(x + 0 + columns*(z+1)); m_IndexArray[ looper++ ] = idx; // 1x1 - bottom row
-                idx = int(x + 1 + columns*(z+1)); m_IndexArray[ looper++ ] = idx; // 0x1 - bottom row
-                idx = 0;
+                indexArray[ looper++ ] = x1 + columns*z0;   // 0x0
+                indexArray[ looper++ ] = x0 + columns*z1;   // 1x1 - bottom row
+                indexArray[ looper++ ] = x1 + columns*z1;   // 0x1 - bottom row
             }
         }
+        // cache order only - the wave is shifted along the rows on the CPU, vertices must stay in grid order
+        const int numTriangles = indexArray.size() / 3;
+        misses[0] += MeshOptimizer::GetACMR( indexArray, columns*rows ) * numTriangles;
+        MeshOptimizer::OptimizeVertexCache( indexArray, columns*rows );
+        misses[1] += MeshOptimizer::GetACMR( indexArray, columns*rows ) * numTriangles;
+
+        lodIndices.push_back( indices.size() );
+        indices.insert( indices.end(), indexArray.begin(), indexArray.end() );
+    }
+    lodIndices.push_back( indices.size() );
+
+    for ( int lod = 0; lod < sNumLods; ++lod ) {
+        Mesh::Lod range = { lodIndices[lod], lodIndices[lod+1] - lodIndices[lod], sLodMinSize[lod] };
+        data.m_Lods.push_back( range );
+    }
+    const int numTriangles = indices.size() / 3;
+    data.m_ACMR[0] = misses[0] / numTriangles;
+    data.m_ACMR[1] = misses[1] / numTriangles;
+}
+
+std::string Surface::GetGridKey()
+{
+    return MeshCache::MakeKey( "grid", "%d %d", sColumns, sRows );
+}
+
+MeshCache::Builder Surface::GetGridBuilder()
+{
+    return boost::bind( &Surface::MakeGrid, sColumns, sRows, _1 );
+}
+
+const std::vector<Vector>* Surface::GetOccluder( const Vector& eye )
+{
+    if ( m_OccluderBelow.empty() ) return nullptr;
+
+    const BoundingBox& bounds = GetBounds();
+    Vector local = TransformPoint( GetRenderState()->GetMatrix().Inverse(), eye );
+    if ( local[Vector::Y] > bounds.m_Max[Vector::Y] ) {
+        return &m_OccluderBelow;
+    }
+    if ( local[Vector::Y] < bounds.m_Min[Vector::Y] ) {
+        return &m_OccluderAbove;
     }
+    // eye is inside the wave - the surface can't hide anything reliably
+    return nullptr;
 }
 
 Surface::~Surface()
 {
-    // shouldn't be done in d'tor...might be weakly linked to e.g. event handler...but vbo must be released from render thread
-    glDeleteBuffers( MAX_BUFFERS, (GLuint*)m_Buffers );
 }
 
 bool Surface::DoInitialize( Renderer* renderer ) throw(std::exception)
@@ -132,30 +255,39 @@ bool Surface::DoInitialize( Renderer* renderer ) throw(std::exception)
     for ( auto& asset : m_Assets ) {
         if ( texi > m_Textures.size() ) break;
 
-        m_Textures[texi] = TexturePtr( new Texture );
-        auto& texture = m_Textures[texi]; ++texi;
-        texture->Load( *asset.get() );
+        m_Textures[texi] = renderer->GetTextureCache()->Get( asset ); ++texi;
     }
     GetRenderState()->ClearFlag( BLEND_COLOR_F );
 
     bool hasVBO  = glewGetExtension("GL_ARB_vertex_buffer_object");
     ASSERT( hasVBO, "VBOs not supported!" );
 
+    // without GLSL the wave is evaluated on the CPU and written into the stream buffer each frame
+    if ( Program::IsSupported() ) {
+        m_Program = ProgramPtr( new Program );
+        m_Program->Load( std::string( "#version 120\n" ) + Program::GetDisplaceSource() + sWaveVertexShader, "" );
+    }
     MakeSurface( sColumns, sRows );
 
-    glGenBuffers( MAX_BUFFERS, (GLuint*)m_Buffers );
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[ VERTEX_BUFFER ] );
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vector)*m_VertexBuffer.size(), 0, GL_STATIC_DRAW);
-    std::size_t offset(0);
-
-    // ***! INTERLEAVED!! copy vertices starting from 0 offest - holds both, vertex and texture array
-    float *vertices = (float*)&m_VertexBuffer[0];
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(Vector)*m_VertexBuffer.size(), vertices);
+    if ( m_Program ) {
+        // ***! INTERLEAVED!! holds both, vertex and texture array
+        // compact - the grid and the column in y are exact in half floats
+        VertexFormat format = VertexFormat::MakeCompact( Mesh::POSITION_F | Mesh::TEXCOORD_F );
+        std::vector<char> vertices( format.GetVertexSize()*sColumns*sRows );
+        for ( int v = 0; v < sColumns*sRows; ++v ) {
+            char* vertex = &vertices[ v*format.GetVertexSize() ];
+            format.Write( Mesh::POSITION, vertex, m_VertexBuffer[ v*m_Stride ] );
+            format.Write( Mesh::TEXCOORD, vertex, m_VertexBuffer[ v*m_Stride + 1 ] );
+        }
+        m_Vertices = MeshPtr( new Mesh( renderer->GetGeometryArena() ) );
+        m_Vertices->SetFormat( format );
+        m_Vertices->SetVertexData( &vertices[0], vertices.size(), sColumns*sRows );
+    }
+    m_StreamBuffer = renderer->GetStreamBuffer();
+    m_JobQueue     = renderer->GetJobQueue();
 
-    // Index Buffer
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[ INDEX_BUFFER ]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int)*m_IndexArray.size(), &m_IndexArray[0], GL_STATIC_DRAW);
+    // Index Buffer - same topology for all surfaces of this size
+    m_Grid = renderer->GetMeshCache()->Get( GetGridKey(), GetGridBuilder() );
 
     // an Entity does not update by default
     renderer->RegisterUpdateFunction( boost::bind( &Surface::Update, this, _1) );
@@ -178,14 +310,38 @@ void Surface::DoRender( int pass ) throw(std::exception)
         }
     }
 
+    // static grid for the wave program - the CPU wave is written into the stream buffer once per frame.
+    // Read the arena offset every time, defragmentation moves it
+    GLuint buffer;
+    std::size_t offset;
+    const VertexFormat* format = &m_StreamFormat;
+    if ( m_Vertices ) {
+        buffer = m_Vertices->GetVertexBuffer();
+        offset = m_Vertices->GetVertexOffset();
+        format = &m_Vertices->GetFormat();
+    } else {
+        if ( m_StreamFrame != m_StreamBuffer->GetFrame() ) {
+            StreamBuffer::Region region = m_StreamBuffer->Allocate( sizeof(Vector)*sColumns*sRows*m_Stride );
+            m_JobQueue->ParallelFor( 0, sRows, boost::bind( &Surface::WriteRows, this, (Vector*)region.m_Data,
+                                                            sColumns, sRows, m_Phase, _1, _2 ), 8 );
+            m_StreamBuffer->Commit( region );
+            m_StreamOffset = region.m_Offset;
+            m_StreamFrame  = m_StreamBuffer->GetFrame();
+        }
+        buffer = m_StreamBuffer->GetBuffer();
+        offset = m_StreamOffset;
+    }
+
     // no need for textures in shadow pass - for now. -> transparent shadows will need it
-    glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[ VERTEX_BUFFER ]);
-    glVertexPointer(4, GL_FLOAT, m_Stride*sizeof(Vector), 0);
+    BufferBinding::Bind( GL_ARRAY_BUFFER, buffer );
+    glVertexPointer( format->GetSize( Mesh::POSITION ), format->GetType( Mesh::POSITION ), format->GetStride( Mesh::POSITION ),
+                     (void*)( offset + format->GetOffset( Mesh::POSITION ) ) );
     // Base texture. No special treatment. Just draw it
     if ( m_Textures[BASE_TEXTURE] ) {
         glClientActiveTexture(GL_TEXTURE0);
-        // only use u/v coords, skip t/s - stride is from n[0] + offset = n[1],
-        glTexCoordPointer( 2, GL_FLOAT, m_Stride*sizeof(Vector), (void*)sizeof(Vector) ); // first Vector is vertex
+        // only use u/v coords, skip t/s
+        glTexCoordPointer( 2, format->GetType( Mesh::TEXCOORD ), format->GetStride( Mesh::TEXCOORD ),
+                           (void*)( offset + format->GetOffset( Mesh::TEXCOORD ) ) );
 
         glActiveTexture(GL_TEXTURE0);
         m_Textures[BASE_TEXTURE]->Enable();
@@ -193,8 +349,9 @@ void Surface::DoRender( int pass ) throw(std::exception)
     // Lightmap. Simple RGB blend it into previous texture
     if ( m_Textures[LIGHT_MAP] ) {
         glClientActiveTexture(GL_TEXTURE1);
-        // only use u/v coords, skip t/s - stride is from n[0] + offset = n[1]
-        glTexCoordPointer( 2, GL_FLOAT, m_Stride*sizeof(Vector), (void*)sizeof(Vector) );
+        // only use u/v coords, skip t/s
+        glTexCoordPointer( 2, format->GetType( Mesh::TEXCOORD ), format->GetStride( Mesh::TEXCOORD ),
+                           (void*)( offset + format->GetOffset( Mesh::TEXCOORD ) ) );
 
         glActiveTexture(GL_TEXTURE1);
         m_Textures[LIGHT_MAP]->Enable();
@@ -206,11 +363,39 @@ void Surface::DoRender( int pass ) throw(std::exception)
         glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR);
     }
 
-    // use index array
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[ INDEX_BUFFER ]);
-    glDrawElements( GL_TRIANGLES, m_IndexArray.size(), GL_UNSIGNED_INT, (void*)0 );
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0 );
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // wave program - or the displacement hook of the program of this pass (shadow map, shadow test)
+    int currentProgram(0);
+    int waveLocation(-1);
+    if ( m_Program ) {
+        glGetIntegerv( GL_CURRENT_PROGRAM, &currentProgram );
+        if ( !currentProgram ) {
+            m_Program->Enable();
+            m_Program->SetUniform( "u_Lighting", int( glIsEnabled( GL_LIGHTING ) && glIsEnabled( GL_LIGHT0 ) ) );
+        }
+        waveLocation = glGetUniformLocation( currentProgram ? currentProgram : m_Program->GetProgramId(), "u_Wave" );
+        if ( waveLocation >= 0 ) {
+            glUniform4f( waveLocation, sAmplitude, sNumWaves/sColumns, sColumns, m_Phase );
+        }
+    }
+
+    // use index array - level of detail is a range of it
+    int lod = m_Lod.Select( *m_Grid, GetBounds(), pass );
+    if ( m_Lod.CasterLevelChanged() ) {
+        GeometryChanged();
+    }
+    BufferBinding::Bind( GL_ELEMENT_ARRAY_BUFFER, m_Grid->GetIndexBuffer() );
+    m_Grid->Draw( lod );
+
+    if ( m_Program ) {
+        if ( currentProgram ) {
+            // the pass draws other entities with it - undisplaced
+            if ( waveLocation >= 0 ) {
+                glUniform4f( waveLocation, 0, 0, 0, 0 );
+            }
+        } else {
+            m_Program->Disable();
+        }
+    }
 
     if (!vertexArrayEnabled)  {
         glDisableClientState(GL_VERTEX_ARRAY);  // disable vertex arrays
@@ -234,20 +419,8 @@ void Surface::DoUpdate( float ticks ) throw(std::exception)
     if ( m_TimeEllapsed*m_Speed > 16.67 )
     {
         m_TimeEllapsed = 0;
-        // size must be > 2
-        auto first = m_VertexBuffer[0]; // backup first vertex
-        for ( auto vit = m_VertexBuffer.begin(); vit != m_VertexBuffer.end();  ) {
-            auto& vertex = *vit; vit += m_Stride;
-            vertex[ Vector::Y ] = (*vit)[ Vector::Y ];
-        }
-        auto& last = m_VertexBuffer[ sColumns*sRows*m_Stride-m_Stride];
-        last[ Vector::Y ] = first[ Vector::Y ];
-
-        // I should probably use split buffers to not copy tex coords again and again
-        glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[ VERTEX_BUFFER ] );
-        // ***! INTERLEAVED!! copy vertices starting from 0 offest - holds both, vertex and texture array
-        float *vertices = (float*)&m_VertexBuffer[0];
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vector)*m_VertexBuffer.size(), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // one column along the rows - the vertices follow when they are drawn next
+        m_Phase = ( m_Phase + 1 ) % sColumns;
+        GeometryChanged();
     }
 }
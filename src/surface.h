@@ -15,6 +15,12 @@
 #include "texture.h"
 #include "entitypool.h"
 #include "allocator.h"
+#include "mesh.h"
+#include "meshcache.h"
+#include "lodselector.h"
+#include "program.h"
+#include "streambuffer.h"
+#include "jobqueue.h"
 
 #include <vector>
 
@@ -29,23 +35,14 @@ public:
         NORMAL,
         SPECULAR
     };
-    enum {
-        VERTEX_BUFFER = 0,
-        TEXUTURE_BUFFER,
-        INDEX_BUFFER,
-
-        MAX_BUFFERS
-    };
 
 private:
-    int m_Buffers[ MAX_BUFFERS ];
-
     enum {
         BASE_TEXTURE = 0,
         LIGHT_MAP,
         MAX_TEXTURES
     };
-    std::vector< BrushPtr > m_Assets;     // all mmaped data. Don't worry about pixel storage memory here!
+    std::vector< std::string > m_Assets;  // texture files, relative to data/ - shared through the TextureCache
     std::vector< TexturePtr > m_Textures; // all textures
 
     typedef std::vector<Vector, Allocator<Vector>> VertexVector;
@@ -54,15 +51,36 @@ private:
 
     int          m_Stride;
     VertexVector m_VertexBuffer;      // linear buffer - custom allocator - all GPU data are stored here
-    std::vector<int>  m_IndexArray;   // standard array to map vertices to tris
+    MeshPtr      m_Grid;              // index buffer only - shared by all surfaces. Vertices are animated per surface
+    MeshPtr      m_Vertices;          // static grid for the wave program - vertices only, not shared
+    VertexFormat m_StreamFormat;      // layout of the CPU wave in the stream buffer
+    LodSelector  m_Lod;
 
     float       m_TimeEllapsed;
     float       m_Speed;
+    int         m_Phase;               // columns the wave moved along the rows
+    ProgramPtr  m_Program;             // evaluates the wave. Null = CPU writes it into the stream buffer
+
+    StreamBufferPtr m_StreamBuffer;
+    JobQueuePtr     m_JobQueue;
+    unsigned int    m_StreamFrame;     // frame of the stream region - all passes of a frame share it
+    std::size_t     m_StreamOffset;
+
+    // flat quads at the bottom/top of the wave - only valid seen from the far side
+    std::vector<Vector> m_OccluderBelow;
+    std::vector<Vector> m_OccluderAbove;
 public:
-    Surface( const std::vector< BrushPtr >& assets );
+    Surface( const std::vector< std::string >& assets );
 
     virtual ~Surface();
 
+    virtual const std::vector<Vector>* GetOccluder( const Vector& eye );
+
+    // MeshCache key and builder of the shared index grid - shared with the meshcook tool
+    static std::string GetGridKey();
+
+    static MeshCache::Builder GetGridBuilder();
+
 protected:
     virtual bool DoInitialize( Renderer* renderer ) throw(std::exception);
 
@@ -71,6 +89,12 @@ protected:
     virtual void DoUpdate( float ticks ) throw(std::exception);
 
     void MakeSurface( int columns, int rows );
+
+    // interleaved vertex/tex coord of rows [begin, end). Called from workers
+    void WriteRows( Vector* vertices, int columns, int rows, int phase, int begin, int end ) const;
+
+    // index only - the vertices are per surface
+    static void MakeGrid( int columns, int rows, MeshData& data );
 };
 
 #endif /* MESH_H */
@@ -6,15 +6,26 @@
  */
 
 #include "texture.h"
+#include "blockdecoder.h"
+#include "mipchain.h"
+#include "pixelconverter.h"
+#include "rledecoder.h"
 
 #include <GL/glew.h>
 
+#include <algorithm>
+#include <vector>
+
 Texture::Texture()
     : m_TextID( -1 )
     , m_Width(0)
     , m_Height(0)
     , m_TextureFilter(GL_LINEAR)
     , m_WrapMode(GL_REPEAT)
+    , m_NumLevels(0)
+    , m_BaseLevel(0)
+    , m_Format(0)
+    , m_Compressed(false)
 {
 }
 
@@ -86,6 +97,47 @@ bool Texture::Allocate( int width, int height, int bpp /*= 4*/ ) throw(std::exce
     return true;
 }
 
+bool Texture::AllocateFormat( int width, int height, int internalFormat ) throw(std::exception)
+{
+    GLenum fmt;
+    GLenum type;
+    switch ( internalFormat )
+    {
+    case GL_RGB:
+    case GL_RGB8:               fmt = GL_RGB;  type = GL_UNSIGNED_BYTE; break;
+    case GL_RGBA:
+    case GL_RGBA8:              fmt = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+    case GL_RG16F:
+    case GL_RG32F:              fmt = GL_RG;   type = GL_FLOAT; break;
+    case GL_RGBA16F:
+    case GL_RGBA32F:            fmt = GL_RGBA; type = GL_FLOAT; break;
+    case GL_DEPTH_COMPONENT16:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32:  fmt = GL_DEPTH_COMPONENT; type = GL_FLOAT; break;
+    default: THROW( "Unsupported texture format (0x%x).", internalFormat ); break;
+    }
+
+    m_Width  = width;
+    m_Height = height;
+    if ( m_TextID <= 0) {
+        glGenTextures( 1, (GLuint*)&m_TextID );
+    }
+    GL_ASSERT( m_TextID > 0, "Error generating texture!" );
+
+    glBindTexture( GL_TEXTURE_2D, m_TextID );
+
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_TextureFilter );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_TextureFilter );
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_WrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_WrapMode);
+
+    // render targets - no auto mip mapping
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, fmt, type, NULL);
+
+    return true;
+}
+
 void Texture::Load( const char* pixels, int width, int height, int bpp, int type ) throw(std::exception)
 {
     ASSERT( (bpp == 1 || bpp == 2 || bpp == 3 || bpp == 4), "Pixel data must be 1, 2, 3 or 4 bytes per pixel!" );
@@ -96,19 +148,193 @@ void Texture::Load( const char* pixels, int width, int height, int bpp, int type
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, type, GL_UNSIGNED_BYTE, pixels);
 }
 
-void Texture::Load( const Brush& brush ) throw(std::exception)
+void Texture::Create( int width, int height, int numLevels ) throw(std::exception)
+{
+    m_Width  = width;
+    m_Height = height;
+    if ( m_TextID <= 0) {
+        glGenTextures( 1, (GLuint*)&m_TextID );
+    }
+    GL_ASSERT( m_TextID > 0, "Error generating texture!" );
+
+    Enable();
+
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_TextureFilter );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_TextureFilter );
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_WrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_WrapMode);
+
+    if ( numLevels > 0 ) {
+        // a chain that doesn't go down to 1x1 is still complete
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+        glTexParameterf(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        glTexParameterf(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+    }
+}
+
+Brush Texture::Prepare( const Brush& brush, bool decompress, std::vector<char>& storage, JobQueuePtr jobQueue,
+                        unsigned int conversion ) throw(std::exception)
 {
-    ASSERT( brush.m_Pixels && ( brush.m_BytesPerPixel == 3 || brush.m_BytesPerPixel == 4 ), "Invalid brush for texture!" );
-    Load( brush.m_Pixels, brush.m_Width, brush.m_Height, brush.m_BytesPerPixel, brush.m_BytesPerPixel == 3 ? GL_BGR : GL_BGRA );
+    ASSERT( brush.m_Pixels && brush.m_NumLevels >= 1, "Invalid brush for texture!" );
+    Brush levels( brush );
+    if ( brush.m_Compression == Brush::NONE && !PixelConverter::IsUploadable( brush, conversion ) ) {
+        // luminance, BGR, padded or top down rows: BGRA here instead of in the driver, straight into the chain
+        ASSERT( brush.m_NumLevels == 1, "Stored mip levels must be tightly packed BGRA!" );
+        storage.resize( MipChain::GetSize( brush.m_Width, brush.m_Height, 4 ) );
+        PixelConverter::Convert( brush, &storage[0], conversion, jobQueue );
+        MipChain::Generate( &storage[0], brush.m_Width, brush.m_Height, 4, jobQueue );
+        levels.m_BytesPerPixel = 4;
+        return MipChain::MakeBrush( levels, storage );
+    }
+    if ( brush.m_Compression == Brush::RLE ) {
+        // no GL takes packets - decoded and converted band by band into the chain
+        storage.resize( MipChain::GetSize( brush.m_Width, brush.m_Height, 4 ) );
+        RleDecoder::Decode( brush, &storage[0], conversion );
+        MipChain::Generate( &storage[0], brush.m_Width, brush.m_Height, 4, jobQueue );
+        levels.m_Compression   = Brush::NONE;
+        levels.m_BytesPerPixel = 4;
+        return MipChain::MakeBrush( levels, storage );
+    }
+    if ( brush.m_Compression != Brush::NONE ) {
+        std::size_t size(0);
+        for ( unsigned int level = 0; level < brush.m_NumLevels; ++level ) {
+            size += brush.GetLevelSize( level );
+        }
+        ASSERT( brush.m_Size >= size, "Invalid compressed brush for texture!" );
+        if ( !decompress ) {
+            // straight from the brush - usually the mmaped file
+            return levels;
+        }
+        levels.m_Compression   = Brush::NONE;
+        levels.m_BytesPerPixel = 4;
+        levels.m_Size          = 0;
+        for ( unsigned int level = 0; level < brush.m_NumLevels; ++level ) {
+            levels.m_Size += levels.GetLevelSize( level );
+        }
+        storage.resize( levels.m_Size );
+        levels.m_Pixels = &storage[0];
+        for ( unsigned int level = 0; level < brush.m_NumLevels; ++level ) {
+            BlockDecoder::Decode( brush.m_Compression, brush.GetLevel( level ), brush.GetLevelWidth( level ), brush.GetLevelHeight( level ),
+                                  const_cast<char*>( levels.GetLevel( level ) ), jobQueue );
+        }
+    }
+    if ( levels.m_NumLevels > 1 ) {
+        return levels;
+    }
+    // no stored mips - box filtered on the CPU, in parallel, instead of by the driver during the upload
+    std::vector<char> chain;
+    MipChain::Generate( levels.m_Pixels, levels.m_Width, levels.m_Height, levels.m_BytesPerPixel, chain, jobQueue, levels.m_Pitch );
+    storage.swap( chain );
+    return MipChain::MakeBrush( levels, storage );
+}
+
+void Texture::AllocateLevels( const Brush& brush ) throw(std::exception)
+{
+    ASSERT( brush.m_NumLevels >= 1, "Invalid brush for texture!" );
+    m_Compressed = brush.m_Compression != Brush::NONE;
+    m_NumLevels  = brush.m_NumLevels;
+
+    // blocks can't be filtered here - compressed brushes without stored mips still need the driver
+    Create( brush.m_Width, brush.m_Height, m_Compressed && m_NumLevels == 1 ? 0 : m_NumLevels );
+
+    // BGRA rows are whole words - uploaded with the default GL_UNPACK_ALIGNMENT of 4, never padded
+    ASSERT( m_Compressed || ( brush.m_BytesPerPixel == 4 && ( brush.m_Pitch == 0 || brush.m_Pitch == brush.m_Width * 4 ) ),
+            "Brush not prepared for texture!" );
+    m_Format = m_Compressed ? GetCompressedFormat( brush.m_Compression ) : GL_BGRA;
+    for ( int level = 0; level < m_NumLevels; ++level ) {
+        const int width  = brush.GetLevelWidth( level );
+        const int height = brush.GetLevelHeight( level );
+        if ( m_Compressed ) {
+            glCompressedTexImage2D( GL_TEXTURE_2D, level, m_Format, width, height, 0, brush.GetLevelSize( level ), NULL );
+        } else {
+            glTexImage2D( GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL );
+        }
+    }
+    SetBaseLevel( m_NumLevels - 1 );
+}
+
+void Texture::LoadLevel( int level, int y, int height, const char* pixels, std::size_t size ) throw(std::exception)
+{
+    ASSERT( level >= 0 && level < m_NumLevels, "Texture level %d not allocated!", level );
+    const int width = std::max( m_Width >> level, 1 );
+    Bind();
+    if ( m_Compressed ) {
+        glCompressedTexSubImage2D( GL_TEXTURE_2D, level, 0, y, width, height, m_Format, size, pixels );
+    } else {
+        // the layout of GL_RGBA8 itself - copied as it is
+        glTexSubImage2D( GL_TEXTURE_2D, level, 0, y, width, height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pixels );
+    }
+}
+
+void Texture::SetBaseLevel( int level )
+{
+    m_BaseLevel = level;
+    Bind();
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level );
+}
+
+void Texture::Load( const Brush& brush, JobQueuePtr jobQueue ) throw(std::exception)
+{
+    const bool decompress = brush.m_Compression != Brush::NONE && !IsCompressionSupported( brush.m_Compression );
+    std::vector<char> storage;
+    Brush levels = Prepare( brush, decompress, storage, jobQueue );
+    AllocateLevels( levels );
+    for ( int level = 0; level < m_NumLevels; ++level ) {
+        LoadLevel( level, 0, levels.GetLevelHeight( level ), levels.GetLevel( level ), levels.GetLevelSize( level ) );
+    }
+    SetBaseLevel( 0 );
+}
+
+bool Texture::IsCompressionSupported( int compression )
+{
+    switch ( compression ) {
+    case Brush::BC1:
+    case Brush::BC2:
+    case Brush::BC3: return glewGetExtension("GL_EXT_texture_compression_s3tc");
+    case Brush::BC4:
+    case Brush::BC5: return glewGetExtension("GL_ARB_texture_compression_rgtc");
+    default:         return false;
+    }
+}
+
+GLenum Texture::GetCompressedFormat( int compression ) throw(std::exception)
+{
+    switch ( compression ) {
+    case Brush::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case Brush::BC2: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    case Brush::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case Brush::BC4: return GL_COMPRESSED_RED_RGTC1;
+    case Brush::BC5: return GL_COMPRESSED_RG_RGTC2;
+    default: THROW( "Invalid compression (%d)", compression ); break;
+    }
+    return 0;
 }
 
 unsigned int Texture::GetTextureId() const
 {
+    if ( m_Shared ) return m_Shared->GetTextureId();
     return m_TextID;
 }
 
+void Texture::Share( boost::shared_ptr<Texture> texture ) throw(std::exception)
+{
+    ASSERT( texture && texture.get() != this && !texture->IsShared(), "Invalid texture to share!" );
+    if ( m_TextID > -1 ) {
+        glDeleteTextures(1,(GLuint*)&m_TextID);
+        m_TextID = -1;
+    }
+    m_Shared = texture;
+}
+
 void Texture::Bind() const
 {
+    if ( m_Shared ) {
+        m_Shared->Bind();
+        return;
+    }
     ASSERT( m_TextID > -1, "Invalid Texture ID" );
 
     /* Typical Texture Generation Using Data From The Bitmap */
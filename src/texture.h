@@ -10,11 +10,14 @@
 
 #include "err.h"
 #include "brush.h"
+#include "jobqueue.h"
 
 #include <GL/glew.h>
 
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 class Texture
 {
 protected:
@@ -22,20 +25,82 @@ protected:
     int m_Width, m_Height;
     int m_TextureFilter;
     int m_WrapMode;
+    int m_NumLevels;
+    int m_BaseLevel;
+    int m_Format;       // of allocated levels: GL_BGRA, or the internal format if compressed
+    bool m_Compressed;
+    boost::shared_ptr<Texture> m_Shared;  // drawn instead, see Share()
 public:
     Texture();
 
     ~Texture();
 
-    int GetWidth() const { return m_Width; }
+    int GetWidth() const { return m_Shared ? m_Shared->GetWidth() : m_Width; }
 
-    int GetHeight() const { return m_Height; }
+    int GetHeight() const { return m_Shared ? m_Shared->GetHeight() : m_Height; }
 
     bool Allocate( int width, int height, int bpp = 4 ) throw(std::exception);
 
+    /*!
+     * Allocate by GL internal format (e.g. GL_RGBA8, GL_RG32F, GL_DEPTH_COMPONENT24).
+     * Used for render targets.
+     */
+    bool AllocateFormat( int width, int height, int internalFormat ) throw(std::exception);
+
     void Load( const char* pixels, int width, int height, int bpp = 4, int type = GL_RGBA ) throw(std::exception);
 
-    void Load( const Brush& brush ) throw(std::exception);
+    /*!
+     * All mip levels of the brush. Compressed brushes are uploaded as they
+     * are, or decoded on the CPU if the GL can't take them (always for RLE). Raw brushes
+     * without stored mips get a box filtered chain - on the job queue if
+     * there is one
+     */
+    void Load( const Brush& brush, JobQueuePtr jobQueue = JobQueuePtr() ) throw(std::exception);
+
+    /*!
+     * The CPU side of Load() - no GL, can run on a worker. Returns the brush
+     * to upload: brush itself, or levels in storage decoded from blocks (if
+     * decompress) and/or box filtered from a brush without mips. Raw pixels
+     * always end up as tightly packed BGRA (see PixelConverter, which also
+     * applies conversion flags to raw brushes)
+     */
+    static Brush Prepare( const Brush& brush, bool decompress, std::vector<char>& storage,
+                          JobQueuePtr jobQueue = JobQueuePtr(), unsigned int conversion = 0 ) throw(std::exception);
+
+    /*!
+     * Storage for all levels of a prepared brush, contents undefined until
+     * loaded. Nothing is sampled but the smallest level until SetBaseLevel()
+     */
+    void AllocateLevels( const Brush& brush ) throw(std::exception);
+
+    /*!
+     * rows [y, y + height) of an allocated level. Block compressed levels in
+     * multiples of 4 rows. pixels may be an offset into the bound
+     * GL_PIXEL_UNPACK_BUFFER
+     */
+    void LoadLevel( int level, int y, int height, const char* pixels, std::size_t size ) throw(std::exception);
+
+    // largest level sampled - once it and all smaller levels are loaded
+    void SetBaseLevel( int level );
+
+    int GetNumLevels() const { return m_Shared ? m_Shared->GetNumLevels() : m_NumLevels; }
+
+    int GetBaseLevel() const { return m_Shared ? m_Shared->GetBaseLevel() : m_BaseLevel; }
+
+    /*!
+     * Frees the GL texture and binds texture from now on - for a texture with
+     * the same pixels. Holders of this one need not know. Nothing may be
+     * loaded into a shared texture any more
+     */
+    void Share( boost::shared_ptr<Texture> texture ) throw(std::exception);
+
+    bool IsShared() const { return bool( m_Shared ); }
+
+    // blocks of a Brush::Compression can be uploaded - S3TC for BC1-3, RGTC for BC4/5
+    static bool IsCompressionSupported( int compression );
+
+    // GL internal format of a Brush::Compression other than NONE
+    static GLenum GetCompressedFormat( int compression ) throw(std::exception);
 
     unsigned int GetTextureId() const;
 
@@ -48,6 +113,10 @@ public:
     void SetFilter( int filter );
 
     void SetWrapMode( int clampMode );
+
+private:
+    // bind and set up the parameters of an empty texture. 0 levels: generated by the driver
+    void Create( int width, int height, int numLevels ) throw(std::exception);
 };
 
 typedef boost::shared_ptr<Texture> TexturePtr;
@@ -0,0 +1,122 @@
+/*
+ * texturearray.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "texturearray.h"
+#include "texture.h"
+
+TextureArray::TextureArray()
+    : m_TextID(0)
+    , m_Width(0)
+    , m_Height(0)
+    , m_NumLayers(0)
+    , m_NumLevels(0)
+    , m_TextureFilter(GL_LINEAR)
+    , m_WrapMode(GL_REPEAT)
+{
+}
+
+TextureArray::~TextureArray()
+{
+    if ( m_TextID ) {
+        glDeleteTextures( 1, &m_TextID );
+    }
+}
+
+bool TextureArray::IsSupported()
+{
+    return glewGetExtension("GL_EXT_texture_array");
+}
+
+bool TextureArray::IsCompatible( const Brush& a, const Brush& b )
+{
+    return a.m_Width == b.m_Width && a.m_Height == b.m_Height && a.m_Compression == b.m_Compression &&
+           a.m_NumLevels == b.m_NumLevels;
+}
+
+void TextureArray::Load( const std::vector<BrushPtr>& brushes, JobQueuePtr jobQueue ) throw(std::exception)
+{
+    ASSERT( IsSupported(), "Texture arrays not supported!" );
+    ASSERT( !brushes.empty() && brushes[0], "No brushes for texture array!" );
+    const Brush& first = *brushes[0];
+    for ( auto& brush : brushes ) {
+        ASSERT( brush && IsCompatible( first, *brush ), "Texture array layers must have the same size and format!" );
+    }
+    const bool decompress = first.m_Compression != Brush::NONE && !Texture::IsCompressionSupported( first.m_Compression );
+
+    if ( !m_TextID ) {
+        glGenTextures( 1, &m_TextID );
+    }
+    GL_ASSERT( m_TextID, "Error generating texture!" );
+    glBindTexture( GL_TEXTURE_2D_ARRAY_EXT, m_TextID );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MIN_FILTER, m_TextureFilter );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAG_FILTER, m_TextureFilter );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_S, m_WrapMode );
+    glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_T, m_WrapMode );
+
+    m_NumLayers = brushes.size();
+    std::vector<char> storage;
+    for ( int layer = 0; layer < m_NumLayers; ++layer ) {
+        Brush levels = Texture::Prepare( *brushes[layer], decompress, storage, jobQueue );
+        const bool compressed = levels.m_Compression != Brush::NONE;
+        // raw levels are prepared as BGRA - the layout of GL_RGBA8
+        const GLenum format   = compressed ? Texture::GetCompressedFormat( levels.m_Compression ) : GL_BGRA;
+        if ( layer == 0 ) {
+            // storage of all layers - the prepared brushes all have the same levels
+            m_Width     = levels.m_Width;
+            m_Height    = levels.m_Height;
+            m_NumLevels = levels.m_NumLevels;
+            glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAX_LEVEL, m_NumLevels - 1 );
+            for ( int level = 0; level < m_NumLevels; ++level ) {
+                const int width  = levels.GetLevelWidth( level );
+                const int height = levels.GetLevelHeight( level );
+                if ( compressed ) {
+                    glCompressedTexImage3D( GL_TEXTURE_2D_ARRAY_EXT, level, format, width, height, m_NumLayers, 0,
+                                            levels.GetLevelSize( level ) * m_NumLayers, NULL );
+                } else {
+                    glTexImage3D( GL_TEXTURE_2D_ARRAY_EXT, level, GL_RGBA8, width, height, m_NumLayers, 0,
+                                  format, GL_UNSIGNED_INT_8_8_8_8_REV, NULL );
+                }
+            }
+        }
+        for ( int level = 0; level < m_NumLevels; ++level ) {
+            const int width  = levels.GetLevelWidth( level );
+            const int height = levels.GetLevelHeight( level );
+            if ( compressed ) {
+                glCompressedTexSubImage3D( GL_TEXTURE_2D_ARRAY_EXT, level, 0, 0, layer, width, height, 1, format,
+                                           levels.GetLevelSize( level ), levels.GetLevel( level ) );
+            } else {
+                glTexSubImage3D( GL_TEXTURE_2D_ARRAY_EXT, level, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_INT_8_8_8_8_REV, levels.GetLevel( level ) );
+            }
+        }
+    }
+}
+
+void TextureArray::Bind() const
+{
+    ASSERT( m_TextID, "Invalid Texture ID" );
+    glBindTexture( GL_TEXTURE_2D_ARRAY_EXT, m_TextID );
+}
+
+void TextureArray::SetFilter( int filter )
+{
+    m_TextureFilter = filter;
+    if ( m_TextID ) {
+        Bind();
+        glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MIN_FILTER, m_TextureFilter );
+        glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAG_FILTER, m_TextureFilter );
+    }
+}
+
+void TextureArray::SetWrapMode( int wrapMode )
+{
+    m_WrapMode = wrapMode;
+    if ( m_TextID ) {
+        Bind();
+        glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_S, m_WrapMode );
+        glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_WRAP_T, m_WrapMode );
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * texturearray.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef TEXTUREARRAY_H_
+#define TEXTUREARRAY_H_
+
+#include "err.h"
+#include "brush.h"
+#include "jobqueue.h"
+
+#include <GL/glew.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+/*!
+ * Images of the same size and format as layers of one GL_TEXTURE_2D_ARRAY -
+ * one bind for all of them, and unlike an atlas each layer still repeats.
+ * Only shaders can sample it: "#extension GL_EXT_texture_array : enable",
+ * a sampler2DArray and the layer as third tex coord.
+ */
+class TextureArray
+{
+    GLuint m_TextID;
+    int    m_Width, m_Height;
+    int    m_NumLayers;
+    int    m_NumLevels;
+    int    m_TextureFilter;
+    int    m_WrapMode;
+public:
+    TextureArray();
+
+    ~TextureArray();
+
+    // GL_EXT_texture_array
+    static bool IsSupported();
+
+    // brushes that can share an array - same size, compression and levels. Raw pixels all end up BGRA
+    static bool IsCompatible( const Brush& a, const Brush& b );
+
+    /*!
+     * One layer per brush, in order. Levels are prepared like Texture::Load()
+     * does - one brush at a time, so only one is decoded in memory.
+     */
+    void Load( const std::vector<BrushPtr>& brushes, JobQueuePtr jobQueue = JobQueuePtr() ) throw(std::exception);
+
+    int GetWidth() const { return m_Width; }
+
+    int GetHeight() const { return m_Height; }
+
+    int GetNumLayers() const { return m_NumLayers; }
+
+    unsigned int GetTextureId() const { return m_TextID; }
+
+    void Bind() const;
+
+    void SetFilter( int filter );
+
+    void SetWrapMode( int wrapMode );
+};
+
+typedef boost::shared_ptr<TextureArray> TextureArrayPtr;
+
+#endif /* TEXTUREARRAY_H_ */
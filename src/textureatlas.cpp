@@ -0,0 +1,185 @@
+/*
+ * textureatlas.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "textureatlas.h"
+#include "blockdecoder.h"
+#include "pixelconverter.h"
+#include "rledecoder.h"
+
+#include <tga_loader.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+TextureAtlas::TextureAtlas( int width /* = 2048 */, int height /* = 2048 */, int border /* = 4 */ )
+    : m_Width( width )
+    , m_Height( height )
+    , m_Border( border )
+    , m_Packer( width, height )
+    , m_Pixels( std::size_t( width ) * height * 4, 0 )
+{
+}
+
+bool TextureAtlas::Add( const std::string& name, const Brush& brush ) throw(std::exception)
+{
+    ASSERT( brush.m_Pixels && brush.m_Width > 0 && brush.m_Height > 0, "Invalid brush for atlas (%s)", name.c_str() );
+    if ( m_Regions.find( name ) != m_Regions.end() ) return true;
+
+    const int width  = brush.m_Width;
+    const int height = brush.m_Height;
+    int x, y;
+    if ( !m_Packer.Insert( width + 2*m_Border, height + 2*m_Border, x, y ) ) return false;
+
+    // level 0 as BGRA, bottom row first - blocks and packets decoded
+    std::vector<char> converted;
+    const char* pixels = brush.m_Pixels;
+    if ( brush.m_Compression == Brush::RLE ) {
+        converted.resize( std::size_t( width ) * height * 4 );
+        RleDecoder::Decode( brush, &converted[0] );
+        pixels = &converted[0];
+    } else if ( brush.m_Compression != Brush::NONE ) {
+        ASSERT( brush.m_Size >= BlockDecoder::GetSize( brush.m_Compression, width, height ), "Invalid compressed brush for atlas (%s)", name.c_str() );
+        converted.resize( std::size_t( width ) * height * 4 );
+        BlockDecoder::Decode( brush.m_Compression, brush.m_Pixels, width, height, &converted[0] );
+        pixels = &converted[0];
+    } else if ( !PixelConverter::IsUploadable( brush ) ) {
+        converted.resize( std::size_t( width ) * height * 4 );
+        PixelConverter::Convert( brush, &converted[0] );
+        pixels = &converted[0];
+    }
+
+    // rows and columns of the border repeat the edge
+    for ( int row = -m_Border; row < height + m_Border; ++row ) {
+        const char* src = pixels + std::size_t( std::min( std::max( row, 0 ), height - 1 ) ) * width * 4;
+        char* dst = &m_Pixels[ ( std::size_t( y + m_Border + row ) * m_Width + x ) * 4 ];
+        for ( int column = -m_Border; column < width + m_Border; ++column, dst += 4 ) {
+            std::memcpy( dst, src + std::min( std::max( column, 0 ), width - 1 ) * 4, 4 );
+        }
+    }
+
+    Region region = { x + m_Border, y + m_Border, width, height };
+    region.m_Scale  = Vector( float( width ) / m_Width, float( height ) / m_Height, 1.0f, 1.0f );
+    region.m_Offset = Vector( float( region.m_X ) / m_Width, float( region.m_Y ) / m_Height, 0.0f, 0.0f );
+    m_Regions[ name ] = region;
+    return true;
+}
+
+const TextureAtlas::Region* TextureAtlas::Find( const std::string& name ) const
+{
+    RegionMap::const_iterator it = m_Regions.find( name );
+    return it != m_Regions.end() ? &it->second : nullptr;
+}
+
+Brush TextureAtlas::GetBrush() const
+{
+    Brush brush = { (unsigned int)m_Width, (unsigned int)m_Height, 4, Brush::NONE, (unsigned int)m_Pixels.size(), 1, &m_Pixels[0] };
+    return brush;
+}
+
+TexturePtr TextureAtlas::Upload( JobQueuePtr jobQueue ) const throw(std::exception)
+{
+    TexturePtr texture( new Texture );
+    texture->SetWrapMode( GL_CLAMP_TO_EDGE );
+    texture->Load( GetBrush(), jobQueue );
+    return texture;
+}
+
+void TextureAtlas::Save( const std::string& path ) const throw(std::exception)
+{
+#pragma pack( push, 1 )
+    struct TgaHeader
+    {
+        uint8_t  identsize, colorMapType, imageType;
+        uint16_t colorMapStart, colorMapLength;
+        uint8_t  colorMapBits;
+        uint16_t xstart, ystart, width, height;
+        uint8_t  bits, descriptor;
+    };
+#pragma pack( pop )
+    ASSERT( m_Width <= 0xffff && m_Height <= 0xffff, "Atlas too large for TGA (%dx%d)", m_Width, m_Height );
+
+    // rows as they are in memory - TgaBrush maps them the same way
+    TgaHeader header = { 0, 0, 2, 0, 0, 0, 0, 0, uint16_t( m_Width ), uint16_t( m_Height ), 32, 8 };
+    std::string image( path + ".tga" );
+    std::ofstream tga( image.c_str(), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc );
+    ASSERT( tga.is_open(), "Can't write '%s'", image.c_str() );
+    tga.write( (const char*)&header, sizeof(header) );
+    tga.write( &m_Pixels[0], m_Pixels.size() );
+    ASSERT( tga.good(), "Error writing '%s'", image.c_str() );
+
+    std::string layout( path + ".atlas" );
+    std::ofstream out( layout.c_str(), std::ios_base::out | std::ios_base::trunc );
+    ASSERT( out.is_open(), "Can't write '%s'", layout.c_str() );
+    out << "atlas " << m_Width << " " << m_Height << " " << m_Border << std::endl;
+    for ( auto& entry : m_Regions ) {
+        const Region& region = entry.second;
+        out << region.m_X << " " << region.m_Y << " " << region.m_Width << " " << region.m_Height << " " << entry.first << std::endl;
+    }
+    ASSERT( out.good(), "Error writing '%s'", layout.c_str() );
+}
+
+void TextureAtlas::Load( const std::string& path ) throw(std::exception)
+{
+    std::string layout( path + ".atlas" );
+    std::ifstream in( layout.c_str() );
+    ASSERT( in.is_open(), "Can't open '%s'", layout.c_str() );
+
+    std::string tag;
+    int width(0), height(0), border(0);
+    in >> tag >> width >> height >> border;
+    ASSERT( tag == "atlas" && width > 0 && height > 0 && border >= 0, "Invalid atlas layout '%s'", layout.c_str() );
+
+    std::string image( path + ".tga" );
+    TgaBrush brush;
+    ASSERT( brush.Load( image.c_str() ), "Error loading atlas '%s'", image.c_str() );
+    ASSERT( int( brush.m_Width ) == width && int( brush.m_Height ) == height && brush.m_BytesPerPixel == 4,
+            "Atlas '%s' doesn't match its layout", image.c_str() );
+
+    // BGRA, bottom row first - whatever the file was saved as (packets, top down rows).
+    // Decoded before anything changes, so a broken file leaves the atlas as it was
+    std::vector<char> pixels( std::size_t( width ) * height * 4 );
+    if ( brush.m_Compression == Brush::RLE ) {
+        RleDecoder::Decode( brush, &pixels[0] );
+    } else {
+        ASSERT( brush.m_Compression == Brush::NONE, "Atlas '%s' doesn't match its layout", image.c_str() );
+        PixelConverter::Convert( brush, &pixels[0] );
+    }
+
+    m_Width  = width;
+    m_Height = height;
+    m_Border = border;
+    m_Pixels.swap( pixels );
+    // the layout is final
+    m_Packer.Reset( 0, 0 );
+    m_Regions.clear();
+
+    std::string line;
+    while ( std::getline( in, line ) ) {
+        std::istringstream fields( line );
+        Region region;
+        std::string name;
+        if ( !( fields >> region.m_X >> region.m_Y >> region.m_Width >> region.m_Height ) ) continue;
+        std::getline( fields >> std::ws, name );
+        ASSERT( !name.empty() && region.m_X >= 0 && region.m_Y >= 0 &&
+                region.m_X + region.m_Width <= width && region.m_Y + region.m_Height <= height,
+                "Invalid region in atlas layout '%s'", layout.c_str() );
+        region.m_Scale  = Vector( float( region.m_Width ) / width, float( region.m_Height ) / height, 1.0f, 1.0f );
+        region.m_Offset = Vector( float( region.m_X ) / width, float( region.m_Y ) / height, 0.0f, 0.0f );
+        m_Regions[ name ] = region;
+    }
+}
+
+void TextureAtlas::Remap( MeshData& data, const Region& region )
+{
+    for ( auto& uv : data.m_Streams[ Mesh::TEXCOORD ] ) {
+        uv[ Vector::X ] = uv[ Vector::X ] * region.m_Scale[ Vector::X ] + region.m_Offset[ Vector::X ];
+        uv[ Vector::Y ] = uv[ Vector::Y ] * region.m_Scale[ Vector::Y ] + region.m_Offset[ Vector::Y ];
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * textureatlas.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef TEXTUREATLAS_H_
+#define TEXTUREATLAS_H_
+
+#include "err.h"
+#include "brush.h"
+#include "texture.h"
+#include "meshdata.h"
+#include "jobqueue.h"
+#include "skylinepacker.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <string>
+#include <vector>
+
+/*!
+ * Many small images in one texture, so objects with different images share
+ * one bind. Images are placed by a skyline packer, converted to BGRA and
+ * surrounded by a border of their edge pixels - filtering and the first mip
+ * levels don't bleed into the neighbours.
+ * Meshes address their image through a region: Remap() moves tex coords in
+ * [0, 1] into it. Tex coords that repeat can't be remapped - tiled images
+ * belong into their own texture or a TextureArray.
+ * Atlases are packed at runtime or by the atlaspack tool; Save() and Load()
+ * read and write the cooked form (<path>.tga and the layout in <path>.atlas).
+ * No GL but Upload().
+ */
+class TextureAtlas
+{
+public:
+    struct Region
+    {
+        int    m_X, m_Y, m_Width, m_Height;     // pixels, without the border
+        Vector m_Scale, m_Offset;               // tex coord into the atlas: uv * scale + offset
+    };
+private:
+    typedef boost::unordered_map< std::string, Region > RegionMap;
+
+    int               m_Width, m_Height;
+    int               m_Border;
+    SkylinePacker     m_Packer;
+    RegionMap         m_Regions;
+    std::vector<char> m_Pixels;         // BGRA
+public:
+    TextureAtlas( int width = 2048, int height = 2048, int border = 4 );
+
+    /*!
+     * Place level 0 of brush under name. Returns false if the atlas is full.
+     * Adding a name twice keeps the first image
+     */
+    bool Add( const std::string& name, const Brush& brush ) throw(std::exception);
+
+    // null if there is no image of that name
+    const Region* Find( const std::string& name ) const;
+
+    int GetNumRegions() const { return m_Regions.size(); }
+
+    int GetWidth() const { return m_Width; }
+
+    int GetHeight() const { return m_Height; }
+
+    float GetOccupancy() const { return m_Packer.GetOccupancy(); }
+
+    /*!
+     * The atlas as a brush without mips - pixels of this instance
+     */
+    Brush GetBrush() const;
+
+    /*!
+     * Texture of the atlas, mip mapped on the CPU - render thread
+     */
+    TexturePtr Upload( JobQueuePtr jobQueue = JobQueuePtr() ) const throw(std::exception);
+
+    /*!
+     * <path>.tga and <path>.atlas
+     */
+    void Save( const std::string& path ) const throw(std::exception);
+
+    /*!
+     * A saved atlas. Its layout is fixed - Add() fails
+     */
+    void Load( const std::string& path ) throw(std::exception);
+
+    /*!
+     * Tex coords of data from the whole image into region
+     */
+    static void Remap( MeshData& data, const Region& region );
+};
+
+typedef boost::shared_ptr<TextureAtlas> TextureAtlasPtr;
+
+#endif /* TEXTUREATLAS_H_ */
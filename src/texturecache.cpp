@@ -0,0 +1,284 @@
+/*
+ * texturecache.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "texturecache.h"
+#include "brushloader.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <utility>
+#include <vector>
+
+static std::uint64_t Mix( std::uint64_t hash, std::uint64_t word )
+{
+    hash = ( hash ^ word ) * 0x100000001b3ULL;
+    return hash ^ ( hash >> 29 );
+}
+
+// VRAM of brush once uploaded, all levels
+static std::size_t EstimateSize( const Brush& brush )
+{
+    Brush levels( brush );
+    if ( brush.m_Compression == Brush::NONE || !Texture::IsCompressionSupported( brush.m_Compression ) ) {
+        // decoded - and RGB is padded by most drivers
+        levels.m_Compression   = Brush::NONE;
+        levels.m_BytesPerPixel = 4;
+    }
+    std::size_t size(0);
+    for ( unsigned int level = 0; level < levels.m_NumLevels; ++level ) {
+        size += levels.GetLevelSize( level );
+    }
+    // the chain is generated on upload
+    return levels.m_NumLevels > 1 ? size : size + size / 3;
+}
+
+TextureCache::TextureCache( TextureStreamerPtr streamer )
+    : m_Streamer( streamer )
+    , m_Pending( new Hashes )
+    , m_NextId(0)
+    , m_Budget( DEFAULT_BUDGET )
+    , m_MinAge( DEFAULT_MIN_AGE )
+    , m_Frame(0)
+    , m_Resident(0)
+    , m_NumHits(0)
+    , m_NumShared(0)
+    , m_NumMisses(0)
+    , m_NumEvicted(0)
+{
+}
+
+TexturePtr TextureCache::Get( const std::string& name ) throw(std::exception)
+{
+    NameMap::iterator it = m_Names.find( name );
+    if ( it != m_Names.end() ) {
+        TexturePtr texture = Find( it->second );
+        if ( texture ) {
+            ++m_NumHits;
+            return texture;
+        }
+    }
+    // only the header is read here - the pixels are touched by the prepare job
+    unsigned int id;
+    TexturePtr texture = Load( LoadBrush( name.c_str() ), id, name );
+    m_Names[ name ] = id;
+    return texture;
+}
+
+TexturePtr TextureCache::Get( BrushPtr brush ) throw(std::exception)
+{
+    SourceMap::iterator it = m_Sources.find( brush.get() );
+    if ( it != m_Sources.end() && it->second.first.lock() == brush ) {
+        TexturePtr texture = Find( it->second.second );
+        if ( texture ) {
+            ++m_NumHits;
+            return texture;
+        }
+    }
+    unsigned int id;
+    TexturePtr texture = Load( brush, id );
+    m_Sources[ brush.get() ] = std::make_pair( boost::weak_ptr<Brush>( brush ), id );
+    return texture;
+}
+
+TexturePtr TextureCache::Load( BrushPtr brush, unsigned int& id, const std::string& name /* = std::string() */ ) throw(std::exception)
+{
+    ASSERT( brush && brush->m_Pixels, "Invalid brush for texture!" );
+    ++m_NumMisses;
+    id = m_NextId++;
+    TexturePtr texture = m_Streamer->Load( brush, boost::bind( &TextureCache::HashJob, m_Pending, id, _1 ), name );
+    Entry& entry = m_Entries[ id ];
+    entry.m_Texture  = texture;
+    entry.m_Keep     = texture;
+    entry.m_Size     = EstimateSize( *brush );
+    entry.m_LastUsed = m_Frame;
+    entry.m_Hash     = 0;
+    entry.m_Hashed   = false;
+    m_Resident += entry.m_Size;
+    return texture;
+}
+
+TexturePtr TextureCache::Find( unsigned int id )
+{
+    EntryMap::iterator it = m_Entries.find( id );
+    if ( it == m_Entries.end() ) return TexturePtr();
+
+    TexturePtr texture = it->second.m_Texture.lock();
+    if ( texture ) {
+        it->second.m_Keep     = texture;
+        it->second.m_LastUsed = m_Frame;
+    }
+    return texture;
+}
+
+void TextureCache::HashJob( HashesPtr hashes, unsigned int id, const Brush& brush )
+{
+    std::uint64_t hash = Hash( brush );
+    boost::lock_guard< boost::mutex > lock( hashes->m_Mutex );
+    hashes->m_Done.push_back( std::make_pair( id, hash ) );
+}
+
+void TextureCache::Merge( unsigned int duplicate, unsigned int original )
+{
+    // its users draw the original from now on - holding it, so it counts as used
+    Entry& entry = m_Entries[ duplicate ];
+    entry.m_Texture.lock()->Share( Find( original ) );
+    entry.m_Size = 0;
+    for ( auto& name : m_Names ) {
+        if ( name.second == duplicate ) {
+            name.second = original;
+        }
+    }
+    for ( auto& source : m_Sources ) {
+        if ( source.second.second == duplicate ) {
+            source.second.second = original;
+        }
+    }
+    // stays for as long as its users hold it - no longer
+    entry.m_Keep.reset();
+    ++m_NumShared;
+}
+
+void TextureCache::Update()
+{
+    ++m_Frame;
+
+    std::vector< std::pair< unsigned int, std::uint64_t > > done;
+    {
+        boost::lock_guard< boost::mutex > lock( m_Pending->m_Mutex );
+        done.swap( m_Pending->m_Done );
+    }
+    for ( auto& hashed : done ) {
+        EntryMap::iterator it = m_Entries.find( hashed.first );
+        if ( it == m_Entries.end() ) continue;
+        it->second.m_Hash   = hashed.second;
+        it->second.m_Hashed = true;
+        HashMap::iterator original = m_Hashes.find( hashed.second );
+        EntryMap::iterator other = original != m_Hashes.end() ? m_Entries.find( original->second ) : m_Entries.end();
+        if ( other != m_Entries.end() && other != it && !other->second.m_Texture.expired() && !it->second.m_Texture.expired() ) {
+            Merge( hashed.first, original->second );
+        } else {
+            m_Hashes[ hashed.second ] = hashed.first;
+        }
+    }
+
+    m_Resident = 0;
+    bool erased(false);
+    std::vector< std::pair< unsigned int, Entry* > > unused;
+    for ( EntryMap::iterator it = m_Entries.begin(); it != m_Entries.end(); ) {
+        Entry& entry = it->second;
+        TexturePtr texture = entry.m_Texture.lock();
+        if ( !texture ) {
+            HashMap::iterator hash = m_Hashes.find( entry.m_Hash );
+            if ( entry.m_Hashed && hash != m_Hashes.end() && hash->second == it->first ) {
+                m_Hashes.erase( hash );
+            }
+            it = m_Entries.erase( it );
+            erased = true;
+            continue;
+        }
+        m_Resident += entry.m_Size;
+        // held by anyone but texture and m_Keep
+        if ( texture.use_count() > ( entry.m_Keep ? 2 : 1 ) ) {
+            entry.m_LastUsed = m_Frame;
+        } else if ( entry.m_Keep && m_Frame - entry.m_LastUsed >= m_MinAge ) {
+            unused.push_back( std::make_pair( entry.m_LastUsed, &entry ) );
+        }
+        ++it;
+    }
+
+    if ( m_Resident > m_Budget ) {
+        // least recently used first
+        std::sort( unused.begin(), unused.end(),
+                   []( const std::pair< unsigned int, Entry* >& a, const std::pair< unsigned int, Entry* >& b ) { return a.first < b.first; } );
+        for ( auto& candidate : unused ) {
+            if ( m_Resident <= m_Budget ) break;
+            // the texture goes now, the entry with the next Update()
+            candidate.second->m_Keep.reset();
+            m_Resident -= candidate.second->m_Size;
+            ++m_NumEvicted;
+        }
+    }
+
+    if ( erased ) {
+        // names and brushes of evicted textures load again
+        for ( NameMap::iterator it = m_Names.begin(); it != m_Names.end(); ) {
+            if ( m_Entries.find( it->second ) == m_Entries.end() ) {
+                it = m_Names.erase( it );
+            } else {
+                ++it;
+            }
+        }
+        for ( SourceMap::iterator it = m_Sources.begin(); it != m_Sources.end(); ) {
+            if ( m_Entries.find( it->second.second ) == m_Entries.end() || it->second.first.expired() ) {
+                it = m_Sources.erase( it );
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void TextureCache::Dump( std::ostream& out ) const
+{
+    out << "textures: " << m_Entries.size() << " cached, " << m_Resident / 1024 << " of " << m_Budget / 1024 << " kb, "
+        << m_NumHits << " hits, " << m_NumShared << " shared, " << m_NumMisses << " loaded, " << m_NumEvicted << " evicted" << std::endl;
+    for ( auto& entry : m_Entries ) {
+        TexturePtr texture = entry.second.m_Texture.lock();
+        if ( !texture ) continue;
+        std::string name;
+        for ( auto& n : m_Names ) {
+            if ( n.second == entry.first ) {
+                name = n.first;
+                break;
+            }
+        }
+        // pending: still being prepared
+        if ( entry.second.m_Hashed ) {
+            out << std::hex << std::setfill('0') << std::setw(16) << entry.second.m_Hash << std::dec << std::setfill(' ');
+        } else {
+            out << std::setw(16) << std::left << "pending" << std::right;
+        }
+        out
+            << " " << std::setw(24) << std::left << name << std::right
+            << " " << std::setw(5) << texture->GetWidth() << "x" << std::setw(5) << std::left << texture->GetHeight() << std::right
+            << " kb " << std::setw(6) << entry.second.m_Size / 1024
+            << " users " << std::setw(4) << texture.use_count() - ( entry.second.m_Keep ? 2 : 1 )
+            << " age " << std::setw(6) << m_Frame - entry.second.m_LastUsed
+            << std::endl;
+    }
+}
+
+std::uint64_t TextureCache::Hash( const Brush& brush )
+{
+    std::size_t size(0);
+    for ( unsigned int level = 0; level < brush.m_NumLevels; ++level ) {
+        size += brush.GetLevelSize( level );
+    }
+    if ( brush.m_Pitch ) {
+        // padding included - it is the same for the same file. The last row may not be padded
+        size = std::size_t( brush.m_Pitch ) * ( brush.m_Height - 1 ) + brush.m_Width * brush.m_BytesPerPixel;
+    }
+    // equal bytes in another layout are another image
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = Mix( hash, std::uint64_t( brush.m_Width ) << 32 | brush.m_Height );
+    hash = Mix( hash, brush.m_BytesPerPixel | brush.m_Compression << 8 | std::uint64_t( brush.m_NumLevels ) << 16 |
+                      std::uint64_t( brush.m_Pitch ) << 24 | std::uint64_t( brush.m_TopDown ) << 56 );
+
+    // a word at a time - memcpy as mapped files don't care about alignment
+    std::size_t offset(0);
+    std::uint64_t word;
+    for ( ; offset + sizeof(word) <= size; offset += sizeof(word) ) {
+        std::memcpy( &word, brush.m_Pixels + offset, sizeof(word) );
+        hash = Mix( hash, word );
+    }
+    word = 0;
+    std::memcpy( &word, brush.m_Pixels + offset, size - offset );
+    return Mix( hash, word ^ size );
+}
@@ -0,0 +1,152 @@
+/*
+ * texturecache.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef TEXTURECACHE_H_
+#define TEXTURECACHE_H_
+
+#include "err.h"
+#include "brush.h"
+#include "texture.h"
+#include "texturestreamer.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/*!
+ * Shares textures between entities. File names and brushes map to the
+ * texture they loaded. Textures are also identified by a hash of their
+ * pixels - taken on the worker that prepares them, as it reads every byte.
+ * Once it is in, a texture with the same pixels as an existing one is a
+ * duplicate: it is shared with the existing texture before any of its
+ * levels go up (see Texture::Share()), its names map to the existing
+ * texture from then on and it isn't kept any longer than its users hold it.
+ * Textures nobody else holds any more stay resident until the (estimated)
+ * VRAM of all cached textures exceeds the budget. Then the ones unused for
+ * the longest time go first - never one used in the last GetMinAge() frames.
+ * New textures are streamed (see TextureStreamer).
+ * Render thread only.
+ */
+class TextureCache
+{
+public:
+    enum {
+        DEFAULT_BUDGET  = 128<<20,
+        DEFAULT_MIN_AGE = 60,       // frames
+    };
+private:
+    struct Entry
+    {
+        boost::weak_ptr<Texture> m_Texture;
+        TexturePtr   m_Keep;        // resident while unused, reset on eviction
+        std::size_t  m_Size;        // estimated VRAM
+        unsigned int m_LastUsed;    // frame
+        std::uint64_t m_Hash;       // of the pixels, once m_Hashed
+        bool         m_Hashed;
+    };
+    typedef boost::unordered_map< unsigned int, Entry > EntryMap;
+    typedef boost::unordered_map< std::string, unsigned int > NameMap;
+    typedef boost::unordered_map< std::uint64_t, unsigned int > HashMap;
+    // the address may be another brush's by now - the weak pointer tells
+    typedef boost::unordered_map< const Brush*, std::pair< boost::weak_ptr<Brush>, unsigned int > > SourceMap;
+
+    // hashes from the prepare jobs, entry id and hash. Shared - jobs may outlive the cache
+    struct Hashes
+    {
+        boost::mutex m_Mutex;
+        std::vector< std::pair< unsigned int, std::uint64_t > > m_Done;
+    };
+    typedef boost::shared_ptr<Hashes> HashesPtr;
+
+    TextureStreamerPtr m_Streamer;
+    EntryMap     m_Entries;         // by id
+    NameMap      m_Names;
+    SourceMap    m_Sources;         // brushes passed to Get()
+    HashMap      m_Hashes;          // first texture with these pixels
+    HashesPtr    m_Pending;
+    unsigned int m_NextId;
+    std::size_t  m_Budget;
+    unsigned int m_MinAge;
+    unsigned int m_Frame;
+    std::size_t  m_Resident;
+    int          m_NumHits;         // by name or brush
+    int          m_NumShared;       // duplicates by content
+    int          m_NumMisses;
+    int          m_NumEvicted;
+public:
+    TextureCache( TextureStreamerPtr streamer );
+
+    /*!
+     * Shared texture of a file relative to data/ - loaded only if there is no
+     * texture for name, or name was found to duplicate another one
+     */
+    TexturePtr Get( const std::string& name ) throw(std::exception);
+
+    /*!
+     * Shared texture of brush - loaded only if there is no texture for this
+     * brush yet. Shared with another one once its pixels are known to match
+     */
+    TexturePtr Get( BrushPtr brush ) throw(std::exception);
+
+    /*!
+     * Once per frame, before TextureStreamer::Update(). Merges duplicates
+     * found since the last call, ages textures nobody holds and evicts them
+     * over budget
+     */
+    void Update();
+
+    void SetBudget( std::size_t budget ) { m_Budget = budget; }
+
+    std::size_t GetBudget() const { return m_Budget; }
+
+    void SetMinAge( unsigned int frames ) { m_MinAge = frames; }
+
+    unsigned int GetMinAge() const { return m_MinAge; }
+
+    // estimated VRAM of the live textures, as of the last Update()
+    std::size_t GetResident() const { return m_Resident; }
+
+    int GetNumHits() const { return m_NumHits + m_NumShared; }
+
+    int GetNumShared() const { return m_NumShared; }
+
+    int GetNumMisses() const { return m_NumMisses; }
+
+    int GetNumEvicted() const { return m_NumEvicted; }
+
+    /*!
+     * Live textures with size, users and age
+     */
+    void Dump( std::ostream& out ) const;
+
+    // of pixels and format, all levels - reads every byte
+    static std::uint64_t Hash( const Brush& brush );
+
+private:
+    // new entry for brush - streamed, hashed by the prepare job. name for errors
+    TexturePtr Load( BrushPtr brush, unsigned int& id, const std::string& name = std::string() ) throw(std::exception);
+
+    // live texture of entry id, marked as used
+    TexturePtr Find( unsigned int id );
+
+    // on a worker
+    static void HashJob( HashesPtr hashes, unsigned int id, const Brush& brush );
+
+    // texture, names and brushes of duplicate to original
+    void Merge( unsigned int duplicate, unsigned int original );
+};
+
+typedef boost::shared_ptr<TextureCache> TextureCachePtr;
+
+#endif /* TEXTURECACHE_H_ */
@@ -0,0 +1,191 @@
+/*
+ * texturestreamer.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "texturestreamer.h"
+
+#include <GL/glew.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// budgets the pixel buffer ring holds - frames in flight before it waits on a fence
+static const int _ringFrames = 4;
+
+// mappings are faulted in one read per page
+static const std::size_t _pageSize = 4096;
+
+TextureStreamer::TextureStreamer( JobQueuePtr jobQueue, std::size_t budget /* = DEFAULT_BUDGET */ )
+    : m_JobQueue( jobQueue )
+    , m_Initialized(false)
+    , m_Budget( budget )
+    , m_NumPending(0)
+    , m_Uploaded(0)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // never leave jobs behind that point into this instance
+    if ( m_Batch ) {
+        try {
+            m_JobQueue->Wait( m_Batch );
+        } catch ( ... ) {
+        }
+    }
+}
+
+TexturePtr TextureStreamer::Load( BrushPtr brush, const PrepareHook& hook /* = PrepareHook() */,
+                                  const std::string& name /* = std::string() */ ) throw(std::exception)
+{
+    ASSERT( brush && brush->m_Pixels, "Invalid brush for texture!" );
+    if ( !m_Initialized ) {
+        if ( glewGetExtension("GL_ARB_pixel_buffer_object") ) {
+            m_Ring = StreamBufferPtr( new StreamBuffer( m_Budget * _ringFrames, GL_PIXEL_UNPACK_BUFFER ) );
+        }
+        m_Initialized = true;
+    }
+
+    // textures modulate - white shows the plain entity until the first level is in
+    static const char white[] = { char(255), char(255), char(255), char(255) };
+    RequestPtr request( new Request );
+    request->m_Texture = TexturePtr( new Texture );
+    request->m_Texture->Load( white, 1, 1, 4, GL_BGRA );
+    request->m_Source     = brush;
+    request->m_Name       = name;
+    request->m_Hook       = hook;
+    request->m_Decompress = brush->m_Compression != Brush::NONE && !Texture::IsCompressionSupported( brush->m_Compression );
+    request->m_Failed     = false;
+    request->m_Level      = 0;
+    request->m_Row        = 0;
+
+    m_Batch = m_JobQueue->Post( boost::bind( &TextureStreamer::Prepare, this, request ), m_Batch );
+    ++m_NumPending;
+    return request->m_Texture;
+}
+
+void TextureStreamer::Prepare( RequestPtr request )
+{
+    try {
+        if ( request->m_Hook ) {
+            request->m_Hook( *request->m_Source );
+        }
+        request->m_Brush = Texture::Prepare( *request->m_Source, request->m_Decompress, request->m_Storage, m_JobQueue );
+        if ( request->m_Storage.empty() ) {
+            // uploaded straight from the mapping - page it in here, not during the copy on the render thread
+            const volatile char* pixels = request->m_Brush.m_Pixels;
+            for ( std::size_t offset = 0; offset < request->m_Brush.m_Size; offset += _pageSize ) {
+                (void)pixels[ offset ];
+            }
+        }
+    } catch ( std::exception& ex ) {
+        // a broken file costs its texture, not the renderer
+        std::cerr << "Ignoring texture '" << ( request->m_Name.empty() ? "(brush)" : request->m_Name ) << "': " << ex.what() << std::endl;
+        request->m_Failed = true;
+    }
+
+    boost::lock_guard< boost::mutex > lock( m_Mutex );
+    m_Prepared.push_back( request );
+}
+
+std::size_t TextureStreamer::Upload( Request& request, std::size_t budget ) throw(std::exception)
+{
+    const Brush& brush = request.m_Brush;
+    const int level  = request.m_Level;
+    const int height = brush.GetLevelHeight( level );
+
+    // whole rows - of blocks if compressed. At least one, even if over the budget
+    const int unit = brush.m_Compression != Brush::NONE ? 4 : 1;
+    const int numUnits = ( height + unit - 1 ) / unit;
+    const std::size_t unitSize = brush.GetLevelSize( level ) / numUnits;
+    if ( m_Ring ) {
+        budget = std::min( budget, m_Ring->GetSize() / 2 );
+    }
+    const int units = std::max( 1, std::min( int( budget / unitSize ), numUnits - request.m_Row / unit ) );
+    const int rows  = std::min( units * unit, height - request.m_Row );
+    const std::size_t size = units * unitSize;
+    const char* pixels = brush.GetLevel( level ) + ( request.m_Row / unit ) * unitSize;
+
+    if ( m_Ring && size <= m_Ring->GetSize() ) {
+        StreamBuffer::Region region = m_Ring->Allocate( size );
+        std::memcpy( region.m_Data, pixels, size );
+        m_Ring->Commit( region );
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, m_Ring->GetBuffer() );
+        request.m_Texture->LoadLevel( level, request.m_Row, rows, (const char*)0 + region.m_Offset, size );
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    } else {
+        request.m_Texture->LoadLevel( level, request.m_Row, rows, pixels, size );
+    }
+
+    request.m_Row += rows;
+    if ( request.m_Row >= height ) {
+        request.m_Texture->SetBaseLevel( level );
+        --request.m_Level;
+        request.m_Row = 0;
+    }
+    return size;
+}
+
+void TextureStreamer::Update() throw(std::exception)
+{
+    if ( m_Batch && m_JobQueue->IsDone( m_Batch ) ) {
+        JobQueue::BatchPtr batch = m_Batch;
+        m_Batch.reset();
+        m_JobQueue->Wait( batch );
+    }
+
+    std::deque<RequestPtr> prepared;
+    {
+        boost::lock_guard< boost::mutex > lock( m_Mutex );
+        prepared.swap( m_Prepared );
+    }
+    for ( auto& request : prepared ) {
+        if ( request->m_Failed || request->m_Texture->IsShared() ) {
+            // stays white, or a duplicate - its levels are in already
+            --m_NumPending;
+            continue;
+        }
+        request->m_Texture->AllocateLevels( request->m_Brush );
+        request->m_Level = request->m_Brush.m_NumLevels - 1;
+        m_Uploads.push_back( request );
+    }
+    for ( auto it = m_Uploads.begin(); it != m_Uploads.end(); ) {
+        if ( (*it)->m_Texture->IsShared() ) {
+            *it = m_Uploads.back();
+            m_Uploads.pop_back();
+            --m_NumPending;
+        } else {
+            ++it;
+        }
+    }
+
+    std::size_t budget = m_Budget;
+    while ( !m_Uploads.empty() && budget > 0 ) {
+        // smallest level first, over all textures
+        auto next = m_Uploads.begin();
+        for ( auto it = next + 1; it != m_Uploads.end(); ++it ) {
+            if ( (*it)->m_Brush.GetLevelSize( (*it)->m_Level ) < (*next)->m_Brush.GetLevelSize( (*next)->m_Level ) ) {
+                next = it;
+            }
+        }
+        const std::size_t size = Upload( **next, budget );
+        budget     -= std::min( size, budget );
+        m_Uploaded += size;
+        if ( (*next)->m_Level < 0 ) {
+            // complete - drops the brush and the prepared levels
+            *next = m_Uploads.back();
+            m_Uploads.pop_back();
+            --m_NumPending;
+        }
+    }
+
+    if ( m_Ring ) {
+        m_Ring->EndFrame();
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * texturestreamer.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef TEXTURESTREAMER_H_
+#define TEXTURESTREAMER_H_
+
+#include "err.h"
+#include "brush.h"
+#include "texture.h"
+#include "jobqueue.h"
+#include "streambuffer.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+/*!
+ * Textures that fill in over the next frames instead of stalling the one
+ * that creates them. Brushes are paged in, decoded and mip mapped on the job
+ * queue; the render thread only copies levels into a pixel buffer ring and
+ * issues glTexSubImage2D from it - no more bytes per frame than the budget.
+ * The smallest levels of all textures go first and each texture samples its
+ * largest complete level, so something is visible right away and detail
+ * follows.
+ * Without GL_ARB_pixel_buffer_object levels are uploaded from system memory,
+ * still within the budget.
+ *
+ * Render thread only.
+ */
+class TextureStreamer
+{
+public:
+    enum {
+        DEFAULT_BUDGET = 4<<20,     // bytes per frame
+    };
+    // runs on a worker with the source brush, before it is prepared
+    typedef boost::function< void( const Brush& ) > PrepareHook;
+private:
+    struct Request
+    {
+        TexturePtr        m_Texture;
+        BrushPtr          m_Source;     // keeps the mapping alive
+        std::string       m_Name;       // for errors
+        PrepareHook       m_Hook;
+        bool              m_Decompress;
+        bool              m_Failed;     // by the prepare job
+        Brush             m_Brush;      // prepared levels - m_Source or m_Storage
+        std::vector<char> m_Storage;
+        int               m_Level;      // uploaded from the smallest level to 0
+        int               m_Row;        // next row in m_Level
+    };
+    typedef boost::shared_ptr<Request> RequestPtr;
+
+    JobQueuePtr              m_JobQueue;
+    JobQueue::BatchPtr       m_Batch;       // prepare jobs in flight
+    StreamBufferPtr          m_Ring;        // GL_PIXEL_UNPACK_BUFFER, if supported
+    bool                     m_Initialized; // GL checked - with the first Load()
+    std::size_t              m_Budget;
+    boost::mutex             m_Mutex;
+    std::deque<RequestPtr>   m_Prepared;    // by the jobs, guarded by m_Mutex
+    std::vector<RequestPtr>  m_Uploads;     // allocated textures with levels to go
+    int                      m_NumPending;  // not uploaded completely
+    std::size_t              m_Uploaded;    // bytes since the start
+public:
+    TextureStreamer( JobQueuePtr jobQueue, std::size_t budget = DEFAULT_BUDGET );
+
+    ~TextureStreamer();
+
+    /*!
+     * A texture for brush that is filled by the following Update()s - a
+     * white pixel until then. The brush is kept until the texture is
+     * complete. hook gets a look at the brush on the worker that prepares
+     * it - the place for anything that reads all pixels. Levels stop going
+     * up once the texture is shared (see Texture::Share()). A brush that
+     * fails to decode is reported on std::cerr by name and leaves the
+     * texture white.
+     */
+    TexturePtr Load( BrushPtr brush, const PrepareHook& hook = PrepareHook(),
+                     const std::string& name = std::string() ) throw(std::exception);
+
+    /*!
+     * Once per frame, before the first draw. Uploads up to the budget and
+     * fences the ring
+     */
+    void Update() throw(std::exception);
+
+    // 0 pauses streaming
+    void SetBudget( std::size_t budget ) { m_Budget = budget; }
+
+    std::size_t GetBudget() const { return m_Budget; }
+
+    // textures not complete yet
+    int GetNumPending() const { return m_NumPending; }
+
+    std::size_t GetUploadedBytes() const { return m_Uploaded; }
+
+private:
+    // on a worker. Never throws - failed requests are dropped by Update()
+    void Prepare( RequestPtr request );
+
+    // up to budget bytes of the request's current level. Returns bytes uploaded
+    std::size_t Upload( Request& request, std::size_t budget ) throw(std::exception);
+};
+
+typedef boost::shared_ptr<TextureStreamer> TextureStreamerPtr;
+
+#endif /* TEXTURESTREAMER_H_ */
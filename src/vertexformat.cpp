@@ -0,0 +1,187 @@
+/*
+ * vertexformat.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#include "vertexformat.h"
+
+#include <algorithm>
+#include <cmath>
+
+// bytes per component, INT_2_10_10_10 is 4 bytes for all of them
+static const int sComponentBytes[ VertexFormat::NUM_ENCODINGS ] = { 0, 4, 2, 1, 2, 1, 0 };
+
+static const GLenum sTypes[ VertexFormat::NUM_ENCODINGS ] = {
+    0, GL_FLOAT, GL_HALF_FLOAT_ARB, GL_BYTE, GL_SHORT, GL_UNSIGNED_BYTE, GL_INT_2_10_10_10_REV
+};
+
+// encodings the fixed function pipeline accepts per attribute (position, normal, color, tex coord)
+static const unsigned int sValidEncodings[ VertexFormat::MAX_ATTRIBUTES ] = {
+    1<<VertexFormat::FLOAT | 1<<VertexFormat::HALF_FLOAT,
+    1<<VertexFormat::FLOAT | 1<<VertexFormat::HALF_FLOAT | 1<<VertexFormat::SNORM8 | 1<<VertexFormat::SNORM16 | 1<<VertexFormat::INT_2_10_10_10,
+    1<<VertexFormat::FLOAT | 1<<VertexFormat::HALF_FLOAT | 1<<VertexFormat::UNORM8,
+    1<<VertexFormat::FLOAT | 1<<VertexFormat::HALF_FLOAT,
+};
+
+static inline float Clamp( float value, float low, float high )
+{
+    return std::min( std::max( value, low ), high );
+}
+
+VertexFormat::VertexFormat()
+    : m_VertexSize(0)
+{
+    for ( auto& element : m_Elements ) {
+        element.m_Encoding = NONE;
+        element.m_Size     = 0;
+        element.m_Stride   = 0;
+        element.m_Offset   = 0;
+    }
+}
+
+void VertexFormat::Set( int attribute, Encoding encoding, int size, int stride, std::size_t offset ) throw(std::exception)
+{
+    ASSERT( attribute >= 0 && attribute < MAX_ATTRIBUTES, "Invalid vertex attribute %d", attribute );
+    ASSERT( sValidEncodings[ attribute ] & (1<<encoding), "Vertex attribute %d can't be encoded as %d", attribute, int(encoding) );
+    ASSERT( encoding != INT_2_10_10_10 || size == 4, "10:10:10:2 always has 4 components" );
+    Element& element   = m_Elements[ attribute ];
+    element.m_Encoding = encoding;
+    element.m_Size     = size;
+    element.m_Stride   = stride;
+    element.m_Offset   = offset;
+    m_VertexSize = std::max<std::size_t>( m_VertexSize, stride );
+}
+
+void VertexFormat::Append( int attribute, Encoding encoding, int size ) throw(std::exception)
+{
+    std::size_t bytes = encoding == INT_2_10_10_10 ? 4 : sComponentBytes[ encoding ]*size;
+    Set( attribute, encoding, size, 0, m_VertexSize );
+    m_VertexSize += ( bytes + 3 ) & ~3;
+    for ( auto& element : m_Elements ) {
+        if ( element.m_Encoding != NONE ) {
+            element.m_Stride = m_VertexSize;
+        }
+    }
+}
+
+GLenum VertexFormat::GetType( int attribute ) const
+{
+    return sTypes[ m_Elements[ attribute ].m_Encoding ];
+}
+
+unsigned short VertexFormat::FloatToHalf( float value )
+{
+    unsigned int bits;
+    std::memcpy( &bits, &value, sizeof(bits) );
+    unsigned int sign     = ( bits >> 16 ) & 0x8000;
+    int          exponent = int( ( bits >> 23 ) & 0xFF ) - 127 + 15;
+    unsigned int mantissa = bits & 0x7FFFFF;
+    if ( exponent >= 31 ) {
+        // too large, inf and nan all end up as inf - vertex data has no nans
+        return sign | 0x7C00;
+    }
+    if ( exponent <= 0 ) {
+        if ( exponent < -10 ) return sign;
+        // denormal, round to nearest
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        return sign | ( ( mantissa + ( 1 << ( shift - 1 ) ) ) >> shift );
+    }
+    // round to nearest, a carry into the exponent is still the right value
+    return sign | ( ( ( exponent << 23 ) | mantissa ) + 0x1000 ) >> 13;
+}
+
+void VertexFormat::Write( int attribute, char* vertex, const float* value ) const
+{
+    const Element& element = m_Elements[ attribute ];
+    char* out = vertex + element.m_Offset;
+    switch ( element.m_Encoding ) {
+    case FLOAT:
+        std::memcpy( out, value, sizeof(float)*element.m_Size );
+        break;
+    case HALF_FLOAT:
+        for ( int i = 0; i < element.m_Size; ++i ) {
+            ((unsigned short*)out)[i] = FloatToHalf( value[i] );
+        }
+        break;
+    case SNORM8:
+        for ( int i = 0; i < element.m_Size; ++i ) {
+            ((signed char*)out)[i] = (signed char)std::floor( Clamp( value[i], -1, 1 ) * 127.0f + 0.5f );
+        }
+        break;
+    case SNORM16:
+        for ( int i = 0; i < element.m_Size; ++i ) {
+            ((short*)out)[i] = (short)std::floor( Clamp( value[i], -1, 1 ) * 32767.0f + 0.5f );
+        }
+        break;
+    case UNORM8:
+        for ( int i = 0; i < element.m_Size; ++i ) {
+            ((unsigned char*)out)[i] = (unsigned char)std::floor( Clamp( value[i], 0, 1 ) * 255.0f + 0.5f );
+        }
+        break;
+    case INT_2_10_10_10: {
+        // x in the low bits. Only xyz are read, the 2 bits of w stay 0
+        unsigned int packed(0);
+        for ( int i = 0; i < 3; ++i ) {
+            int v = int( std::floor( Clamp( value[i], -1, 1 ) * 511.0f + 0.5f ) );
+            packed |= ( unsigned(v) & 0x3FF ) << ( i*10 );
+        }
+        std::memcpy( out, &packed, sizeof(packed) );
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void VertexFormat::Interleave( const Vector* const streams[ MAX_ATTRIBUTES ], int numVertices, std::vector<char>& buffer ) const
+{
+    buffer.assign( m_VertexSize*numVertices, 0 );
+    for ( int a = 0; a < MAX_ATTRIBUTES; ++a ) {
+        if ( !Has( a ) ) continue;
+        ASSERT( streams[a], "No data for vertex attribute %d", a );
+        char* vertex = &buffer[0];
+        for ( int v = 0; v < numVertices; ++v, vertex += m_VertexSize ) {
+            Write( a, vertex, streams[a][v] );
+        }
+    }
+}
+
+bool VertexFormat::IsSupported( Encoding encoding )
+{
+    switch ( encoding ) {
+    case HALF_FLOAT:     return glewGetExtension("GL_ARB_half_float_vertex");
+    case INT_2_10_10_10: return glewGetExtension("GL_ARB_vertex_type_2_10_10_10_rev");
+    default:             return true;
+    }
+}
+
+VertexFormat VertexFormat::MakeCompact( unsigned int attributes )
+{
+    return MakeCompact( attributes, IsSupported( HALF_FLOAT ), IsSupported( INT_2_10_10_10 ) );
+}
+
+VertexFormat VertexFormat::MakeCompact( unsigned int attributes, bool halfFloat, bool packedNormals )
+{
+    const Encoding half = halfFloat ? HALF_FLOAT : FLOAT;
+    VertexFormat format;
+    if ( attributes & (1<<POSITION) ) {
+        format.Append( POSITION, half, 3 );
+    }
+    if ( attributes & (1<<NORMAL) ) {
+        if ( packedNormals ) {
+            format.Append( NORMAL, INT_2_10_10_10, 4 );
+        } else {
+            format.Append( NORMAL, SNORM8, 3 );
+        }
+    }
+    if ( attributes & (1<<COLOR) ) {
+        format.Append( COLOR, UNORM8, 4 );
+    }
+    if ( attributes & (1<<TEXCOORD) ) {
+        format.Append( TEXCOORD, half, 2 );
+    }
+    return format;
+}
@@ -0,0 +1,122 @@
+/*
+ * vertexformat.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ */
+
+#ifndef VERTEXFORMAT_H_
+#define VERTEXFORMAT_H_
+
+#include "err.h"
+#include "vector.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/*!
+ * Describes where and how the attributes of a vertex buffer are stored.
+ * Builders encode their float data with Write(), Mesh::Enable() sets the
+ * array pointers from it - both only look at the descriptor.
+ *
+ * Mesh::Attribute uses the same indices. All encodings must be usable
+ * by the fixed function pipeline, which normalizes integer normals and
+ * colors, but not positions or texture coords:
+ *
+ *  - FLOAT:           any attribute
+ *  - HALF_FLOAT:      any attribute - GL_ARB_half_float_vertex
+ *  - SNORM8, SNORM16: normals
+ *  - UNORM8:          colors
+ *  - INT_2_10_10_10:  normals, xyz + 2 bit w in 32 bit - GL_ARB_vertex_type_2_10_10_10_rev
+ */
+class VertexFormat
+{
+public:
+    enum Attribute {
+        POSITION = 0,
+        NORMAL,
+        COLOR,
+        TEXCOORD,
+
+        MAX_ATTRIBUTES
+    };
+    enum Encoding {
+        NONE = 0,
+        FLOAT,
+        HALF_FLOAT,
+        SNORM8,
+        SNORM16,
+        UNORM8,
+        INT_2_10_10_10,
+
+        NUM_ENCODINGS
+    };
+private:
+    struct Element
+    {
+        Encoding    m_Encoding;
+        int         m_Size;         // components
+        int         m_Stride;       // bytes
+        std::size_t m_Offset;       // bytes into the vertex buffer
+    };
+    Element     m_Elements[ MAX_ATTRIBUTES ];
+    std::size_t m_VertexSize;       // interleaved layouts only - the stride of the attributes
+public:
+    VertexFormat();
+
+    /*!
+     * Any layout - planar arrays or your own interleaving
+     */
+    void Set( int attribute, Encoding encoding, int size, int stride, std::size_t offset ) throw(std::exception);
+
+    /*!
+     * Interleaved layouts: add the attribute at the end of the vertex, 4 byte
+     * aligned. The stride of all appended attributes grows with it.
+     */
+    void Append( int attribute, Encoding encoding, int size ) throw(std::exception);
+
+    bool Has( int attribute ) const { return m_Elements[ attribute ].m_Encoding != NONE; }
+
+    Encoding GetEncoding( int attribute ) const { return m_Elements[ attribute ].m_Encoding; }
+
+    int GetSize( int attribute ) const { return m_Elements[ attribute ].m_Size; }
+
+    int GetStride( int attribute ) const { return m_Elements[ attribute ].m_Stride; }
+
+    std::size_t GetOffset( int attribute ) const { return m_Elements[ attribute ].m_Offset; }
+
+    // GL type for the array pointer
+    GLenum GetType( int attribute ) const;
+
+    std::size_t GetVertexSize() const { return m_VertexSize; }
+
+    /*!
+     * Encode size components of value into the attribute of the interleaved
+     * vertex at vertex.
+     */
+    void Write( int attribute, char* vertex, const float* value ) const;
+
+    /*!
+     * Encode numVertices interleaved vertices from one Vector array per
+     * attribute of this format.
+     */
+    void Interleave( const Vector* const streams[ MAX_ATTRIBUTES ], int numVertices, std::vector<char>& buffer ) const;
+
+    static bool IsSupported( Encoding encoding );
+
+    /*!
+     * Smallest interleaved layout for the attributes (1<<Attribute)
+     * the hardware can draw: half float xyz positions and uv texture coords,
+     * 10:10:10:2 or 8 bit normals, 8 bit colors. Floats without half float
+     * support.
+     */
+    static VertexFormat MakeCompact( unsigned int attributes );
+
+    // same without asking GL - for the cook tool
+    static VertexFormat MakeCompact( unsigned int attributes, bool halfFloat, bool packedNormals );
+
+    static unsigned short FloatToHalf( float value );
+};
+
+#endif /* VERTEXFORMAT_H_ */
@@ -88,6 +88,8 @@ public:
 
     int GetHeight() const { return m_RenderStateProxy->m_Height; }
 
+    const Matrix& GetProjectionMatrix() const { return m_RenderStateProxy->m_Frustum.m_Matrix; }
+
     void SetClearFlags( unsigned int clearFlags ) { m_RenderStateProxy->m_ClearFlags = clearFlags; }
 
     virtual void Render( int pass ) throw(std::exception);
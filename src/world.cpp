@@ -6,6 +6,7 @@
  */
 
 #include "world.h"
+#include "renderer.h"
 #include "surface.h"
 #include "cube.h"
 #include "sphere.h"
@@ -13,6 +14,9 @@
 
 World::World()
     : m_IsInitialized(false)
+    , m_OcclusionCulling(true)
+    , m_ShadowCasterCulling(true)
+    , m_ShadowRegion( ShadowDirtyTracker::GetFullRect() )
 {
     LightPtr light( new Light );
     light->GetRenderState()->Translate( Vector( 0, 5, 0 ) );
@@ -68,6 +72,8 @@ bool World::Initialize( Renderer* renderer ) throw(std::exception)
 bool World::DoInitialize( Renderer* renderer ) throw( std::exception )
 {
     bool r(true);
+    m_OcclusionCuller = OcclusionCullerPtr( new OcclusionCuller( renderer->GetJobQueue() ) );
+
     // transform/render all lights
     for ( auto& light : m_Lights ) {
 //        r &= light->Initialize( renderer );
@@ -75,6 +81,37 @@ bool World::DoInitialize( Renderer* renderer ) throw( std::exception )
     return r;
 }
 
+void World::SetShadowReceiverView( const Matrix& view, const Matrix& projection )
+{
+    m_ShadowCasterCuller.SetReceiverView( view, projection );
+}
+
+const std::vector<bool>& World::GetShadowCasters( const Matrix& lightViewProjection )
+{
+    if ( m_ShadowCasterCulling ) {
+        m_ShadowCasters = m_ShadowCasterCuller.GetCasters( lightViewProjection, m_RenderList );
+    } else {
+        m_ShadowCasters.assign( m_RenderList.size(), true );
+    }
+    int index(0);
+    for( auto it = m_RenderList.begin(); it != m_RenderList.end(); ++it, ++index ) {
+        const EntityPtr& entity = *it;
+        if ( !entity->IsFlagSet( Entity::F_ENABLE|Entity::F_VISIBLE ) ||
+              entity->IsFlagSet( Entity::F_DELETE ) )
+        {
+            m_ShadowCasters[index] = false;
+        }
+    }
+    return m_ShadowCasters;
+}
+
+bool World::GetShadowDirtyRect( const Matrix& lightView, const Matrix& lightProjection,
+                                ShadowDirtyTracker& tracker, ScreenRect& dirty )
+{
+    Matrix lightViewProjection = Matrix( lightView ).Mul( lightProjection );
+    return tracker.Update( lightViewProjection, m_RenderList, GetShadowCasters( lightViewProjection ), dirty );
+}
+
 void World::SetupRender( int pass )
 {
     // do nothing. World uses identity. Does not transform
@@ -91,16 +128,77 @@ void World::RenderSubTree( int pass ) throw( std::exception )
     // Transform/Render lights before children
     DoRender( pass );
 
-    // render all children
-    for( auto it = m_RenderList.begin(); it != m_RenderList.end(); ) {
+    if ( pass & PASS_SHADOW_MAP_F ) {
+        // World does not transform - current matrices are the light's view & projection
+        Matrix view, projection;
+        glGetFloatv( GL_MODELVIEW_MATRIX, view );
+        glGetFloatv( GL_PROJECTION_MATRIX, projection );
+        Matrix lightViewProjection = Matrix( view ).Mul( projection );
+
+        const std::vector<bool>& casters = GetShadowCasters( lightViewProjection );
+        int index(0);
+        for( auto it = m_RenderList.begin(); it != m_RenderList.end(); ++it, ++index ) {
+            EntityPtr entity = *it;
+            if ( casters[index] ) {
+                // the rest of the map is kept from previous frames
+                const BoundingBox& bounds = entity->GetWorldBounds();
+                ScreenRect rect;
+                if ( bounds.IsEmpty() || !bounds.Project( lightViewProjection, rect ) || rect.Overlaps( m_ShadowRegion ) ) {
+                    entity->Render( pass );
+                }
+            }
+        }
+        return;
+    }
+
+    // camera passes only. Shadow casters may be hidden from the camera but still throw a shadow into view
+    bool cull = m_OcclusionCulling && m_OcclusionCuller;
+    if ( !cull ) {
+        // render all children
+        for( auto it = m_RenderList.begin(); it != m_RenderList.end(); ) {
+            EntityPtr entity = *it;
+            if ( entity->IsFlagSet( Entity::F_ENABLE|Entity::F_VISIBLE ) &&
+                !entity->IsFlagSet( Entity::F_DELETE ) )
+            {
+                // don't bother rendering if we are marked for deletion
+                entity->Render( pass );
+            }
+            ++it;
+        }
+        return;
+    }
+
+    // World does not transform - modelview is the camera (view) matrix
+    Matrix view, projection;
+    glGetFloatv( GL_MODELVIEW_MATRIX, view );
+    glGetFloatv( GL_PROJECTION_MATRIX, projection );
+
+    m_OcclusionCuller->Begin( view, projection, m_RenderList );
+
+    // occluders first - gives the workers time to rasterize them
+    int index(0);
+    for( auto it = m_RenderList.begin(); it != m_RenderList.end(); ++it, ++index ) {
         EntityPtr entity = *it;
-        if ( entity->IsFlagSet( Entity::F_ENABLE|Entity::F_VISIBLE ) &&
+        if ( m_OcclusionCuller->IsOccluder( index ) &&
+             entity->IsFlagSet( Entity::F_ENABLE|Entity::F_VISIBLE ) &&
             !entity->IsFlagSet( Entity::F_DELETE ) )
         {
-            // don't bother rendering if we are marked for deletion
             entity->Render( pass );
         }
-        ++it;
+    }
+
+    m_OcclusionCuller->Finish();
+
+    index = 0;
+    for( auto it = m_RenderList.begin(); it != m_RenderList.end(); ++it, ++index ) {
+        EntityPtr entity = *it;
+        if ( !m_OcclusionCuller->IsOccluder( index ) &&
+              m_OcclusionCuller->IsVisible( index ) &&
+              entity->IsFlagSet( Entity::F_ENABLE|Entity::F_VISIBLE ) &&
+             !entity->IsFlagSet( Entity::F_DELETE ) )
+        {
+            entity->Render( pass );
+        }
     }
 }
 
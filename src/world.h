@@ -11,6 +11,9 @@
 #include "err.h"
 #include "entity.h"
 #include "light.h"
+#include "occlusion.h"
+#include "shadowcull.h"
+#include "shadowdirty.h"
 
 #include <list>
 
@@ -21,6 +24,14 @@ public:
 private:
     bool        m_IsInitialized;
     LightList   m_Lights;
+
+    OcclusionCullerPtr m_OcclusionCuller;
+    bool        m_OcclusionCulling;
+
+    ShadowCasterCuller m_ShadowCasterCuller;
+    bool        m_ShadowCasterCulling;
+    std::vector<bool> m_ShadowCasters;  // scratch
+    ScreenRect  m_ShadowRegion;     // light space NDC - shadow passes skip casters outside
 public:
     World();
 
@@ -31,6 +42,36 @@ public:
     virtual bool Initialize( Renderer* renderer ) throw(std::exception);
 
     const LightList& GetLights() const;
+
+    /*!
+     * Test entities against a CPU depth buffer of large occluders before
+     * rendering. Only applies to camera passes, never to shadow map passes.
+     */
+    void SetOcclusionCulling( bool enable ) { m_OcclusionCulling = enable; }
+
+    bool IsOcclusionCulling() const { return m_OcclusionCulling; }
+
+    /*!
+     * Only render entities into shadow maps that can cast onto something the
+     * camera sees. Call SetShadowReceiverView() each frame before the shadow passes.
+     */
+    void SetShadowCasterCulling( bool enable ) { m_ShadowCasterCulling = enable; }
+
+    void SetShadowReceiverView( const Matrix& view, const Matrix& projection );
+
+    const ShadowCasterCuller& GetShadowCasterCuller() const { return m_ShadowCasterCuller; }
+
+    /*!
+     * Region of a light's shadow map that has to be redrawn since tracker saw
+     * the casters last. Returns false if the map is up to date.
+     */
+    bool GetShadowDirtyRect( const Matrix& lightView, const Matrix& lightProjection,
+                             ShadowDirtyTracker& tracker, ScreenRect& dirty );
+
+    /*!
+     * Only render casters overlapping region in the following shadow passes.
+     */
+    void SetShadowRegion( const ScreenRect& region ) { m_ShadowRegion = region; }
 protected:
     virtual bool DoInitialize( Renderer* renderer ) throw( std::exception );
 
@@ -41,6 +82,9 @@ protected:
     virtual void SetupRender( int pass );
 
     virtual void CleanupRender( int pass );
+
+    // casters that go into a shadow map - culled and enabled ones
+    const std::vector<bool>& GetShadowCasters( const Matrix& lightViewProjection );
 };
 
 typedef boost::shared_ptr<World> WorldPtr;
@@ -0,0 +1,60 @@
+/*
+ * atlaspack.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ *
+ * Packs images into a texture atlas:
+ *
+ *   atlaspack <path> <width> <height> <border> <image>...
+ *
+ * Images are loaded like the game loads them (relative to data/, type by
+ * extension) and placed tallest first. Writes <path>.tga and <path>.atlas
+ * for TextureAtlas::Load().
+ */
+
+#include "textureatlas.h"
+#include "brushloader.h"
+#include "err.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main( int argc, char* argv[] )
+{
+    if ( argc < 6 ) {
+        std::cerr << "usage: atlaspack <path> <width> <height> <border> <image>..." << std::endl;
+        return 1;
+    }
+    try {
+        TextureAtlas atlas( std::atoi( argv[2] ), std::atoi( argv[3] ), std::atoi( argv[4] ) );
+        ASSERT( atlas.GetWidth() > 0 && atlas.GetHeight() > 0, "Invalid atlas size %dx%d", atlas.GetWidth(), atlas.GetHeight() );
+
+        std::vector< std::pair< std::string, BrushPtr > > images;
+        for ( int i = 5; i < argc; ++i ) {
+            images.push_back( std::make_pair( std::string( argv[i] ), LoadBrush( argv[i] ) ) );
+        }
+        // tall ones first pack tighter into a skyline
+        std::stable_sort( images.begin(), images.end(),
+                          []( const std::pair< std::string, BrushPtr >& a, const std::pair< std::string, BrushPtr >& b ) {
+                              return a.second->m_Height > b.second->m_Height;
+                          } );
+        for ( auto& image : images ) {
+            ASSERT( atlas.Add( image.first, *image.second ), "'%s' doesn't fit into the atlas", image.first.c_str() );
+            const TextureAtlas::Region* region = atlas.Find( image.first );
+            std::cout << image.first << ": " << region->m_Width << "x" << region->m_Height
+                      << " at " << region->m_X << "," << region->m_Y << std::endl;
+        }
+        atlas.Save( argv[1] );
+        std::cout << atlas.GetNumRegions() << " images, " << int( atlas.GetOccupancy() * 100.0f + 0.5f ) << "% used" << std::endl;
+        return 0;
+    }
+    catch ( std::exception& ex ) {
+        std::cerr << "atlaspack: " << ex.what() << std::endl;
+    }
+    return 1;
+}
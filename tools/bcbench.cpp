@@ -0,0 +1,91 @@
+/*
+ * bcbench.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ *
+ * Throughput of the block decoder (MB/s of decoded BGRA):
+ *
+ *   bcbench [width height [iterations]]
+ *
+ * Random blocks for each format, decoded by the scalar reference, the SSE2
+ * decoder on one thread and the SSE2 decoder on the job queue. The outputs
+ * must match the reference.
+ */
+
+#include "blockdecoder.h"
+#include "jobqueue.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+namespace bpt = boost::posix_time;
+
+// MB/s of iterations x decode
+static double Measure( const boost::function< void() >& decode, int iterations, std::size_t bytes )
+{
+    decode();   // warm up, page in the output
+    bpt::ptime start = bpt::microsec_clock::local_time();
+    for ( int i = 0; i < iterations; ++i ) {
+        decode();
+    }
+    double seconds = double( ( bpt::microsec_clock::local_time() - start ).total_microseconds() ) * 1e-6;
+    return double( bytes ) * iterations / ( 1024.0 * 1024.0 ) / std::max( seconds, 1e-6 );
+}
+
+int main( int argc, char* argv[] )
+{
+    const int width      = argc > 2 ? std::atoi( argv[1] ) : 2048;
+    const int height     = argc > 2 ? std::atoi( argv[2] ) : 2048;
+    const int iterations = argc > 3 ? std::atoi( argv[3] ) : 10;
+    if ( width <= 0 || height <= 0 || iterations <= 0 ) {
+        std::cerr << "usage: bcbench [width height [iterations]]" << std::endl;
+        return 1;
+    }
+    try {
+        JobQueuePtr jobQueue( new JobQueue );
+        const char* names[] = { "", "BC1", "BC2", "BC3", "BC4", "BC5" };
+        const std::size_t bytes = std::size_t( width ) * height * 4;
+        std::vector<char> reference( bytes ), pixels( bytes );
+
+        std::cout << width << "x" << height << ", " << iterations << " iterations, "
+                  << jobQueue->GetNumThreads() << " worker threads" << std::endl;
+        std::cout << "format   scalar MB/s     simd MB/s  threaded MB/s" << std::endl;
+        for ( int compression = Brush::BC1; compression <= Brush::BC5; ++compression ) {
+            // any bit pattern is a valid block
+            std::vector<char> blocks( BlockDecoder::GetSize( compression, width, height ) );
+            unsigned int seed = 0x12345678;
+            for ( auto& b : blocks ) {
+                seed = seed * 1664525 + 1013904223;
+                b = char( seed >> 24 );
+            }
+
+            double scalar = Measure( boost::bind( &BlockDecoder::DecodeScalar, compression, &blocks[0], width, height, &reference[0] ),
+                                     iterations, bytes );
+            double simd = Measure( boost::bind( &BlockDecoder::Decode, compression, &blocks[0], width, height, &pixels[0], JobQueuePtr() ),
+                                   iterations, bytes );
+            bool match = std::memcmp( &reference[0], &pixels[0], bytes ) == 0;
+            std::fill( pixels.begin(), pixels.end(), 0 );
+            double threaded = Measure( boost::bind( &BlockDecoder::Decode, compression, &blocks[0], width, height, &pixels[0], jobQueue ),
+                                       iterations, bytes );
+            match &= std::memcmp( &reference[0], &pixels[0], bytes ) == 0;
+
+            std::cout << std::setw(6) << names[ compression ] << std::fixed << std::setprecision(1)
+                      << std::setw(14) << scalar << std::setw(14) << simd << std::setw(15) << threaded
+                      << ( match ? "" : "  MISMATCH" ) << std::endl;
+            if ( !match ) return 1;
+        }
+        return 0;
+    }
+    catch ( std::exception& ex ) {
+        std::cerr << "bcbench: " << ex.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,375 @@
+/*
+ * loaderfuzz.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ *
+ * Robustness of the image loaders and the decoders behind them:
+ *
+ *   loaderfuzz [iterations [seed ...]]
+ *
+ * Seeds - generated TGAs (raw, RLE, luminance, top down), BMPs (padded rows,
+ * top down) and DDSs (BC1 with mips, BC3, BC5, linear BGRA) plus any .tga,
+ * .bmp or .dds given - get a few bytes changed, mostly in the headers, and
+ * now and then are cut short. Each is loaded from memory by TgaBrush,
+ * BmpBrush or DdsBrush and whatever loads is decoded like Texture::Prepare()
+ * does it: RleDecoder, PixelConverter, BlockDecoder and MipChain.
+ * Rejections are expected, crashes aren't - build with
+ * -fsanitize=address,undefined so a read past a buffer aborts with a report.
+ * The mutations come from a fixed seed, runs repeat.
+ */
+
+#include "rledecoder.h"
+#include "pixelconverter.h"
+#include "blockdecoder.h"
+#include "mipchain.h"
+#include "jobqueue.h"
+
+#include <tga_loader.h>
+#include <bmp_loader.h>
+#include <dds_loader.h>
+
+#include <boost/filesystem.hpp>
+namespace bfs = boost::filesystem;
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <string>
+#include <vector>
+
+enum Kind {
+    TGA = 0,
+    BMP,
+    DDS,
+
+    NUM_KINDS
+};
+
+enum Result {
+    REJECTED = 0,   // by the loader
+    FAILED,         // loaded, but a decoder threw
+    DECODED,
+
+    NUM_RESULTS
+};
+
+struct Seed
+{
+    std::string       m_Name;
+    Kind              m_Kind;
+    std::vector<char> m_Data;
+};
+
+// same generator as bcbench - the same mutations on every run
+static unsigned int _state = 0x12345678;
+
+static std::size_t Random( std::size_t range )
+{
+    _state = _state * 1664525 + 1013904223;
+    return ( _state >> 8 ) % range;
+}
+
+// little endian, bytes wide
+static void Put( std::vector<char>& out, std::uint32_t value, int bytes )
+{
+    for ( int i = 0; i < bytes; ++i ) {
+        out.push_back( char( value >> ( i*8 ) ) );
+    }
+}
+
+// stripes 8 pixels wide - flat enough for RLE runs
+static char Pixel( int x, int y, int channel )
+{
+    return char( ( x / 8 ) * 40 + y * 3 + channel * 85 );
+}
+
+static std::vector<char> MakeTga( int width, int height, int bpp, bool rle, bool topDown )
+{
+    std::vector<char> out;
+    const int type = ( bpp == 1 ? 3 : 2 ) + ( rle ? 8 : 0 );
+    Put( out, 0, 1 );       // identsize
+    Put( out, 0, 1 );       // colorMapType
+    Put( out, type, 1 );
+    Put( out, 0, 2 );       // colorMapStart
+    Put( out, 0, 2 );       // colorMapLength
+    Put( out, 0, 1 );       // colorMapBits
+    Put( out, 0, 2 );       // xstart
+    Put( out, 0, 2 );       // ystart
+    Put( out, width, 2 );
+    Put( out, height, 2 );
+    Put( out, bpp * 8, 1 );
+    Put( out, topDown ? 0x20 : 0, 1 );
+
+    std::vector<char> pixels;
+    for ( int y = 0; y < height; ++y ) {
+        for ( int x = 0; x < width; ++x ) {
+            for ( int c = 0; c < bpp; ++c ) {
+                pixels.push_back( Pixel( x, y, c ) );
+            }
+        }
+    }
+    if ( !rle ) {
+        out.insert( out.end(), pixels.begin(), pixels.end() );
+        return out;
+    }
+    // greedy: 2 or more equal pixels are a run, the rest literal packets - across rows
+    const std::size_t count = pixels.size() / bpp;
+    for ( std::size_t i = 0; i < count; ) {
+        std::size_t run = 1;
+        while ( i + run < count && run < 128 && std::memcmp( &pixels[ (i + run) * bpp ], &pixels[ i * bpp ], bpp ) == 0 ) {
+            ++run;
+        }
+        if ( run > 1 ) {
+            out.push_back( char( 0x80 | ( run - 1 ) ) );
+            out.insert( out.end(), pixels.begin() + i * bpp, pixels.begin() + (i + 1) * bpp );
+            i += run;
+            continue;
+        }
+        std::size_t literal = 1;
+        while ( i + literal < count && literal < 128 &&
+                !( i + literal + 1 < count && std::memcmp( &pixels[ (i + literal) * bpp ], &pixels[ (i + literal + 1) * bpp ], bpp ) == 0 ) ) {
+            ++literal;
+        }
+        out.push_back( char( literal - 1 ) );
+        out.insert( out.end(), pixels.begin() + i * bpp, pixels.begin() + (i + literal) * bpp );
+        i += literal;
+    }
+    return out;
+}
+
+static std::vector<char> MakeBmp( int width, int height, int bpp, bool topDown )
+{
+    const std::size_t row   = std::size_t( width ) * bpp;
+    const std::size_t pitch = ( row + 3 ) & ~std::size_t( 3 );
+    std::vector<char> out;
+    out.push_back( 'B' );
+    out.push_back( 'M' );
+    Put( out, 54 + pitch * height, 4 );     // filesize
+    Put( out, 0, 4 );                       // reserved
+    Put( out, 54, 4 );                      // data_offset
+    Put( out, 40, 4 );                      // bih_size
+    Put( out, width, 4 );
+    Put( out, topDown ? 0u - height : height, 4 );
+    Put( out, 1, 2 );                       // planes
+    Put( out, bpp * 8, 2 );
+    Put( out, 0, 4 );                       // compression
+    Put( out, pitch * height, 4 );
+    Put( out, 2835, 4 );                    // 72 dpi
+    Put( out, 2835, 4 );
+    Put( out, 0, 4 );
+    Put( out, 0, 4 );
+    for ( int y = 0; y < height; ++y ) {
+        for ( int x = 0; x < width; ++x ) {
+            for ( int c = 0; c < bpp; ++c ) {
+                out.push_back( Pixel( x, y, c ) );
+            }
+        }
+        out.insert( out.end(), pitch - row, 0 );
+    }
+    return out;
+}
+
+// compression NONE is linear BGRA
+static std::vector<char> MakeDds( int width, int height, int compression, int levels )
+{
+    const char* fourCCs[] = { "", "DXT1", "DXT3", "DXT5", "ATI1", "ATI2" };
+    std::vector<char> out;
+    Put( out, 0x20534444, 4 );              // "DDS "
+    Put( out, 124, 4 );
+    // CAPS | HEIGHT | WIDTH | PIXELFORMAT | LINEARSIZE, MIPMAPCOUNT
+    Put( out, 0x81007 | ( levels > 1 ? 0x20000 : 0 ), 4 );
+    Put( out, height, 4 );
+    Put( out, width, 4 );
+    Put( out, 0, 4 );                       // linear size - the loader works it out
+    Put( out, 0, 4 );                       // depth
+    Put( out, levels, 4 );
+    out.insert( out.end(), 4 * 11, 0 );
+    Put( out, 32, 4 );                      // pixel format
+    if ( compression == Brush::NONE ) {
+        Put( out, 0x41, 4 );                // RGB | ALPHAPIXELS
+        Put( out, 0, 4 );
+        Put( out, 32, 4 );
+        Put( out, 0x00ff0000, 4 );
+        Put( out, 0x0000ff00, 4 );
+        Put( out, 0x000000ff, 4 );
+        Put( out, 0xff000000, 4 );
+    } else {
+        Put( out, 0x4, 4 );                 // FOURCC
+        out.insert( out.end(), fourCCs[ compression ], fourCCs[ compression ] + 4 );
+        out.insert( out.end(), 5 * 4, 0 );
+    }
+    Put( out, 0x1000 | ( levels > 1 ? 0x400008 : 0 ), 4 );    // TEXTURE, COMPLEX | MIPMAP
+    out.insert( out.end(), 4 * 4, 0 );
+
+    if ( compression == Brush::NONE ) {
+        for ( int y = 0; y < height; ++y ) {
+            for ( int x = 0; x < width; ++x ) {
+                for ( int c = 0; c < 4; ++c ) {
+                    out.push_back( Pixel( x, y, c ) );
+                }
+            }
+        }
+        return out;
+    }
+    // any bit pattern is a valid block
+    for ( int level = 0; level < levels; ++level ) {
+        const std::size_t size = BlockDecoder::GetSize( compression, std::max( width >> level, 1 ), std::max( height >> level, 1 ) );
+        for ( std::size_t i = 0; i < size; ++i ) {
+            out.push_back( char( Random( 256 ) ) );
+        }
+    }
+    return out;
+}
+
+static Seed MakeSeed( const std::string& name, Kind kind, const std::vector<char>& data )
+{
+    Seed seed = { name, kind, data };
+    return seed;
+}
+
+static Seed ReadSeed( const std::string& filename ) throw(std::exception)
+{
+    std::string extension = bfs::path( filename ).extension().string();
+    for ( auto& c : extension ) {
+        c = std::tolower( c );
+    }
+    ASSERT( extension == ".tga" || extension == ".bmp" || extension == ".dds", "'%s' is not a .tga, .bmp or .dds", filename.c_str() );
+    std::ifstream in( filename.c_str(), std::ios_base::binary );
+    ASSERT( in.is_open(), "Can't open '%s'", filename.c_str() );
+    std::vector<char> data( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+    return MakeSeed( filename, extension == ".tga" ? TGA : extension == ".bmp" ? BMP : DDS, data );
+}
+
+// a few bytes changed, mostly in the first 160 where the headers are, and now and then cut short
+static void Mutate( std::vector<char>& data )
+{
+    const int count = 1 + Random( 6 );
+    for ( int i = 0; i < count && !data.empty(); ++i ) {
+        const std::size_t at = Random( 3 ) ? Random( std::min<std::size_t>( data.size(), 160 ) ) : Random( data.size() );
+        switch ( Random( 4 ) ) {
+        case 0:  data[at] ^= char( 1 << Random( 8 ) ); break;
+        case 1:  data[at] = char( Random( 256 ) ); break;
+        case 2:  data[at] = char( 0xff ); break;
+        default: data[at] = 0; break;
+        }
+    }
+    if ( !data.empty() && Random( 4 ) == 0 ) {
+        data.resize( Random( data.size() ) );
+    }
+}
+
+// the paths of Texture::Prepare() without GL - throws where it would
+static void Decode( const Brush& brush, unsigned int flags, JobQueuePtr jobQueue ) throw(std::exception)
+{
+    const int width  = brush.m_Width;
+    const int height = brush.m_Height;
+    std::vector<char> chain( MipChain::GetSize( width, height, 4 ) );
+    if ( brush.m_Compression == Brush::RLE ) {
+        RleDecoder::Decode( brush, &chain[0], flags );
+    } else if ( brush.m_Compression == Brush::NONE ) {
+        PixelConverter::Convert( brush, &chain[0], flags, jobQueue );
+    } else {
+        std::size_t size(0);
+        for ( unsigned int level = 0; level < brush.m_NumLevels; ++level ) {
+            size += brush.GetLevelSize( level );
+        }
+        ASSERT( brush.m_Size >= size, "Invalid compressed brush!" );
+        BlockDecoder::Decode( brush.m_Compression, brush.m_Pixels, width, height, &chain[0], jobQueue );
+        std::vector<char> pixels;
+        for ( unsigned int level = 1; level < brush.m_NumLevels; ++level ) {
+            pixels.resize( std::size_t( brush.GetLevelWidth( level ) ) * brush.GetLevelHeight( level ) * 4 );
+            BlockDecoder::Decode( brush.m_Compression, brush.GetLevel( level ), brush.GetLevelWidth( level ), brush.GetLevelHeight( level ),
+                                  &pixels[0], jobQueue );
+        }
+    }
+    MipChain::Generate( &chain[0], width, height, 4, jobQueue );
+}
+
+template< class T >
+static Result Run( const std::vector<char>& data, unsigned int flags, JobQueuePtr jobQueue )
+{
+    // a copy of exactly the file - ASan sees every read past its end
+    std::vector<char> file( data );
+    T brush;
+    try {
+        if ( !brush.Load( "fuzz", file.empty() ? nullptr : &file[0], file.size() ) ) return REJECTED;
+    } catch ( std::exception& ) {
+        return REJECTED;
+    }
+    try {
+        Decode( brush, flags, jobQueue );
+    } catch ( std::exception& ) {
+        return FAILED;
+    }
+    return DECODED;
+}
+
+static Result Run( Kind kind, const std::vector<char>& data, unsigned int flags, JobQueuePtr jobQueue )
+{
+    switch ( kind ) {
+    case TGA: return Run<TgaBrush>( data, flags, jobQueue );
+    case BMP: return Run<BmpBrush>( data, flags, jobQueue );
+    default:  return Run<DdsBrush>( data, flags, jobQueue );
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    const int iterations = argc > 1 ? std::atoi( argv[1] ) : 10000;
+    if ( iterations <= 0 ) {
+        std::cerr << "usage: loaderfuzz [iterations [seed ...]]" << std::endl;
+        return 1;
+    }
+    try {
+        std::vector<Seed> seeds;
+        seeds.push_back( MakeSeed( "raw.tga",       TGA, MakeTga( 37, 23, 4, false, false ) ) );
+        seeds.push_back( MakeSeed( "topdown.tga",   TGA, MakeTga( 37, 23, 3, false, true ) ) );
+        seeds.push_back( MakeSeed( "luminance.tga", TGA, MakeTga( 37, 23, 1, false, false ) ) );
+        seeds.push_back( MakeSeed( "rle.tga",       TGA, MakeTga( 37, 23, 4, true, false ) ) );
+        seeds.push_back( MakeSeed( "rle24.tga",     TGA, MakeTga( 61, 19, 3, true, true ) ) );
+        seeds.push_back( MakeSeed( "padded.bmp",    BMP, MakeBmp( 37, 23, 3, false ) ) );
+        seeds.push_back( MakeSeed( "topdown.bmp",   BMP, MakeBmp( 37, 23, 4, true ) ) );
+        seeds.push_back( MakeSeed( "bc1.dds",       DDS, MakeDds( 32, 16, Brush::BC1, 6 ) ) );
+        seeds.push_back( MakeSeed( "bc3.dds",       DDS, MakeDds( 37, 23, Brush::BC3, 1 ) ) );
+        seeds.push_back( MakeSeed( "bc5.dds",       DDS, MakeDds( 16, 16, Brush::BC5, 1 ) ) );
+        seeds.push_back( MakeSeed( "linear.dds",    DDS, MakeDds( 37, 23, Brush::NONE, 1 ) ) );
+        for ( int i = 2; i < argc; ++i ) {
+            seeds.push_back( ReadSeed( argv[i] ) );
+        }
+
+        JobQueuePtr jobQueue( new JobQueue );
+        // untouched, every seed decodes - or its mutations prove nothing
+        for ( auto& seed : seeds ) {
+            ASSERT( Run( seed.m_Kind, seed.m_Data, 0, jobQueue ) == DECODED, "Seed '%s' doesn't decode", seed.m_Name.c_str() );
+        }
+
+        int results[ NUM_KINDS ][ NUM_RESULTS ] = {};
+        for ( int i = 0; i < iterations; ++i ) {
+            const Seed& seed = seeds[ Random( seeds.size() ) ];
+            std::vector<char> data( seed.m_Data );
+            Mutate( data );
+            const unsigned int flags = Random( 4 );     // SWIZZLE, PREMULTIPLY
+            ++results[ seed.m_Kind ][ Run( seed.m_Kind, data, flags, jobQueue ) ];
+        }
+
+        const char* names[] = { "TGA", "BMP", "DDS" };
+        std::cout << seeds.size() << " seeds, " << iterations << " iterations" << std::endl;
+        std::cout << "format  rejected    failed   decoded" << std::endl;
+        for ( int kind = 0; kind < NUM_KINDS; ++kind ) {
+            std::cout << std::setw(6) << names[ kind ] << std::setw(10) << results[ kind ][ REJECTED ]
+                      << std::setw(10) << results[ kind ][ FAILED ] << std::setw(10) << results[ kind ][ DECODED ] << std::endl;
+        }
+        return 0;
+    }
+    catch ( std::exception& ex ) {
+        std::cerr << "loaderfuzz: " << ex.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,193 @@
+/*
+ * meshcook.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ *
+ * Cooks meshes into the MeshCache directory (data/meshes):
+ *
+ *   meshcook <dir> sphere <radius> <r> <g> <b> <a>
+ *   meshcook <dir> cylinder <radius>
+ *   meshcook <dir> cube
+ *   meshcook <dir> grid
+ *   meshcook <dir> obj <file.obj> <key>
+ *
+ * Procedural meshes use the builders and keys of the entities, so the game
+ * loads them instead of generating them. Wavefront meshes are loaded with
+ * MeshCache::GetCooked( key ).
+ * Vertices are written in the compact format with half floats and packed
+ * normals - hardware without them builds the procedural meshes itself.
+ */
+
+#include "meshdata.h"
+#include "meshfile.h"
+#include "meshcache.h"
+#include "meshoptimizer.h"
+#include "sphere.h"
+#include "cylinder.h"
+#include "cube.h"
+#include "surface.h"
+#include "err.h"
+
+#include <boost/filesystem/operations.hpp>
+namespace bfs = boost::filesystem;
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+// position, tex coord, normal index of an obj face corner. 0 = not given
+typedef std::tuple<int, int, int> ObjCorner;
+
+// obj indices are 1 based, negative ones count back from the last element
+static int ObjIndex( int index, std::size_t count, const char* filename ) throw(std::exception)
+{
+    int resolved = index < 0 ? int(count) + index + 1 : index;
+    ASSERT( resolved >= 1 && resolved <= int(count), "Invalid obj index %d (%s)", index, filename );
+    return resolved;
+}
+
+static void LoadObj( const char* filename, MeshData& data ) throw(std::exception)
+{
+    std::ifstream in( filename );
+    ASSERT( in.is_open(), "Can't open '%s'", filename );
+
+    std::vector<Vector> positions, normals, texCoords;
+    std::map<ObjCorner, unsigned int> vertices;
+    std::string line;
+    while ( std::getline( in, line ) ) {
+        std::istringstream tokens( line );
+        std::string type;
+        tokens >> type;
+        if ( type == "v" ) {
+            float x(0), y(0), z(0);
+            tokens >> x >> y >> z;
+            positions.push_back( Vector( x, y, z ) );
+        } else if ( type == "vn" ) {
+            float x(0), y(0), z(0);
+            tokens >> x >> y >> z;
+            normals.push_back( Vector( x, y, z ).Normalize() );
+        } else if ( type == "vt" ) {
+            float u(0), v(0);
+            tokens >> u >> v;
+            texCoords.push_back( Vector( u, v, 0 ) );
+        } else if ( type == "f" ) {
+            // one vertex per distinct corner, polygons as fans
+            std::vector<unsigned int> face;
+            std::string corner;
+            while ( tokens >> corner ) {
+                int p(0), t(0), n(0);
+                if ( std::sscanf( corner.c_str(), "%d/%d/%d", &p, &t, &n ) != 3 &&
+                     std::sscanf( corner.c_str(), "%d//%d", &p, &n ) != 2 &&
+                     std::sscanf( corner.c_str(), "%d/%d", &p, &t ) != 2 ) {
+                    ASSERT( std::sscanf( corner.c_str(), "%d", &p ) == 1, "Invalid face '%s' (%s)", line.c_str(), filename );
+                }
+                ObjCorner key( ObjIndex( p, positions.size(), filename ),
+                               t ? ObjIndex( t, texCoords.size(), filename ) : 0,
+                               n ? ObjIndex( n, normals.size(), filename ) : 0 );
+                auto it = vertices.find( key );
+                if ( it == vertices.end() ) {
+                    it = vertices.insert( std::make_pair( key, (unsigned int)vertices.size() ) ).first;
+                }
+                face.push_back( it->second );
+            }
+            ASSERT( face.size() >= 3, "Face with less than 3 vertices (%s)", filename );
+            for ( std::size_t i = 2; i < face.size(); ++i ) {
+                data.m_Indices.push_back( face[0] );
+                data.m_Indices.push_back( face[i-1] );
+                data.m_Indices.push_back( face[i] );
+            }
+        }
+    }
+    ASSERT( !vertices.empty() && !data.m_Indices.empty(), "No triangles in '%s'", filename );
+
+    // tex coords and normals only if every corner has them
+    bool hasTexCoords(true), hasNormals(true);
+    for ( auto& vertex : vertices ) {
+        hasTexCoords &= std::get<1>( vertex.first ) != 0;
+        hasNormals   &= std::get<2>( vertex.first ) != 0;
+    }
+    const int numVertices = vertices.size();
+    data.m_Streams[ Mesh::POSITION ].resize( numVertices );
+    if ( hasNormals ) data.m_Streams[ Mesh::NORMAL ].resize( numVertices );
+    if ( hasTexCoords ) data.m_Streams[ Mesh::TEXCOORD ].resize( numVertices );
+    for ( auto& vertex : vertices ) {
+        data.m_Streams[ Mesh::POSITION ][ vertex.second ] = positions[ std::get<0>( vertex.first ) - 1 ];
+        if ( hasTexCoords ) data.m_Streams[ Mesh::TEXCOORD ][ vertex.second ] = texCoords[ std::get<1>( vertex.first ) - 1 ];
+        if ( hasNormals ) data.m_Streams[ Mesh::NORMAL ][ vertex.second ] = normals[ std::get<2>( vertex.first ) - 1 ];
+    }
+
+    // what the builders do for generated meshes
+    const int numTriangles = data.m_Indices.size() / 3;
+    data.m_ACMR[0] = MeshOptimizer::GetACMR( data.m_Indices, numVertices );
+    MeshOptimizer::OptimizeVertexCache( data.m_Indices, numVertices );
+    std::vector<unsigned int> remap;
+    MeshOptimizer::OptimizeVertexFetch( data.m_Indices, numVertices, remap );
+    for ( auto& stream : data.m_Streams ) {
+        if ( !stream.empty() ) {
+            MeshOptimizer::RemapVertices( &stream[0], numVertices, remap );
+        }
+    }
+    data.m_ACMR[1] = MeshOptimizer::GetACMR( data.m_Indices, numVertices );
+
+    for ( auto& point : data.m_Streams[ Mesh::POSITION ] ) {
+        data.m_Bounds.Add( point );
+    }
+    std::cout << filename << ": " << numVertices << " vertices, " << numTriangles << " triangles" << std::endl;
+}
+
+static int Usage()
+{
+    std::cerr << "usage: meshcook <dir> sphere <radius> <r> <g> <b> <a>\n"
+                 "       meshcook <dir> cylinder <radius>\n"
+                 "       meshcook <dir> cube\n"
+                 "       meshcook <dir> grid\n"
+                 "       meshcook <dir> obj <file.obj> <key>" << std::endl;
+    return 1;
+}
+
+int main( int argc, char* argv[] )
+{
+    if ( argc < 3 ) return Usage();
+    const std::string directory( argv[1] );
+    const std::string type( argv[2] );
+    try {
+        std::string key;
+        MeshData data;
+        if ( type == "sphere" && argc == 8 ) {
+            const float radius = std::atof( argv[3] );
+            const Vector color( std::atof( argv[4] ), std::atof( argv[5] ), std::atof( argv[6] ), std::atof( argv[7] ) );
+            key = Sphere::GetMeshKey( radius, color );
+            Sphere::GetMeshBuilder( JobQueuePtr(), radius, color )( data );
+        } else if ( type == "cylinder" && argc == 4 ) {
+            const float radius = std::atof( argv[3] );
+            key = Cylinder::GetMeshKey( radius );
+            Cylinder::GetMeshBuilder( JobQueuePtr(), radius )( data );
+        } else if ( type == "cube" && argc == 3 ) {
+            key = Cube::GetMeshKey();
+            Cube::GetMeshBuilder()( data );
+        } else if ( type == "grid" && argc == 3 ) {
+            key = Surface::GetGridKey();
+            Surface::GetGridBuilder()( data );
+        } else if ( type == "obj" && argc == 5 ) {
+            key = MeshCache::MakeKey( "obj", "%s", argv[4] );
+            LoadObj( argv[3], data );
+        } else {
+            return Usage();
+        }
+
+        bfs::create_directories( directory );
+        const std::string filename = MeshFile::GetFileName( directory, key );
+        MeshFile::Save( filename.c_str(), data, VertexFormat::MakeCompact( data.GetAttributes(), true, true ) );
+        std::cout << key << " -> " << filename << std::endl;
+        return 0;
+    }
+    catch ( std::exception& ex ) {
+        std::cerr << "meshcook: " << ex.what() << std::endl;
+    }
+    return 1;
+}
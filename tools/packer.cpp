@@ -0,0 +1,157 @@
+/*
+ * packer.cpp
+ *
+ *  Created on: 2026-10-19
+ *      Author: jurgens
+ *
+ * Packs a directory into a PackFile archive:
+ *
+ *   packer [-z] <pack> [<dir>]
+ *
+ * The images below dir (default data) - .tga, .bmp and .dds, the files
+ * LoadBrush() looks for in mounted archives - are stored under their path
+ * relative to it, '/' separated. -z compresses entries with LZ4 if that
+ * saves at least an eighth (and they aren't over PackFile::MAX_RAW_SIZE).
+ * Raw entries are handed out straight from the mapping, so only compress
+ * what isn't pointed into (uncompressed DDS, or when the archive size
+ * matters more than the loads).
+ */
+
+#include "packfile.h"
+#include "lz4block.h"
+#include "err.h"
+
+#include <boost/filesystem.hpp>
+namespace bfs = boost::filesystem;
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// what LoadBrush() resolves - everything else in the directory (sources, layouts, packs) stays out
+static bool IsAsset( const bfs::path& path )
+{
+    std::string extension = path.extension().string();
+    for ( auto& c : extension ) {
+        c = std::tolower( c );
+    }
+    return extension == ".tga" || extension == ".bmp" || extension == ".dds";
+}
+
+struct Input
+{
+    std::string          m_Name;
+    PackFile::IndexEntry m_Entry;
+    std::vector<char>    m_Payload;
+};
+
+static void Pad( std::ofstream& out, std::uint64_t& offset )
+{
+    static const char zeros[ PackFile::ALIGNMENT ] = {};
+    const std::uint64_t aligned = ( offset + PackFile::ALIGNMENT - 1 ) & ~std::uint64_t( PackFile::ALIGNMENT - 1 );
+    out.write( zeros, aligned - offset );
+    offset = aligned;
+}
+
+int main( int argc, char* argv[] )
+{
+    bool compress(false);
+    std::vector<std::string> args;
+    for ( int i = 1; i < argc; ++i ) {
+        if ( std::strcmp( argv[i], "-z" ) == 0 ) {
+            compress = true;
+        } else {
+            args.push_back( argv[i] );
+        }
+    }
+    if ( args.empty() || args.size() > 2 ) {
+        std::cerr << "usage: packer [-z] <pack> [<dir>]" << std::endl;
+        return 1;
+    }
+    try {
+        const std::string filename( args[0] );
+        const bfs::path root( args.size() > 1 ? args[1] : "data" );
+        ASSERT( bfs::is_directory( root ), "'%s' is not a directory", root.string().c_str() );
+        std::string rootName( root.generic_string() );
+        if ( rootName.size() > 1 && rootName[ rootName.size() - 1 ] == '/' ) {
+            rootName.erase( rootName.size() - 1 );
+        }
+
+        std::vector<Input> inputs;
+        std::size_t rawBytes(0), storedBytes(0);
+        for ( bfs::recursive_directory_iterator it( root ), end; it != end; ++it ) {
+            if ( !bfs::is_regular_file( it->status() ) || !IsAsset( it->path() ) ) continue;
+
+            // relative to root, the way the game names it
+            const std::string name = it->path().generic_string().substr( rootName.size() + 1 );
+
+            Input input;
+            input.m_Name = name;
+            std::ifstream in( it->path().string().c_str(), std::ios_base::binary );
+            ASSERT( in.is_open(), "Can't open '%s'", it->path().string().c_str() );
+            std::vector<char> raw( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+            ASSERT( raw.size() < 0xffffffffu, "'%s' is too large for a pack file", name.c_str() );
+
+            std::memset( &input.m_Entry, 0, sizeof(input.m_Entry) );
+            input.m_Entry.m_Hash    = PackFile::Hash( name );
+            input.m_Entry.m_RawSize = raw.size();
+            input.m_Entry.m_Format  = PackFile::RAW;
+            if ( compress && !raw.empty() && raw.size() <= PackFile::MAX_RAW_SIZE ) {
+                Lz4Block::Compress( &raw[0], raw.size(), input.m_Payload );
+                if ( input.m_Payload.size() <= raw.size() - raw.size() / 8 ) {
+                    input.m_Entry.m_Format = PackFile::LZ4;
+                }
+            }
+            if ( input.m_Entry.m_Format == PackFile::RAW ) {
+                input.m_Payload.swap( raw );
+            }
+            input.m_Entry.m_Size = input.m_Payload.size();
+            rawBytes    += input.m_Entry.m_RawSize;
+            storedBytes += input.m_Entry.m_Size;
+            inputs.push_back( input );
+        }
+
+        // binary searched by hash
+        std::sort( inputs.begin(), inputs.end(),
+                   []( const Input& a, const Input& b ) { return a.m_Entry.m_Hash < b.m_Entry.m_Hash; } );
+        for ( std::size_t i = 1; i < inputs.size(); ++i ) {
+            ASSERT( inputs[i-1].m_Entry.m_Hash != inputs[i].m_Entry.m_Hash, "Hash collision: '%s' and '%s'",
+                    inputs[i-1].m_Name.c_str(), inputs[i].m_Name.c_str() );
+        }
+
+        std::uint64_t offset = sizeof(PackFile::Header) + inputs.size() * sizeof(PackFile::IndexEntry);
+        for ( auto& input : inputs ) {
+            offset = ( offset + PackFile::ALIGNMENT - 1 ) & ~std::uint64_t( PackFile::ALIGNMENT - 1 );
+            input.m_Entry.m_Offset = offset;
+            offset += input.m_Entry.m_Size;
+        }
+
+        std::ofstream out( filename.c_str(), std::ios_base::binary | std::ios_base::trunc );
+        ASSERT( out.is_open(), "Can't write '%s'", filename.c_str() );
+        PackFile::Header header = { { 'P', 'A', 'C', 'K' }, PackFile::VERSION, std::uint32_t( inputs.size() ), 0 };
+        out.write( (const char*)&header, sizeof(header) );
+        for ( auto& input : inputs ) {
+            out.write( (const char*)&input.m_Entry, sizeof(input.m_Entry) );
+        }
+        offset = sizeof(PackFile::Header) + inputs.size() * sizeof(PackFile::IndexEntry);
+        for ( auto& input : inputs ) {
+            Pad( out, offset );
+            out.write( input.m_Payload.data(), input.m_Payload.size() );
+            offset += input.m_Payload.size();
+            std::cout << ( input.m_Entry.m_Format == PackFile::LZ4 ? "lz4 " : "raw " ) << input.m_Name << " "
+                      << input.m_Entry.m_RawSize << " -> " << input.m_Entry.m_Size << std::endl;
+        }
+        ASSERT( out.good(), "Error writing '%s'", filename.c_str() );
+        std::cout << inputs.size() << " entries, " << rawBytes << " -> " << storedBytes << " bytes, " << offset << " bytes with the index" << std::endl;
+        return 0;
+    }
+    catch ( std::exception& ex ) {
+        std::cerr << "packer: " << ex.what() << std::endl;
+    }
+    return 1;
+}